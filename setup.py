@@ -1,5 +1,67 @@
-from distutils.core import setup
-from setuptools import find_packages
+import glob
+import os
+
+from setuptools import Extension, find_packages, setup
+
+ERPC_DIR = "external/erpc/erpc_c"
+TINYPROTO_DIR = "external/tinyproto/src"
+TINYPROTO_SRC_DIR = "src/erpc_esp/erpc_tinyproto/src"
+
+
+def native_tinyproto_extension():
+    """
+    The C++ Tinyproto transport, wrapped by erpc_esp.erpc_tinyproto.native.
+
+    It needs the sources of the erpc and tinyproto submodules.
+    """
+    sources = [
+        "src/native/python/erpc_tinyproto_native.cpp",
+        "src/native/os/freertos_native.cpp",
+        "src/native/os/esp_log_native.c",
+        "src/native/os/esp_timer_native.c",
+        "src/erpc_esp/erpc_esp_utils/utils.c",
+        "src/erpc_esp/erpc/src/erpc_call_deadline.cpp",
+        "src/erpc_esp/erpc/src/erpc_esp_message_header.c",
+        f"{TINYPROTO_SRC_DIR}/tinyproto_channel.cpp",
+        f"{TINYPROTO_SRC_DIR}/tinyproto_frame_queue.cpp",
+        f"{TINYPROTO_SRC_DIR}/tinyproto_lzf.c",
+        f"{TINYPROTO_SRC_DIR}/tinyproto_stream.cpp",
+        f"{TINYPROTO_SRC_DIR}/tinyproto_transport.cpp",
+        f"{ERPC_DIR}/infra/erpc_message_buffer.cpp",
+    ]
+    for ext in ("c", "cpp"):
+        sources += glob.glob(f"{TINYPROTO_DIR}/**/*.{ext}", recursive=True)
+
+    return Extension(
+        "erpc_esp.erpc_tinyproto._native",
+        sources=sources,
+        include_dirs=[
+            # Must come first: it provides FreeRTOS and ESP-IDF headers
+            "src/native/os/include",
+            "src/erpc_esp/erpc/include",
+            "src/erpc_esp/erpc_esp_utils/include",
+            "src/erpc_esp/erpc_tinyproto/include",
+            TINYPROTO_SRC_DIR,
+            f"{ERPC_DIR}/config",
+            f"{ERPC_DIR}/infra",
+            f"{ERPC_DIR}/port",
+            f"{ERPC_DIR}/setup",
+            f"{ERPC_DIR}/transports",
+            TINYPROTO_DIR,
+        ],
+        define_macros=[("ERPC_THREADS", "ERPC_THREADS_PTHREADS")],
+        extra_compile_args=["-include", "erpc_config_override.h", "-pthread"],
+        extra_link_args=["-pthread"],
+        # The pure Python transport is still available without it
+        optional=True,
+    )
+
+
+ext_modules = []
+if os.path.isdir(ERPC_DIR) and os.path.isdir(TINYPROTO_DIR):
+    ext_modules.append(native_tinyproto_extension())
+else:
+    print("erpc or tinyproto submodule missing: not building the native transport")
 
 
 setup(
@@ -14,4 +76,5 @@ setup(
     packages=find_packages(
         where="src/",
     ),
+    ext_modules=ext_modules,
 )
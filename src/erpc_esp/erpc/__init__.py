@@ -0,0 +1 @@
+from .compact_codec import CompactCodec
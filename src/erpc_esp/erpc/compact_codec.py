@@ -0,0 +1,148 @@
+"""
+Codec with variable length integers.
+
+Pure Python counterpart of erpc_compact_codec.cpp. Must be kept in sync with it.
+"""
+
+from erpc.basic_codec import BasicCodec
+from erpc.codec import CodecError, MessageInfo, MessageType
+
+_HEADER_MARKER = 0xC0
+_HEADER_MARKER_MASK = 0xFC
+_HEADER_TYPE_MASK = 0x03
+
+
+class CompactCodec(BasicCodec):
+    """
+    Integers, enums and lengths are written as LEB128 varints, zigzag encoded
+    if signed. The header is 0xC0 | type, service, request and the varint
+    sequence number. Everything else is written as by BasicCodec.
+    """
+
+    def _write_varint(self, value: int):
+        data = bytearray()
+        while value >= 0x80:
+            data.append((value & 0x7F) | 0x80)
+            value >>= 7
+        data.append(value)
+        self._buffer += data
+        self._cursor += len(data)
+
+    def _write_signed(self, value: int, bits: int):
+        self._write_varint(((value << 1) ^ (value >> (bits - 1))) & ((1 << bits) - 1))
+
+    def _read_varint(self, bits: int) -> int:
+        value = 0
+        shift = 0
+        while True:
+            if self._cursor >= len(self._buffer):
+                raise CodecError("truncated varint")
+            byte = self._buffer[self._cursor]
+            self._cursor += 1
+            value |= (byte & 0x7F) << shift
+            if not byte & 0x80:
+                break
+            shift += 7
+            if shift >= 70:
+                raise CodecError("varint too long")
+        if value >> bits:
+            raise CodecError(f"varint does not fit in {bits} bits")
+        return value
+
+    def _read_signed(self, bits: int) -> int:
+        value = self._read_varint(bits)
+        return (value >> 1) ^ -(value & 1)
+
+    def start_write_message(self, msgInfo):
+        self._buffer += bytes(
+            [
+                _HEADER_MARKER | (msgInfo.type.value & _HEADER_TYPE_MASK),
+                msgInfo.service & 0xFF,
+                msgInfo.request & 0xFF,
+            ]
+        )
+        self._cursor += 3
+        self._write_varint(msgInfo.sequence & 0xFFFFFFFF)
+
+    def write_int16(self, value):
+        self._write_signed(value, 16)
+
+    def write_int32(self, value):
+        self._write_signed(value, 32)
+
+    def write_int64(self, value):
+        self._write_signed(value, 64)
+
+    def write_uint16(self, value):
+        self._write_varint(value)
+
+    def write_uint32(self, value):
+        self._write_varint(value)
+
+    def write_uint64(self, value):
+        self._write_varint(value)
+
+    def write_string(self, value):
+        self.write_binary(value.encode())
+
+    def write_binary(self, value):
+        self._write_varint(len(value))
+        self._buffer += value
+        self._cursor += len(value)
+
+    def start_write_list(self, length):
+        self._write_varint(length)
+
+    def start_write_union(self, discriminator):
+        # Same as the C++ codec, which writes it as an int32_t
+        self._write_signed(discriminator, 32)
+
+    def start_read_message(self):
+        if len(self._buffer) - self._cursor < 3:
+            raise CodecError("truncated header")
+        marker, service, request = self._buffer[self._cursor : self._cursor + 3]
+        if marker & _HEADER_MARKER_MASK != _HEADER_MARKER:
+            raise CodecError("not a compact codec message")
+        self._cursor += 3
+        sequence = self._read_varint(32)
+        return MessageInfo(
+            type=MessageType(marker & _HEADER_TYPE_MASK),
+            service=service,
+            request=request,
+            sequence=sequence,
+        )
+
+    def read_int16(self):
+        return self._read_signed(16)
+
+    def read_int32(self):
+        return self._read_signed(32)
+
+    def read_int64(self):
+        return self._read_signed(64)
+
+    def read_uint16(self):
+        return self._read_varint(16)
+
+    def read_uint32(self):
+        return self._read_varint(32)
+
+    def read_uint64(self):
+        return self._read_varint(64)
+
+    def read_string(self):
+        return self.read_binary().decode()
+
+    def read_binary(self):
+        length = self._read_varint(32)
+        if len(self._buffer) - self._cursor < length:
+            raise CodecError("truncated binary")
+        data = self._buffer[self._cursor : self._cursor + length]
+        self._cursor += length
+        return data
+
+    def start_read_list(self):
+        return self._read_varint(32)
+
+    def start_read_union(self):
+        return self._read_signed(32)
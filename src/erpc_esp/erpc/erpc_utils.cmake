@@ -28,6 +28,30 @@ function(erpc_find_erpcgen)
     endif()
 endfunction()
 
+#[=======================================================================[.rst:
+ERPCTargetThreadingIncludes
+---------------------------
+Add to a target the include directories needed to include `erpc_threading.h`,
+directly or through other eRPC headers, e.g. `erpc_framed_transport.hpp`.
+
+Signature::
+
+erpc_target_threading_includes(<TARGET>)
+
+With the FreeRTOS threading model, `erpc_threading.h` includes "FreeRTOS.h",
+"semphr.h" and "task.h", which are forwarded to ESP-IDF's `freertos/` ones.
+They are added as PRIVATE include directories, so that they don't shadow
+same-named headers in the targets depending on <TARGET>. Nothing is added
+with the other threading models.
+#]=======================================================================]
+function(erpc_target_threading_includes TARGET)
+    if(CONFIG_ERPC_THREADS_FREERTOS)
+        idf_component_get_property(erpc_dir erpc COMPONENT_DIR)
+        target_include_directories(${TARGET}
+                                   PRIVATE ${erpc_dir}/freertos_compat)
+    endif()
+endfunction()
+
 #[=======================================================================[.rst:
 ERPCGetPrefix
 -------------
@@ -0,0 +1,21 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		FreeRTOS.h
+ *
+ * \brief		Forwards eRPC's #include "FreeRTOS.h" to ESP-IDF's FreeRTOS
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_FREERTOS_COMPAT_FREERTOS_H_
+#define ERPC_ESP_FREERTOS_COMPAT_FREERTOS_H_
+
+#include "freertos/FreeRTOS.h"
+
+#endif /* ifndef ERPC_ESP_FREERTOS_COMPAT_FREERTOS_H_ */
@@ -0,0 +1,67 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_esp_arbitrated_client.h
+ *
+ * \brief		Arbitrated eRPC client aware of the connection status
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_ARBITRATED_CLIENT_H_
+#define ERPC_ESP_ARBITRATED_CLIENT_H_
+
+#include "erpc_client_setup.h"
+#include "erpc_mbf_setup.h"
+#include "erpc_transport_setup.h"
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create an arbitrated client whose pending calls can be failed at once when
+ * the connection is lost, instead of waiting for the transport to time out.
+ *
+ * Use it in place of erpc_arbitrated_client_init. The returned client works
+ * with the other functions of erpc_arbitrated_client_setup.h, e.g.
+ * erpc_arbitrated_client_set_error_handler.
+ *
+ * \param [in] transport shared transport
+ * \param [in] message_buffer_factory message buffer factory
+ * \param [out] arbitrator transport arbitrator, to be used by the server
+ *
+ * \return client
+ */
+erpc_client_t erpc_esp_arbitrated_client_init(
+	erpc_transport_t transport, erpc_mbf_t message_buffer_factory,
+	erpc_transport_t *arbitrator);
+
+/**
+ * Notify the client of a change of the connection status, e.g. from the
+ * connection status callback of the transport.
+ *
+ * On disconnection, the calls waiting for a reply are woken up and fail
+ * with kErpcStatus_ConnectionClosed. Until the connection is restored, new
+ * calls fail immediately with the same status.
+ *
+ * The client starts as connected.
+ *
+ * \param [in] client client created by erpc_esp_arbitrated_client_init
+ * \param [in] connected whether the connection is established
+ */
+void erpc_esp_arbitrated_client_set_connected(erpc_client_t client,
+											  bool connected);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_ARBITRATED_CLIENT_H_ */
@@ -0,0 +1,88 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_esp_call_deadline.h
+ *
+ * \brief		Per-call deadlines of the eRPC clients
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_CALL_DEADLINE_H_
+#define ERPC_ESP_CALL_DEADLINE_H_
+
+#include "freertos/FreeRTOS.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Use the send and receive timeouts of the transport
+ */
+#define ERPC_ESP_CALL_TIMEOUT_DEFAULT 0
+
+/**
+ * Set the timeout of the calls that the calling task performs from now on
+ * through a client created by erpc_esp_arbitrated_client_init.
+ *
+ * The timeout covers the whole call: the deadline is set when the call
+ * starts and bounds both the wait for room to send the request and the wait
+ * for the reply. It replaces the send timeout of the transports that support
+ * deadlines (e.g. the Tinyproto transport) and the receive timeout of the
+ * transport, which would otherwise abort any call lasting longer.
+ *
+ * \param [in] timeout timeout in ticks or ERPC_ESP_CALL_TIMEOUT_DEFAULT
+ */
+void erpc_esp_call_timeout_set(TickType_t timeout);
+
+/**
+ * Get the timeout set by the calling task.
+ */
+TickType_t erpc_esp_call_timeout_get(void);
+
+/**
+ * Get the time left before the deadline of the call that the calling task
+ * is performing. For transports.
+ *
+ * \param [in] default_timeout returned if the call has no deadline
+ *
+ * \return time left, 0 if the deadline has expired
+ */
+TickType_t erpc_esp_call_deadline_remaining(TickType_t default_timeout);
+
+/**
+ * Statistics of the calls performed with a timeout
+ */
+struct erpc_esp_call_deadline_stats {
+	uint32_t calls;
+	/**
+	 * Calls whose deadline expired before the request was sent
+	 */
+	uint32_t expired_send;
+	/**
+	 * Calls whose deadline expired while waiting for the reply
+	 */
+	uint32_t expired_receive;
+};
+
+/**
+ * Get the statistics of the calls performed with a timeout.
+ *
+ * \param [out] stats statistics
+ */
+void erpc_esp_call_deadline_get_stats(
+	struct erpc_esp_call_deadline_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_CALL_DEADLINE_H_ */
@@ -0,0 +1,69 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_esp_compact_codec.h
+ *
+ * \brief		Selection of the codec with variable length integers
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_COMPACT_CODEC_H_
+#define ERPC_ESP_COMPACT_CODEC_H_
+
+#include "erpc_client_setup.h"
+#include "erpc_server_setup.h"
+#include "erpc_transport_setup.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The compact codec writes integers, enums, lengths and the message header
+ * with as few bytes as needed. Both sides of a link must use it, including
+ * the transport arbitrator. On the Python side, use
+ * erpc_esp.erpc.CompactCodec.
+ *
+ * The functions below must be called right after the initialization of the
+ * client, server or arbitrator, before any message is exchanged. The codec is
+ * a property of the link, not of the interfaces: all the interfaces sharing
+ * a client, server or arbitrator use the same codec.
+ */
+
+/**
+ * Make the client encode its requests and decode the replies with the
+ * compact codec
+ *
+ * \param [in] client client, arbitrated or not
+ */
+void erpc_esp_client_use_compact_codec(erpc_client_t client);
+
+/**
+ * Make the server decode the requests and encode the replies with the
+ * compact codec
+ *
+ * \param [in] server server, e.g. created by erpc_server_init or
+ * erpc_esp_pool_server_init
+ */
+void erpc_esp_server_use_compact_codec(erpc_server_t server);
+
+/**
+ * Make the transport arbitrator decode the headers of the received messages
+ * with the compact codec
+ *
+ * \param [in] arbitrator arbitrator returned by erpc_arbitrated_client_init
+ * or erpc_esp_arbitrated_client_init
+ */
+void erpc_esp_arbitrator_use_compact_codec(erpc_transport_t arbitrator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_COMPACT_CODEC_H_ */
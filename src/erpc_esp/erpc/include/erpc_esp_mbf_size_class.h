@@ -0,0 +1,82 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_esp_mbf_size_class.h
+ *
+ * \brief		Message buffer factory with small and large buffers
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_MBF_SIZE_CLASS_H_
+#define ERPC_ESP_MBF_SIZE_CLASS_H_
+
+#include "erpc_mbf_setup.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Statistics of the size-class message buffer factory
+ */
+struct erpc_esp_mbf_size_class_stats {
+	/**
+	 * Small buffers currently in use
+	 */
+	size_t small_used;
+	/**
+	 * Maximum number of small buffers that have been in use at the same time
+	 */
+	size_t small_peak_used;
+	/**
+	 * Large buffers currently in use
+	 */
+	size_t large_used;
+	/**
+	 * Maximum number of large buffers that have been in use at the same time
+	 */
+	size_t large_peak_used;
+	/**
+	 * Buffer requests that failed because all the buffers of the requested
+	 * class were in use
+	 */
+	uint32_t failures;
+};
+
+/**
+ * Create a message buffer factory with CONFIG_ERPC_SIZE_CLASS_MBF_SMALL_COUNT
+ * small buffers and CONFIG_ERPC_SIZE_CLASS_MBF_LARGE_COUNT large buffers.
+ *
+ * The factory hands out large buffers, since the size of a message to be
+ * encoded is not known in advance. The transports of this repository swap
+ * them for small buffers while waiting for a frame and pick the class from the
+ * frame length once it is known.
+ *
+ * Only available if CONFIG_ERPC_SIZE_CLASS_MBF is enabled.
+ *
+ * \return message buffer factory
+ */
+erpc_mbf_t erpc_esp_mbf_size_class_init(void);
+
+/**
+ * Get the current statistics of the size-class message buffer factory.
+ *
+ * \param [out] stats statistics
+ */
+void erpc_esp_mbf_size_class_get_stats(
+	struct erpc_esp_mbf_size_class_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_MBF_SIZE_CLASS_H_ */
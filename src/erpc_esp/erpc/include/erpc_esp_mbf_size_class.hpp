@@ -0,0 +1,65 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_esp_mbf_size_class.hpp
+ *
+ * \brief		Message buffer factory with small and large buffers - transport
+ * hooks
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_MBF_SIZE_CLASS_HPP_
+#define ERPC_ESP_MBF_SIZE_CLASS_HPP_
+
+#include "erpc_config_internal.h"
+#include "erpc_message_buffer.hpp"
+
+#include "sdkconfig.h"
+
+/**
+ * Size of the largest message buffer: the large buffers of the size-class
+ * message buffer factory, if enabled, or the buffers of eRPC's factories.
+ * Transports drop the received messages that are larger.
+ */
+#if CONFIG_ERPC_SIZE_CLASS_MBF
+#define ERPC_ESP_MAX_MESSAGE_BUFFER_SIZE CONFIG_ERPC_SIZE_CLASS_MBF_LARGE_SIZE
+#else
+#define ERPC_ESP_MAX_MESSAGE_BUFFER_SIZE ERPC_DEFAULT_BUFFER_SIZE
+#endif
+
+namespace erpc {
+namespace esp {
+
+#if CONFIG_ERPC_SIZE_CLASS_MBF
+/**
+ * Make \p message able to hold \p size bytes, using the smallest buffer
+ * class that fits. The content of the message is not preserved.
+ *
+ * Transports call this with the frame length before receiving a frame, with
+ * 0 after sending and before waiting for a frame, so that large buffers are
+ * held only while they are needed.
+ *
+ * Message buffers that do not come from the size-class message buffer factory
+ * are left untouched.
+ *
+ * \retval true \p message can hold \p size bytes
+ * \retval false \p size is larger than the large buffers, or no buffer of the
+ * needed class is free
+ */
+bool fitMessageBuffer(MessageBuffer *message, uint32_t size);
+#else
+inline bool fitMessageBuffer(MessageBuffer *message, uint32_t size) {
+	return size <= message->getLength();
+}
+#endif
+
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_ESP_MBF_SIZE_CLASS_HPP_ */
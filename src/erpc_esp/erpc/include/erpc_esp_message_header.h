@@ -0,0 +1,73 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_esp_message_header.h
+ *
+ * \brief		Decoding of the header of eRPC messages
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_MESSAGE_HEADER_H_
+#define ERPC_ESP_MESSAGE_HEADER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * eRPC message type. Same values as erpc::message_type_t.
+ */
+enum erpc_esp_message_type {
+	ERPC_ESP_MESSAGE_TYPE_INVOCATION = 0,
+	ERPC_ESP_MESSAGE_TYPE_ONEWAY = 1,
+	ERPC_ESP_MESSAGE_TYPE_REPLY = 2,
+	ERPC_ESP_MESSAGE_TYPE_NOTIFICATION = 3,
+};
+
+/**
+ * Header of an eRPC message
+ */
+struct erpc_esp_message_header {
+	enum erpc_esp_message_type type;
+	/**
+	 * Interface ID
+	 */
+	uint8_t service;
+	/**
+	 * Function ID
+	 */
+	uint8_t request;
+	uint32_t sequence;
+};
+
+/**
+ * Decode the header of a message encoded by eRPC's BasicCodec or by
+ * CompactCodec (see erpc_esp_compact_codec.h).
+ *
+ * Used by components that observe the traffic (e.g. profiler, trace) without
+ * instantiating a codec.
+ *
+ * \param [in] data encoded message
+ * \param [in] size size of the encoded message
+ * \param [out] header decoded header
+ *
+ * \return false if \p data does not start with a valid header
+ */
+bool erpc_esp_message_header_decode(const uint8_t *data, size_t size,
+									struct erpc_esp_message_header *header);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_MESSAGE_HEADER_H_ */
@@ -0,0 +1,129 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_esp_pool_server.h
+ *
+ * \brief		eRPC server dispatching requests to a pool of worker tasks
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_POOL_SERVER_H_
+#define ERPC_ESP_POOL_SERVER_H_
+
+#include "erpc_mbf_setup.h"
+#include "erpc_server_setup.h"
+#include "erpc_transport_setup.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Size of a request in the queue of the pool server
+ */
+#define ERPC_ESP_POOL_SERVER_REQUEST_SIZE                                      \
+	(sizeof(void *) + 4 * sizeof(uint32_t))
+
+/**
+ * Size of the storage of a queue of \p queue_size requests
+ */
+#define ERPC_ESP_POOL_SERVER_QUEUE_BUFFER_SIZE(queue_size)                     \
+	((queue_size)*ERPC_ESP_POOL_SERVER_REQUEST_SIZE)
+
+/**
+ * Pool server configuration
+ */
+struct erpc_esp_pool_server_config {
+	/**
+	 * Number of worker tasks, i.e. maximum number of requests handled in
+	 * parallel
+	 */
+	uint32_t worker_count;
+	/**
+	 * Stack size of each worker task, in bytes. Handlers run on the worker
+	 * tasks.
+	 */
+	uint32_t worker_stack_size;
+	/**
+	 * Priority of the worker tasks
+	 */
+	UBaseType_t worker_priority;
+	/**
+	 * Number of received requests that can wait for a free worker. When the
+	 * queue is full, the server stops receiving.
+	 */
+	uint32_t queue_size;
+	/**
+	 * Storage of the worker tasks, worker_count of them
+	 */
+	StaticTask_t *worker_tasks;
+	/**
+	 * Storage of the stacks of the worker tasks, worker_count *
+	 * worker_stack_size bytes
+	 */
+	StackType_t *worker_stacks;
+	/**
+	 * Storage of the request queue,
+	 * ERPC_ESP_POOL_SERVER_QUEUE_BUFFER_SIZE(queue_size) bytes
+	 */
+	uint8_t *queue_buffer;
+};
+
+#define ERPC_ESP_POOL_SERVER_CONFIG_DEFAULT()                                  \
+	{                                                                          \
+		.worker_count = 2, .worker_stack_size = 4096, .worker_priority = 5,    \
+		.queue_size = 4, .worker_tasks = NULL, .worker_stacks = NULL,          \
+		.queue_buffer = NULL,                                                  \
+	}
+
+/**
+ * Create a server that receives the requests on the task that calls
+ * erpc_server_run and handles them on a pool of worker tasks.
+ *
+ * Use it in place of erpc_server_init. The returned server works with the
+ * other functions of erpc_server_setup.h, e.g. erpc_add_service_to_server,
+ * erpc_server_run and erpc_server_stop.
+ *
+ * \param [in] transport transport, usually the transport arbitrator
+ * \param [in] message_buffer_factory message buffer factory. It must be able
+ * to provide a buffer for each request in flight.
+ * \param [in] config configuration. The storage it points to must outlive
+ * the server.
+ *
+ * \return server or NULL if some storage is missing
+ */
+erpc_server_t erpc_esp_pool_server_init(
+	erpc_transport_t transport, erpc_mbf_t message_buffer_factory,
+	const struct erpc_esp_pool_server_config *config);
+
+/**
+ * IDs of the request being handled by the calling task, if it is a worker of
+ * the pool server. Meant for the pre/post action callbacks, which are not
+ * told which function is called.
+ *
+ * \param [out] service interface ID
+ * \param [out] function function ID
+ *
+ * \return false if the calling task is not handling a request of the pool
+ * server
+ */
+bool erpc_esp_pool_server_current_request(uint32_t *service,
+										  uint32_t *function);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_POOL_SERVER_H_ */
@@ -0,0 +1,94 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_esp_port_pool.h
+ *
+ * \brief		Fixed-block pool implementation of erpc_malloc/erpc_free
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_PORT_POOL_H_
+#define ERPC_ESP_PORT_POOL_H_
+
+#include "erpc_mbf_setup.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of size classes of the pool
+ */
+#define ERPC_ESP_PORT_POOL_CLASS_COUNT 3
+
+/**
+ * Statistics of a single size class
+ */
+struct erpc_esp_port_pool_class_stats {
+	/**
+	 * Size of each block
+	 */
+	size_t block_size;
+	/**
+	 * Number of blocks
+	 */
+	size_t block_count;
+	/**
+	 * Number of blocks currently allocated
+	 */
+	size_t used;
+	/**
+	 * Maximum number of blocks that have been allocated at the same time
+	 */
+	size_t peak_used;
+	/**
+	 * Allocations that fitted this class, but failed because this class and
+	 * all the larger ones were exhausted
+	 */
+	uint32_t failures;
+};
+
+/**
+ * Statistics of the pool
+ */
+struct erpc_esp_port_pool_stats {
+	/**
+	 * From the smallest to the largest class
+	 */
+	struct erpc_esp_port_pool_class_stats
+		classes[ERPC_ESP_PORT_POOL_CLASS_COUNT];
+	/**
+	 * Allocations larger than the largest block size
+	 */
+	uint32_t oversize_failures;
+};
+
+/**
+ * Get the current statistics of the pool.
+ *
+ * \param [out] stats statistics
+ */
+void erpc_esp_port_pool_get_stats(struct erpc_esp_port_pool_stats *stats);
+
+/**
+ * Create a message buffer factory that allocates buffers of
+ * ERPC_DEFAULT_BUFFER_SIZE bytes from the pool.
+ *
+ * \return message buffer factory
+ */
+erpc_mbf_t erpc_esp_mbf_pool_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_PORT_POOL_H_ */
@@ -0,0 +1,207 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_arbitrated_client.cpp
+ *
+ * \brief		Connection aware arbitrated client classes - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_arbitrated_client.hpp"
+
+#include "erpc_esp_message_header.h"
+
+using namespace erpc;
+using namespace erpc::esp;
+
+ConnectionAwareArbitrator::ConnectionAwareArbitrator(void)
+	: TransportArbitrator(), m_connected(true) {
+}
+
+erpc_status_t ConnectionAwareArbitrator::receive(MessageBuffer *message) {
+	erpc_status_t err = TransportArbitrator::receive(message);
+	if (err == kErpcStatus_ConnectionClosed) {
+		/*
+		 * E.g. the server is receiving again while the link is still down.
+		 * Nobody would wake up the clients until the next timeout.
+		 */
+		this->wakePendingClients();
+	}
+	return err;
+}
+
+void ConnectionAwareArbitrator::setConnected(bool connected) {
+	this->m_connected = connected;
+	if (!connected) {
+		this->wakePendingClients();
+	}
+}
+
+bool ConnectionAwareArbitrator::isConnected(void) const {
+	return this->m_connected;
+}
+
+/**
+ * Whether the arbitrator has passed the reply to the client, replacing the
+ * request in its buffer
+ */
+static bool has_reply(MessageBuffer *buffer) {
+	erpc_esp_message_header header;
+	return erpc_esp_message_header_decode(buffer->get(), buffer->getUsed(),
+										  &header) &&
+		   header.type == ERPC_ESP_MESSAGE_TYPE_REPLY;
+}
+
+/**
+ * Convert ticks to the microseconds taken by Semaphore::get
+ */
+static uint32_t ticks_to_us(TickType_t ticks) {
+	uint64_t us = (uint64_t)ticks * portTICK_PERIOD_MS * 1000;
+	return us < Semaphore::kWaitForever ? us : Semaphore::kWaitForever - 1;
+}
+
+erpc_status_t ConnectionAwareArbitrator::waitReply(client_token_t token,
+												   CallDeadline &deadline) {
+	PendingClientInfo *info = reinterpret_cast<PendingClientInfo *>(token);
+	MessageBuffer *buffer = info->m_request->getCodec()->getBuffer();
+	erpc_status_t status;
+
+	while (1) {
+		bool woken = info->m_sem.get(deadline.isSet()
+										 ? ticks_to_us(deadline.remaining())
+										 : Semaphore::kWaitForever);
+		Mutex::Guard lock(this->m_clientListMutex);
+		if (!woken) {
+			// The reply may have been passed meanwhile
+			woken = info->m_sem.get(0);
+		}
+		if (has_reply(buffer)) {
+			status = kErpcStatus_Success;
+			break;
+		}
+		/*
+		 * Check the wake reason recorded for this client rather than the
+		 * current connection status: the link may be back already.
+		 */
+		if (!info->m_isValid || !this->m_connected) {
+			status = kErpcStatus_ConnectionClosed;
+			break;
+		}
+		if (!woken || deadline.expired()) {
+			deadline.countExpiredReceive();
+			status = kErpcStatus_Timeout;
+			break;
+		}
+		if (!deadline.isSet()) {
+			// Like TransportArbitrator: the call ends with the receive
+			status = kErpcStatus_Timeout;
+			break;
+		}
+		/*
+		 * Woken up by a timeout of the shared transport (see
+		 * TransportArbitrator::receive), but the call may last longer.
+		 */
+	}
+	this->removePendingClient(info);
+	return status;
+}
+
+void ConnectionAwareArbitrator::cancelClientReceive(client_token_t token) {
+	this->removePendingClient(reinterpret_cast<PendingClientInfo *>(token));
+}
+
+void ConnectionAwareArbitrator::wakePendingClients(void) {
+	Mutex::Guard lock(this->m_clientListMutex);
+	for (PendingClientInfo *client = this->m_clientList; client != NULL;
+		 client = client->m_next) {
+		if (client->m_isValid) {
+			/*
+			 * Wake it up only once, even if its reply arrives later. While
+			 * the client is pending, only this clears m_isValid, so it
+			 * also tells waitReply that the connection was lost.
+			 */
+			client->m_isValid = false;
+			client->m_sem.put();
+		}
+	}
+}
+
+ConnectionAwareClientManager::ConnectionAwareClientManager(void)
+	: ArbitratedClientManager(), m_connectionArbitrator(NULL) {
+}
+
+void ConnectionAwareClientManager::setArbitrator(
+	ConnectionAwareArbitrator *arbitrator) {
+	ArbitratedClientManager::setArbitrator(arbitrator);
+	this->m_connectionArbitrator = arbitrator;
+}
+
+ConnectionAwareArbitrator *ConnectionAwareClientManager::getArbitrator(void) {
+	return this->m_connectionArbitrator;
+}
+
+void ConnectionAwareClientManager::performClientRequest(
+	RequestContext &request) {
+	Codec *codec = request.getCodec();
+	CallDeadline deadline;
+
+	if (!this->m_connectionArbitrator->isConnected()) {
+		codec->updateStatus(kErpcStatus_ConnectionClosed);
+		return;
+	}
+
+	if (request.isOneway()) {
+		// Only the send, which sees the deadline through the transport
+		ArbitratedClientManager::performClientRequest(request);
+		if (!codec->isStatusOk() && deadline.expired()) {
+			deadline.countExpiredSend();
+		}
+		return;
+	}
+
+	/*
+	 * Same as ArbitratedClientManager::performClientRequest, but waiting for
+	 * the reply with waitReply.
+	 * Register before sending, so that the arbitrator knows where to pass the
+	 * reply even if it arrives before we wait for it.
+	 */
+	TransportArbitrator::client_token_t token =
+		this->m_connectionArbitrator->prepareClientReceive(request);
+	if (token == 0) {
+		codec->updateStatus(kErpcStatus_Fail);
+		return;
+	}
+
+#if ERPC_MESSAGE_LOGGING
+	codec->updateStatus(this->logMessage(codec->getBuffer()));
+#endif
+	if (codec->isStatusOk()) {
+		codec->updateStatus(
+			this->m_connectionArbitrator->send(codec->getBuffer()));
+	}
+	if (!codec->isStatusOk()) {
+		this->m_connectionArbitrator->cancelClientReceive(token);
+		if (deadline.expired()) {
+			deadline.countExpiredSend();
+		}
+		return;
+	}
+
+	codec->updateStatus(
+		this->m_connectionArbitrator->waitReply(token, deadline));
+#if ERPC_MESSAGE_LOGGING
+	if (codec->isStatusOk()) {
+		codec->updateStatus(this->logMessage(codec->getBuffer()));
+	}
+#endif
+	if (codec->isStatusOk()) {
+		this->verifyReply(request);
+	}
+}
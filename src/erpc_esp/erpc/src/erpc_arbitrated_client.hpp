@@ -0,0 +1,103 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_arbitrated_client.hpp
+ *
+ * \brief		Connection aware arbitrated client classes - interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_ARBITRATED_CLIENT_HPP_H_
+#define ERPC_ESP_ARBITRATED_CLIENT_HPP_H_
+
+#include "erpc_call_deadline.hpp"
+
+#include "erpc_arbitrated_client_manager.hpp"
+#include "erpc_transport_arbitrator.hpp"
+
+namespace erpc {
+namespace esp {
+
+/*!
+ * @brief Transport arbitrator that can wake up all the pending clients when
+ * the connection is lost.
+ */
+class ConnectionAwareArbitrator : public TransportArbitrator {
+  public:
+	ConnectionAwareArbitrator(void);
+
+	/*!
+	 * @brief Receive like TransportArbitrator, but also wake up the pending
+	 * clients if the shared transport reports that the connection is closed.
+	 * TransportArbitrator does that only on timeout.
+	 */
+	virtual erpc_status_t receive(MessageBuffer *message) override;
+
+	/*!
+	 * @brief Set the connection status. On disconnection, wake up all the
+	 * pending clients.
+	 */
+	void setConnected(bool connected);
+
+	bool isConnected(void) const;
+
+	/*!
+	 * @brief Wait for the reply of a client registered with
+	 * prepareClientReceive, and unregister it.
+	 *
+	 * Unlike clientReceive, the wait is bounded by the deadline of the call,
+	 * if set, and a timeout of the shared transport does not end it.
+	 *
+	 * @retval kErpcStatus_Success Reply received.
+	 * @retval kErpcStatus_Timeout Deadline expired, or the shared transport
+	 * failed and the call has no deadline.
+	 * @retval kErpcStatus_ConnectionClosed Connection lost.
+	 */
+	erpc_status_t waitReply(client_token_t token, CallDeadline &deadline);
+
+	/*!
+	 * @brief Unregister a client registered with prepareClientReceive
+	 * without waiting for its reply, e.g. because the request could not be
+	 * sent.
+	 */
+	void cancelClientReceive(client_token_t token);
+
+  private:
+	/*!
+	 * @brief Wake up all the pending clients, without a reply, and mark them
+	 * invalid, so that they end with kErpcStatus_ConnectionClosed even if
+	 * the connection is restored before they run.
+	 */
+	void wakePendingClients(void);
+
+	volatile bool m_connected;
+};
+
+/*!
+ * @brief Arbitrated client manager that reports the calls failed due to the
+ * connection loss with kErpcStatus_ConnectionClosed, and that bounds the
+ * calls by their deadline (see erpc_esp_call_deadline.h).
+ */
+class ConnectionAwareClientManager : public ArbitratedClientManager {
+  public:
+	ConnectionAwareClientManager(void);
+
+	void setArbitrator(ConnectionAwareArbitrator *arbitrator);
+
+	ConnectionAwareArbitrator *getArbitrator(void);
+
+  protected:
+	virtual void performClientRequest(RequestContext &request) override;
+
+	ConnectionAwareArbitrator *m_connectionArbitrator;
+};
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_ESP_ARBITRATED_CLIENT_HPP_H_ */
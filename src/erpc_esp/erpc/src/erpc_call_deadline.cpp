@@ -0,0 +1,96 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_call_deadline.cpp
+ *
+ * \brief		Deadline of the current call - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_call_deadline.hpp"
+
+#include "erpc_esp/utils.h"
+
+#include "freertos/task.h"
+
+using namespace erpc::esp;
+
+/**
+ * Timeout set by the task
+ */
+static thread_local TickType_t t_timeout = ERPC_ESP_CALL_TIMEOUT_DEFAULT;
+/**
+ * Deadline of the call being performed by the task, if any
+ */
+static thread_local const CallDeadline *t_deadline = NULL;
+
+static erpc_esp_freertos_critical_section_lock s_stats_lock =
+	ERPC_ESP_FREERTOS_CRITICAL_SECTION_LOCK_INIT;
+static erpc_esp_call_deadline_stats s_stats;
+
+CallDeadline::CallDeadline(void)
+	: m_start(xTaskGetTickCount()), m_timeout(t_timeout) {
+	if (this->isSet()) {
+		t_deadline = this;
+		erpc_esp_freertos_critical_enter(&s_stats_lock);
+		++s_stats.calls;
+		erpc_esp_freertos_critical_exit(&s_stats_lock);
+	}
+}
+
+CallDeadline::~CallDeadline(void) {
+	if (t_deadline == this) {
+		t_deadline = NULL;
+	}
+}
+
+bool CallDeadline::isSet(void) const {
+	return this->m_timeout != ERPC_ESP_CALL_TIMEOUT_DEFAULT;
+}
+
+TickType_t CallDeadline::remaining(void) const {
+	TickType_t elapsed = xTaskGetTickCount() - this->m_start;
+	return elapsed >= this->m_timeout ? 0 : this->m_timeout - elapsed;
+}
+
+bool CallDeadline::expired(void) const {
+	return this->isSet() && this->remaining() == 0;
+}
+
+void CallDeadline::countExpiredSend(void) {
+	erpc_esp_freertos_critical_enter(&s_stats_lock);
+	++s_stats.expired_send;
+	erpc_esp_freertos_critical_exit(&s_stats_lock);
+}
+
+void CallDeadline::countExpiredReceive(void) {
+	erpc_esp_freertos_critical_enter(&s_stats_lock);
+	++s_stats.expired_receive;
+	erpc_esp_freertos_critical_exit(&s_stats_lock);
+}
+
+void erpc_esp_call_timeout_set(TickType_t timeout) {
+	t_timeout = timeout;
+}
+
+TickType_t erpc_esp_call_timeout_get(void) {
+	return t_timeout;
+}
+
+TickType_t erpc_esp_call_deadline_remaining(TickType_t default_timeout) {
+	return t_deadline != NULL ? t_deadline->remaining() : default_timeout;
+}
+
+void erpc_esp_call_deadline_get_stats(
+	struct erpc_esp_call_deadline_stats *stats) {
+	erpc_esp_freertos_critical_enter(&s_stats_lock);
+	*stats = s_stats;
+	erpc_esp_freertos_critical_exit(&s_stats_lock);
+}
@@ -0,0 +1,58 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_call_deadline.hpp
+ *
+ * \brief		Deadline of the current call - interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_CALL_DEADLINE_HPP_H_
+#define ERPC_ESP_CALL_DEADLINE_HPP_H_
+
+#include "erpc_esp_call_deadline.h"
+
+namespace erpc {
+namespace esp {
+
+/*!
+ * @brief Deadline of the call performed by the calling task.
+ *
+ * Armed from construction to destruction, if the task has set a timeout
+ * with erpc_esp_call_timeout_set. Meanwhile the transports see it through
+ * erpc_esp_call_deadline_remaining.
+ */
+class CallDeadline {
+  public:
+	CallDeadline(void);
+	~CallDeadline(void);
+
+	bool isSet(void) const;
+
+	/*!
+	 * @brief Time left, 0 if expired. Only if set.
+	 */
+	TickType_t remaining(void) const;
+
+	bool expired(void) const;
+
+	void countExpiredSend(void);
+	void countExpiredReceive(void);
+
+  private:
+	CallDeadline(const CallDeadline &) = delete;
+	CallDeadline &operator=(const CallDeadline &) = delete;
+
+	TickType_t m_start;
+	TickType_t m_timeout;
+};
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_ESP_CALL_DEADLINE_HPP_H_ */
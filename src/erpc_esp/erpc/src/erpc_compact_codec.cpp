@@ -0,0 +1,194 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_compact_codec.cpp
+ *
+ * \brief		Codec with variable length integers - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_compact_codec.hpp"
+
+#include "erpc_config_internal.h"
+#include "erpc_manually_constructed.hpp"
+
+#include "erpc_esp/utils.h"
+
+using namespace erpc;
+using namespace erpc::esp;
+
+/**
+ * Marker in the first byte of the header, whose 2 least significant bits
+ * hold the message type
+ */
+#define HEADER_MARKER 0xC0
+#define HEADER_MARKER_MASK 0xFC
+#define HEADER_TYPE_MASK 0x03
+
+/**
+ * A uint64_t takes at most 10 bytes
+ */
+#define VARINT_MAX_SIZE 10
+
+void CompactCodec::writeVarint(uint64_t value) {
+	uint8_t buf[VARINT_MAX_SIZE];
+	uint32_t size = 0;
+	while (value >= 0x80) {
+		buf[size++] = static_cast<uint8_t>(value) | 0x80;
+		value >>= 7;
+	}
+	buf[size++] = static_cast<uint8_t>(value);
+	this->writeData(buf, size);
+}
+
+void CompactCodec::writeSigned(int64_t value) {
+	// Zigzag: 0, -1, 1, -2, ... are encoded as 0, 1, 2, 3, ...
+	this->writeVarint((static_cast<uint64_t>(value) << 1) ^
+					  static_cast<uint64_t>(value >> 63));
+}
+
+uint64_t CompactCodec::readVarint(uint64_t max) {
+	uint64_t value = 0;
+	for (uint32_t shift = 0; shift < 7 * VARINT_MAX_SIZE; shift += 7) {
+		uint8_t byte = 0;
+		this->readData(&byte, sizeof(byte));
+		if (!this->isStatusOk()) {
+			return 0;
+		}
+		// The 10th byte can only hold the most significant bit
+		if (shift == 63 && byte > 1) {
+			break;
+		}
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			if (value > max) {
+				break;
+			}
+			return value;
+		}
+	}
+	this->updateStatus(kErpcStatus_InvalidArgument);
+	return 0;
+}
+
+int64_t CompactCodec::readSigned(int64_t min, int64_t max) {
+	uint64_t zigzag = this->readVarint(UINT64_MAX);
+	int64_t value = static_cast<int64_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+	if (value < min || value > max) {
+		this->updateStatus(kErpcStatus_InvalidArgument);
+		return 0;
+	}
+	return value;
+}
+
+void CompactCodec::startWriteMessage(message_type_t type, uint32_t service,
+									 uint32_t request, uint32_t sequence) {
+	uint8_t header[] = {
+		static_cast<uint8_t>(HEADER_MARKER | (type & HEADER_TYPE_MASK)),
+		static_cast<uint8_t>(service),
+		static_cast<uint8_t>(request),
+	};
+	this->writeData(header, sizeof(header));
+	this->writeVarint(sequence);
+}
+
+void CompactCodec::write(int16_t value) { this->writeSigned(value); }
+
+void CompactCodec::write(int32_t value) { this->writeSigned(value); }
+
+void CompactCodec::write(int64_t value) { this->writeSigned(value); }
+
+void CompactCodec::write(uint16_t value) { this->writeVarint(value); }
+
+void CompactCodec::write(uint32_t value) { this->writeVarint(value); }
+
+void CompactCodec::write(uint64_t value) { this->writeVarint(value); }
+
+void CompactCodec::startReadMessage(message_type_t *type, uint32_t *service,
+									uint32_t *request, uint32_t *sequence) {
+	uint8_t header[3];
+	this->readData(header, sizeof(header));
+	if (!this->isStatusOk()) {
+		return;
+	}
+	if ((header[0] & HEADER_MARKER_MASK) != HEADER_MARKER) {
+		this->updateStatus(kErpcStatus_InvalidMessageVersion);
+		return;
+	}
+	*type = static_cast<message_type_t>(header[0] & HEADER_TYPE_MASK);
+	*service = header[1];
+	*request = header[2];
+	*sequence = static_cast<uint32_t>(this->readVarint(UINT32_MAX));
+}
+
+void CompactCodec::read(int16_t *value) {
+	*value = static_cast<int16_t>(this->readSigned(INT16_MIN, INT16_MAX));
+}
+
+void CompactCodec::read(int32_t *value) {
+	*value = static_cast<int32_t>(this->readSigned(INT32_MIN, INT32_MAX));
+}
+
+void CompactCodec::read(int64_t *value) {
+	*value = this->readSigned(INT64_MIN, INT64_MAX);
+}
+
+void CompactCodec::read(uint16_t *value) {
+	*value = static_cast<uint16_t>(this->readVarint(UINT16_MAX));
+}
+
+void CompactCodec::read(uint32_t *value) {
+	*value = static_cast<uint32_t>(this->readVarint(UINT32_MAX));
+}
+
+void CompactCodec::read(uint64_t *value) {
+	*value = this->readVarint(UINT64_MAX);
+}
+
+#if ERPC_ALLOCATION_POLICY == ERPC_ALLOCATION_POLICY_STATIC
+static ManuallyConstructed<CompactCodec> s_codecs[ERPC_CODEC_COUNT];
+static bool s_codecUsed[ERPC_CODEC_COUNT];
+static erpc_esp_freertos_critical_section_lock s_codecsLock =
+	ERPC_ESP_FREERTOS_CRITICAL_SECTION_LOCK_INIT;
+
+Codec *CompactCodecFactory::create(void) {
+	size_t i;
+	erpc_esp_freertos_critical_enter(&s_codecsLock);
+	for (i = 0; i < ERPC_CODEC_COUNT && s_codecUsed[i]; ++i) {
+	}
+	if (i < ERPC_CODEC_COUNT) {
+		s_codecUsed[i] = true;
+	}
+	erpc_esp_freertos_critical_exit(&s_codecsLock);
+
+	if (i == ERPC_CODEC_COUNT) {
+		return NULL;
+	}
+	// Constructed outside of the critical section, the slot is reserved
+	s_codecs[i].construct();
+	return s_codecs[i].get();
+}
+
+void CompactCodecFactory::dispose(Codec *codec) {
+	for (size_t i = 0; i < ERPC_CODEC_COUNT; ++i) {
+		if (s_codecs[i].get() == codec) {
+			s_codecs[i].destroy();
+			erpc_esp_freertos_critical_enter(&s_codecsLock);
+			s_codecUsed[i] = false;
+			erpc_esp_freertos_critical_exit(&s_codecsLock);
+			return;
+		}
+	}
+}
+#else
+Codec *CompactCodecFactory::create(void) { return new CompactCodec(); }
+
+void CompactCodecFactory::dispose(Codec *codec) { delete codec; }
+#endif
@@ -0,0 +1,95 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_compact_codec.hpp
+ *
+ * \brief		Codec with variable length integers - interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_COMPACT_CODEC_HPP_
+#define ERPC_ESP_COMPACT_CODEC_HPP_
+
+#include "erpc_basic_codec.hpp"
+
+namespace erpc {
+namespace esp {
+
+/*!
+ * @brief Codec writing integers, enums and lengths as varints.
+ *
+ * Unsigned integers are encoded as LEB128 varints, signed integers are
+ * zigzag encoded first, so that small negative values are short too. bool,
+ * 8-bit integers, floats, doubles and the content of strings and binaries are
+ * written as by BasicCodec.
+ *
+ * The header is written as:
+ * - 1 byte: 0xC0 | message type
+ * - 1 byte: service ID
+ * - 1 byte: request ID
+ * - varint: sequence number
+ *
+ * The first byte of a BasicCodec header is the message type, so the two
+ * headers cannot be mistaken for each other. See erpc_esp_message_header.h.
+ */
+class CompactCodec : public BasicCodec {
+  public:
+	using BasicCodec::read;
+	using BasicCodec::write;
+
+	virtual void startWriteMessage(message_type_t type, uint32_t service,
+								   uint32_t request,
+								   uint32_t sequence) override;
+
+	virtual void write(int16_t value) override;
+	virtual void write(int32_t value) override;
+	virtual void write(int64_t value) override;
+	virtual void write(uint16_t value) override;
+	virtual void write(uint32_t value) override;
+	virtual void write(uint64_t value) override;
+
+	virtual void startReadMessage(message_type_t *type, uint32_t *service,
+								  uint32_t *request,
+								  uint32_t *sequence) override;
+
+	virtual void read(int16_t *value) override;
+	virtual void read(int32_t *value) override;
+	virtual void read(int64_t *value) override;
+	virtual void read(uint16_t *value) override;
+	virtual void read(uint32_t *value) override;
+	virtual void read(uint64_t *value) override;
+
+  private:
+	void writeVarint(uint64_t value);
+	void writeSigned(int64_t value);
+
+	/*!
+	 * @brief Read a varint, failing with kErpcStatus_InvalidArgument if it
+	 * does not fit in \p max.
+	 */
+	uint64_t readVarint(uint64_t max);
+	int64_t readSigned(int64_t min, int64_t max);
+};
+
+/*!
+ * @brief Factory of CompactCodec.
+ *
+ * With the static allocation policy, up to ERPC_CODEC_COUNT codecs can be
+ * used at the same time.
+ */
+class CompactCodecFactory : public CodecFactory {
+  public:
+	virtual Codec *create(void) override;
+	virtual void dispose(Codec *codec) override;
+};
+
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_ESP_COMPACT_CODEC_HPP_ */
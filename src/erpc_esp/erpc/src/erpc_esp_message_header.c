@@ -0,0 +1,93 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_esp_message_header.c
+ *
+ * \brief		Decoding of the header of eRPC messages
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_esp_message_header.h"
+
+/**
+ * Version written by BasicCodec in the most significant byte of the header
+ */
+#define BASIC_CODEC_VERSION 1
+
+/**
+ * Marker written by CompactCodec in the most significant bits of the first
+ * byte, the others hold the message type
+ */
+#define COMPACT_CODEC_MARKER 0xC0
+#define COMPACT_CODEC_MARKER_MASK 0xFC
+
+/**
+ * Maximum size of the varint of a uint32_t
+ */
+#define VARINT32_MAX_SIZE 5
+
+/**
+ * BasicCodec writes the header as two uint32_t in native byte order, which is
+ * little endian on all the supported targets.
+ */
+static uint32_t read_u32_le(const uint8_t *data) {
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+		   ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static bool compact_header_decode(const uint8_t *data, size_t size,
+								  struct erpc_esp_message_header *header) {
+	if (size < 4) {
+		return false;
+	}
+
+	uint32_t sequence = 0;
+	for (size_t i = 0; i < VARINT32_MAX_SIZE && 3 + i < size; ++i) {
+		uint8_t byte = data[3 + i];
+		sequence |= (uint32_t)(byte & 0x7f) << (7 * i);
+		if (!(byte & 0x80)) {
+			header->type = (enum erpc_esp_message_type)(
+				data[0] & ~COMPACT_CODEC_MARKER_MASK);
+			header->service = data[1];
+			header->request = data[2];
+			header->sequence = sequence;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool erpc_esp_message_header_decode(const uint8_t *data, size_t size,
+									struct erpc_esp_message_header *header) {
+	if (data == NULL || size == 0) {
+		return false;
+	}
+	if ((data[0] & COMPACT_CODEC_MARKER_MASK) == COMPACT_CODEC_MARKER) {
+		return compact_header_decode(data, size, header);
+	}
+	if (size < 2 * sizeof(uint32_t)) {
+		return false;
+	}
+
+	uint32_t word = read_u32_le(data);
+	if ((word >> 24) != BASIC_CODEC_VERSION) {
+		return false;
+	}
+	uint8_t type = word & 0xff;
+	if (type > ERPC_ESP_MESSAGE_TYPE_NOTIFICATION) {
+		return false;
+	}
+
+	header->type = (enum erpc_esp_message_type)type;
+	header->service = (word >> 16) & 0xff;
+	header->request = (word >> 8) & 0xff;
+	header->sequence = read_u32_le(data + sizeof(uint32_t));
+	return true;
+}
@@ -0,0 +1,128 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_pool_server.cpp
+ *
+ * \brief		eRPC pool server class - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_pool_server.hpp"
+
+#include "freertos/task.h"
+
+#include <cassert>
+
+#define TAG "erpc_esp_pool_server"
+#include "esp_log.h"
+
+using namespace erpc;
+using namespace erpc::esp;
+
+thread_local const PoolServer::Request *PoolServer::s_current = NULL;
+
+PoolServer::PoolServer(const erpc_esp_pool_server_config &config)
+	: SimpleServer(), m_config(config), m_queueBuffer(), m_queue(NULL),
+	  m_sendLock() {
+}
+
+erpc_status_t PoolServer::init(void) {
+	if (this->m_config.worker_tasks == NULL ||
+		this->m_config.worker_stacks == NULL ||
+		this->m_config.queue_buffer == NULL) {
+		ESP_LOGE(TAG, "Missing storage");
+		return kErpcStatus_InitFailed;
+	}
+
+	this->m_queue =
+		xQueueCreateStatic(this->m_config.queue_size, sizeof(Request),
+						   this->m_config.queue_buffer, &this->m_queueBuffer);
+	assert(this->m_queue);
+	// The stack size is in bytes, xTaskCreateStatic wants StackType_t units
+	const uint32_t stack_depth =
+		this->m_config.worker_stack_size / sizeof(StackType_t);
+	for (uint32_t i = 0; i < this->m_config.worker_count; ++i) {
+		TaskHandle_t task = xTaskCreateStatic(
+			workerTask, "erpc_worker", stack_depth, this,
+			this->m_config.worker_priority,
+			this->m_config.worker_stacks + i * stack_depth,
+			&this->m_config.worker_tasks[i]);
+		assert(task);
+	}
+	return kErpcStatus_Success;
+}
+
+erpc_status_t PoolServer::run(void) {
+	erpc_status_t err = kErpcStatus_Success;
+
+	while (err == kErpcStatus_Success && this->m_isServerOn) {
+		Request request;
+		MessageBuffer buffer;
+		err = this->runInternalBegin(&request.codec, buffer, request.msgType,
+									 request.serviceId, request.methodId,
+									 request.sequence);
+		if (err == kErpcStatus_Success) {
+			// Backpressure: stop receiving while all the workers are busy
+			xQueueSend(this->m_queue, &request, portMAX_DELAY);
+		}
+	}
+	return err;
+}
+
+void PoolServer::workerTask(void *arg) {
+	PoolServer *self = static_cast<PoolServer *>(arg);
+
+	while (1) {
+		Request request;
+		if (xQueueReceive(self->m_queue, &request, portMAX_DELAY) != pdTRUE) {
+			continue;
+		}
+		erpc_status_t err = self->handle(request);
+		if (err != kErpcStatus_Success) {
+			ESP_LOGW(TAG, "Request %u:%u failed: %d",
+					 (unsigned)request.serviceId, (unsigned)request.methodId,
+					 err);
+		}
+	}
+}
+
+erpc_status_t PoolServer::handle(const Request &request) {
+	/*
+	 * Same as SimpleServer::runInternalEnd, but only the send is serialized,
+	 * so that the handlers can run in parallel.
+	 */
+	s_current = &request;
+	erpc_status_t err =
+		this->processMessage(request.codec, request.msgType, request.serviceId,
+							 request.methodId, request.sequence);
+	s_current = NULL;
+	if (err == kErpcStatus_Success && request.msgType != kOnewayMessage) {
+		Mutex::Guard lock(this->m_sendLock);
+#if ERPC_MESSAGE_LOGGING
+		err = this->logMessage(request.codec->getBuffer());
+		if (err == kErpcStatus_Success) {
+#endif
+			err = this->m_transport->send(request.codec->getBuffer());
+#if ERPC_MESSAGE_LOGGING
+		}
+#endif
+	}
+	this->disposeBufferAndCodec(request.codec);
+	return err;
+}
+
+bool PoolServer::currentRequest(uint32_t *serviceId, uint32_t *methodId) {
+	if (s_current == NULL) {
+		return false;
+	}
+	*serviceId = s_current->serviceId;
+	*methodId = s_current->methodId;
+	return true;
+}
@@ -0,0 +1,104 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_pool_server.hpp
+ *
+ * \brief		eRPC pool server class - interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_POOL_SERVER_HPP_H_
+#define ERPC_ESP_POOL_SERVER_HPP_H_
+
+#include "erpc_esp_pool_server.h"
+
+#include "erpc_simple_server.hpp"
+#include "erpc_threading.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+namespace erpc {
+namespace esp {
+
+/*!
+ * @brief Server that receives the requests on the task calling run() and
+ * handles them on a pool of worker tasks.
+ *
+ * Replies are sent by the workers, one at a time.
+ */
+class PoolServer : public SimpleServer {
+  public:
+	/*!
+	 * @brief Constructor.
+	 *
+	 * @param [in] config configuration
+	 */
+	explicit PoolServer(const erpc_esp_pool_server_config &config);
+
+	/*!
+	 * @brief Create the request queue and the worker tasks in the storage
+	 * provided by the configuration.
+	 *
+	 * @retval kErpcStatus_InitFailed Some storage is missing.
+	 * @retval kErpcStatus_Success Success.
+	 */
+	erpc_status_t init(void);
+
+	/*!
+	 * @brief Receive requests and pass them to the workers, until an error
+	 * occurs or stop() is called.
+	 */
+	virtual erpc_status_t run(void) override;
+
+	/*!
+	 * @brief IDs of the request being handled by the calling task.
+	 *
+	 * @retval false The calling task is not a worker handling a request.
+	 */
+	static bool currentRequest(uint32_t *serviceId, uint32_t *methodId);
+
+  private:
+	/*!
+	 * @brief A received request, waiting for a worker
+	 */
+	struct Request {
+		Codec *codec;
+		message_type_t msgType;
+		uint32_t serviceId;
+		uint32_t methodId;
+		uint32_t sequence;
+	};
+	static_assert(sizeof(Request) == ERPC_ESP_POOL_SERVER_REQUEST_SIZE,
+				  "ERPC_ESP_POOL_SERVER_REQUEST_SIZE doesn't match Request");
+
+	static void workerTask(void *arg);
+
+	/*!
+	 * @brief Handle a request and send its reply.
+	 */
+	erpc_status_t handle(const Request &request);
+
+	/**
+	 * Request being handled by the task, if it is a worker
+	 */
+	static thread_local const Request *s_current;
+
+	erpc_esp_pool_server_config m_config;
+	StaticQueue_t m_queueBuffer;
+	QueueHandle_t m_queue;
+	/**
+	 * Serializes the replies sent by the workers
+	 */
+	Mutex m_sendLock;
+};
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_ESP_POOL_SERVER_HPP_H_ */
@@ -0,0 +1,197 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_port_pool.c
+ *
+ * \brief		Fixed-block pool implementation of erpc_malloc/erpc_free
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_esp_port_pool.h"
+#include "erpc_port.h"
+
+#include "erpc_esp/utils.h"
+
+#include "sdkconfig.h"
+
+#include <assert.h>
+#include <stdbool.h>
+
+/**
+ * Alignment of every block
+ */
+#define POOL_ALIGNMENT 8
+#define POOL_ALIGN_UP(size)                                                    \
+	(((size) + POOL_ALIGNMENT - 1) & ~((size_t)POOL_ALIGNMENT - 1))
+
+#define SMALL_BLOCK_SIZE POOL_ALIGN_UP(CONFIG_ERPC_PORT_POOL_SMALL_BLOCK_SIZE)
+#define MEDIUM_BLOCK_SIZE POOL_ALIGN_UP(CONFIG_ERPC_PORT_POOL_MEDIUM_BLOCK_SIZE)
+#define LARGE_BLOCK_SIZE POOL_ALIGN_UP(CONFIG_ERPC_PORT_POOL_LARGE_BLOCK_SIZE)
+
+_Static_assert(SMALL_BLOCK_SIZE < MEDIUM_BLOCK_SIZE &&
+				   MEDIUM_BLOCK_SIZE < LARGE_BLOCK_SIZE,
+			   "Pool block sizes must be strictly increasing");
+
+static uint8_t s_small_storage[CONFIG_ERPC_PORT_POOL_SMALL_BLOCK_COUNT]
+							  [SMALL_BLOCK_SIZE]
+	__attribute__((aligned(POOL_ALIGNMENT)));
+static uint8_t s_medium_storage[CONFIG_ERPC_PORT_POOL_MEDIUM_BLOCK_COUNT]
+							   [MEDIUM_BLOCK_SIZE]
+	__attribute__((aligned(POOL_ALIGNMENT)));
+static uint8_t s_large_storage[CONFIG_ERPC_PORT_POOL_LARGE_BLOCK_COUNT]
+							  [LARGE_BLOCK_SIZE]
+	__attribute__((aligned(POOL_ALIGNMENT)));
+
+/**
+ * Free blocks are linked through their first bytes
+ */
+struct free_block {
+	struct free_block *next;
+};
+
+struct pool_class {
+	uint8_t *storage;
+	size_t block_size;
+	size_t block_count;
+	struct free_block *free_list;
+	/**
+	 * Number of blocks never allocated so far. They are taken from the end of
+	 * `storage` before looking at `free_list`, so that no initialization pass
+	 * is needed.
+	 */
+	size_t untouched;
+	size_t used;
+	size_t peak_used;
+	uint32_t failures;
+};
+
+static struct {
+	erpc_esp_freertos_critical_section_lock lock;
+	struct pool_class classes[ERPC_ESP_PORT_POOL_CLASS_COUNT];
+	uint32_t oversize_failures;
+} s_pool = {
+	.lock = ERPC_ESP_FREERTOS_CRITICAL_SECTION_LOCK_INIT,
+	.classes =
+		{
+			{
+				.storage = &s_small_storage[0][0],
+				.block_size = SMALL_BLOCK_SIZE,
+				.block_count = CONFIG_ERPC_PORT_POOL_SMALL_BLOCK_COUNT,
+				.untouched = CONFIG_ERPC_PORT_POOL_SMALL_BLOCK_COUNT,
+			},
+			{
+				.storage = &s_medium_storage[0][0],
+				.block_size = MEDIUM_BLOCK_SIZE,
+				.block_count = CONFIG_ERPC_PORT_POOL_MEDIUM_BLOCK_COUNT,
+				.untouched = CONFIG_ERPC_PORT_POOL_MEDIUM_BLOCK_COUNT,
+			},
+			{
+				.storage = &s_large_storage[0][0],
+				.block_size = LARGE_BLOCK_SIZE,
+				.block_count = CONFIG_ERPC_PORT_POOL_LARGE_BLOCK_COUNT,
+				.untouched = CONFIG_ERPC_PORT_POOL_LARGE_BLOCK_COUNT,
+			},
+		},
+};
+
+static void *pool_class_take(struct pool_class *c) {
+	void *block = NULL;
+	if (c->untouched > 0) {
+		--c->untouched;
+		block = c->storage + c->untouched * c->block_size;
+	} else if (c->free_list != NULL) {
+		block = c->free_list;
+		c->free_list = c->free_list->next;
+	}
+	if (block != NULL) {
+		++c->used;
+		if (c->used > c->peak_used) {
+			c->peak_used = c->used;
+		}
+	}
+	return block;
+}
+
+static bool pool_class_owns(const struct pool_class *c, const void *ptr) {
+	const uint8_t *p = ptr;
+	return p >= c->storage && p < c->storage + c->block_size * c->block_count;
+}
+
+void *erpc_malloc(size_t size) {
+	void *block = NULL;
+	bool fits = false;
+	size_t first_fit = 0;
+
+	erpc_esp_freertos_critical_enter(&s_pool.lock);
+	for (size_t i = 0; i < ERPC_ESP_PORT_POOL_CLASS_COUNT; ++i) {
+		struct pool_class *c = &s_pool.classes[i];
+		if (size > c->block_size) {
+			continue;
+		}
+		if (!fits) {
+			fits = true;
+			first_fit = i;
+		}
+		// Fall back to the larger classes when a class is exhausted
+		block = pool_class_take(c);
+		if (block != NULL) {
+			break;
+		}
+	}
+	if (block == NULL) {
+		if (fits) {
+			++s_pool.classes[first_fit].failures;
+		} else {
+			++s_pool.oversize_failures;
+		}
+	}
+	erpc_esp_freertos_critical_exit(&s_pool.lock);
+
+	return block;
+}
+
+void erpc_free(void *ptr) {
+	if (ptr == NULL) {
+		return;
+	}
+
+	erpc_esp_freertos_critical_enter(&s_pool.lock);
+	bool found = false;
+	for (size_t i = 0; i < ERPC_ESP_PORT_POOL_CLASS_COUNT; ++i) {
+		struct pool_class *c = &s_pool.classes[i];
+		if (pool_class_owns(c, ptr)) {
+			assert((((const uint8_t *)ptr - c->storage) % c->block_size) == 0);
+			struct free_block *block = ptr;
+			block->next = c->free_list;
+			c->free_list = block;
+			--c->used;
+			found = true;
+			break;
+		}
+	}
+	erpc_esp_freertos_critical_exit(&s_pool.lock);
+
+	assert(found && "erpc_free of a pointer not allocated by erpc_malloc");
+	(void)found;
+}
+
+void erpc_esp_port_pool_get_stats(struct erpc_esp_port_pool_stats *stats) {
+	erpc_esp_freertos_critical_enter(&s_pool.lock);
+	for (size_t i = 0; i < ERPC_ESP_PORT_POOL_CLASS_COUNT; ++i) {
+		const struct pool_class *c = &s_pool.classes[i];
+		stats->classes[i].block_size = c->block_size;
+		stats->classes[i].block_count = c->block_count;
+		stats->classes[i].used = c->used;
+		stats->classes[i].peak_used = c->peak_used;
+		stats->classes[i].failures = c->failures;
+	}
+	stats->oversize_failures = s_pool.oversize_failures;
+	erpc_esp_freertos_critical_exit(&s_pool.lock);
+}
@@ -0,0 +1,63 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_setup_arbitrated_client.cpp
+ *
+ * \brief		Connection aware arbitrated client setup functions
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_esp_arbitrated_client.h"
+
+#include "erpc_arbitrated_client.hpp"
+
+#include "erpc_basic_codec.hpp"
+#include "erpc_crc16.hpp"
+#include "erpc_manually_constructed.hpp"
+
+using namespace erpc;
+using namespace erpc::esp;
+
+static ManuallyConstructed<ConnectionAwareClientManager> s_client;
+static ManuallyConstructed<ConnectionAwareArbitrator> s_arbitrator;
+static ManuallyConstructed<BasicCodecFactory> s_codecFactory;
+static ManuallyConstructed<BasicCodec> s_codec;
+static ManuallyConstructed<Crc16> s_crc16;
+
+erpc_client_t erpc_esp_arbitrated_client_init(
+	erpc_transport_t transport, erpc_mbf_t message_buffer_factory,
+	erpc_transport_t *arbitrator) {
+	Transport *castedTransport = reinterpret_cast<Transport *>(transport);
+
+	s_codecFactory.construct();
+	s_codec.construct();
+	s_crc16.construct();
+	castedTransport->setCrc16(s_crc16.get());
+
+	s_arbitrator.construct();
+	s_arbitrator->setSharedTransport(castedTransport);
+	s_arbitrator->setCodec(s_codec.get());
+
+	s_client.construct();
+	s_client->setArbitrator(s_arbitrator.get());
+	s_client->setCodecFactory(s_codecFactory.get());
+	s_client->setMessageBufferFactory(
+		reinterpret_cast<MessageBufferFactory *>(message_buffer_factory));
+
+	*arbitrator = reinterpret_cast<erpc_transport_t>(s_arbitrator.get());
+	return reinterpret_cast<erpc_client_t>(s_client.get());
+}
+
+void erpc_esp_arbitrated_client_set_connected(erpc_client_t client,
+											  bool connected) {
+	reinterpret_cast<ConnectionAwareClientManager *>(client)
+		->getArbitrator()
+		->setConnected(connected);
+}
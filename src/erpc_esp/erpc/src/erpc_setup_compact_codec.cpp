@@ -0,0 +1,50 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_setup_compact_codec.cpp
+ *
+ * \brief		Compact codec setup functions
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_esp_compact_codec.h"
+
+#include "erpc_compact_codec.hpp"
+
+#include "erpc_client_manager.h"
+#include "erpc_manually_constructed.hpp"
+#include "erpc_server.hpp"
+#include "erpc_transport_arbitrator.hpp"
+
+using namespace erpc;
+using namespace erpc::esp;
+
+/**
+ * Stateless, so it is shared by all the clients and servers. Its implicit
+ * constructor is constexpr, so no static constructor is run.
+ */
+static CompactCodecFactory s_codecFactory;
+static ManuallyConstructed<CompactCodec> s_arbitratorCodec;
+
+void erpc_esp_client_use_compact_codec(erpc_client_t client) {
+	reinterpret_cast<ClientManager *>(client)->setCodecFactory(
+		&s_codecFactory);
+}
+
+void erpc_esp_server_use_compact_codec(erpc_server_t server) {
+	reinterpret_cast<Server *>(server)->setCodecFactory(&s_codecFactory);
+}
+
+void erpc_esp_arbitrator_use_compact_codec(erpc_transport_t arbitrator) {
+	// There is a single arbitrator per application
+	s_arbitratorCodec.construct();
+	reinterpret_cast<TransportArbitrator *>(arbitrator)->setCodec(
+		s_arbitratorCodec.get());
+}
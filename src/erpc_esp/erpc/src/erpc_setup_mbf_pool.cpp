@@ -0,0 +1,49 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_setup_mbf_pool.cpp
+ *
+ * \brief		Message buffer factory backed by the erpc_malloc pool
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_esp_port_pool.h"
+
+#include "erpc_manually_constructed.hpp"
+#include "erpc_mbf_setup.h"
+#include "erpc_message_buffer.hpp"
+#include "erpc_port.h"
+
+using namespace erpc;
+
+/*!
+ * @brief Message buffer factory that allocates the buffers from the
+ * erpc_malloc pool.
+ */
+class PoolMessageBufferFactory : public MessageBufferFactory {
+  public:
+	virtual MessageBuffer create(void) {
+		uint8_t *buf =
+			reinterpret_cast<uint8_t *>(erpc_malloc(ERPC_DEFAULT_BUFFER_SIZE));
+		return MessageBuffer(buf, (buf != NULL) ? ERPC_DEFAULT_BUFFER_SIZE : 0);
+	}
+
+	virtual void dispose(MessageBuffer *buf) {
+		erpc_assert(buf);
+		erpc_free(buf->get());
+	}
+};
+
+static ManuallyConstructed<PoolMessageBufferFactory> s_msgFactory;
+
+erpc_mbf_t erpc_esp_mbf_pool_init(void) {
+	s_msgFactory.construct();
+	return reinterpret_cast<erpc_mbf_t>(s_msgFactory.get());
+}
@@ -0,0 +1,185 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_setup_mbf_size_class.cpp
+ *
+ * \brief		Message buffer factory with small and large buffers
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_esp_mbf_size_class.h"
+#include "erpc_esp_mbf_size_class.hpp"
+
+#include "erpc_manually_constructed.hpp"
+#include "erpc_mbf_setup.h"
+#include "erpc_message_buffer.hpp"
+
+#include "erpc_esp/utils.h"
+
+#include "sdkconfig.h"
+
+using namespace erpc;
+
+#define SMALL_SIZE CONFIG_ERPC_SIZE_CLASS_MBF_SMALL_SIZE
+#define LARGE_SIZE CONFIG_ERPC_SIZE_CLASS_MBF_LARGE_SIZE
+
+static_assert(SMALL_SIZE < LARGE_SIZE,
+			  "Small buffers must be smaller than large buffers");
+static_assert(LARGE_SIZE <= UINT16_MAX,
+			  "MessageBuffer length is limited to 16 bits");
+
+namespace {
+
+/**
+ * Set of equally sized buffers
+ */
+template <size_t Size, size_t Count> class BufferClass {
+  public:
+	uint8_t *take(void) {
+		for (size_t i = 0; i < Count; ++i) {
+			if (!m_used[i]) {
+				m_used[i] = true;
+				++m_usedCount;
+				if (m_usedCount > m_peakUsedCount) {
+					m_peakUsedCount = m_usedCount;
+				}
+				return m_storage[i];
+			}
+		}
+		return NULL;
+	}
+
+	void give(uint8_t *buf) {
+		size_t i = (buf - m_storage[0]) / Size;
+		erpc_assert(owns(buf) && m_used[i]);
+		m_used[i] = false;
+		--m_usedCount;
+	}
+
+	bool owns(const uint8_t *buf) const {
+		return buf >= m_storage[0] && buf < m_storage[0] + Size * Count;
+	}
+
+	size_t usedCount(void) const { return m_usedCount; }
+	size_t peakUsedCount(void) const { return m_peakUsedCount; }
+
+  private:
+	uint8_t m_storage[Count][Size] __attribute__((aligned(4)));
+	bool m_used[Count];
+	size_t m_usedCount;
+	size_t m_peakUsedCount;
+};
+
+BufferClass<SMALL_SIZE, CONFIG_ERPC_SIZE_CLASS_MBF_SMALL_COUNT> s_small;
+BufferClass<LARGE_SIZE, CONFIG_ERPC_SIZE_CLASS_MBF_LARGE_COUNT> s_large;
+uint32_t s_failures;
+erpc_esp_freertos_critical_section_lock s_lock =
+	ERPC_ESP_FREERTOS_CRITICAL_SECTION_LOCK_INIT;
+
+} // namespace
+
+/*!
+ * @brief Message buffer factory with small and large buffers.
+ */
+class SizeClassMessageBufferFactory : public MessageBufferFactory {
+  public:
+	/*!
+	 * @brief Create a large buffer: the size of the message to be encoded is
+	 * not known yet.
+	 */
+	virtual MessageBuffer create(void) {
+		erpc_esp_freertos_critical_enter(&s_lock);
+		uint8_t *buf = s_large.take();
+		if (buf == NULL) {
+			++s_failures;
+		}
+		erpc_esp_freertos_critical_exit(&s_lock);
+		return MessageBuffer(buf, (buf != NULL) ? LARGE_SIZE : 0);
+	}
+
+	/*!
+	 * @brief The server reuses the buffer of the request, which may be small.
+	 */
+	virtual erpc_status_t prepareServerBufferForSend(MessageBuffer *message) {
+		return esp::fitMessageBuffer(message, LARGE_SIZE)
+				   ? kErpcStatus_Success
+				   : kErpcStatus_MemoryError;
+	}
+
+	virtual void dispose(MessageBuffer *buf) {
+		erpc_assert(buf);
+		uint8_t *data = buf->get();
+		if (data == NULL) {
+			return;
+		}
+		erpc_esp_freertos_critical_enter(&s_lock);
+		if (s_small.owns(data)) {
+			s_small.give(data);
+		} else {
+			s_large.give(data);
+		}
+		erpc_esp_freertos_critical_exit(&s_lock);
+	}
+};
+
+bool esp::fitMessageBuffer(MessageBuffer *message, uint32_t size) {
+	uint8_t *data = message->get();
+	bool small = s_small.owns(data);
+	if (!small && !s_large.owns(data)) {
+		// Not ours
+		return size <= message->getLength();
+	}
+	if (size > LARGE_SIZE) {
+		return false;
+	}
+
+	bool want_small = size <= SMALL_SIZE;
+	if (want_small == small) {
+		return true;
+	}
+
+	erpc_esp_freertos_critical_enter(&s_lock);
+	uint8_t *new_data = want_small ? s_small.take() : s_large.take();
+	if (new_data != NULL) {
+		if (small) {
+			s_small.give(data);
+		} else {
+			s_large.give(data);
+		}
+	} else if (!want_small) {
+		++s_failures;
+	}
+	erpc_esp_freertos_critical_exit(&s_lock);
+
+	if (new_data == NULL) {
+		// Shrinking is best effort: the large buffer can hold any size.
+		return want_small;
+	}
+	message->set(new_data, want_small ? SMALL_SIZE : LARGE_SIZE);
+	return true;
+}
+
+static ManuallyConstructed<SizeClassMessageBufferFactory> s_msgFactory;
+
+erpc_mbf_t erpc_esp_mbf_size_class_init(void) {
+	s_msgFactory.construct();
+	return reinterpret_cast<erpc_mbf_t>(s_msgFactory.get());
+}
+
+void erpc_esp_mbf_size_class_get_stats(
+	struct erpc_esp_mbf_size_class_stats *stats) {
+	erpc_esp_freertos_critical_enter(&s_lock);
+	stats->small_used = s_small.usedCount();
+	stats->small_peak_used = s_small.peakUsedCount();
+	stats->large_used = s_large.usedCount();
+	stats->large_peak_used = s_large.peakUsedCount();
+	stats->failures = s_failures;
+	erpc_esp_freertos_critical_exit(&s_lock);
+}
@@ -0,0 +1,55 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_setup_pool_server.cpp
+ *
+ * \brief		eRPC pool server setup functions
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_esp_pool_server.h"
+
+#include "erpc_pool_server.hpp"
+
+#include "erpc_basic_codec.hpp"
+#include "erpc_crc16.hpp"
+#include "erpc_manually_constructed.hpp"
+
+using namespace erpc;
+using namespace erpc::esp;
+
+static ManuallyConstructed<PoolServer> s_server;
+static ManuallyConstructed<BasicCodecFactory> s_codecFactory;
+static ManuallyConstructed<Crc16> s_crc16;
+
+erpc_server_t erpc_esp_pool_server_init(
+	erpc_transport_t transport, erpc_mbf_t message_buffer_factory,
+	const struct erpc_esp_pool_server_config *config) {
+	Transport *castedTransport = reinterpret_cast<Transport *>(transport);
+
+	s_server.construct(*config);
+	s_codecFactory.construct();
+	s_crc16.construct();
+	castedTransport->setCrc16(s_crc16.get());
+	s_server->setTransport(castedTransport);
+	s_server->setCodecFactory(s_codecFactory.get());
+	s_server->setMessageBufferFactory(
+		reinterpret_cast<MessageBufferFactory *>(message_buffer_factory));
+
+	if (s_server->init() != kErpcStatus_Success) {
+		return NULL;
+	}
+	return reinterpret_cast<erpc_server_t>(s_server.get());
+}
+
+bool erpc_esp_pool_server_current_request(uint32_t *service,
+										  uint32_t *function) {
+	return PoolServer::currentRequest(service, function);
+}
@@ -0,0 +1,137 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_esp_profiler.h
+ *
+ * \brief		Per-function profiler of eRPC servers
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_PROFILER_H_
+#define ERPC_ESP_PROFILER_H_
+
+#include "erpc_server_setup.h"
+#include "erpc_transport_setup.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of buckets of the latency histogram.
+ *
+ * Bucket 0 counts the calls that took less than 2 us. Bucket i (i > 0) counts
+ * the calls that took [2^i, 2^(i+1)) us. The last bucket counts also all the
+ * longer calls.
+ */
+#define ERPC_ESP_PROFILER_HISTOGRAM_BUCKETS 16
+
+/**
+ * Statistics of a single function
+ */
+struct erpc_esp_profiler_function_stats {
+	/**
+	 * Interface ID
+	 */
+	uint8_t service;
+	/**
+	 * Function ID
+	 */
+	uint8_t function;
+	/**
+	 * Number of requests received
+	 */
+	uint32_t requests;
+	/**
+	 * Number of handler executions measured
+	 */
+	uint32_t calls;
+	/**
+	 * Minimum handler latency in us
+	 */
+	uint32_t min_us;
+	/**
+	 * Maximum handler latency in us
+	 */
+	uint32_t max_us;
+	/**
+	 * Sum of the handler latencies in us. Divide by calls to get the mean.
+	 */
+	uint64_t total_us;
+	/**
+	 * Latency histogram. See #ERPC_ESP_PROFILER_HISTOGRAM_BUCKETS.
+	 */
+	uint32_t histogram[ERPC_ESP_PROFILER_HISTOGRAM_BUCKETS];
+	/**
+	 * Bytes of the received requests
+	 */
+	uint64_t bytes_in;
+	/**
+	 * Bytes of the sent replies
+	 */
+	uint64_t bytes_out;
+};
+
+/**
+ * Wrap a transport, so that the profiler can observe the requests received
+ * and the replies sent through it.
+ *
+ * With the arbitrated client, wrap the transport given to
+ * erpc_arbitrated_client_init.
+ *
+ * \param [in] transport transport to be profiled
+ *
+ * \return transport to be used in place of \p transport
+ */
+erpc_transport_t erpc_esp_profiler_transport_init(erpc_transport_t transport);
+
+/**
+ * Install the profiler pre/post action callbacks on \p server, to measure the
+ * handlers latency.
+ *
+ * \param [in] server server, whose transport has been wrapped with
+ * erpc_esp_profiler_transport_init
+ */
+void erpc_esp_profiler_attach_server(erpc_server_t server);
+
+/**
+ * Get the statistics of the functions that have been called so far.
+ *
+ * \param [out] stats array of at least \p max_count entries
+ * \param [in] max_count
+ *
+ * \return number of entries written in \p stats
+ */
+size_t erpc_esp_profiler_get_stats(
+	struct erpc_esp_profiler_function_stats *stats, size_t max_count);
+
+/**
+ * Number of calls whose statistics have been dropped because the table of
+ * functions is full (see CONFIG_ERPC_ESP_PROFILER_MAX_FUNCTIONS).
+ */
+uint32_t erpc_esp_profiler_get_dropped(void);
+
+/**
+ * Clear all the statistics
+ */
+void erpc_esp_profiler_reset(void);
+
+/**
+ * Print the statistics using ESP_LOGI
+ */
+void erpc_esp_profiler_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_PROFILER_H_ */
@@ -0,0 +1,37 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		profiler_setup.cpp
+ *
+ * \brief		eRPC profiler setup functions
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_esp_profiler.h"
+
+#include "profiler_stats.h"
+#include "profiler_transport.hpp"
+
+#include "erpc_manually_constructed.hpp"
+
+using namespace erpc;
+using namespace erpc::esp;
+
+static ManuallyConstructed<ProfilerTransport> s_transport;
+
+erpc_transport_t erpc_esp_profiler_transport_init(erpc_transport_t transport) {
+	s_transport.construct(reinterpret_cast<Transport *>(transport));
+	return reinterpret_cast<erpc_transport_t>(s_transport.get());
+}
+
+void erpc_esp_profiler_attach_server(erpc_server_t server) {
+	erpc_server_add_pre_cb_action(server, profiler_stats_pre_cb);
+	erpc_server_add_post_cb_action(server, profiler_stats_post_cb);
+}
@@ -0,0 +1,312 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		profiler_stats.c
+ *
+ * \brief		eRPC profiler statistics
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_esp_profiler.h"
+#include "profiler_stats.h"
+
+#include "erpc_esp/utils.h"
+#include "erpc_esp_pool_server.h"
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#define TAG "erpc_esp_profiler"
+#include "esp_log.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !CONFIG_ERPC_PRE_POST_ACTION
+#error "erpc_esp_profiler requires CONFIG_ERPC_PRE_POST_ACTION"
+#endif
+
+#define MAX_FUNCTIONS CONFIG_ERPC_ESP_PROFILER_MAX_FUNCTIONS
+#define MAX_CALLS CONFIG_ERPC_ESP_PROFILER_MAX_CONCURRENT_CALLS
+
+#define NO_FUNCTION UINT16_MAX
+
+/**
+ * The last request received by a task, whose handler has not been started
+ * yet
+ */
+struct pending_call {
+	TaskHandle_t task;
+	uint16_t function;
+};
+
+/**
+ * A handler that is being executed
+ */
+struct active_call {
+	TaskHandle_t task;
+	uint16_t function;
+	int64_t start;
+};
+
+static struct {
+	erpc_esp_freertos_critical_section_lock lock;
+	struct erpc_esp_profiler_function_stats functions[MAX_FUNCTIONS];
+	uint16_t function_count;
+	uint32_t dropped;
+	/**
+	 * Except for the pool server, whose workers tell which request they are
+	 * handling, the handler runs on the task that received the request,
+	 * before it receives the next one. So the pre action callback belongs to
+	 * the last request received by its task, and a request that never reaches
+	 * its handler (e.g. of an unknown service) is replaced by the next one.
+	 */
+	struct pending_call pending[MAX_CALLS];
+	struct active_call active[MAX_CALLS];
+} s_profiler = {
+	.lock = ERPC_ESP_FREERTOS_CRITICAL_SECTION_LOCK_INIT,
+};
+
+/**
+ * Must be called inside the critical section.
+ *
+ * \return index of the stats of the given function, or NO_FUNCTION if the
+ * table is full
+ */
+static uint16_t find_function(uint8_t service, uint8_t function) {
+	for (uint16_t i = 0; i < s_profiler.function_count; ++i) {
+		if (s_profiler.functions[i].service == service &&
+			s_profiler.functions[i].function == function) {
+			return i;
+		}
+	}
+	if (s_profiler.function_count == MAX_FUNCTIONS) {
+		return NO_FUNCTION;
+	}
+
+	struct erpc_esp_profiler_function_stats *stats =
+		&s_profiler.functions[s_profiler.function_count];
+	memset(stats, 0, sizeof(*stats));
+	stats->service = service;
+	stats->function = function;
+	stats->min_us = UINT32_MAX;
+	return s_profiler.function_count++;
+}
+
+static unsigned histogram_bucket(uint32_t us) {
+	unsigned bucket = 0;
+	while (us >= 2 && bucket < ERPC_ESP_PROFILER_HISTOGRAM_BUCKETS - 1) {
+		us >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+
+/**
+ * Must be called inside the critical section.
+ *
+ * \return index of the function of the last request received by \p task,
+ * or NO_FUNCTION if none
+ */
+static uint16_t take_pending(TaskHandle_t task) {
+	for (unsigned i = 0; i < MAX_CALLS; ++i) {
+		if (s_profiler.pending[i].task == task) {
+			s_profiler.pending[i].task = NULL;
+			return s_profiler.pending[i].function;
+		}
+	}
+	return NO_FUNCTION;
+}
+
+void profiler_stats_on_request(const struct erpc_esp_message_header *header,
+							   uint32_t size) {
+	TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+	erpc_esp_freertos_critical_enter(&s_profiler.lock);
+	uint16_t index = find_function(header->service, header->request);
+	if (index != NO_FUNCTION) {
+		++s_profiler.functions[index].requests;
+		s_profiler.functions[index].bytes_in += size;
+	} else {
+		++s_profiler.dropped;
+	}
+
+	struct pending_call *slot = NULL;
+	for (unsigned i = 0; i < MAX_CALLS; ++i) {
+		if (s_profiler.pending[i].task == task) {
+			// Previous request of this task never handled
+			slot = &s_profiler.pending[i];
+			break;
+		}
+		if (slot == NULL && s_profiler.pending[i].task == NULL) {
+			slot = &s_profiler.pending[i];
+		}
+	}
+	if (slot != NULL) {
+		slot->task = task;
+		slot->function = index;
+	}
+	erpc_esp_freertos_critical_exit(&s_profiler.lock);
+}
+
+void profiler_stats_on_reply(const struct erpc_esp_message_header *header,
+							 uint32_t size) {
+	erpc_esp_freertos_critical_enter(&s_profiler.lock);
+	uint16_t index = find_function(header->service, header->request);
+	if (index != NO_FUNCTION) {
+		s_profiler.functions[index].bytes_out += size;
+	}
+	erpc_esp_freertos_critical_exit(&s_profiler.lock);
+}
+
+void profiler_stats_pre_cb(void) {
+	TaskHandle_t task = xTaskGetCurrentTaskHandle();
+	uint32_t service = 0;
+	uint32_t function = 0;
+#if CONFIG_ERPC_THREADS_NONE
+	bool pooled = false;
+#else
+	bool pooled = erpc_esp_pool_server_current_request(&service, &function);
+#endif
+	int64_t now = esp_timer_get_time();
+
+	erpc_esp_freertos_critical_enter(&s_profiler.lock);
+	uint16_t index = pooled ? find_function(service, function)
+							: take_pending(task);
+	struct active_call *slot = NULL;
+	for (unsigned i = 0; i < MAX_CALLS; ++i) {
+		if (s_profiler.active[i].task == task) {
+			// Previous call of this task never completed
+			slot = &s_profiler.active[i];
+			break;
+		}
+		if (slot == NULL && s_profiler.active[i].task == NULL) {
+			slot = &s_profiler.active[i];
+		}
+	}
+	if (slot != NULL) {
+		slot->task = task;
+		slot->function = index;
+		slot->start = now;
+	}
+	erpc_esp_freertos_critical_exit(&s_profiler.lock);
+}
+
+void profiler_stats_post_cb(void) {
+	TaskHandle_t task = xTaskGetCurrentTaskHandle();
+	int64_t now = esp_timer_get_time();
+
+	erpc_esp_freertos_critical_enter(&s_profiler.lock);
+	for (unsigned i = 0; i < MAX_CALLS; ++i) {
+		struct active_call *call = &s_profiler.active[i];
+		if (call->task != task) {
+			continue;
+		}
+		call->task = NULL;
+		if (call->function == NO_FUNCTION) {
+			break;
+		}
+
+		struct erpc_esp_profiler_function_stats *stats =
+			&s_profiler.functions[call->function];
+		uint32_t latency = (uint32_t)(now - call->start);
+		++stats->calls;
+		stats->total_us += latency;
+		if (latency < stats->min_us) {
+			stats->min_us = latency;
+		}
+		if (latency > stats->max_us) {
+			stats->max_us = latency;
+		}
+		++stats->histogram[histogram_bucket(latency)];
+		break;
+	}
+	erpc_esp_freertos_critical_exit(&s_profiler.lock);
+}
+
+size_t erpc_esp_profiler_get_stats(
+	struct erpc_esp_profiler_function_stats *stats, size_t max_count) {
+	erpc_esp_freertos_critical_enter(&s_profiler.lock);
+	size_t count = s_profiler.function_count;
+	if (count > max_count) {
+		count = max_count;
+	}
+	memcpy(stats, s_profiler.functions, count * sizeof(*stats));
+	erpc_esp_freertos_critical_exit(&s_profiler.lock);
+	return count;
+}
+
+uint32_t erpc_esp_profiler_get_dropped(void) {
+	erpc_esp_freertos_critical_enter(&s_profiler.lock);
+	uint32_t dropped = s_profiler.dropped;
+	erpc_esp_freertos_critical_exit(&s_profiler.lock);
+	return dropped;
+}
+
+void erpc_esp_profiler_reset(void) {
+	erpc_esp_freertos_critical_enter(&s_profiler.lock);
+	/*
+	 * Calls in flight keep pointing to their table entry, so keep the entries
+	 * and only clear their counters.
+	 */
+	for (uint16_t i = 0; i < s_profiler.function_count; ++i) {
+		struct erpc_esp_profiler_function_stats *stats =
+			&s_profiler.functions[i];
+		uint8_t service = stats->service;
+		uint8_t function = stats->function;
+		memset(stats, 0, sizeof(*stats));
+		stats->service = service;
+		stats->function = function;
+		stats->min_us = UINT32_MAX;
+	}
+	s_profiler.dropped = 0;
+	erpc_esp_freertos_critical_exit(&s_profiler.lock);
+}
+
+void erpc_esp_profiler_dump(void) {
+	struct erpc_esp_profiler_function_stats stats;
+
+	ESP_LOGI(TAG, "%4s %4s %8s %8s %8s %8s %8s %10s %10s", "svc", "fn",
+			 "requests", "calls", "min_us", "mean_us", "max_us", "bytes_in",
+			 "bytes_out");
+	for (uint16_t i = 0; i < MAX_FUNCTIONS; ++i) {
+		// Copy one entry at a time, to keep the critical section short
+		erpc_esp_freertos_critical_enter(&s_profiler.lock);
+		bool valid = i < s_profiler.function_count;
+		if (valid) {
+			stats = s_profiler.functions[i];
+		}
+		erpc_esp_freertos_critical_exit(&s_profiler.lock);
+		if (!valid) {
+			break;
+		}
+
+		uint32_t mean = stats.calls > 0 ? stats.total_us / stats.calls : 0;
+		ESP_LOGI(TAG,
+				 "%4u %4u %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32
+				 " %8" PRIu32 " %10" PRIu64 " %10" PRIu64,
+				 stats.service, stats.function, stats.requests, stats.calls,
+				 stats.calls > 0 ? stats.min_us : 0, mean, stats.max_us,
+				 stats.bytes_in, stats.bytes_out);
+
+		char histogram[ERPC_ESP_PROFILER_HISTOGRAM_BUCKETS * 11 + 1];
+		size_t len = 0;
+		for (unsigned b = 0; b < ERPC_ESP_PROFILER_HISTOGRAM_BUCKETS; ++b) {
+			len += snprintf(histogram + len, sizeof(histogram) - len,
+							" %" PRIu32, stats.histogram[b]);
+		}
+		ESP_LOGI(TAG, "          log2(us) histogram:%s", histogram);
+	}
+	ESP_LOGI(TAG, "dropped: %" PRIu32, erpc_esp_profiler_get_dropped());
+}
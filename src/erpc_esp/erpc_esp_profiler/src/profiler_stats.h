@@ -0,0 +1,50 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		profiler_stats.h
+ *
+ * \brief		eRPC profiler statistics - private interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_PROFILER_STATS_H_
+#define ERPC_ESP_PROFILER_STATS_H_
+
+#include "erpc_esp_message_header.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A request has been received by the calling task
+ */
+void profiler_stats_on_request(const struct erpc_esp_message_header *header,
+							   uint32_t size);
+/**
+ * A reply has been sent
+ */
+void profiler_stats_on_reply(const struct erpc_esp_message_header *header,
+							 uint32_t size);
+/**
+ * Pre action callback: a handler is about to be invoked
+ */
+void profiler_stats_pre_cb(void);
+/**
+ * Post action callback: a handler has returned
+ */
+void profiler_stats_post_cb(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_PROFILER_STATS_H_ */
@@ -0,0 +1,70 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		profiler_transport.cpp
+ *
+ * \brief		eRPC profiler transport class - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "profiler_transport.hpp"
+
+#include "profiler_stats.h"
+
+using namespace erpc::esp;
+
+ProfilerTransport::ProfilerTransport(Transport *transport)
+	: m_transport(transport) {
+}
+
+ProfilerTransport::~ProfilerTransport(void) {
+}
+
+erpc_status_t ProfilerTransport::receive(MessageBuffer *message) {
+	erpc_status_t status = this->m_transport->receive(message);
+	if (status != kErpcStatus_Success) {
+		return status;
+	}
+
+	struct erpc_esp_message_header header;
+	if (erpc_esp_message_header_decode(message->get(), message->getUsed(),
+									   &header) &&
+		(header.type == ERPC_ESP_MESSAGE_TYPE_INVOCATION ||
+		 header.type == ERPC_ESP_MESSAGE_TYPE_ONEWAY)) {
+		profiler_stats_on_request(&header, message->getUsed());
+	}
+	return status;
+}
+
+erpc_status_t ProfilerTransport::send(MessageBuffer *message) {
+	/*
+	 * Decode before sending: the wrapped transport may release or reuse the
+	 * buffer.
+	 */
+	struct erpc_esp_message_header header;
+	uint32_t size = message->getUsed();
+	bool is_reply =
+		erpc_esp_message_header_decode(message->get(), size, &header) &&
+		header.type == ERPC_ESP_MESSAGE_TYPE_REPLY;
+
+	erpc_status_t status = this->m_transport->send(message);
+	if (status == kErpcStatus_Success && is_reply) {
+		profiler_stats_on_reply(&header, size);
+	}
+	return status;
+}
+
+bool ProfilerTransport::hasMessage(void) {
+	return this->m_transport->hasMessage();
+}
+
+void ProfilerTransport::setCrc16(Crc16 *crcImpl) {
+	this->m_transport->setCrc16(crcImpl);
+}
@@ -0,0 +1,65 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		profiler_transport.hpp
+ *
+ * \brief		eRPC profiler transport class - interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_PROFILER_TRANSPORT_HPP_H_
+#define ERPC_ESP_PROFILER_TRANSPORT_HPP_H_
+
+#include "erpc_transport.hpp"
+
+namespace erpc {
+namespace esp {
+
+/*!
+ * @brief Transport decorator that feeds the profiler with the requests
+ * received and the replies sent through the wrapped transport.
+ */
+class ProfilerTransport : public Transport {
+  public:
+	/*!
+	 * @brief Constructor.
+	 *
+	 * @param [in] transport wrapped transport
+	 */
+	explicit ProfilerTransport(Transport *transport);
+
+	/*!
+	 * @brief Destructor.
+	 */
+	virtual ~ProfilerTransport(void);
+
+	/*!
+	 * @brief Receive a message from the wrapped transport. Requests are
+	 * recorded, so that the next pre action callback knows which function is
+	 * being called.
+	 */
+	virtual erpc_status_t receive(MessageBuffer *message) override;
+
+	/*!
+	 * @brief Send a message through the wrapped transport. The size of
+	 * replies is recorded.
+	 */
+	virtual erpc_status_t send(MessageBuffer *message) override;
+
+	virtual bool hasMessage(void) override;
+
+	virtual void setCrc16(Crc16 *crcImpl) override;
+
+  private:
+	Transport *m_transport;
+};
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_ESP_PROFILER_TRANSPORT_HPP_H_ */
@@ -0,0 +1,233 @@
+"""
+Decoder of the dumps of the erpc_esp_trace component.
+
+See erpc_esp_trace.h for the dump format.
+"""
+
+import re
+import struct
+from dataclasses import dataclass, field
+from typing import Dict, Iterable, List, Optional, Tuple
+
+DUMP_MAGIC = b"ERTR"
+DUMP_VERSION = 1
+HEADER_FORMAT = "<4sBBHII"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+RECORD_HEADER_FORMAT = "<IHBB"
+RECORD_HEADER_SIZE = struct.calcsize(RECORD_HEADER_FORMAT)
+
+FLAG_OUT = 1 << 0
+FLAG_CLIENT = 1 << 1
+
+MESSAGE_TYPES = {0: "invocation", 1: "oneway", 2: "reply", 3: "notification"}
+
+# First byte of the header written by CompactCodec: marker and message type
+COMPACT_HEADER_MARKER = 0xC0
+COMPACT_HEADER_MARKER_MASK = 0xFC
+COMPACT_HEADER_TYPE_MASK = 0x03
+# Maximum size of the varint of a uint32
+VARINT32_MAX_SIZE = 5
+
+TRACE_LOG_PATTERN = re.compile(r"erpc_esp_trace:\sTRACE\s([0-9a-fA-F]+)")
+
+
+class TraceDecodeError(Exception):
+    pass
+
+
+@dataclass
+class TraceRecord:
+    timestamp_us: int
+    """
+    Timestamp in us, unwrapped, relative to the first record of the dump
+    """
+    length: int
+    """
+    Original length of the message
+    """
+    flags: int
+    data: bytes
+    """
+    Captured bytes of the message
+    """
+
+    @property
+    def outgoing(self) -> bool:
+        return bool(self.flags & FLAG_OUT)
+
+    @property
+    def client(self) -> bool:
+        return bool(self.flags & FLAG_CLIENT)
+
+    def header(self) -> Optional[Tuple[str, int, int, int]]:
+        """
+        Decode the eRPC message header, written by BasicCodec or by
+        CompactCodec. Same as erpc_esp_message_header_decode.
+
+        :return: (type, service, function, sequence) or None if the captured
+        bytes don't contain a valid header
+        """
+        if (
+            len(self.data) > 0
+            and self.data[0] & COMPACT_HEADER_MARKER_MASK == COMPACT_HEADER_MARKER
+        ):
+            return self._compact_header()
+        if len(self.data) < 8:
+            return None
+        word, sequence = struct.unpack_from("<II", self.data)
+        if (word >> 24) != 1 or (word & 0xFF) not in MESSAGE_TYPES:
+            return None
+        return (
+            MESSAGE_TYPES[word & 0xFF],
+            (word >> 16) & 0xFF,
+            (word >> 8) & 0xFF,
+            sequence,
+        )
+
+    def _compact_header(self) -> Optional[Tuple[str, int, int, int]]:
+        sequence = 0
+        for i, byte in enumerate(self.data[3 : 3 + VARINT32_MAX_SIZE]):
+            sequence |= (byte & 0x7F) << (7 * i)
+            if not byte & 0x80:
+                return (
+                    MESSAGE_TYPES[self.data[0] & COMPACT_HEADER_TYPE_MASK],
+                    self.data[1],
+                    self.data[2],
+                    sequence & 0xFFFFFFFF,
+                )
+        return None
+
+
+@dataclass
+class TraceDump:
+    written: int
+    """
+    Records written by the target since boot or reset
+    """
+    dropped: int
+    """
+    Records dropped because they were logged while dumping
+    """
+    records: List[TraceRecord] = field(default_factory=list)
+
+    @property
+    def overwritten(self) -> int:
+        """
+        Records lost because the ring buffer wrapped around
+        """
+        return self.written - len(self.records)
+
+
+def decode(data: bytes) -> TraceDump:
+    """
+    Decode a binary dump produced by erpc_esp_trace_dump
+    """
+    if len(data) < HEADER_SIZE:
+        raise TraceDecodeError("Dump too short")
+    magic, version, capture_size, count, written, dropped = struct.unpack_from(
+        HEADER_FORMAT, data
+    )
+    if magic != DUMP_MAGIC:
+        raise TraceDecodeError("Bad magic {}".format(magic))
+    if version != DUMP_VERSION:
+        raise TraceDecodeError("Unsupported version {}".format(version))
+    record_size = RECORD_HEADER_SIZE + capture_size
+    if len(data) < HEADER_SIZE + count * record_size:
+        raise TraceDecodeError("Truncated dump")
+
+    dump = TraceDump(written=written, dropped=dropped)
+    offset = HEADER_SIZE
+    previous = None
+    now = 0
+    for _ in range(count):
+        timestamp, length, flags, captured = struct.unpack_from(
+            RECORD_HEADER_FORMAT, data, offset
+        )
+        payload_offset = offset + RECORD_HEADER_SIZE
+        payload = bytes(data[payload_offset : payload_offset + captured])
+        offset += record_size
+
+        # The target only keeps the low 32 bits of the timestamp, a delta over
+        # half the range is a record taken slightly earlier than the previous
+        if previous is not None:
+            delta = (timestamp - previous) & 0xFFFFFFFF
+            if delta >= 1 << 31:
+                delta -= 1 << 32
+            now += delta
+        previous = timestamp
+        dump.records.append(TraceRecord(now, length, flags, payload))
+    return dump
+
+
+def parse_log(lines: Iterable[str]) -> bytes:
+    """
+    Extract the binary dump from the output of erpc_esp_trace_dump_to_log.
+    If the log contains more dumps, the last one is returned.
+    """
+    data = bytearray()
+    for line in lines:
+        if "erpc_esp_trace: TRACE BEGIN" in line:
+            data = bytearray()
+            continue
+        match = TRACE_LOG_PATTERN.search(line)
+        if match:
+            data += bytes.fromhex(match.group(1))
+    return bytes(data)
+
+
+@dataclass
+class FunctionLatency:
+    count: int = 0
+    total_us: int = 0
+    min_us: Optional[int] = None
+    max_us: int = 0
+
+    def add(self, latency_us: int):
+        self.count += 1
+        self.total_us += latency_us
+        self.max_us = max(self.max_us, latency_us)
+        if self.min_us is None or latency_us < self.min_us:
+            self.min_us = latency_us
+
+
+def timeline(
+    dump: TraceDump,
+) -> Tuple[List[str], Dict[Tuple[str, int, int], FunctionLatency]]:
+    """
+    Turn a dump into a human readable timeline.
+
+    Requests are matched with their replies by role, interface, function and
+    sequence number. For servers the latency is the time between the request
+    received and the reply sent, for clients it is the round trip time.
+
+    :return: lines of the timeline and latency statistics per (role,
+    interface, function)
+    """
+    lines = []
+    latencies: Dict[Tuple[str, int, int], FunctionLatency] = {}
+    pending: Dict[Tuple[str, int, int, int], int] = {}
+    for record in dump.records:
+        role = "client" if record.client else "server"
+        direction = "OUT" if record.outgoing else "IN "
+        line = "{:>12.3f} ms {} {} len={:<5}".format(
+            record.timestamp_us / 1000, direction, role, record.length
+        )
+        header = record.header()
+        if header is None:
+            lines.append(line + " " + record.data.hex())
+            continue
+        msg_type, service, function, sequence = header
+        line += " {:<12} svc={} fn={} seq={}".format(
+            msg_type, service, function, sequence
+        )
+        key = (role, service, function, sequence)
+        if msg_type == "invocation":
+            pending[key] = record.timestamp_us
+        elif msg_type == "reply" and key in pending:
+            latency = record.timestamp_us - pending.pop(key)
+            latencies.setdefault(
+                (role, service, function), FunctionLatency()
+            ).add(latency)
+            line += " latency={} us".format(latency)
+        lines.append(line)
+    return lines, latencies
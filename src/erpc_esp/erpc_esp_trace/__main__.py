@@ -0,0 +1,57 @@
+import argparse
+import sys
+
+from . import decode, parse_log, timeline
+
+if __name__ == "__main__":
+    arg_parser = argparse.ArgumentParser(
+        description="Decode a dump of the erpc_esp_trace ring buffer"
+    )
+    arg_parser.add_argument("dump", help="Dump file, '-' for stdin")
+    arg_parser.add_argument(
+        "--log",
+        action="store_true",
+        help="The dump is a log produced by erpc_esp_trace_dump_to_log",
+    )
+    args = arg_parser.parse_args()
+
+    if args.log:
+        if args.dump == "-":
+            data = parse_log(sys.stdin)
+        else:
+            with open(args.dump, "r", errors="ignore") as f:
+                data = parse_log(f)
+    elif args.dump == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.dump, "rb") as f:
+            data = f.read()
+
+    dump = decode(data)
+    lines, latencies = timeline(dump)
+    print(
+        "{} records, {} overwritten, {} dropped while dumping".format(
+            len(dump.records), dump.overwritten, dump.dropped
+        )
+    )
+    for line in lines:
+        print(line)
+    if latencies:
+        print()
+        print(
+            "{:<6} {:>4} {:>4} {:>8} {:>10} {:>10} {:>10}".format(
+                "role", "svc", "fn", "calls", "min_us", "mean_us", "max_us"
+            )
+        )
+        for (role, service, function), stats in sorted(latencies.items()):
+            print(
+                "{:<6} {:>4} {:>4} {:>8} {:>10} {:>10.1f} {:>10}".format(
+                    role,
+                    service,
+                    function,
+                    stats.count,
+                    stats.min_us,
+                    stats.total_us / stats.count,
+                    stats.max_us,
+                )
+            )
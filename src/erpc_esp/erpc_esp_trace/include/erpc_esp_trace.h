@@ -0,0 +1,121 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_esp_trace.h
+ *
+ * \brief		Binary trace of eRPC messages in a RAM ring buffer
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_TRACE_H_
+#define ERPC_ESP_TRACE_H_
+
+#include "erpc_client_setup.h"
+#include "erpc_server_setup.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Version of the dump format. Must be kept in sync with the Python decoder.
+ */
+#define ERPC_ESP_TRACE_DUMP_VERSION 1
+
+/**
+ * Size of the header of a dump.
+ *
+ * The header is made of (all fields little endian):
+ * - magic "ERTR";
+ * - u8 dump format version;
+ * - u8 capture size (CONFIG_ERPC_ESP_TRACE_CAPTURE_SIZE);
+ * - u16 number of records in the dump;
+ * - u32 number of records written since boot or since the last reset;
+ * - u32 number of records dropped because the trace was being dumped.
+ *
+ * It is followed by the records, oldest first. Each record is made of:
+ * - u32 timestamp, low 32 bits of esp_timer_get_time();
+ * - u16 original message length;
+ * - u8 flags, see erpc_esp_trace_flags;
+ * - u8 number of bytes captured;
+ * - capture size bytes: the first bytes of the message, zero padded.
+ */
+#define ERPC_ESP_TRACE_DUMP_HEADER_SIZE 16
+
+/**
+ * Size of a record in a dump
+ */
+#define ERPC_ESP_TRACE_DUMP_RECORD_SIZE(capture_size) (8 + (capture_size))
+
+enum erpc_esp_trace_flags {
+	/**
+	 * The message has been sent. Otherwise it has been received.
+	 */
+	ERPC_ESP_TRACE_FLAG_OUT = 1 << 0,
+	/**
+	 * The message has been logged by a client. Otherwise by a server.
+	 */
+	ERPC_ESP_TRACE_FLAG_CLIENT = 1 << 1,
+};
+
+/**
+ * Record the messages handled by \p server.
+ *
+ * \return false if the message logger could not be added
+ */
+bool erpc_esp_trace_attach_server(erpc_server_t server);
+
+/**
+ * Record the messages handled by \p client.
+ *
+ * \return false if the message logger could not be added
+ */
+bool erpc_esp_trace_attach_client(erpc_client_t client);
+
+/**
+ * Enable or disable the recording. It is enabled by default.
+ */
+void erpc_esp_trace_set_enabled(bool enabled);
+
+/**
+ * Clear the trace
+ */
+void erpc_esp_trace_reset(void);
+
+/**
+ * Size of the buffer needed by erpc_esp_trace_dump for the whole ring.
+ */
+size_t erpc_esp_trace_dump_size(void);
+
+/**
+ * Copy the trace into \p buffer, in the format described in
+ * #ERPC_ESP_TRACE_DUMP_HEADER_SIZE. If \p size is too small, only the most
+ * recent records are copied.
+ *
+ * Messages logged while dumping are not recorded, but counted as dropped.
+ *
+ * \return number of bytes written, 0 if \p size is smaller than the header
+ */
+size_t erpc_esp_trace_dump(uint8_t *buffer, size_t size);
+
+/**
+ * Print the dump as hex strings using ESP_LOGI, e.g. to collect it from the
+ * serial monitor. The Python decoder accepts such logs with `--log`.
+ */
+void erpc_esp_trace_dump_to_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_TRACE_H_ */
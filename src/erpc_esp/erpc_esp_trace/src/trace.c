@@ -0,0 +1,219 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		trace.c
+ *
+ * \brief		eRPC trace ring buffer
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_esp_trace.h"
+#include "trace.h"
+
+#include "erpc_esp_message_header.h"
+
+#include "erpc_esp/utils.h"
+
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#define TAG "erpc_esp_trace"
+#include "esp_log.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if !CONFIG_ERPC_MESSAGE_LOGGING
+#error "erpc_esp_trace requires CONFIG_ERPC_MESSAGE_LOGGING"
+#endif
+
+#define SLOT_COUNT CONFIG_ERPC_ESP_TRACE_SLOT_COUNT
+#define CAPTURE_SIZE CONFIG_ERPC_ESP_TRACE_CAPTURE_SIZE
+
+/**
+ * Same layout as the records of the dump
+ */
+struct record {
+	uint32_t timestamp;
+	uint16_t length;
+	uint8_t flags;
+	uint8_t captured;
+	uint8_t data[CAPTURE_SIZE];
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct record) ==
+				   ERPC_ESP_TRACE_DUMP_RECORD_SIZE(CAPTURE_SIZE),
+			   "Unexpected trace record layout");
+
+static struct {
+	erpc_esp_freertos_critical_section_lock lock;
+	struct record records[SLOT_COUNT];
+	/**
+	 * Records written so far. The next record goes to
+	 * `records[written % SLOT_COUNT]`.
+	 */
+	uint32_t written;
+	uint32_t dropped;
+	bool enabled;
+	/**
+	 * Set while dumping, so that the records being copied are not
+	 * overwritten.
+	 */
+	bool dumping;
+} s_trace = {
+	.lock = ERPC_ESP_FREERTOS_CRITICAL_SECTION_LOCK_INIT,
+	.enabled = true,
+};
+
+void trace_record(bool client, const uint8_t *data, uint32_t size) {
+	uint8_t captured = size < CAPTURE_SIZE ? size : CAPTURE_SIZE;
+	/*
+	 * Servers receive requests and send replies, clients do the opposite
+	 */
+	struct erpc_esp_message_header header;
+	bool request = erpc_esp_message_header_decode(data, size, &header) &&
+				   (header.type == ERPC_ESP_MESSAGE_TYPE_INVOCATION ||
+					header.type == ERPC_ESP_MESSAGE_TYPE_ONEWAY);
+	uint8_t flags = client ? ERPC_ESP_TRACE_FLAG_CLIENT : 0;
+	if (request == client) {
+		flags |= ERPC_ESP_TRACE_FLAG_OUT;
+	}
+
+	erpc_esp_freertos_critical_enter(&s_trace.lock);
+	if (s_trace.dumping) {
+		++s_trace.dropped;
+	} else if (s_trace.enabled) {
+		struct record *r = &s_trace.records[s_trace.written % SLOT_COUNT];
+		++s_trace.written;
+		/*
+		 * Sampled with the slot, so the records of concurrent tasks stay
+		 * ordered by time
+		 */
+		r->timestamp = (uint32_t)esp_timer_get_time();
+		r->length = size > UINT16_MAX ? UINT16_MAX : size;
+		r->flags = flags;
+		r->captured = captured;
+		memcpy(r->data, data, captured);
+		memset(r->data + captured, 0, CAPTURE_SIZE - captured);
+	}
+	erpc_esp_freertos_critical_exit(&s_trace.lock);
+}
+
+void erpc_esp_trace_set_enabled(bool enabled) {
+	erpc_esp_freertos_critical_enter(&s_trace.lock);
+	s_trace.enabled = enabled;
+	erpc_esp_freertos_critical_exit(&s_trace.lock);
+}
+
+void erpc_esp_trace_reset(void) {
+	erpc_esp_freertos_critical_enter(&s_trace.lock);
+	s_trace.written = 0;
+	s_trace.dropped = 0;
+	erpc_esp_freertos_critical_exit(&s_trace.lock);
+}
+
+size_t erpc_esp_trace_dump_size(void) {
+	return ERPC_ESP_TRACE_DUMP_HEADER_SIZE +
+		   SLOT_COUNT * sizeof(struct record);
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+	put_u16(p, v & 0xFFFF);
+	put_u16(p + 2, v >> 16);
+}
+
+static void put_header(uint8_t *p, uint16_t count, uint32_t written,
+					   uint32_t dropped) {
+	memcpy(p, "ERTR", 4);
+	p[4] = ERPC_ESP_TRACE_DUMP_VERSION;
+	p[5] = CAPTURE_SIZE;
+	put_u16(p + 6, count);
+	put_u32(p + 8, written);
+	put_u32(p + 12, dropped);
+}
+
+/**
+ * Stop recording, so that the records can be read without holding the lock.
+ *
+ * \param [out] dropped number of records dropped so far
+ *
+ * \return number of records written so far
+ */
+static uint32_t dump_begin(uint32_t *dropped) {
+	erpc_esp_freertos_critical_enter(&s_trace.lock);
+	s_trace.dumping = true;
+	uint32_t written = s_trace.written;
+	*dropped = s_trace.dropped;
+	erpc_esp_freertos_critical_exit(&s_trace.lock);
+	return written;
+}
+
+static void dump_end(void) {
+	erpc_esp_freertos_critical_enter(&s_trace.lock);
+	s_trace.dumping = false;
+	erpc_esp_freertos_critical_exit(&s_trace.lock);
+}
+
+size_t erpc_esp_trace_dump(uint8_t *buffer, size_t size) {
+	if (size < ERPC_ESP_TRACE_DUMP_HEADER_SIZE) {
+		return 0;
+	}
+
+	uint32_t dropped;
+	uint32_t written = dump_begin(&dropped);
+	uint32_t count = written < SLOT_COUNT ? written : SLOT_COUNT;
+	size_t max_count =
+		(size - ERPC_ESP_TRACE_DUMP_HEADER_SIZE) / sizeof(struct record);
+	if (count > max_count) {
+		count = max_count;
+	}
+	uint8_t *p = buffer + ERPC_ESP_TRACE_DUMP_HEADER_SIZE;
+	for (uint32_t i = written - count; i != written; ++i) {
+		memcpy(p, &s_trace.records[i % SLOT_COUNT], sizeof(struct record));
+		p += sizeof(struct record);
+	}
+	dump_end();
+
+	put_header(buffer, count, written, dropped);
+	return p - buffer;
+}
+
+static void log_hex(const uint8_t *data, size_t size) {
+	char hex[sizeof(struct record) * 2 + 1];
+
+	for (size_t i = 0; i < size; ++i) {
+		sprintf(hex + 2 * i, "%02x", data[i]);
+	}
+	ESP_LOGI(TAG, "TRACE %s", hex);
+}
+
+void erpc_esp_trace_dump_to_log(void) {
+	uint8_t header[ERPC_ESP_TRACE_DUMP_HEADER_SIZE];
+
+	uint32_t dropped;
+	uint32_t written = dump_begin(&dropped);
+	uint32_t count = written < SLOT_COUNT ? written : SLOT_COUNT;
+
+	// One line per record, so that no copy of the ring is needed
+	ESP_LOGI(TAG, "TRACE BEGIN");
+	put_header(header, count, written, dropped);
+	log_hex(header, sizeof(header));
+	for (uint32_t i = written - count; i != written; ++i) {
+		log_hex((const uint8_t *)&s_trace.records[i % SLOT_COUNT],
+				sizeof(struct record));
+	}
+	ESP_LOGI(TAG, "TRACE END");
+	dump_end();
+}
@@ -0,0 +1,39 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		trace.h
+ *
+ * \brief		eRPC trace ring buffer - private interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_TRACE_PRIV_H_
+#define ERPC_ESP_TRACE_PRIV_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Append a message to the ring buffer.
+ *
+ * \param [in] client true if the message has been logged by a client
+ * \param [in] data serialized message
+ * \param [in] size size of \p data
+ */
+void trace_record(bool client, const uint8_t *data, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_TRACE_PRIV_H_ */
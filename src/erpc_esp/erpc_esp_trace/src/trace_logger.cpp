@@ -0,0 +1,37 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		trace_logger.cpp
+ *
+ * \brief		eRPC trace message logger class - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "trace_logger.hpp"
+
+#include "trace.h"
+
+using namespace erpc::esp;
+
+TraceLogger::TraceLogger(bool client) : m_client(client) {
+}
+
+TraceLogger::~TraceLogger(void) {
+}
+
+erpc_status_t TraceLogger::receive(MessageBuffer *message) {
+	(void)message;
+	return kErpcStatus_ReceiveFailed;
+}
+
+erpc_status_t TraceLogger::send(MessageBuffer *message) {
+	trace_record(this->m_client, message->get(), message->getUsed());
+	return kErpcStatus_Success;
+}
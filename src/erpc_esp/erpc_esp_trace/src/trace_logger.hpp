@@ -0,0 +1,63 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		trace_logger.hpp
+ *
+ * \brief		eRPC trace message logger class - interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_TRACE_LOGGER_HPP_H_
+#define ERPC_ESP_TRACE_LOGGER_HPP_H_
+
+#include "erpc_transport.hpp"
+
+namespace erpc {
+namespace esp {
+
+/*!
+ * @brief Message logger that appends every logged message to the trace ring
+ * buffer.
+ *
+ * eRPC message loggers are transports, to which a copy of every message is
+ * sent.
+ */
+class TraceLogger : public Transport {
+  public:
+	/*!
+	 * @brief Constructor.
+	 *
+	 * @param [in] client true if the logger is added to a client, false if
+	 * it is added to a server
+	 */
+	explicit TraceLogger(bool client);
+
+	virtual ~TraceLogger(void);
+
+	/*!
+	 * @brief Not supported.
+	 *
+	 * @retval kErpcStatus_ReceiveFailed always
+	 */
+	virtual erpc_status_t receive(MessageBuffer *message) override;
+
+	/*!
+	 * @brief Record the message in the trace ring buffer.
+	 *
+	 * @retval kErpcStatus_Success always
+	 */
+	virtual erpc_status_t send(MessageBuffer *message) override;
+
+  private:
+	bool m_client;
+};
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_ESP_TRACE_LOGGER_HPP_H_ */
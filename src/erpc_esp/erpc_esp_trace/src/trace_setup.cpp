@@ -0,0 +1,47 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		trace_setup.cpp
+ *
+ * \brief		eRPC trace setup functions
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_esp_trace.h"
+
+#include "trace_logger.hpp"
+
+#include "erpc_manually_constructed.hpp"
+
+using namespace erpc;
+using namespace erpc::esp;
+
+static ManuallyConstructed<TraceLogger> s_serverLogger;
+static bool s_serverLoggerConstructed = false;
+static ManuallyConstructed<TraceLogger> s_clientLogger;
+static bool s_clientLoggerConstructed = false;
+
+bool erpc_esp_trace_attach_server(erpc_server_t server) {
+	if (!s_serverLoggerConstructed) {
+		s_serverLogger.construct(false);
+		s_serverLoggerConstructed = true;
+	}
+	return erpc_server_add_message_logger(
+		server, reinterpret_cast<erpc_transport_t>(s_serverLogger.get()));
+}
+
+bool erpc_esp_trace_attach_client(erpc_client_t client) {
+	if (!s_clientLoggerConstructed) {
+		s_clientLogger.construct(true);
+		s_clientLoggerConstructed = true;
+	}
+	return erpc_client_add_message_logger(
+		client, reinterpret_cast<erpc_transport_t>(s_clientLogger.get()));
+}
@@ -4,16 +4,50 @@
 #include "freertos/FreeRTOS.h"
 #include "sdkconfig.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#if CONFIG_ERPC_ESP_CRITICAL_TRACE
+/**
+ * Call site of erpc_esp_freertos_critical_enter, statically allocated by the
+ * erpc_esp_freertos_critical_enter macro. Private, use
+ * erpc_esp_critical_trace_get_stats.
+ */
+struct erpc_esp_critical_site {
+	const char *file;
+	uint32_t line;
+	uint32_t count;
+	uint32_t max_ticks;
+	uint64_t total_ticks;
+	struct erpc_esp_critical_site *next;
+	uint8_t registered;
+};
+#endif
+
 typedef struct {
 #if CONFIG_IDF_TARGET_LINUX
 	char dummy;
 #else
 	portMUX_TYPE lock;
 #endif
+#if CONFIG_ERPC_ESP_CRITICAL_TRACE
+	/**
+	 * Call site of the outermost enter, NULL if not traced
+	 */
+	struct erpc_esp_critical_site *trace_site;
+	/**
+	 * Cycle counter (or us on linux) at the outermost enter
+	 */
+	uint32_t trace_start;
+	/**
+	 * Nesting level of the critical section
+	 */
+	uint32_t trace_depth;
+#endif
 } erpc_esp_freertos_critical_section_lock;
 
 #if CONFIG_IDF_TARGET_LINUX
@@ -29,6 +63,78 @@ void erpc_esp_freertos_critical_enter(
 void erpc_esp_freertos_critical_exit(
 	erpc_esp_freertos_critical_section_lock *handle);
 
+#if CONFIG_ERPC_ESP_CRITICAL_TRACE
+/**
+ * Statistics of a call site of erpc_esp_freertos_critical_enter
+ */
+struct erpc_esp_critical_site_stats {
+	/**
+	 * Source file of the call site
+	 */
+	const char *file;
+	/**
+	 * Source line of the call site
+	 */
+	uint32_t line;
+	/**
+	 * Number of times the critical section has been entered. Nested enters
+	 * of the same lock are not counted.
+	 */
+	uint32_t count;
+	/**
+	 * Maximum hold time in ns
+	 */
+	uint32_t max_ns;
+	/**
+	 * Sum of the hold times in ns. Divide by count to get the mean.
+	 */
+	uint64_t total_ns;
+};
+
+/**
+ * Enter the critical section, attributing its hold time to the given call
+ * site. Use erpc_esp_freertos_critical_enter instead.
+ */
+void erpc_esp_freertos_critical_enter_at(
+	erpc_esp_freertos_critical_section_lock *handle,
+	struct erpc_esp_critical_site *site);
+
+/**
+ * Every call site of erpc_esp_freertos_critical_enter gets its own statistics.
+ * Only the outermost enter of a lock is measured, until the matching exit.
+ */
+#define erpc_esp_freertos_critical_enter(handle)                               \
+	do {                                                                       \
+		static struct erpc_esp_critical_site erpc_esp_critical_site_ = {       \
+			__FILE__, __LINE__, 0, 0, 0, NULL, 0};                             \
+		erpc_esp_freertos_critical_enter_at((handle),                          \
+											&erpc_esp_critical_site_);         \
+	} while (0)
+
+/**
+ * Get the statistics of the call sites that have entered a critical section
+ * at least once
+ *
+ * \param[out] stats array filled with the statistics
+ * \param[in] max_count size of stats
+ *
+ * \return number of entries written to stats
+ */
+size_t
+erpc_esp_critical_trace_get_stats(struct erpc_esp_critical_site_stats *stats,
+								  size_t max_count);
+
+/**
+ * Clear all the statistics
+ */
+void erpc_esp_critical_trace_reset(void);
+
+/**
+ * Print the statistics using ESP_LOGI
+ */
+void erpc_esp_critical_trace_dump(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,9 +2,176 @@
 
 #include "freertos/task.h"
 
+#if CONFIG_ERPC_ESP_CRITICAL_TRACE
+#define TAG "erpc_esp_utils"
+#include "esp_log.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include "esp_timer.h"
+#else
+#include "esp_cpu.h"
+#include "esp_idf_version.h"
+#include "esp_rom_sys.h"
+#endif
+
+#include <inttypes.h>
+#include <string.h>
+
+// The functions below are the untraced versions
+#undef erpc_esp_freertos_critical_enter
+
+static struct {
+#if !CONFIG_IDF_TARGET_LINUX
+	/*
+	 * The same call site may enter the critical sections of different locks,
+	 * e.g. of two instances of a class, at the same time on both cores
+	 */
+	portMUX_TYPE lock;
+#endif
+	struct erpc_esp_critical_site *sites;
+} s_trace = {
+#if !CONFIG_IDF_TARGET_LINUX
+	.lock = portMUX_INITIALIZER_UNLOCKED,
+#endif
+};
+
+static inline uint32_t trace_ticks(void) {
+#if CONFIG_IDF_TARGET_LINUX
+	return (uint32_t)esp_timer_get_time();
+#elif ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+	return esp_cpu_get_cycle_count();
+#else
+	return esp_cpu_get_ccount();
+#endif
+}
+
+static inline uint32_t trace_ticks_per_us(void) {
+#if CONFIG_IDF_TARGET_LINUX
+	return 1;
+#else
+	return esp_rom_get_cpu_ticks_per_us();
+#endif
+}
+
+static void trace_lock(void) {
+#if CONFIG_IDF_TARGET_LINUX
+	taskENTER_CRITICAL();
+#else
+	taskENTER_CRITICAL(&s_trace.lock);
+#endif
+}
+
+static void trace_unlock(void) {
+#if CONFIG_IDF_TARGET_LINUX
+	taskEXIT_CRITICAL();
+#else
+	taskEXIT_CRITICAL(&s_trace.lock);
+#endif
+}
+
+/**
+ * Called with the critical section of handle held
+ */
+static void trace_exit(erpc_esp_freertos_critical_section_lock *handle) {
+	if (handle->trace_depth == 0 || --handle->trace_depth > 0 ||
+		handle->trace_site == NULL) {
+		return;
+	}
+	// Cycle counters are per core, but the critical section pins the task
+	uint32_t held = trace_ticks() - handle->trace_start;
+	struct erpc_esp_critical_site *site = handle->trace_site;
+	handle->trace_site = NULL;
+
+	trace_lock();
+	if (!site->registered) {
+		site->registered = 1;
+		site->next = s_trace.sites;
+		s_trace.sites = site;
+	}
+	++site->count;
+	site->total_ticks += held;
+	if (held > site->max_ticks) {
+		site->max_ticks = held;
+	}
+	trace_unlock();
+}
+
+void erpc_esp_freertos_critical_enter_at(
+	erpc_esp_freertos_critical_section_lock *handle,
+	struct erpc_esp_critical_site *site) {
+#if CONFIG_IDF_TARGET_LINUX
+	taskENTER_CRITICAL();
+#else
+	taskENTER_CRITICAL(&handle->lock);
+#endif
+	if (handle->trace_depth++ == 0) {
+		handle->trace_site = site;
+		handle->trace_start = trace_ticks();
+	}
+}
+
+size_t
+erpc_esp_critical_trace_get_stats(struct erpc_esp_critical_site_stats *stats,
+								  size_t max_count) {
+	uint32_t ticks_per_us = trace_ticks_per_us();
+	size_t count = 0;
+
+	trace_lock();
+	for (struct erpc_esp_critical_site *site = s_trace.sites;
+		 site != NULL && count < max_count; site = site->next) {
+		struct erpc_esp_critical_site_stats *s = &stats[count++];
+		s->file = site->file;
+		s->line = site->line;
+		s->count = site->count;
+		s->max_ns = (uint64_t)site->max_ticks * 1000 / ticks_per_us;
+		s->total_ns = site->total_ticks * 1000 / ticks_per_us;
+	}
+	trace_unlock();
+	return count;
+}
+
+void erpc_esp_critical_trace_reset(void) {
+	trace_lock();
+	for (struct erpc_esp_critical_site *site = s_trace.sites; site != NULL;
+		 site = site->next) {
+		site->count = 0;
+		site->max_ticks = 0;
+		site->total_ticks = 0;
+	}
+	trace_unlock();
+}
+
+void erpc_esp_critical_trace_dump(void) {
+	uint32_t ticks_per_us = trace_ticks_per_us();
+
+	ESP_LOGI(TAG, "%10s %10s %10s  %s", "count", "mean_ns", "max_ns", "site");
+	trace_lock();
+	struct erpc_esp_critical_site *site = s_trace.sites;
+	trace_unlock();
+	// Sites are only prepended, so the list can be walked without the lock
+	for (; site != NULL; site = site->next) {
+		// Copy one entry at a time, to keep the critical section short
+		trace_lock();
+		uint32_t count = site->count;
+		uint64_t max_ticks = site->max_ticks;
+		uint64_t total_ticks = site->total_ticks;
+		trace_unlock();
+
+		uint64_t mean = count > 0 ? total_ticks / count : 0;
+		const char *file = strrchr(site->file, '/');
+		ESP_LOGI(TAG, "%10" PRIu32 " %10" PRIu64 " %10" PRIu64 "  %s:%" PRIu32,
+				 count, mean * 1000 / ticks_per_us,
+				 max_ticks * 1000 / ticks_per_us,
+				 file != NULL ? file + 1 : site->file, site->line);
+	}
+}
+#endif
+
 void erpc_esp_freertos_critical_enter(
 	erpc_esp_freertos_critical_section_lock *handle) {
-#if CONFIG_IDF_TARGET_LINUX
+#if CONFIG_ERPC_ESP_CRITICAL_TRACE
+	erpc_esp_freertos_critical_enter_at(handle, NULL);
+#elif CONFIG_IDF_TARGET_LINUX
 	taskENTER_CRITICAL();
 #else
 	taskENTER_CRITICAL(&handle->lock);
@@ -12,6 +179,9 @@ void erpc_esp_freertos_critical_enter(
 }
 void erpc_esp_freertos_critical_exit(
 	erpc_esp_freertos_critical_section_lock *handle) {
+#if CONFIG_ERPC_ESP_CRITICAL_TRACE
+	trace_exit(handle);
+#endif
 #if CONFIG_IDF_TARGET_LINUX
 	taskEXIT_CRITICAL();
 #else
@@ -0,0 +1,73 @@
+"""
+Client side of the gateway daemon (src/native/gateway), which terminates the
+Tinyproto links of many devices and exposes each channel of each device as a
+Unix domain socket.
+"""
+
+import json
+import os
+import socket
+
+import erpc
+
+
+class GatewayTransport(erpc.transport.FramedTransport):
+    """
+    eRPC transport of a channel of a device served by the gateway.
+
+    The gateway accepts the connection only while the device is connected,
+    and closes it when the device disconnects: in both cases send and receive
+    raise ConnectionError. Create a new GatewayTransport to reconnect.
+    """
+
+    def __init__(self, socket_dir: str, device: str, channel: int = 0):
+        """
+        GatewayTransport constructor
+
+        :param socket_dir directory of the sockets of the gateway (-d).
+        :param device name of the device.
+        :param channel channel of the device.
+        """
+        super(GatewayTransport, self).__init__()
+        self._socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self._socket.connect(socket_path(socket_dir, device, channel))
+
+    def close(self):
+        self._socket.close()
+
+    def _base_send(self, data):
+        self._socket.sendall(data)
+
+    def _base_receive(self, count):
+        data = bytearray()
+        while len(data) < count:
+            chunk = self._socket.recv(count - len(data))
+            if not chunk:
+                raise ConnectionError("Connection closed by the gateway")
+            data += chunk
+        return data
+
+
+def socket_path(socket_dir: str, device: str, channel: int = 0) -> str:
+    """
+    Path of the socket of a channel of a device
+    """
+    name = device if channel == 0 else f"{device}.{channel}"
+    return os.path.join(socket_dir, f"{name}.sock")
+
+
+def read_stats(socket_dir: str) -> dict:
+    """
+    Get the statistics of the gateway: its uptime (uptime_ms), its CPU time
+    (cpu_us) and, for each link, the counters of DeviceLinkStats (see
+    device_link.hpp) plus name, spec, state and compression.
+    """
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as stats_socket:
+        stats_socket.connect(os.path.join(socket_dir, "stats"))
+        data = bytearray()
+        while True:
+            chunk = stats_socket.recv(65536)
+            if not chunk:
+                break
+            data += chunk
+    return json.loads(data)
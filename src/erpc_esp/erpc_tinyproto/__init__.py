@@ -1,4 +1,6 @@
 from enum import IntFlag, auto
+import io
+import struct
 import time
 import threading
 import queue
@@ -7,6 +9,8 @@ from typing import Callable
 import erpc
 import tinyproto
 
+from . import lzf
+
 
 class TinyprotoUnRecoverableError(Exception):
     def __init__(self, msg="TinyProto generic unrecovarble error", *args, **kwargs):
@@ -184,11 +188,345 @@ class StoppableThread(threading.Thread):
 class _EventFlags(IntFlag):
     OPENED = auto()
     CONNECTED = auto()
-    NEW_FRAME_RX_PENDING = auto()
     POSSIBLE_NEW_TX_PENDING = auto()
     NEW_DISCONNECTION_EVENT_PENDING = auto()
 
 
+def _new_frame_rx_pending(channel: int) -> _EventFlags:
+    """
+    Event flag set when a new frame has been received on ``channel``
+    """
+    return _EventFlags(1 << (8 + channel))
+
+
+# Link header, prepended to every Tinyproto frame.
+# Must be kept in sync with tinyproto_link.h
+MAX_CHANNELS = 4
+_LINK_HEADER_KIND_SHIFT = 5
+_LINK_HEADER_CHANNEL_MASK = 0x0F
+_LINK_HEADER_COMPRESSED = 0x10
+_LINK_FRAME_KIND_RPC = 0
+_LINK_FRAME_KIND_CONTROL = 1
+_LINK_FRAME_KIND_STREAM = 2
+_LINK_FRAME_KIND_BATCH = 3
+_LINK_CONTROL_HELLO = 0
+_LINK_CONTROL_CREDIT = 1
+_LINK_VERSION = 1
+_LINK_HELLO_SIZE = 3
+_LINK_CONTROL_CREDIT_SIZE = 6
+_LINK_FEATURE_LZF = 1 << 0
+_LINK_FEATURE_BATCH = 1 << 1
+_LINK_FEATURE_CREDIT = 1 << 2
+_LINK_CREDIT_MESSAGE_COST = 4
+_LINK_STREAM_OPEN = 0
+_LINK_STREAM_DATA = 1
+_LINK_STREAM_CREDIT = 2
+_LINK_STREAM_CLOSE = 3
+MAX_STREAMS = 4
+# Upper bound of decompressed frames, only to reject corrupted data
+_MAX_FRAME_SIZE = 0xFFFF
+
+
+def _link_header(kind: int, channel: int) -> int:
+    return (kind << _LINK_HEADER_KIND_SHIFT) | (channel & _LINK_HEADER_CHANNEL_MASK)
+
+
+def split_batch(payload: bytes):
+    """
+    Split the payload of a batch frame into the eRPC messages it contains.
+
+    Each message is preceded by its u16 little endian size.
+
+    :raises ValueError: after the last valid message, if the batch is truncated
+    """
+    offset = 0
+    while offset < len(payload):
+        if len(payload) - offset < 2:
+            raise ValueError("Truncated batch")
+        (size,) = struct.unpack_from("<H", payload, offset)
+        offset += 2
+        if size > len(payload) - offset:
+            raise ValueError("Truncated batch")
+        yield payload[offset : offset + size]
+        offset += size
+
+
+class TinyprotoChannel(erpc.transport.Transport):
+    """
+    eRPC transport over one of the channels multiplexed on a Tinyproto link.
+
+    Get it with TinyprotoTransport.channel.
+    """
+
+    def __init__(self, link: "TinyprotoTransport", channel: int):
+        super(TinyprotoChannel, self).__init__()
+        self._link = link
+        self._channel = channel
+
+    def send(self, data):
+        data = bytes(data)
+        cost = len(data) + _LINK_CREDIT_MESSAGE_COST
+        self._link._reserve_credit(self._channel, cost)
+        try:
+            self._link._send_frame(
+                _link_header(_LINK_FRAME_KIND_RPC, self._channel), data
+            )
+        except TinyprotoTimeoutError:
+            self._link._release_credit(self._channel, cost)
+            raise
+
+    def receive(self):
+        message = self._link._receive(self._channel)
+        self._link._on_message_read(self._channel, len(message))
+        return message
+
+
+class TinyprotoStream(object):
+    """
+    Bidirectional byte stream over the Tinyproto link, with credit based flow
+    control. Counterpart of erpc_esp_transport_tinyproto_stream_*.
+
+    The peer grants credit, i.e. the free room in its receive window, and we
+    never send more data than the credit.
+
+    Get it with TinyprotoTransport.stream. See also TinyprotoStreamReader and
+    TinyprotoStreamWriter.
+    """
+
+    def __init__(
+        self,
+        link: "TinyprotoTransport",
+        stream_id: int,
+        rx_window: int = 16384,
+        max_chunk: int = 1024,
+    ):
+        """
+        :param rx_window size of the receive window
+        :param max_chunk maximum size of the data of a frame. The ESP32 side
+         can't receive frames larger than its channel 0 buffers.
+        """
+        self._link = link
+        self._id = stream_id
+        self._rx_window = rx_window
+        self._max_chunk = max_chunk
+        self._cond = threading.Condition()
+        self._rx = bytearray()
+        self._local_open = False
+        self._peer_closed = False
+        # Bytes we can still send
+        self._tx_credit = 0
+        # Bytes read and not yet returned to the peer as credit
+        self._pending_credit = 0
+
+    def open(self):
+        """
+        Open the stream. Data can be written once the peer has opened it too.
+        """
+        with self._cond:
+            if self._local_open:
+                raise TinyprotoRecoverableError("Stream already open")
+            self._rx.clear()
+            self._pending_credit = 0
+            self._peer_closed = False
+            self._local_open = True
+        try:
+            # Our whole receive window is the initial credit of the peer
+            self._send(_LINK_STREAM_OPEN, struct.pack("<I", self._rx_window))
+        except Exception:
+            with self._cond:
+                self._local_open = False
+            raise
+
+    def write(self, data, timeout: float = None):
+        """
+        Write all of ``data``, blocking while the peer has no room for it.
+
+        :param timeout timeout in seconds, for the whole write
+        :raise TinyprotoClosedError stream not open, closed by the peer or
+         disconnected
+        :raise TinyprotoTimeoutError timeout expired
+        """
+        data = memoryview(bytes(data))
+        deadline = None if timeout is None else time.monotonic() + timeout
+        while len(data) > 0:
+            with self._cond:
+                remaining = None
+                if deadline is not None:
+                    remaining = max(0, deadline - time.monotonic())
+                has_credit = self._cond.wait_for(
+                    lambda: not self._local_open
+                    or self._peer_closed
+                    or self._tx_credit > 0,
+                    remaining,
+                )
+                if not self._local_open or self._peer_closed:
+                    raise TinyprotoClosedError("Stream write")
+                if not has_credit:
+                    raise TinyprotoTimeoutError("Stream write")
+                chunk = min(len(data), self._tx_credit, self._max_chunk)
+                self._tx_credit -= chunk
+            self._send(_LINK_STREAM_DATA, data[:chunk])
+            data = data[chunk:]
+
+    def read(self, size: int, timeout: float = None) -> bytes:
+        """
+        Read up to ``size`` bytes. Returns as soon as some data is available.
+
+        :param timeout timeout in seconds
+        :return the data. Empty when the peer has closed the stream and all
+         its data has been read.
+        :raise TinyprotoClosedError stream not open or disconnected
+        :raise TinyprotoTimeoutError no data in time
+        """
+        credit = 0
+        with self._cond:
+            self._cond.wait_for(
+                lambda: not self._local_open or self._rx or self._peer_closed,
+                timeout,
+            )
+            if not self._local_open:
+                raise TinyprotoClosedError("Stream read")
+            if not self._rx:
+                if self._peer_closed:
+                    return b""
+                raise TinyprotoTimeoutError("Stream read")
+            data = bytes(self._rx[:size])
+            del self._rx[:size]
+            self._pending_credit += len(data)
+            # Return the credit in large enough pieces, like the ESP32 side
+            if self._pending_credit >= self._rx_window // 4:
+                credit = self._pending_credit
+                self._pending_credit = 0
+        if credit:
+            self._send(_LINK_STREAM_CREDIT, struct.pack("<I", credit))
+        return data
+
+    def close(self):
+        """
+        Close the stream.
+
+        The data already written is still delivered. Unread data is dropped.
+        Both sides must close the stream before opening it again.
+        """
+        with self._cond:
+            if not self._local_open:
+                return
+        try:
+            self._send(_LINK_STREAM_CLOSE, b"")
+        finally:
+            with self._cond:
+                self._local_open = False
+                self._peer_closed = False
+                self._tx_credit = 0
+                self._pending_credit = 0
+                self._rx.clear()
+                self._cond.notify_all()
+
+    @property
+    def closed(self) -> bool:
+        with self._cond:
+            return not self._local_open
+
+    def _send(self, op: int, payload):
+        self._link._send_frame(
+            _link_header(_LINK_FRAME_KIND_STREAM, self._id),
+            bytes([op]) + bytes(payload),
+        )
+
+    def _on_frame(self, payload: bytes):
+        """
+        Handle a stream frame. Called in the RX thread.
+        """
+        if len(payload) < 1:
+            return
+        op = payload[0]
+        with self._cond:
+            if op == _LINK_STREAM_OPEN and len(payload) >= 5:
+                # Accepted even if we are not open yet
+                (self._tx_credit,) = struct.unpack_from("<I", payload, 1)
+                self._peer_closed = False
+            elif op == _LINK_STREAM_DATA:
+                # Beyond the window only if the peer ignores the credit
+                room = self._rx_window - len(self._rx)
+                if self._local_open:
+                    self._rx.extend(payload[1 : 1 + room])
+            elif op == _LINK_STREAM_CREDIT and len(payload) >= 5:
+                self._tx_credit += struct.unpack_from("<I", payload, 1)[0]
+            elif op == _LINK_STREAM_CLOSE:
+                # When we are not open, it is the closure of an old session
+                if self._local_open:
+                    self._peer_closed = True
+                    self._tx_credit = 0
+            self._cond.notify_all()
+
+    def _reset(self):
+        """
+        Close the stream on disconnection.
+        """
+        with self._cond:
+            self._local_open = False
+            self._peer_closed = False
+            self._tx_credit = 0
+            self._pending_credit = 0
+            self._cond.notify_all()
+
+
+class TinyprotoStreamReader(io.RawIOBase):
+    """
+    Read-only file-like view of a TinyprotoStream, e.g. for
+    shutil.copyfileobj. The stream must be open.
+    """
+
+    def __init__(self, stream: TinyprotoStream, timeout: float = None):
+        """
+        :param timeout timeout in seconds of each read
+        """
+        super(TinyprotoStreamReader, self).__init__()
+        self._stream = stream
+        self._timeout = timeout
+
+    def readable(self) -> bool:
+        return True
+
+    def readinto(self, b) -> int:
+        data = self._stream.read(len(b), self._timeout)
+        b[: len(data)] = data
+        return len(data)
+
+    def close(self):
+        if not self.closed:
+            self._stream.close()
+        super(TinyprotoStreamReader, self).close()
+
+
+class TinyprotoStreamWriter(io.RawIOBase):
+    """
+    Write-only file-like view of a TinyprotoStream. The stream must be open.
+    Closing the writer closes the stream, so that the peer reads the end of
+    the stream.
+    """
+
+    def __init__(self, stream: TinyprotoStream, timeout: float = None):
+        """
+        :param timeout timeout in seconds of each write
+        """
+        super(TinyprotoStreamWriter, self).__init__()
+        self._stream = stream
+        self._timeout = timeout
+
+    def writable(self) -> bool:
+        return True
+
+    def write(self, b) -> int:
+        self._stream.write(b, self._timeout)
+        return len(b)
+
+    def close(self):
+        if not self.closed:
+            self._stream.close()
+        super(TinyprotoStreamWriter, self).close()
+
+
 class TinyprotoTransport(erpc.transport.Transport):
     class RxThread(StoppableThread):
         # Why is the string "TinyprotoTransport" used as type annotation?
@@ -246,6 +584,8 @@ class TinyprotoTransport(erpc.transport.Transport):
         write_func,
         send_timeout: float = 0.5,
         receive_timeout: float = None,
+        compression_threshold: int = 64,
+        channel_rx_window: int = 16384,
     ):
         """
         TinyprotoTransport constructor
@@ -254,15 +594,52 @@ class TinyprotoTransport(erpc.transport.Transport):
         :param write_func tinyproto Fd write function
         :param send_timeout send timeout in seconds.
         :param receive_timeout receive timeout in seconds.
+        :param compression_threshold messages of at least this size are
+         compressed, if the peer supports it. 0 disables compression.
+        :param channel_rx_window credit granted to the peer for each channel,
+         i.e. bytes of received messages, plus 4 per message, that can wait to
+         be read. Used only if the peer supports credit flow control.
         """
         super(TinyprotoTransport, self).__init__()
         self._proto = tinyproto.Fd()
         self._write_func = write_func
         self._read_func = read_func
         self._event_flags = EventFlags()
-        self._rx_fifo = queue.Queue(0)
+        self._rx_fifos = [queue.Queue(0) for _ in range(MAX_CHANNELS)]
+        self._channels = [TinyprotoChannel(self, c) for c in range(MAX_CHANNELS)]
+        self._streams = [TinyprotoStream(self, s) for s in range(MAX_STREAMS)]
         self._send_timeout = send_timeout
         self._receive_timeout = receive_timeout
+        self._compression_threshold = compression_threshold
+        # Features advertised by the peer in its HELLO
+        self._peer_features = 0
+        # Credit flow control of the channels, see _LINK_CONTROL_CREDIT
+        self._channel_rx_window = channel_rx_window
+        self._credit_cond = threading.Condition()
+        # Credit granted by the peer and not used yet. Messages sent before
+        # the HELLO of the peer are charged too, so it may be negative.
+        self._tx_credit = [0] * MAX_CHANNELS
+        # Credit of the messages read and not yet returned to the peer
+        self._pending_credit = [0] * MAX_CHANNELS
+        self._stats_lock = threading.Lock()
+        self._stats = dict.fromkeys(
+            [
+                "tx_frames",
+                "tx_compressed_frames",
+                "tx_payload_bytes",
+                "tx_wire_bytes",
+                "rx_frames",
+                "rx_compressed_frames",
+                "rx_payload_bytes",
+                "rx_wire_bytes",
+                "rx_errors",
+                # The RX FIFOs are unbounded, so the RX thread never stalls
+                "rx_stalls",
+                # Any message fits in a Python buffer, so none is dropped
+                "rx_dropped",
+            ],
+            0,
+        )
         self._rx_thread = TinyprotoTransport.RxThread(
             self,
             name="TinyprotoTransport RX",
@@ -278,17 +655,72 @@ class TinyprotoTransport(erpc.transport.Transport):
         """
 
         def on_read(data):
-            self._rx_fifo.put(data, block=True)
-            self._event_flags.set_bits(_EventFlags.NEW_FRAME_RX_PENDING)
+            if len(data) < 1:
+                return
+            header = data[0]
+            kind = header >> _LINK_HEADER_KIND_SHIFT
+            channel = header & _LINK_HEADER_CHANNEL_MASK
+            payload = bytes(data[1:])
+            wire_len = len(payload)
+            if header & _LINK_HEADER_COMPRESSED:
+                try:
+                    payload = lzf.decompress(payload, _MAX_FRAME_SIZE)
+                except ValueError:
+                    self._update_stats(rx_errors=1)
+                    return
+                self._update_stats(rx_compressed_frames=1)
+            self._update_stats(
+                rx_frames=1, rx_payload_bytes=len(payload), rx_wire_bytes=wire_len
+            )
+            if kind == _LINK_FRAME_KIND_CONTROL:
+                self._on_control(payload)
+                return
+            if kind == _LINK_FRAME_KIND_STREAM and channel < MAX_STREAMS:
+                self._streams[channel]._on_frame(payload)
+                return
+            if kind == _LINK_FRAME_KIND_BATCH and channel < MAX_CHANNELS:
+                try:
+                    for message in split_batch(payload):
+                        self._rx_fifos[channel].put(message, block=True)
+                        self._event_flags.set_bits(_new_frame_rx_pending(channel))
+                except ValueError:
+                    # The messages before are valid, keep them
+                    self._update_stats(rx_errors=1)
+                return
+            if kind != _LINK_FRAME_KIND_RPC or channel >= MAX_CHANNELS:
+                # Unknown frame. Drop it.
+                self._update_stats(rx_errors=1)
+                return
+            self._rx_fifos[channel].put(payload, block=True)
+            self._event_flags.set_bits(_new_frame_rx_pending(channel))
 
         def on_connect_event(address, connected):
+            # Until the HELLO of the peer, assume it supports nothing
+            self._peer_features = 0
+            with self._credit_cond:
+                if connected:
+                    # Messages of the previous connection would return credit
+                    for rx_fifo in self._rx_fifos:
+                        with rx_fifo.mutex:
+                            rx_fifo.queue.clear()
+                    self._tx_credit = [0] * MAX_CHANNELS
+                    self._pending_credit = [0] * MAX_CHANNELS
+                # Wake up the senders waiting for credit
+                self._credit_cond.notify_all()
             if connected:
                 self._event_flags.set_bits(_EventFlags.CONNECTED)
+                # Don't send from the Tinyproto callback, which runs in the
+                # RX or TX thread: send could wait for them.
+                threading.Thread(
+                    target=self._send_hello, name="TinyprotoTransport HELLO"
+                ).start()
             else:
                 # Reset protocol on disconnection
                 # self._proto.begin()
                 self._event_flags.clear_bits(_EventFlags.CONNECTED)
                 self._event_flags.set_bits(_EventFlags.NEW_DISCONNECTION_EVENT_PENDING)
+                for stream in self._streams:
+                    stream._reset()
 
         self._proto.on_read = on_read
         self._proto.on_connect_event = on_connect_event
@@ -309,6 +741,10 @@ class TinyprotoTransport(erpc.transport.Transport):
         Close the transport.
         """
         self._event_flags.clear_bits(_EventFlags.OPENED | _EventFlags.CONNECTED)
+        for stream in self._streams:
+            stream._reset()
+        with self._credit_cond:
+            self._credit_cond.notify_all()
         self._rx_thread.stop()
         self._tx_thread.stop()
         self._rx_thread.join()
@@ -364,7 +800,162 @@ class TinyprotoTransport(erpc.transport.Transport):
     def connected(self):
         return self._proto.get_status() == 0
 
+    @property
+    def compression(self) -> bool:
+        """
+        Whether messages are compressed, i.e. the peer accepts compressed
+        frames and compression is enabled
+        """
+        return (
+            self._compression_threshold > 0
+            and (self._peer_features & _LINK_FEATURE_LZF) != 0
+        )
+
+    def stats(self) -> dict:
+        """
+        Get the transport statistics. The same as
+        erpc_esp_transport_tinyproto_get_stats.
+
+        Payload bytes are counted before compression and wire bytes after
+        compression, both without the link header.
+        """
+        with self._stats_lock:
+            stats = dict(self._stats)
+        stats["compression"] = self.compression
+        return stats
+
+    def _update_stats(self, **increments):
+        with self._stats_lock:
+            for key, value in increments.items():
+                self._stats[key] += value
+
+    def _send_hello(self):
+        # We can always decompress, even if we don't compress, split batches
+        # and use credit flow control
+        features = _LINK_FEATURE_LZF | _LINK_FEATURE_BATCH | _LINK_FEATURE_CREDIT
+        hello = bytes([_LINK_CONTROL_HELLO, _LINK_VERSION, features])
+        try:
+            self._send_frame(_link_header(_LINK_FRAME_KIND_CONTROL, 0), hello)
+        except (TinyprotoRecoverableError, TinyprotoUnRecoverableError):
+            # Disconnected or closed meanwhile. On the next connection we'll
+            # try again.
+            pass
+
+    def _on_control(self, payload: bytes):
+        if len(payload) == 0:
+            self._update_stats(rx_errors=1)
+            return
+        if payload[0] == _LINK_CONTROL_HELLO and len(payload) >= _LINK_HELLO_SIZE:
+            # Newer versions only add features, so the version is informative
+            self._peer_features = payload[2]
+            if self._peer_features & _LINK_FEATURE_CREDIT:
+                with self._credit_cond:
+                    # Added to the credit of the messages already read, if any
+                    for channel in range(MAX_CHANNELS):
+                        self._pending_credit[channel] += self._channel_rx_window
+                # Like _send_hello, not from the Tinyproto callback
+                threading.Thread(
+                    target=self._grant_credit, name="TinyprotoTransport credit"
+                ).start()
+        elif (
+            payload[0] == _LINK_CONTROL_CREDIT
+            and len(payload) >= _LINK_CONTROL_CREDIT_SIZE
+            and payload[1] < MAX_CHANNELS
+        ):
+            (credit,) = struct.unpack_from("<I", payload, 2)
+            self._release_credit(payload[1], credit)
+        else:
+            self._update_stats(rx_errors=1)
+
+    def _reserve_credit(self, channel: int, cost: int):
+        """
+        Use credit for a message of ``cost``, waiting up to the send timeout
+        for the peer to grant enough. Called before sending the message.
+        """
+
+        def can_send():
+            if not (self._peer_features & _LINK_FEATURE_CREDIT):
+                return True
+            if not (self._event_flags.get_bits() & _EventFlags.CONNECTED):
+                # _send_frame will fail
+                return True
+            return self._tx_credit[channel] >= cost
+
+        with self._credit_cond:
+            if not self._credit_cond.wait_for(can_send, self._send_timeout):
+                raise TinyprotoTimeoutError("No credit")
+            self._tx_credit[channel] -= cost
+
+    def _release_credit(self, channel: int, credit: int):
+        with self._credit_cond:
+            self._tx_credit[channel] += credit
+            self._credit_cond.notify_all()
+
+    def _take_credit(self, channel: int) -> int:
+        """
+        Take the credit to be returned to the peer, if worth a frame
+        """
+        if not (self._peer_features & _LINK_FEATURE_CREDIT):
+            return 0
+        with self._credit_cond:
+            credit = self._pending_credit[channel]
+            # Like the ESP32 side, in large enough pieces
+            if credit < self._channel_rx_window // 4:
+                return 0
+            self._pending_credit[channel] = 0
+            return credit
+
+    def _send_credit(self, channel: int, credit: int):
+        payload = struct.pack("<BBI", _LINK_CONTROL_CREDIT, channel, credit)
+        try:
+            self._send_frame(_link_header(_LINK_FRAME_KIND_CONTROL, 0), payload)
+        except (TinyprotoRecoverableError, TinyprotoUnRecoverableError):
+            # Disconnected or closed meanwhile. The credit is reset on the
+            # next connection.
+            pass
+
+    def _grant_credit(self):
+        for channel in range(MAX_CHANNELS):
+            credit = self._take_credit(channel)
+            if credit:
+                self._send_credit(channel, credit)
+
+    def _on_message_read(self, channel: int, size: int):
+        with self._credit_cond:
+            self._pending_credit[channel] += size + _LINK_CREDIT_MESSAGE_COST
+        credit = self._take_credit(channel)
+        if credit:
+            self._send_credit(channel, credit)
+
+    def channel(self, channel: int) -> TinyprotoChannel:
+        """
+        Get the transport of a channel
+
+        The channel 0 is also used by send and receive of this transport.
+        NOTE that frames are passed to Tinyproto in the order in which send
+        is called: unlike the ESP32 side, there is no prioritization among
+        channels.
+
+        :param channel channel number, in [0, MAX_CHANNELS)
+        """
+        return self._channels[channel]
+
+    def stream(self, stream_id: int) -> TinyprotoStream:
+        """
+        Get a stream
+
+        :param stream_id stream id, in [0, MAX_STREAMS). The ESP32 side uses
+         the same id.
+        """
+        return self._streams[stream_id]
+
     def send(self, data):
+        self._channels[0].send(data)
+
+    def receive(self):
+        return self._channels[0].receive()
+
+    def _send_frame(self, header: int, data):
         event_flags = self._event_flags.get_bits()
         if (event_flags & _EventFlags.OPENED) == 0:
             raise TinyprotoClosedError("TX failure")
@@ -373,7 +964,21 @@ class TinyprotoTransport(erpc.transport.Transport):
         if not self._tx_thread.is_alive():
             raise TinyprotoTxThreadDead("TX failure")
 
-        ret = self._proto.send(data)
+        data = bytes(data)
+        payload_len = len(data)
+        kind = header >> _LINK_HEADER_KIND_SHIFT
+        if (
+            self.compression
+            and kind != _LINK_FRAME_KIND_CONTROL
+            and payload_len >= self._compression_threshold
+        ):
+            # Send it compressed only if it saves at least one byte
+            compressed = lzf.compress(data, payload_len - 1)
+            if compressed is not None:
+                header |= _LINK_HEADER_COMPRESSED
+                data = compressed
+
+        ret = self._proto.send(bytes([header]) + data)
         if ret != 0:
             if (self._event_flags.get_bits() & _EventFlags.OPENED) == 0:
                 raise TinyprotoClosedError("TX failure")
@@ -389,23 +994,31 @@ class TinyprotoTransport(erpc.transport.Transport):
             else:
                 assert False
         else:
+            self._update_stats(
+                tx_frames=1,
+                tx_compressed_frames=1 if header & _LINK_HEADER_COMPRESSED else 0,
+                tx_payload_bytes=payload_len,
+                tx_wire_bytes=len(data),
+            )
             # Successfully queued some data to be sent. Unblock the TX thread
             # immediately, if it is waiting for new TX data.
             self._event_flags.set_bits(_EventFlags.POSSIBLE_NEW_TX_PENDING)
 
-    def receive(self):
-        if self._rx_fifo.qsize() > 0:
+    def _receive(self, channel: int):
+        rx_fifo = self._rx_fifos[channel]
+        rx_pending = _new_frame_rx_pending(channel)
+        if rx_fifo.qsize() > 0:
             try:
-                self._event_flags.clear_bits(_EventFlags.NEW_FRAME_RX_PENDING)
-                return self._rx_fifo.get(block=False)
+                self._event_flags.clear_bits(rx_pending)
+                return rx_fifo.get(block=False)
             except queue.Empty:
                 raise AssertionError("Queue must contain at least one item")
         event_flags = self._event_flags.wait_bits(
-            _EventFlags.NEW_FRAME_RX_PENDING,
+            rx_pending,
             _EventFlags.CONNECTED | _EventFlags.OPENED,
             timeout=self._receive_timeout,
             # Clear new frame rx pending
-            op=lambda flags: flags & ~(_EventFlags.NEW_FRAME_RX_PENDING),
+            op=lambda flags: flags & ~(rx_pending),
         )
 
         # If connection shutdown and disconnection happen at the same time,
@@ -415,9 +1028,9 @@ class TinyprotoTransport(erpc.transport.Transport):
         if (event_flags & _EventFlags.CONNECTED) == 0:
             raise TinyprotoDisconnectedError("RX failure")
 
-        if event_flags & _EventFlags.NEW_FRAME_RX_PENDING:
+        if event_flags & rx_pending:
             try:
-                return self._rx_fifo.get(block=False)
+                return rx_fifo.get(block=False)
             except queue.Empty:
                 raise AssertionError("Queue must contain at least one item")
         if not self._rx_thread.is_alive():
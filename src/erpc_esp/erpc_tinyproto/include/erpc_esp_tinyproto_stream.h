@@ -0,0 +1,139 @@
+/**
+ * \file		erpc_esp_tinyproto_stream.h
+ *
+ * \brief		Byte streams over the Tinyproto link
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#ifndef ERPC_ESP_TINYPROTO_STREAM_H_
+#define ERPC_ESP_TINYPROTO_STREAM_H_
+
+#include "erpc_esp_tinyproto_transport_setup.h"
+
+#include "erpc_common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Maximum number of streams over a Tinyproto link
+ */
+#define ERPC_ESP_TRANSPORT_TINYPROTO_MAX_STREAMS 4
+
+/*!
+ * @brief Opaque stream object type.
+ */
+typedef struct ErpcEspTinyprotoStream *erpc_esp_tinyproto_stream_t;
+
+/**
+ * Stream configuration.
+ */
+struct erpc_esp_transport_tinyproto_stream_config {
+	/**
+	 * TX priority, shared with the channels. See
+	 * erpc_esp_transport_tinyproto_channel_config::priority.
+	 */
+	uint8_t priority;
+	/**
+	 * Storage of the receive window. The peer never sends more data than it
+	 * can hold, so its size bounds the throughput: make it a few times the
+	 * data that the link transfers in a round trip.
+	 */
+	void *rx_buffer;
+	size_t rx_buffer_size;
+	/**
+	 * Storage of the TX queue. Data is written in chunks of at most its size
+	 * minus a few bytes.
+	 */
+	void *tx_buffer;
+	size_t tx_buffer_size;
+};
+
+#define ERPC_ESP_TRANSPORT_TINYPROTO_STREAM_CONFIG_DEFAULT()                   \
+	{                                                                          \
+		.priority = 0, .rx_buffer = NULL, .rx_buffer_size = 0,                 \
+		.tx_buffer = NULL, .tx_buffer_size = 0,                                \
+	}
+
+/*!
+ * @brief Create a stream over the Tinyproto link.
+ *
+ * Must be called after erpc_esp_transport_tinyproto_init and before
+ * erpc_esp_transport_tinyproto_open.
+ *
+ * @param [in] id stream id, in [0, ERPC_ESP_TRANSPORT_TINYPROTO_MAX_STREAMS).
+ * The peer uses the same id.
+ * @param [in] config stream configuration
+ *
+ * @return NULL or the stream
+ */
+erpc_esp_tinyproto_stream_t erpc_esp_transport_tinyproto_stream_init(
+	uint8_t id,
+	const struct erpc_esp_transport_tinyproto_stream_config *config);
+
+/*!
+ * @brief Open the stream.
+ *
+ * The stream is bidirectional. Data can be written once the peer has opened
+ * it too, and can be read until the peer closes it.
+ *
+ * @retval kErpcStatus_ConnectionClosed not connected
+ * @retval kErpcStatus_Fail already open
+ * @retval kErpcStatus_Timeout TX queue full
+ * @retval kErpcStatus_Success
+ */
+erpc_status_t erpc_esp_transport_tinyproto_stream_open(
+	erpc_esp_tinyproto_stream_t stream);
+
+/*!
+ * @brief Write data to the stream.
+ *
+ * Blocks while the peer has no room for more data.
+ *
+ * @param [out] written bytes written, also on failure
+ *
+ * @retval kErpcStatus_ConnectionClosed stream not open, closed by the peer or
+ * disconnected
+ * @retval kErpcStatus_Timeout not all the data could be written in time
+ * @retval kErpcStatus_Success all the data written
+ */
+erpc_status_t erpc_esp_transport_tinyproto_stream_write(
+	erpc_esp_tinyproto_stream_t stream, const void *data, size_t size,
+	size_t *written, TickType_t timeout);
+
+/*!
+ * @brief Read data from the stream.
+ *
+ * Returns as soon as some data is available.
+ *
+ * @param [out] read bytes read. 0 on success means that the peer has closed
+ * the stream and all its data has been read.
+ *
+ * @retval kErpcStatus_ConnectionClosed stream not open or disconnected
+ * @retval kErpcStatus_Timeout no data in time
+ * @retval kErpcStatus_Success
+ */
+erpc_status_t erpc_esp_transport_tinyproto_stream_read(
+	erpc_esp_tinyproto_stream_t stream, void *data, size_t size, size_t *read,
+	TickType_t timeout);
+
+/*!
+ * @brief Close the stream.
+ *
+ * The data already written is still delivered. Unread data is dropped.
+ * Both sides must close the stream before opening it again. Disconnection
+ * closes all the streams.
+ */
+erpc_status_t erpc_esp_transport_tinyproto_stream_close(
+	erpc_esp_tinyproto_stream_t stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ERPC_ESP_TINYPROTO_STREAM_H_
@@ -25,12 +25,50 @@ extern "C" {
  */
 typedef struct ErpcTransport *erpc_transport_t;
 
+/**
+ * Maximum number of channels multiplexed over a Tinyproto link, including
+ * the default channel 0.
+ */
+#define ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS 4
+
+/**
+ * Batching of the oneway messages sent on a channel.
+ *
+ * Consecutive oneway messages are coalesced into one Tinyproto frame, which
+ * is queued when it holds max_messages messages, when the next message does
+ * not fit in the buffer, when a non-oneway message is sent or timeout after
+ * the first message. Batching is used only if the peer supports it.
+ */
+struct erpc_esp_transport_tinyproto_batch_config {
+	/**
+	 * Storage of the batch. Its size limits the size of a batch. NULL
+	 * disables batching.
+	 */
+	void *buffer;
+	size_t buffer_size;
+	/**
+	 * Maximum number of messages in a batch
+	 */
+	uint8_t max_messages;
+	/**
+	 * Maximum time spent by a message in the batch
+	 */
+	TickType_t timeout;
+};
+
+#define ERPC_ESP_TRANSPORT_TINYPROTO_BATCH_CONFIG_DEFAULT()                    \
+	{                                                                          \
+		.buffer = NULL, .buffer_size = 0, .max_messages = 16,                  \
+		.timeout = pdMS_TO_TICKS(10),                                          \
+	}
+
 /**
  * TinyProto transport configuration.
  */
 struct erpc_esp_transport_tinyproto_config {
 	/**
-	 * Underlying send timeout
+	 * Underlying send timeout. Replaced by the deadline of the call, if any
+	 * (see erpc_esp_call_deadline.h).
 	 */
 	TickType_t send_timeout;
 	/**
@@ -42,7 +80,8 @@ struct erpc_esp_transport_tinyproto_config {
 	 *
 	 * \param [in] connected whether now the link is connected
 	 *
-	 * May be NULL.
+	 * On disconnection, it is called before the pending receives are woken
+	 * up. May be NULL.
 	 */
 	void (*on_connect_status_change_cb)(bool connected);
 	/**
@@ -53,13 +92,107 @@ struct erpc_esp_transport_tinyproto_config {
 	 * Tx task priority
 	 */
 	UBaseType_t tx_task_priority;
+	/**
+	 * TX priority of channel 0. See
+	 * erpc_esp_transport_tinyproto_channel_config::priority.
+	 */
+	uint8_t priority;
+	/**
+	 * Messages of at least this size are compressed, if the peer supports
+	 * it. 0 disables compression.
+	 *
+	 * Ignored if CONFIG_ERPC_ESP_TINYPROTO_COMPRESSION is disabled.
+	 */
+	uint16_t compression_threshold;
+	/**
+	 * Batching of the oneway messages of channel 0
+	 */
+	struct erpc_esp_transport_tinyproto_batch_config batch;
+	/**
+	 * Passed as first argument to write_func and read_func. May be NULL.
+	 */
+	void *io_user_data;
 };
 
 #define ERPC_ESP_TRANSPORT_TINYPROTO_CONFIG_DEFAULT()                          \
 	{                                                                          \
 		.send_timeout = pdMS_TO_TICKS(500),                                    \
-		.receive_timeout = pdMS_TO_TICKS(500), .tx_task_priority = 10,         \
-		.rx_task_priority = 11,                                                \
+		.receive_timeout = pdMS_TO_TICKS(500), .rx_task_priority = 11,         \
+		.tx_task_priority = 10, .priority = 0, .compression_threshold = 64,    \
+		.batch = ERPC_ESP_TRANSPORT_TINYPROTO_BATCH_CONFIG_DEFAULT(),          \
+	}
+
+/**
+ * Tinyproto transport statistics.
+ *
+ * Payload bytes are counted before compression and wire bytes after
+ * compression, both without the link header.
+ */
+struct erpc_esp_transport_tinyproto_stats {
+	/**
+	 * Whether the peer accepts compressed frames
+	 */
+	bool compression;
+	uint32_t tx_frames;
+	uint32_t tx_compressed_frames;
+	uint32_t tx_payload_bytes;
+	uint32_t tx_wire_bytes;
+	uint32_t rx_frames;
+	uint32_t rx_compressed_frames;
+	uint32_t rx_payload_bytes;
+	uint32_t rx_wire_bytes;
+	/**
+	 * Received frames dropped because they could not be decoded
+	 */
+	uint32_t rx_errors;
+	/**
+	 * Times the link RX task waited for room in the RX FIFO of a channel.
+	 * Only a peer that doesn't support credit flow control can cause it.
+	 */
+	uint32_t rx_stalls;
+	/**
+	 * Received messages dropped because larger than any message buffer (see
+	 * ERPC_ESP_MAX_MESSAGE_BUFFER_SIZE in erpc_esp_mbf_size_class.hpp) or
+	 * than the RX FIFO of their channel
+	 */
+	uint32_t rx_dropped;
+};
+
+/**
+ * Configuration of an additional channel.
+ */
+struct erpc_esp_transport_tinyproto_channel_config {
+	/**
+	 * TX priority. When several channels have messages to send, the messages
+	 * of the channel with the highest priority are passed to Tinyproto
+	 * first. Channels with the same priority are served round-robin.
+	 */
+	uint8_t priority;
+	/**
+	 * Storage of the RX FIFO, where received messages wait to be read.
+	 * Its size limits the size of the messages that can be received: each
+	 * message takes its size plus sizeof(size_t) bytes, and the larger ones
+	 * are dropped (see rx_dropped).
+	 */
+	void *rx_buffer;
+	size_t rx_buffer_size;
+	/**
+	 * Storage of the TX queue, where sent messages wait to be passed to
+	 * Tinyproto. Its size limits the size of the messages that can be sent.
+	 */
+	void *tx_buffer;
+	size_t tx_buffer_size;
+	/**
+	 * Batching of the oneway messages
+	 */
+	struct erpc_esp_transport_tinyproto_batch_config batch;
+};
+
+#define ERPC_ESP_TRANSPORT_TINYPROTO_CHANNEL_CONFIG_DEFAULT()                  \
+	{                                                                          \
+		.priority = 0, .rx_buffer = NULL, .rx_buffer_size = 0,                 \
+		.tx_buffer = NULL, .tx_buffer_size = 0,                                \
+		.batch = ERPC_ESP_TRANSPORT_TINYPROTO_BATCH_CONFIG_DEFAULT(),          \
 	}
 
 /*!
@@ -72,13 +205,33 @@ struct erpc_esp_transport_tinyproto_config {
  * @param [in] read_func low level read function
  * @param [in] config other misc tinyproto configuration
  *
- * @return Return NULL or erpc_transport_t instance pointer.
+ * @return Return NULL or erpc_transport_t instance pointer. It is the
+ * transport of channel 0.
  */
 erpc_transport_t erpc_esp_transport_tinyproto_init(
 	void *buffer, size_t buffer_size, write_block_cb_t write_func,
 	read_block_cb_t read_func,
 	const struct erpc_esp_transport_tinyproto_config *config);
 
+/*!
+ * @brief Create an additional channel over the Tinyproto link.
+ *
+ * Each channel is an independent eRPC transport, with its own FIFOs, so that
+ * e.g. a large message on one channel does not delay the messages of a
+ * channel with higher priority.
+ * Must be called after erpc_esp_transport_tinyproto_init and before
+ * erpc_esp_transport_tinyproto_open.
+ *
+ * @param [in] channel channel number, in [1,
+ * ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS)
+ * @param [in] config channel configuration
+ *
+ * @return Return NULL or erpc_transport_t instance pointer.
+ */
+erpc_transport_t erpc_esp_transport_tinyproto_channel_init(
+	uint8_t channel,
+	const struct erpc_esp_transport_tinyproto_channel_config *config);
+
 /**
  * Open Tinyproto transport.
  */
@@ -98,6 +251,14 @@ void erpc_esp_transport_tinyproto_close(void);
  */
 bool erpc_esp_transport_tinyproto_wait_connected(TickType_t timeout);
 
+/**
+ * Get the transport statistics.
+ *
+ * \param [out] stats statistics
+ */
+void erpc_esp_transport_tinyproto_get_stats(
+	struct erpc_esp_transport_tinyproto_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,120 @@
+"""
+Minimal LZF compressor and decompressor.
+
+Pure Python counterpart of tinyproto_lzf.c. Must be kept in sync with it.
+"""
+
+from typing import Optional
+
+_HLOG = 10
+_MAX_LIT = 1 << 5
+_MAX_OFF = 1 << 13
+_MAX_REF = (1 << 8) + (1 << 3)
+
+
+def _hash(data, i: int) -> int:
+    v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2]
+    return ((v * 2654435761) & 0xFFFFFFFF) >> (32 - _HLOG)
+
+
+def compress(data: bytes, max_size: Optional[int] = None) -> Optional[bytes]:
+    """
+    Compress ``data``
+
+    :param max_size maximum size of the compressed data
+    :return the compressed data or None if larger than ``max_size``
+    """
+    in_len = len(data)
+    if max_size is None:
+        # Worst case: a control byte every _MAX_LIT literals
+        max_size = in_len + in_len // _MAX_LIT + 1
+    if in_len == 0:
+        return None
+
+    htab = {}
+    out = bytearray()
+    ip = 0
+    lit = bytearray()
+
+    def flush_literals():
+        out.append(len(lit) - 1)
+        out.extend(lit)
+        lit.clear()
+
+    while ip < in_len:
+        if ip + 2 < in_len:
+            h = _hash(data, ip)
+            ref = htab.get(h)
+            htab[h] = ip
+            if (
+                ref is not None
+                and ip - ref - 1 < _MAX_OFF
+                and data[ref : ref + 3] == data[ip : ip + 3]
+            ):
+                off = ip - ref - 1
+                max_len = min(in_len - ip, _MAX_REF)
+                length = 3
+                while length < max_len and data[ref + length] == data[ip + length]:
+                    length += 1
+                if lit:
+                    flush_literals()
+                length -= 2
+                if length < 7:
+                    out.append((off >> 8) + (length << 5))
+                else:
+                    out.append((off >> 8) + (7 << 5))
+                    out.append(length - 7)
+                out.append(off & 0xFF)
+                ip += length + 2
+                continue
+        lit.append(data[ip])
+        ip += 1
+        if len(lit) == _MAX_LIT:
+            flush_literals()
+
+    if lit:
+        flush_literals()
+    if len(out) > max_size:
+        return None
+    return bytes(out)
+
+
+def decompress(data: bytes, max_size: int) -> bytes:
+    """
+    Decompress ``data``
+
+    :param max_size maximum size of the decompressed data
+    :raise ValueError corrupted data or decompressed data larger than
+     ``max_size``
+    """
+    out = bytearray()
+    ip = 0
+    in_len = len(data)
+    while ip < in_len:
+        ctrl = data[ip]
+        ip += 1
+        if ctrl < _MAX_LIT:
+            length = ctrl + 1
+            if len(out) + length > max_size or ip + length > in_len:
+                raise ValueError("Corrupted LZF data")
+            out.extend(data[ip : ip + length])
+            ip += length
+        else:
+            length = ctrl >> 5
+            off = (ctrl & 0x1F) << 8
+            if length == 7:
+                if ip >= in_len:
+                    raise ValueError("Corrupted LZF data")
+                length += data[ip]
+                ip += 1
+            if ip >= in_len:
+                raise ValueError("Corrupted LZF data")
+            off += data[ip]
+            ip += 1
+            length += 2
+            if len(out) + length > max_size or off + 1 > len(out):
+                raise ValueError("Corrupted LZF data")
+            ref = len(out) - off - 1
+            for i in range(length):
+                out.append(out[ref + i])
+    return bytes(out)
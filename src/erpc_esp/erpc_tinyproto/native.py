@@ -0,0 +1,163 @@
+"""
+Tinyproto transport implemented by the C++ transport of the ESP32 side.
+
+The RX and TX threads, Tinyproto, the compression and the FIFOs run in native
+code, without the GIL. Only send and receive, called by eRPC, hold the GIL
+while copying the messages.
+
+Requires the ``_native`` extension module, built by ``setup.py`` when the
+``tinyproto`` and ``erpc`` submodules are available.
+"""
+
+import erpc
+
+from . import (
+    TinyprotoClosedError,
+    TinyprotoDisconnectedError,
+    TinyprotoTimeoutError,
+)
+from . import _native
+
+MAX_CHANNELS = _native.MAX_CHANNELS
+
+
+def _fileno(file) -> int:
+    return file if isinstance(file, int) else file.fileno()
+
+
+def _ms(timeout: float) -> int:
+    return -1 if timeout is None else int(timeout * 1000)
+
+
+class NativeTinyprotoChannel(erpc.transport.Transport):
+    """
+    eRPC transport of a channel of the Tinyproto link. The same as
+    erpc_esp.erpc_tinyproto.TinyprotoChannel.
+    """
+
+    def __init__(self, link: "NativeTinyprotoTransport", channel: int):
+        super(NativeTinyprotoChannel, self).__init__()
+        self._link = link
+        self._channel = channel
+
+    def send(self, data):
+        if not self._link._link.send(self._channel, bytes(data)):
+            self._link._raise_failure("TX failure")
+
+    def receive(self):
+        data = self._link._link.receive(self._channel)
+        if data is None:
+            self._link._raise_failure("RX failure")
+        return data
+
+
+class NativeTinyprotoTransport(erpc.transport.Transport):
+    """
+    Drop-in replacement of erpc_esp.erpc_tinyproto.TinyprotoTransport, with
+    the same send/receive/wait_connected API, on two file descriptors instead
+    of read and write functions.
+
+    Streams are not supported. Unlike TinyprotoTransport, the channels are
+    prioritized like on the ESP32 side (all with priority 0, so round-robin)
+    and received messages wait in bounded FIFOs of about 2 KB per channel.
+    """
+
+    def __init__(
+        self,
+        read_file,
+        write_file,
+        send_timeout: float = 0.5,
+        receive_timeout: float = None,
+        compression_threshold: int = 64,
+    ):
+        """
+        NativeTinyprotoTransport constructor
+
+        :param read_file file descriptor, or object with fileno(), from which
+         the Tinyproto data is read, e.g. the stdout pipe of the ESP-IDF
+         application or a serial port. It is used as is, so it must remain
+         open while the transport is open.
+        :param write_file file descriptor, or object with fileno(), to which
+         the Tinyproto data is written. It can be the same as read_file.
+        :param send_timeout send timeout in seconds.
+        :param receive_timeout receive timeout in seconds. None waits forever.
+        :param compression_threshold messages of at least this size are
+         compressed, if the peer supports it. 0 disables compression.
+        """
+        super(NativeTinyprotoTransport, self).__init__()
+        self._link = _native.Link(
+            _fileno(read_file),
+            _fileno(write_file),
+            send_timeout_ms=_ms(send_timeout),
+            receive_timeout_ms=_ms(receive_timeout),
+            compression_threshold=compression_threshold,
+        )
+        self._channels = [
+            NativeTinyprotoChannel(self, c) for c in range(MAX_CHANNELS)
+        ]
+
+    def open(self):
+        """
+        Open the transport.
+        """
+        self._link.open()
+
+    def close(self):
+        """
+        Close the transport.
+        """
+        self._link.close()
+
+    def wait_connected(self, timeout: float = None):
+        """
+        Wait connection to be established
+
+        :param timeout connection timeout in seconds.
+        """
+        if not self._link.wait_connected(_ms(timeout)):
+            if not self._link.opened():
+                raise TinyprotoClosedError("Connection failed")
+            raise TinyprotoTimeoutError("Connection failed")
+
+    @property
+    def connected(self):
+        return self._link.connected()
+
+    @property
+    def compression(self) -> bool:
+        """
+        Whether messages are compressed, i.e. the peer accepts compressed
+        frames and compression is enabled
+        """
+        return self._link.stats()["compression"]
+
+    def stats(self) -> dict:
+        """
+        Get the transport statistics. The same as
+        erpc_esp_transport_tinyproto_get_stats, plus the number of failed
+        writes (write_errors).
+        """
+        return self._link.stats()
+
+    def channel(self, channel: int) -> NativeTinyprotoChannel:
+        """
+        Get the transport of a channel
+
+        :param channel channel number, in [0, MAX_CHANNELS)
+        """
+        return self._channels[channel]
+
+    def send(self, data):
+        self._channels[0].send(data)
+
+    def receive(self):
+        return self._channels[0].receive()
+
+    def _raise_failure(self, msg: str):
+        # If closure and disconnection happen at the same time, the
+        # TinyprotoClosedError has higher priority
+        if not self._link.opened():
+            raise TinyprotoClosedError(msg)
+        if not self._link.connected():
+            raise TinyprotoDisconnectedError(msg)
+        raise TinyprotoTimeoutError(msg)
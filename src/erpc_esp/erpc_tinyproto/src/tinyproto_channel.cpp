@@ -0,0 +1,517 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		tinyproto_channel.cpp
+ *
+ * \brief		ERPC Tinyproto channel class - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "tinyproto_channel.hpp"
+
+#include "tinyproto_events.h"
+#include "tinyproto_link.h"
+#include "tinyproto_transport.hpp"
+
+#include "erpc_esp_call_deadline.h"
+#include "erpc_esp_mbf_size_class.hpp"
+#include "erpc_esp_message_header.h"
+
+#define TAG "erpc_esp_tinyproto"
+#include "esp_log.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace erpc::esp;
+
+TinyprotoChannel::TinyprotoChannel(void)
+	: link_(NULL), id_(0), priority_(0), rx_fifo_(), tx_queue_(), credit_(),
+	  batch_() {
+}
+
+void TinyprotoChannel::init(
+	TinyprotoTransport *link, uint8_t id, uint8_t priority, uint8_t *rx_buffer,
+	size_t rx_buffer_size, uint8_t *tx_buffer, size_t tx_buffer_size,
+	const erpc_esp_transport_tinyproto_batch_config &batch) {
+	this->link_ = link;
+	this->id_ = id;
+	this->priority_ = priority;
+	this->rx_fifo_.handle = xMessageBufferCreateStatic(
+		rx_buffer_size - 1, rx_buffer, &this->rx_fifo_.buf);
+	// Each message is stored after its size_t length
+	this->rx_fifo_.capacity = rx_buffer_size - 1 > sizeof(size_t)
+								  ? rx_buffer_size - 1 - sizeof(size_t)
+								  : 0;
+	/*
+	 * The RX FIFO stores each message with a size_t length, which may be
+	 * larger than LINK_CREDIT_MESSAGE_COST, e.g. on 64 bit hosts
+	 */
+	this->credit_.rx_window =
+		(rx_buffer_size - 1) * LINK_CREDIT_MESSAGE_COST /
+		std::max<size_t>(sizeof(size_t), LINK_CREDIT_MESSAGE_COST);
+	this->tx_queue_.init(tx_buffer, tx_buffer_size);
+
+	if (batch.buffer != NULL) {
+		this->batch_.buffer = static_cast<uint8_t *>(batch.buffer);
+		this->batch_.size =
+			std::min(batch.buffer_size, this->maxPayloadSize());
+		this->batch_.max_messages = batch.max_messages;
+		this->batch_.timeout = batch.timeout;
+		this->batch_.lock =
+			xSemaphoreCreateMutexStatic(&this->batch_.lock_buf);
+		assert(this->batch_.lock);
+	}
+}
+
+bool TinyprotoChannel::isInitialized(void) const {
+	return this->link_ != NULL;
+}
+
+size_t TinyprotoChannel::maxPayloadSize(void) const {
+	return std::min(this->tx_queue_.maxFrameSize(),
+					sizeof(this->link_->tx_frame_.data)) -
+		   LINK_HEADER_SIZE;
+}
+
+erpc_status_t TinyprotoChannel::send(MessageBuffer *message) {
+	const uint8_t header = LINK_HEADER(LINK_FRAME_KIND_RPC, this->id_);
+	erpc_status_t status;
+
+	if (this->batch_.buffer == NULL) {
+		status = this->push(header, message->get(), message->getUsed(), true);
+	} else {
+		xSemaphoreTake(this->batch_.lock, portMAX_DELAY);
+		if (this->isBatchable(message)) {
+			status = this->appendToBatch(message);
+		} else {
+			// The batched messages were sent first
+			status = this->flushBatch(true);
+			if (status == kErpcStatus_Success) {
+				status = this->push(header, message->get(),
+									message->getUsed(), true);
+			}
+		}
+		xSemaphoreGive(this->batch_.lock);
+	}
+
+	if (status == kErpcStatus_Success) {
+		// The data has been copied. Release the large buffer, if any.
+		fitMessageBuffer(message, 0);
+	}
+	return status;
+}
+
+erpc_status_t TinyprotoChannel::push(uint8_t header, const uint8_t *data,
+									 size_t size, bool wait) {
+	EventGroupHandle_t events = this->link_->events_.handle;
+	const EventBits_t tx_read = EVENT_STATUS_CHANNEL_TX_READ(this->id_);
+	const TickType_t send_timeout = this->link_->config_.send_timeout;
+	// The deadline of the call being sent, if any, replaces the send timeout
+	const TickType_t timeout =
+		wait ? erpc_esp_call_deadline_remaining(send_timeout) : 0;
+	const TickType_t start = xTaskGetTickCount();
+	const size_t cost = creditCost(header, data, size);
+
+	if (size > this->maxPayloadSize()) {
+		return kErpcStatus_SendFailed;
+	}
+
+	while (1) {
+		EventBits_t bits = xEventGroupGetBits(events);
+		if (!(bits & EVENT_STATUS_CONNECTED) || (bits & EVENT_STATUS_CLOSED)) {
+			return kErpcStatus_SendFailed;
+		}
+		/*
+		 * Clear before trying, so that a frame taken by the TX task or credit
+		 * received after a failed push is not missed.
+		 */
+		xEventGroupClearBits(events, tx_read);
+		if (this->reserveCredit(cost)) {
+			if (this->tx_queue_.push(header, data, size)) {
+				break;
+			}
+			// TX queue full
+			this->releaseCredit(cost);
+		}
+		TickType_t elapsed = xTaskGetTickCount() - start;
+		if (elapsed >= timeout) {
+			return kErpcStatus_SendFailed;
+		}
+		xEventGroupWaitBits(events,
+							tx_read | EVENT_STATUS_DISCONNECTED |
+								EVENT_STATUS_CLOSED,
+							pdFALSE, pdFALSE, timeout - elapsed);
+	}
+
+	/*
+	 * Successfully queued some data to be sent. Unblock the TX thread
+	 * immediately, if it is waiting for new TX data.
+	 */
+	xEventGroupSetBits(events, EVENT_STATUS_POTENTIAL_NEW_TX);
+	return kErpcStatus_Success;
+}
+
+size_t TinyprotoChannel::creditCost(uint8_t header, const uint8_t *data,
+									size_t size) {
+	// A batch was built by appendToBatch, so it is well formed
+	return link_credit_cost(header, data, size);
+}
+
+bool TinyprotoChannel::reserveCredit(size_t cost) {
+	bool honor = this->link_->peer_features_ & LINK_FEATURE_CREDIT;
+	bool reserved = false;
+
+	erpc_esp_freertos_critical_enter(&this->link_->rx_lock_);
+	if (!honor || this->credit_.tx >= static_cast<int32_t>(cost)) {
+		this->credit_.tx -= cost;
+		reserved = true;
+	}
+	erpc_esp_freertos_critical_exit(&this->link_->rx_lock_);
+	return reserved;
+}
+
+void TinyprotoChannel::releaseCredit(size_t cost) {
+	erpc_esp_freertos_critical_enter(&this->link_->rx_lock_);
+	this->credit_.tx += cost;
+	erpc_esp_freertos_critical_exit(&this->link_->rx_lock_);
+}
+
+void TinyprotoChannel::onCredit(uint32_t credit) {
+	this->releaseCredit(credit);
+	// Wake up the senders waiting for credit
+	xEventGroupSetBits(this->link_->events_.handle,
+					   EVENT_STATUS_CHANNEL_TX_READ(this->id_));
+}
+
+void TinyprotoChannel::onConnect(void) {
+	erpc_esp_freertos_critical_enter(&this->link_->rx_lock_);
+	xMessageBufferReset(this->rx_fifo_.handle);
+	this->credit_.tx = 0;
+	this->credit_.pending = 0;
+	erpc_esp_freertos_critical_exit(&this->link_->rx_lock_);
+}
+
+void TinyprotoChannel::onPeerHello(void) {
+	erpc_esp_freertos_critical_enter(&this->link_->rx_lock_);
+	// Added to the credit of the messages already read, if any
+	this->credit_.pending += this->credit_.rx_window;
+	erpc_esp_freertos_critical_exit(&this->link_->rx_lock_);
+}
+
+uint32_t TinyprotoChannel::takeCredit(void) {
+	if (!(this->link_->peer_features_ & LINK_FEATURE_CREDIT)) {
+		return 0;
+	}
+	uint32_t credit = 0;
+	erpc_esp_freertos_critical_enter(&this->link_->rx_lock_);
+	if (this->credit_.pending >= this->credit_.rx_window / 4) {
+		credit = this->credit_.pending;
+		this->credit_.pending = 0;
+	}
+	erpc_esp_freertos_critical_exit(&this->link_->rx_lock_);
+	return credit;
+}
+
+bool TinyprotoChannel::isBatchable(MessageBuffer *message) const {
+	erpc_esp_message_header header;
+	return (this->link_->peer_features_ & LINK_FEATURE_BATCH) &&
+		   LINK_BATCH_LEN_SIZE + static_cast<size_t>(message->getUsed()) <=
+			   this->batch_.size &&
+		   erpc_esp_message_header_decode(message->get(), message->getUsed(),
+										  &header) &&
+		   header.type == ERPC_ESP_MESSAGE_TYPE_ONEWAY;
+}
+
+erpc_status_t TinyprotoChannel::appendToBatch(MessageBuffer *message) {
+	EventBits_t bits = xEventGroupGetBits(this->link_->events_.handle);
+	if (!(bits & EVENT_STATUS_CONNECTED) || (bits & EVENT_STATUS_CLOSED)) {
+		return kErpcStatus_SendFailed;
+	}
+
+	size_t size = message->getUsed();
+	if (this->batch_.used + LINK_BATCH_LEN_SIZE + size > this->batch_.size) {
+		erpc_status_t status = this->flushBatch(true);
+		if (status != kErpcStatus_Success) {
+			return status;
+		}
+	}
+
+	if (this->batch_.count == 0) {
+		this->batch_.start = xTaskGetTickCount();
+	}
+	this->batch_.used += link_batch_append(
+		this->batch_.buffer + this->batch_.used, message->get(), size);
+	++this->batch_.count;
+
+	if (this->batch_.count >= this->batch_.max_messages) {
+		return this->flushBatch(true);
+	}
+	return kErpcStatus_Success;
+}
+
+erpc_status_t TinyprotoChannel::flushBatch(bool wait) {
+	if (this->batch_.count == 0) {
+		return kErpcStatus_Success;
+	}
+
+	erpc_status_t status;
+	bool drop = wait;
+	if (!(this->link_->peer_features_ & LINK_FEATURE_BATCH)) {
+		/*
+		 * Reconnected to a peer that doesn't support batches. The batch is
+		 * stale anyway, like the frames queued before the disconnection.
+		 */
+		status = kErpcStatus_SendFailed;
+		drop = true;
+	} else if (this->batch_.count == 1) {
+		// No need for a batch frame
+		status = this->push(LINK_HEADER(LINK_FRAME_KIND_RPC, this->id_),
+							this->batch_.buffer + LINK_BATCH_LEN_SIZE,
+							this->batch_.used - LINK_BATCH_LEN_SIZE, wait);
+	} else {
+		status = this->push(LINK_HEADER(LINK_FRAME_KIND_BATCH, this->id_),
+							this->batch_.buffer, this->batch_.used, wait);
+	}
+
+	if (status == kErpcStatus_Success || drop) {
+		this->batch_.used = 0;
+		this->batch_.count = 0;
+	}
+	return status;
+}
+
+void TinyprotoChannel::pollBatch(bool connected) {
+	if (this->batch_.buffer == NULL ||
+		xSemaphoreTake(this->batch_.lock, 0) != pdTRUE) {
+		// The sender holding the batch will queue it when needed
+		return;
+	}
+	if (this->batch_.count > 0) {
+		if (!connected) {
+			this->batch_.used = 0;
+			this->batch_.count = 0;
+		} else if (xTaskGetTickCount() - this->batch_.start >=
+				   this->batch_.timeout) {
+			// If the TX queue is full, retry at the next poll
+			this->flushBatch(false);
+		}
+	}
+	xSemaphoreGive(this->batch_.lock);
+}
+
+void TinyprotoChannel::onReceive(const uint8_t *data, size_t size) {
+	EventGroupHandle_t events = this->link_->events_.handle;
+	if (size > ERPC_ESP_MAX_MESSAGE_BUFFER_SIZE ||
+		size > this->rx_fifo_.capacity) {
+		/*
+		 * No message buffer could ever hold it, so it would stay at the head
+		 * of the RX FIFO forever, or it doesn't fit in the RX FIFO, so the RX
+		 * task would wait for room forever. Only a peer that doesn't use
+		 * credit can send it. Return its credit as if it had been read.
+		 */
+		ESP_LOGW(TAG, "Dropped message of %u bytes on channel %u",
+				 (unsigned)size, this->id_);
+		++this->link_->stats_.rx_dropped;
+		erpc_esp_freertos_critical_enter(&this->link_->rx_lock_);
+		this->credit_.pending += size + LINK_CREDIT_MESSAGE_COST;
+		bool credit_due = this->credit_.pending >= this->credit_.rx_window / 4;
+		erpc_esp_freertos_critical_exit(&this->link_->rx_lock_);
+		if (credit_due && (this->link_->peer_features_ & LINK_FEATURE_CREDIT)) {
+			xEventGroupSetBits(events, EVENT_STATUS_POTENTIAL_NEW_TX);
+		}
+		return;
+	}
+	while (1) {
+		erpc_esp_freertos_critical_enter(&this->link_->rx_lock_);
+		size_t sent = xMessageBufferSend(this->rx_fifo_.handle, data, size, 0);
+		erpc_esp_freertos_critical_exit(&this->link_->rx_lock_);
+		if (sent == size) {
+			xEventGroupSetBits(events,
+							   EVENT_STATUS_CHANNEL_RX_PENDING(this->id_));
+			break;
+		}
+		/*
+		 * Nobody reads fast enough and the peer doesn't use credit flow
+		 * control. Block the RX task, so that Tinyproto stops acknowledging
+		 * frames and the peer slows down.
+		 */
+		++this->link_->stats_.rx_stalls;
+		EventBits_t bits = xEventGroupWaitBits(
+			events,
+			EVENT_STATUS_CHANNEL_RX_READ(this->id_) | EVENT_STATUS_CLOSED |
+				EVENT_STATUS_DISCONNECTED,
+			pdFALSE, pdFALSE, portMAX_DELAY);
+		if (bits & (EVENT_STATUS_CLOSED | EVENT_STATUS_DISCONNECTED)) {
+			break;
+		}
+		xEventGroupClearBits(events, EVENT_STATUS_CHANNEL_RX_READ(this->id_));
+	}
+}
+
+erpc_status_t TinyprotoChannel::readFifo(MessageBuffer *message,
+										 bool *received) {
+	*received = false;
+	/*
+	 * NOTE: for some reason access to the message buffer must be protected
+	 * in critical section.
+	 * Otherwise sometimes even thought xMessageBufferIsEmpty returns false
+	 * the subsequent call to xMessageBufferReceive returns 0 (i.e. zero bytes
+	 * read from the message queue).
+	 * I was able to hit the problem using the esp_log example in this
+	 * repository, which performs a massive number of eRPC communication.
+	 * So the idea is that we can hit the problem we a lot of data is passing
+	 * through the MessageBuffer.
+	 *
+	 * Since xMessageBuffer is by contract single producer single
+	 * consumer, if this `receive` function were called concurrently in multiple
+	 * tasks, then the necessity of using critical sections would make sense,
+	 * as suggested in the [MessageBuffer
+	 * documentation](https://www.freertos.org/RTOS-message-buffer-example.html).
+	 * But I have checked and this "receive" function doesn't seem to be called
+	 * concurrently...
+	 *
+	 * Maybe it's this bug? https://github.com/aws/amazon-freertos/issues/1837
+	 * I tried to apply the proposed workaround, but it doesn't seem to work.
+	 */
+	erpc_esp_freertos_critical_enter(&this->link_->rx_lock_);
+	if (xMessageBufferIsEmpty(this->rx_fifo_.handle)) {
+		erpc_esp_freertos_critical_exit(&this->link_->rx_lock_);
+		return kErpcStatus_Success;
+	}
+	while (!fitMessageBuffer(message, xMessageBufferNextLengthBytes(
+										  this->rx_fifo_.handle))) {
+		erpc_esp_freertos_critical_exit(&this->link_->rx_lock_);
+		/*
+		 * onReceive drops the messages larger than any buffer, so all the
+		 * large buffers are in use. The factory doesn't tell when one is
+		 * freed: poll every tick, leaving the frame in the FIFO.
+		 */
+		if (xEventGroupGetBits(this->link_->events_.handle) &
+			(EVENT_STATUS_CLOSED | EVENT_STATUS_DISCONNECTED)) {
+			// Let the caller see it as any other disconnection
+			return kErpcStatus_Timeout;
+		}
+		vTaskDelay(1);
+		erpc_esp_freertos_critical_enter(&this->link_->rx_lock_);
+		if (xMessageBufferIsEmpty(this->rx_fifo_.handle)) {
+			// Dropped on connection
+			erpc_esp_freertos_critical_exit(&this->link_->rx_lock_);
+			return kErpcStatus_Success;
+		}
+	}
+	size_t size = xMessageBufferReceive(this->rx_fifo_.handle, message->get(),
+										message->getLength(), 0);
+	this->credit_.pending += size + LINK_CREDIT_MESSAGE_COST;
+	bool credit_due = this->credit_.pending >= this->credit_.rx_window / 4;
+	erpc_esp_freertos_critical_exit(&this->link_->rx_lock_);
+	assert(size != 0);
+	EventBits_t bits = EVENT_STATUS_CHANNEL_RX_READ(this->id_);
+	if (credit_due && (this->link_->peer_features_ & LINK_FEATURE_CREDIT)) {
+		// Let the TX task return the credit to the peer
+		bits |= EVENT_STATUS_POTENTIAL_NEW_TX;
+	}
+	xEventGroupSetBits(this->link_->events_.handle, bits);
+
+	message->setUsed(size);
+	*received = true;
+	return kErpcStatus_Success;
+}
+
+erpc_status_t TinyprotoChannel::receive(MessageBuffer *message) {
+	EventGroupHandle_t events = this->link_->events_.handle;
+	const EventBits_t rx_pending = EVENT_STATUS_CHANNEL_RX_PENDING(this->id_);
+	assert(xEventGroupGetBits(events) & EVENT_STATUS_OPENED);
+
+	if (!(xEventGroupGetBits(events) & (EVENT_STATUS_CONNECTED))) {
+		xMessageBufferReset(this->rx_fifo_.handle);
+		// not connected yet
+		return kErpcStatus_ConnectionClosed;
+	}
+
+	/*
+	 * The pending bit could be set multiple times. There could be multiple
+	 * frames pending. So, as long the message buffer is not empty, we simply
+	 * read it and don't wait for the pending event.
+	 */
+	bool received;
+	erpc_status_t status = this->readFifo(message, &received);
+	if (status != kErpcStatus_Success || received) {
+		if (received) {
+			xEventGroupClearBits(events, rx_pending);
+		}
+		return status;
+	}
+
+	/*
+	 * No frame yet. Don't hold a large buffer while waiting.
+	 */
+	fitMessageBuffer(message, 0);
+	/*
+	 * Wait to receive.
+	 */
+	EventBits_t event = xEventGroupWaitBits(
+		events,
+		rx_pending | EVENT_STATUS_DISCONNECTED | EVENT_STATUS_CLOSED, pdFALSE,
+		pdFALSE, this->link_->config_.receive_timeout);
+
+	bool event_received = false;
+	if (event & rx_pending) {
+		/*
+		 * Is it possible to lose events due to clearing this bit at
+		 * this stage, instead of passing pdTRUE to the xClearOnExit
+		 * parameter of xEventGroupWaitBits? Yes. But, as commented above,
+		 * if multiple frames are received quickly, the pending bit may be set
+		 * multiple times, in which case we also lose events.
+		 * That's why we also initially check whether the message buffer
+		 * is empty or not and if not read what's left in there.
+		 * We don't rely on the pending bit as the *only* "trigger" to read
+		 * from the message buffer, so we don't risk leaving unread data in
+		 * the message buffer.
+		 * OTOH not using xClearOnExit makes things easier. In fact
+		 * FreeRTOS doesn't allow to clear *only some of the bits we are
+		 * waiting for* on exit, which means that we can't wait for other
+		 * "shared" event bits (e.g. EVENT_STATUS_CLOSED) while we're
+		 * waiting for the pending bit if we wanted to clear it with
+		 * xClearOnExit, because also these would be cleared if set while
+		 * we're waiting, which is not what we want.
+		 */
+		xEventGroupClearBits(events, rx_pending);
+		status = this->readFifo(message, &received);
+		if (status != kErpcStatus_Success) {
+			return status;
+		}
+
+		event_received = true;
+	}
+	if (event & (EVENT_STATUS_CLOSED | EVENT_STATUS_DISCONNECTED)) {
+		xMessageBufferReset(this->rx_fifo_.handle);
+		/*
+		 * Disconnected or closed. Why do we return kErpcStatus_Timeout
+		 * instead of kErpcStatus_ConnectionClosed? Well, eRPC unblocks
+		 * clients only when the error is timeout... See
+		 * https://github.com/EmbeddedRPC/erpc/blob/cd8ffc8c7f08cb6fb123b86422ecbb738a26a69c/erpc_c/infra/erpc_transport_arbitrator.cpp#L79-L90
+		 */
+		status = kErpcStatus_Timeout;
+
+		event_received = true;
+	}
+
+	if (!event_received) {
+		// None of the events we waited for is set. xEventGroupWaitBits
+		// timed out
+		status = kErpcStatus_Timeout;
+	}
+	return status;
+}
+
+bool TinyprotoChannel::hasMessage(void) {
+	return !xMessageBufferIsEmpty(this->rx_fifo_.handle);
+}
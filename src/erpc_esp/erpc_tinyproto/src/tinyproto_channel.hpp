@@ -0,0 +1,261 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		tinyproto_channel.hpp
+ *
+ * \brief		ERPC Tinyproto channel class - interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_TINYPROTO_CHANNEL_HPP_
+#define ERPC_TINYPROTO_CHANNEL_HPP_
+
+#include "erpc_esp_tinyproto_transport_setup.h"
+
+#include "tinyproto_frame_queue.hpp"
+
+#include "erpc_transport.hpp"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/message_buffer.h"
+#include "freertos/semphr.h"
+
+namespace erpc {
+namespace esp {
+
+class TinyprotoTransport;
+
+/*!
+ * @brief eRPC transport over one of the channels multiplexed on a Tinyproto
+ * link.
+ */
+class TinyprotoChannel : public Transport {
+  public:
+	TinyprotoChannel(void);
+
+	/*!
+	 * @brief Bind the channel to the link.
+	 *
+	 * @param [in] link Tinyproto link
+	 * @param [in] id channel number
+	 * @param [in] priority TX priority
+	 * @param [in] rx_buffer storage of the RX FIFO
+	 * @param [in] rx_buffer_size
+	 * @param [in] tx_buffer storage of the TX queue
+	 * @param [in] tx_buffer_size
+	 * @param [in] batch batching of the oneway messages
+	 */
+	void init(TinyprotoTransport *link, uint8_t id, uint8_t priority,
+			  uint8_t *rx_buffer, size_t rx_buffer_size, uint8_t *tx_buffer,
+			  size_t tx_buffer_size,
+			  const erpc_esp_transport_tinyproto_batch_config &batch);
+
+	bool isInitialized(void) const;
+
+	/*!
+	 * @brief Queue a message for transmission.
+	 *
+	 * If batching is enabled, oneway messages are appended to the batch
+	 * instead.
+	 *
+	 * @param[in] message Message to send.
+	 *
+	 * @retval kErpcStatus_SendFailed Not connected, message too large or TX
+	 * queue still full after the send timeout.
+	 * @retval kErpcStatus_Success Message queued.
+	 */
+	virtual erpc_status_t send(MessageBuffer *message) override;
+
+	/*!
+	 * @brief Read a message received on this channel.
+	 *
+	 * @param[in] message Message to receive.
+	 *
+	 * @retval kErpcStatus_ConnectionClosed Not connected.
+	 * If all the large message buffers are in use, it waits for one to be
+	 * freed.
+	 *
+	 * @retval kErpcStatus_Timeout No message within the receive timeout or
+	 * disconnected while waiting.
+	 * @retval kErpcStatus_Success Successfully received.
+	 */
+	virtual erpc_status_t receive(MessageBuffer *message) override;
+	virtual bool hasMessage(void) override;
+
+  private:
+	friend class TinyprotoTransport;
+
+	/*!
+	 * @brief Enqueue a received message in the RX FIFO. Called by the link RX
+	 * task.
+	 *
+	 * Messages larger than ERPC_ESP_MAX_MESSAGE_BUFFER_SIZE are dropped.
+	 * If the peer sent the message without credit and the RX FIFO is full,
+	 * it blocks until a message is read.
+	 */
+	void onReceive(const uint8_t *data, size_t size);
+
+	/*!
+	 * @brief Drop the received messages and the credit of the previous
+	 * connection. Called by the link RX task on connection.
+	 */
+	void onConnect(void);
+
+	/*!
+	 * @brief Grant the whole RX window to the peer, which supports credit.
+	 * Called by the link RX task on the HELLO of the peer.
+	 */
+	void onPeerHello(void);
+
+	/*!
+	 * @brief Credit received from the peer. Called by the link RX task.
+	 */
+	void onCredit(uint32_t credit);
+
+	/*!
+	 * @brief Take the credit to be returned to the peer, if worth a frame.
+	 * Called by the link TX task.
+	 *
+	 * @return credit, 0 if none
+	 */
+	uint32_t takeCredit(void);
+
+	/*!
+	 * @brief Credit used by a frame. See LINK_CREDIT_MESSAGE_COST.
+	 */
+	static size_t creditCost(uint8_t header, const uint8_t *data, size_t size);
+
+	/*!
+	 * @brief Use \p cost credit, if the peer has granted enough. Without
+	 * credit flow control, it always succeeds.
+	 */
+	bool reserveCredit(size_t cost);
+
+	/*!
+	 * @brief Give back credit, e.g. reserved for a frame that didn't fit in
+	 * the TX queue.
+	 */
+	void releaseCredit(size_t cost);
+
+	/*!
+	 * @brief Move the next message from the RX FIFO into \p message, if any.
+	 *
+	 * @param[out] received whether a message has been read
+	 */
+	erpc_status_t readFifo(MessageBuffer *message, bool *received);
+
+	/*!
+	 * @brief Maximum size of the payload of a frame of this channel
+	 */
+	size_t maxPayloadSize(void) const;
+
+	/*!
+	 * @brief Queue a frame in the TX queue.
+	 *
+	 * @param[in] wait whether to wait up to the send timeout for room in the
+	 * TX queue
+	 */
+	erpc_status_t push(uint8_t header, const uint8_t *data, size_t size,
+					   bool wait);
+
+	/*!
+	 * @brief Whether \p message must be appended to the batch. Requires
+	 * batch_.lock.
+	 */
+	bool isBatchable(MessageBuffer *message) const;
+
+	/*!
+	 * @brief Append a message to the batch, queuing the batch when full.
+	 * Requires batch_.lock.
+	 */
+	erpc_status_t appendToBatch(MessageBuffer *message);
+
+	/*!
+	 * @brief Queue the batch, if not empty. Requires batch_.lock.
+	 *
+	 * @param[in] wait see push. If the batch can't be queued, it is dropped
+	 * when waiting and kept otherwise.
+	 */
+	erpc_status_t flushBatch(bool wait);
+
+	/*!
+	 * @brief Queue the batch if its timeout has expired, or drop it if
+	 * disconnected. Called by the link TX task, which must not block, so
+	 * nothing is done if a sender holds the batch.
+	 */
+	void pollBatch(bool connected);
+
+	TinyprotoTransport *link_;
+	uint8_t id_;
+	uint8_t priority_;
+	/**
+	 * FIFO that contains data that received via onReceive and that receive
+	 * waits.
+	 */
+	struct {
+		StaticMessageBuffer_t buf;
+		MessageBufferHandle_t handle;
+		/**
+		 * Size of the largest message it can hold
+		 */
+		size_t capacity;
+	} rx_fifo_;
+	/**
+	 * Messages waiting to be passed to Tinyproto by the link TX task
+	 */
+	TinyprotoFrameQueue tx_queue_;
+	/**
+	 * Credit flow control, see LINK_FEATURE_CREDIT. Protected by the
+	 * rx_lock_ of the link.
+	 */
+	struct {
+		/**
+		 * Credit granted by the peer and not used yet. Messages are charged
+		 * also before the HELLO of the peer: the peer returns their credit
+		 * too, so this may be negative.
+		 */
+		int32_t tx;
+		/**
+		 * Credit of the messages read and not yet returned to the peer
+		 */
+		uint32_t pending;
+		/**
+		 * Credit that fits in the RX FIFO
+		 */
+		uint32_t rx_window;
+	} credit_;
+	/**
+	 * Oneway messages waiting to be queued as a single frame. See
+	 * LINK_FRAME_KIND_BATCH.
+	 */
+	struct {
+		/**
+		 * NULL if batching is disabled
+		 */
+		uint8_t *buffer;
+		size_t size;
+		uint8_t max_messages;
+		TickType_t timeout;
+		size_t used;
+		uint8_t count;
+		/**
+		 * When the first message has been appended
+		 */
+		TickType_t start;
+		/**
+		 * Taken by the senders and by the link TX task
+		 */
+		StaticSemaphore_t lock_buf;
+		SemaphoreHandle_t lock;
+	} batch_;
+};
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_TINYPROTO_CHANNEL_HPP_ */
@@ -0,0 +1,113 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		tinyproto_events.h
+ *
+ * \brief		Event bits of the Tinyproto transport
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_TINYPROTO_EVENTS_H_
+#define ERPC_TINYPROTO_EVENTS_H_
+
+#include "erpc_esp_tinyproto_transport_setup.h"
+
+enum event_status {
+	/**
+	 * Set on TinyprotoTransport::open.
+	 * Cleared in TinyprotoTransport::close.
+	 * When cleared, TinyprotoTransport::rx_task and TinyprotoTransport::tx_task
+	 * will terminate themselves.
+	 */
+	EVENT_STATUS_OPENED = 1,
+	/**
+	 * Set on open => closed transition.
+	 * Cleared in TinyprotoTransport::open.
+	 * Mainly used to give blocking functions a way to unblock themselves
+	 * immediately on closure.
+	 */
+	EVENT_STATUS_CLOSED = 1 << 1,
+	/**
+	 * Set when the connection is established and cleared when the connection is
+	 * dropped.
+	 */
+	EVENT_STATUS_CONNECTED = 1 << 2,
+	/**
+	 * Set on connected => disconnected transition.
+	 * Cleared when a new connection is established.
+	 * Mainly used to give blocking functions a way to unblock themselves
+	 * immediately on disconnection.
+	 */
+	EVENT_STATUS_DISCONNECTED = 1 << 3,
+	/**
+	 * Cleared on TinyprotoTransport::open
+	 * Set by TX thread just before its termination.
+	 */
+	EVENT_STATUS_TX_THREAD_CLOSED = 1 << 5,
+	/**
+	 * Cleared on TinyprotoTransport::open
+	 * Set by RX thread just before its termination.
+	 */
+	EVENT_STATUS_RX_THREAD_CLOSED = 1 << 6,
+	/**
+	 * Set whenever something could leads to potentially new data to be
+	 * transmitted.
+	 * TX thread waits on this flags and clears it.
+	 */
+	EVENT_STATUS_POTENTIAL_NEW_TX = 1 << 7,
+	/**
+	 * First of the per-channel bits. See EVENT_STATUS_CHANNEL_RX_PENDING.
+	 */
+	EVENT_STATUS_CHANNEL_RX_PENDING_0 = 1 << 9,
+	/**
+	 * First of the per-channel bits. See EVENT_STATUS_CHANNEL_RX_READ.
+	 */
+	EVENT_STATUS_CHANNEL_RX_READ_0 =
+		EVENT_STATUS_CHANNEL_RX_PENDING_0
+		<< ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS,
+	/**
+	 * First of the per-channel bits. See EVENT_STATUS_CHANNEL_TX_READ.
+	 */
+	EVENT_STATUS_CHANNEL_TX_READ_0 =
+		EVENT_STATUS_CHANNEL_RX_READ_0
+		<< ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS,
+};
+
+/**
+ * Event bit for TinyprotoChannel::receive, which may run in any user thread.
+ * Set when a new frame has been received and enqueued in the RX FIFO of the
+ * channel.
+ * Cleared by TinyprotoChannel::receive when the new frame is read from the
+ * message buffer.
+ */
+#define EVENT_STATUS_CHANNEL_RX_PENDING(channel)                               \
+	((EventBits_t)EVENT_STATUS_CHANNEL_RX_PENDING_0 << (channel))
+/**
+ * Set whenever some data is read from the RX FIFO of the channel.
+ * If the RX FIFO is full, RX thread waits on this flags and clears it.
+ */
+#define EVENT_STATUS_CHANNEL_RX_READ(channel)                                  \
+	((EventBits_t)EVENT_STATUS_CHANNEL_RX_READ_0 << (channel))
+/**
+ * Set whenever a frame is taken from the TX queue of the channel or credit is
+ * received for the channel.
+ * If the TX queue is full or the credit is not enough, TinyprotoChannel::send
+ * waits on this flag.
+ */
+#define EVENT_STATUS_CHANNEL_TX_READ(channel)                                  \
+	((EventBits_t)EVENT_STATUS_CHANNEL_TX_READ_0 << (channel))
+
+/*
+ * The upper 8 bits of the event groups are reserved by FreeRTOS
+ */
+static_assert((EVENT_STATUS_CHANNEL_TX_READ_0
+				<< (ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS - 1)) < (1 << 24),
+			   "Too many channels for the event group");
+
+#endif /* ifndef ERPC_TINYPROTO_EVENTS_H_ */
@@ -0,0 +1,97 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		tinyproto_frame_queue.cpp
+ *
+ * \brief		Queue of outgoing Tinyproto link frames - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "tinyproto_frame_queue.hpp"
+
+#include <cassert>
+
+using namespace erpc::esp;
+
+TinyprotoFrameQueue::TinyprotoFrameQueue(void)
+	: handle_(nullptr), size_(0) {
+}
+
+void TinyprotoFrameQueue::init(uint8_t *storage, size_t size) {
+	assert(size > sizeof(uint16_t) + 1);
+	// FreeRTOS needs one more byte than the capacity
+	this->size_ = size - 1;
+	this->handle_ =
+		xStreamBufferCreateStatic(this->size_, 1, storage, &this->buf_);
+	assert(this->handle_);
+}
+
+bool TinyprotoFrameQueue::push(uint8_t header, const uint8_t *data1,
+							   size_t size1, const uint8_t *data2,
+							   size_t size2) {
+	size_t frame_size = 1 + size1 + size2;
+	if (frame_size > UINT16_MAX) {
+		return false;
+	}
+	uint16_t len = frame_size;
+
+	/*
+	 * The stream buffer is single producer, but checking the space and
+	 * writing the pieces inside the same critical section makes the push
+	 * atomic with respect to the other producers.
+	 */
+	erpc_esp_freertos_critical_enter(&this->lock_);
+	bool fits = xStreamBufferSpacesAvailable(this->handle_) >=
+				sizeof(len) + frame_size;
+	if (fits) {
+		xStreamBufferSend(this->handle_, &len, sizeof(len), 0);
+		xStreamBufferSend(this->handle_, &header, 1, 0);
+		if (size1 > 0) {
+			xStreamBufferSend(this->handle_, data1, size1, 0);
+		}
+		if (size2 > 0) {
+			xStreamBufferSend(this->handle_, data2, size2, 0);
+		}
+	}
+	erpc_esp_freertos_critical_exit(&this->lock_);
+	return fits;
+}
+
+size_t TinyprotoFrameQueue::pop(uint8_t *frame, size_t size) {
+	uint16_t len = 0;
+
+	erpc_esp_freertos_critical_enter(&this->lock_);
+	if (xStreamBufferBytesAvailable(this->handle_) >= sizeof(len)) {
+		xStreamBufferReceive(this->handle_, &len, sizeof(len), 0);
+		// Frames larger than the caller buffer can't be pushed in the first
+		// place (see maxFrameSize)
+		assert(len <= size);
+		xStreamBufferReceive(this->handle_, frame, len, 0);
+	}
+	erpc_esp_freertos_critical_exit(&this->lock_);
+	return len;
+}
+
+size_t TinyprotoFrameQueue::maxFrameSize(void) const {
+	return this->size_ - sizeof(uint16_t);
+}
+
+bool TinyprotoFrameQueue::isEmpty(void) {
+	erpc_esp_freertos_critical_enter(&this->lock_);
+	bool empty = xStreamBufferIsEmpty(this->handle_);
+	erpc_esp_freertos_critical_exit(&this->lock_);
+	return empty;
+}
+
+void TinyprotoFrameQueue::reset(void) {
+	erpc_esp_freertos_critical_enter(&this->lock_);
+	xStreamBufferReset(this->handle_);
+	erpc_esp_freertos_critical_exit(&this->lock_);
+}
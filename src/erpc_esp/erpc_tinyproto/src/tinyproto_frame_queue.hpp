@@ -0,0 +1,86 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		tinyproto_frame_queue.hpp
+ *
+ * \brief		Queue of outgoing Tinyproto link frames - interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_TINYPROTO_FRAME_QUEUE_HPP_
+#define ERPC_TINYPROTO_FRAME_QUEUE_HPP_
+
+#include "erpc_esp/utils.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/stream_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace erpc {
+namespace esp {
+
+/*!
+ * @brief Multiple producers, single consumer queue of link frames.
+ *
+ * Each frame is stored as a 16 bit length, the link header and the payload,
+ * so that producers can push the header and the payload without first
+ * copying them in a contiguous buffer.
+ */
+class TinyprotoFrameQueue {
+  public:
+	TinyprotoFrameQueue(void);
+
+	/*!
+	 * @brief Use \p size bytes of \p storage for the queue.
+	 */
+	void init(uint8_t *storage, size_t size);
+
+	/*!
+	 * @brief Append a frame made of \p header, \p data1 and \p data2
+	 * (optional).
+	 *
+	 * @retval true success
+	 * @retval false not enough space
+	 */
+	bool push(uint8_t header, const uint8_t *data1, size_t size1,
+			  const uint8_t *data2 = nullptr, size_t size2 = 0);
+
+	/*!
+	 * @brief Remove the oldest frame and copy it, header included, in
+	 * \p frame.
+	 *
+	 * @return size of the frame, 0 if the queue is empty
+	 */
+	size_t pop(uint8_t *frame, size_t size);
+
+	/*!
+	 * @brief Size of the largest frame that can be pushed in the empty queue
+	 */
+	size_t maxFrameSize(void) const;
+
+	bool isEmpty(void);
+
+	/*!
+	 * @brief Drop all the frames
+	 */
+	void reset(void);
+
+  private:
+	StaticStreamBuffer_t buf_;
+	StreamBufferHandle_t handle_;
+	size_t size_;
+	erpc_esp_freertos_critical_section_lock lock_ =
+		ERPC_ESP_FREERTOS_CRITICAL_SECTION_LOCK_INIT;
+};
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_TINYPROTO_FRAME_QUEUE_HPP_ */
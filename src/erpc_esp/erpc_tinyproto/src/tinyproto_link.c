@@ -0,0 +1,173 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		tinyproto_link.c
+ *
+ * \brief		Frames exchanged over the Tinyproto link - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "tinyproto_link.h"
+
+#include "sdkconfig.h"
+
+#include <string.h>
+
+static void put_u32(uint8_t *data, uint32_t value) {
+	data[0] = value;
+	data[1] = value >> 8;
+	data[2] = value >> 16;
+	data[3] = value >> 24;
+}
+
+static uint32_t get_u32(const uint8_t *data) {
+	return data[0] | (data[1] << 8) | (data[2] << 16) |
+		   ((uint32_t)data[3] << 24);
+}
+
+size_t link_encode_hello(uint8_t *frame, uint8_t features) {
+	frame[0] = LINK_HEADER(LINK_FRAME_KIND_CONTROL, 0);
+	frame[1] = LINK_CONTROL_HELLO;
+	frame[2] = LINK_VERSION;
+	frame[3] = features;
+	return LINK_HEADER_SIZE + LINK_HELLO_SIZE;
+}
+
+size_t link_encode_credit(uint8_t *frame, uint8_t channel, uint32_t credit) {
+	frame[0] = LINK_HEADER(LINK_FRAME_KIND_CONTROL, 0);
+	frame[1] = LINK_CONTROL_CREDIT;
+	frame[2] = channel;
+	put_u32(frame + 3, credit);
+	return LINK_HEADER_SIZE + LINK_CONTROL_CREDIT_SIZE;
+}
+
+size_t link_encode_stream_credit(uint8_t *frame, uint8_t stream,
+								 uint32_t credit) {
+	frame[0] = LINK_HEADER(LINK_FRAME_KIND_STREAM, stream);
+	frame[1] = LINK_STREAM_CREDIT;
+	put_u32(frame + 2, credit);
+	return LINK_HEADER_SIZE + LINK_STREAM_OP_SIZE + LINK_STREAM_CREDIT_SIZE;
+}
+
+bool link_decode_control(const uint8_t *payload, size_t size,
+						 struct link_control *control) {
+	if (size == 0) {
+		return false;
+	}
+	control->op = (enum link_control_op)payload[0];
+	switch (payload[0]) {
+	case LINK_CONTROL_HELLO:
+		if (size < LINK_HELLO_SIZE) {
+			return false;
+		}
+		control->version = payload[1];
+		control->features = payload[2];
+		return true;
+	case LINK_CONTROL_CREDIT:
+		if (size < LINK_CONTROL_CREDIT_SIZE) {
+			return false;
+		}
+		control->channel = payload[1];
+		control->credit = get_u32(payload + 2);
+		return true;
+	default:
+		return false;
+	}
+}
+
+size_t link_batch_append(uint8_t *entry, const uint8_t *message, size_t size) {
+	entry[0] = size;
+	entry[1] = size >> 8;
+	memcpy(entry + LINK_BATCH_LEN_SIZE, message, size);
+	return LINK_BATCH_LEN_SIZE + size;
+}
+
+bool link_batch_next(const uint8_t **data, size_t *size,
+					 const uint8_t **message, size_t *message_size) {
+	if (*size < LINK_BATCH_LEN_SIZE) {
+		return false;
+	}
+	size_t len = (*data)[0] | ((*data)[1] << 8);
+	if (len > *size - LINK_BATCH_LEN_SIZE) {
+		return false;
+	}
+	*message = *data + LINK_BATCH_LEN_SIZE;
+	*message_size = len;
+	*data += LINK_BATCH_LEN_SIZE + len;
+	*size -= LINK_BATCH_LEN_SIZE + len;
+	return true;
+}
+
+size_t link_credit_cost(uint8_t header, const uint8_t *payload, size_t size) {
+	if (LINK_HEADER_GET_KIND(header) != LINK_FRAME_KIND_BATCH) {
+		return size + LINK_CREDIT_MESSAGE_COST;
+	}
+	size_t cost = 0;
+	const uint8_t *message;
+	size_t message_size;
+	while (link_batch_next(&payload, &size, &message, &message_size)) {
+		cost += message_size + LINK_CREDIT_MESSAGE_COST;
+	}
+	return cost;
+}
+
+size_t link_compress_frame(const uint8_t *frame, size_t size, uint8_t *out,
+						   tinyproto_lzf_htab htab) {
+#if CONFIG_ERPC_ESP_TINYPROTO_COMPRESSION
+	uint8_t header = frame[0];
+	size_t payload_len = size - LINK_HEADER_SIZE;
+
+	if (size <= LINK_HEADER_SIZE + 1 ||
+		LINK_HEADER_GET_KIND(header) == LINK_FRAME_KIND_CONTROL) {
+		return 0;
+	}
+	// Worth it only if it saves at least one byte
+	size_t compressed_len =
+		tinyproto_lzf_compress(frame + LINK_HEADER_SIZE, payload_len,
+							   out + LINK_HEADER_SIZE, payload_len - 1, htab);
+	if (compressed_len == 0) {
+		return 0;
+	}
+	out[0] = header | LINK_HEADER_COMPRESSED;
+	return LINK_HEADER_SIZE + compressed_len;
+#else
+	(void)frame;
+	(void)size;
+	(void)out;
+	(void)htab;
+	return 0;
+#endif
+}
+
+bool link_decode_frame(const uint8_t *data, size_t size, uint8_t *rx,
+					   size_t rx_size, struct link_frame *frame) {
+	if (size < LINK_HEADER_SIZE) {
+		return false;
+	}
+	frame->header = data[0];
+	frame->payload = data + LINK_HEADER_SIZE;
+	frame->wire_len = size - LINK_HEADER_SIZE;
+	frame->payload_len = frame->wire_len;
+	if (!LINK_HEADER_IS_COMPRESSED(frame->header)) {
+		return true;
+	}
+#if CONFIG_ERPC_ESP_TINYPROTO_COMPRESSION
+	if (rx != NULL) {
+		frame->payload = rx;
+		frame->payload_len = tinyproto_lzf_decompress(
+			data + LINK_HEADER_SIZE, frame->wire_len, rx, rx_size);
+		return frame->payload_len != 0;
+	}
+#else
+	(void)rx;
+	(void)rx_size;
+#endif
+	return false;
+}
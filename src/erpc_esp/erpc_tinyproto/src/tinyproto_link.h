@@ -0,0 +1,277 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		tinyproto_link.h
+ *
+ * \brief		Frames exchanged over the Tinyproto link
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_TINYPROTO_LINK_H_
+#define ERPC_TINYPROTO_LINK_H_
+
+#include "tinyproto_lzf.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Every Tinyproto frame starts with a 1 byte link header:
+ *
+ *   bit 7..5  kind, see link_frame_kind
+ *   bit 4     the payload is compressed with LZF (see tinyproto_lzf.h)
+ *   bit 3..0  channel
+ *
+ * Must be kept in sync with the Python counterpart.
+ */
+#define LINK_HEADER_SIZE 1
+#define LINK_HEADER_KIND_SHIFT 5
+#define LINK_HEADER_CHANNEL_MASK 0x0F
+#define LINK_HEADER_COMPRESSED 0x10
+
+#define LINK_HEADER(kind, channel)                                             \
+	((uint8_t)(((kind) << LINK_HEADER_KIND_SHIFT) |                            \
+			   ((channel)&LINK_HEADER_CHANNEL_MASK)))
+#define LINK_HEADER_GET_KIND(header) ((header) >> LINK_HEADER_KIND_SHIFT)
+#define LINK_HEADER_GET_CHANNEL(header) ((header)&LINK_HEADER_CHANNEL_MASK)
+#define LINK_HEADER_IS_COMPRESSED(header) ((header)&LINK_HEADER_COMPRESSED)
+
+enum link_frame_kind {
+	/**
+	 * The payload is an eRPC message of the given channel
+	 */
+	LINK_FRAME_KIND_RPC = 0,
+	/**
+	 * The payload is a link control message, see link_control_op. Never
+	 * compressed.
+	 */
+	LINK_FRAME_KIND_CONTROL = 1,
+	/**
+	 * The payload is a message of the stream whose id is in the channel
+	 * field, see link_stream_op
+	 */
+	LINK_FRAME_KIND_STREAM = 2,
+	/**
+	 * The payload is a sequence of oneway eRPC messages of the given channel,
+	 * each one preceded by its u16 little endian size. Sent only if the peer
+	 * advertised LINK_FEATURE_BATCH.
+	 */
+	LINK_FRAME_KIND_BATCH = 3,
+};
+
+/*
+ * The first byte of the payload of control frames
+ */
+enum link_control_op {
+	/**
+	 * Sent by both sides on connection:
+	 *
+	 *   byte 0  LINK_CONTROL_HELLO
+	 *   byte 1  LINK_VERSION
+	 *   byte 2  features supported by the sender, see link_feature
+	 */
+	LINK_CONTROL_HELLO = 0,
+	/**
+	 * Sent only if the peer advertised LINK_FEATURE_CREDIT:
+	 *
+	 *   byte 0     LINK_CONTROL_CREDIT
+	 *   byte 1     channel
+	 *   byte 2..5  u32 little endian credit that the receiver can use for
+	 *              the messages of the channel, in addition to its current
+	 *              credit
+	 *
+	 * The sender of the HELLO first grants its whole RX window, then
+	 * returns the credit of each message as it is read. Credit for a channel
+	 * that the receiver doesn't have is ignored.
+	 */
+	LINK_CONTROL_CREDIT = 1,
+};
+
+#define LINK_VERSION 1
+#define LINK_HELLO_SIZE 3
+#define LINK_CONTROL_CREDIT_SIZE 6
+
+enum link_feature {
+	/**
+	 * The sender accepts compressed frames
+	 */
+	LINK_FEATURE_LZF = 1 << 0,
+	/**
+	 * The sender accepts batch frames
+	 */
+	LINK_FEATURE_BATCH = 1 << 1,
+	/**
+	 * The sender grants credit for the messages of the channels (see
+	 * LINK_CONTROL_CREDIT) and sends messages only within the credit
+	 * granted by the peer
+	 */
+	LINK_FEATURE_CREDIT = 1 << 2,
+};
+
+/*
+ * Credit used by a message of a channel, in addition to its size. It is the
+ * length prefix of the FreeRTOS message buffers on the ESP32. Each message of
+ * a batch frame uses credit separately.
+ */
+#define LINK_CREDIT_MESSAGE_COST 4
+
+/*
+ * The first byte of the payload of stream frames. Numbers are little endian.
+ */
+enum link_stream_op {
+	/**
+	 * The sender opened the stream. Followed by the u32 size of its
+	 * receive window, which is the initial credit of the receiver.
+	 */
+	LINK_STREAM_OPEN = 0,
+	/**
+	 * Followed by stream data. Never more than the credit of the sender.
+	 */
+	LINK_STREAM_DATA = 1,
+	/**
+	 * Followed by the u32 number of bytes that the receiver can send in
+	 * addition to its current credit.
+	 */
+	LINK_STREAM_CREDIT = 2,
+	/**
+	 * The sender closed the stream. No data follows.
+	 */
+	LINK_STREAM_CLOSE = 3,
+};
+
+#define LINK_STREAM_OP_SIZE 1
+#define LINK_STREAM_CREDIT_SIZE 4
+
+#define LINK_BATCH_LEN_SIZE 2
+
+/*
+ * Encoding and decoding of the frames, shared by the ESP32 transport and the
+ * gateway. Frames include the link header.
+ */
+
+/**
+ * Write a HELLO control frame advertising \p features in \p frame.
+ *
+ * @return size of the frame
+ */
+size_t link_encode_hello(uint8_t *frame, uint8_t features);
+
+/**
+ * Write a LINK_CONTROL_CREDIT control frame in \p frame.
+ *
+ * @return size of the frame
+ */
+size_t link_encode_credit(uint8_t *frame, uint8_t channel, uint32_t credit);
+
+/**
+ * Write a LINK_STREAM_CREDIT frame of \p stream in \p frame.
+ *
+ * @return size of the frame
+ */
+size_t link_encode_stream_credit(uint8_t *frame, uint8_t stream,
+								 uint32_t credit);
+
+/**
+ * Decoded payload of a control frame
+ */
+struct link_control {
+	enum link_control_op op;
+	/**
+	 * LINK_CONTROL_HELLO
+	 */
+	uint8_t version;
+	uint8_t features;
+	/**
+	 * LINK_CONTROL_CREDIT
+	 */
+	uint8_t channel;
+	uint32_t credit;
+};
+
+/**
+ * Decode the payload of a control frame.
+ *
+ * @retval false unknown or truncated control message
+ */
+bool link_decode_control(const uint8_t *payload, size_t size,
+						 struct link_control *control);
+
+/**
+ * Append a message of \p size bytes, at most UINT16_MAX, to the payload of a
+ * batch frame, at \p entry.
+ *
+ * @return bytes written, i.e. LINK_BATCH_LEN_SIZE + \p size
+ */
+size_t link_batch_append(uint8_t *entry, const uint8_t *message, size_t size);
+
+/**
+ * Take the next message from the payload of a batch frame, of which \p data
+ * and \p size are the part not read yet, and advance them.
+ *
+ * @retval false no more messages. If \p size is not 0, the batch is
+ * truncated: the messages before are valid.
+ */
+bool link_batch_next(const uint8_t **data, size_t *size,
+					 const uint8_t **message, size_t *message_size);
+
+/**
+ * Credit used by the messages of the payload of a frame of kind
+ * LINK_FRAME_KIND_RPC or LINK_FRAME_KIND_BATCH. See LINK_CREDIT_MESSAGE_COST.
+ */
+size_t link_credit_cost(uint8_t header, const uint8_t *payload, size_t size);
+
+/**
+ * Compress the payload of \p frame in \p out, which has room for \p size
+ * bytes, if that saves at least one byte. Control frames are never
+ * compressed.
+ *
+ * @param [in] htab working memory
+ *
+ * @return size of the compressed frame, 0 if it is not compressed
+ */
+size_t link_compress_frame(const uint8_t *frame, size_t size, uint8_t *out,
+						   tinyproto_lzf_htab htab);
+
+/**
+ * Received frame
+ */
+struct link_frame {
+	uint8_t header;
+	/**
+	 * Payload, decompressed if needed
+	 */
+	const uint8_t *payload;
+	size_t payload_len;
+	/**
+	 * Size of the payload as received
+	 */
+	size_t wire_len;
+};
+
+/**
+ * Decode a received frame. A compressed payload is decompressed in \p rx,
+ * which has room for \p rx_size bytes. Without \p rx compressed frames are
+ * invalid.
+ *
+ * @retval false the frame is shorter than the link header or its payload
+ * cannot be decompressed
+ */
+bool link_decode_frame(const uint8_t *data, size_t size, uint8_t *rx,
+					   size_t rx_size, struct link_frame *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_TINYPROTO_LINK_H_ */
@@ -0,0 +1,146 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		tinyproto_lzf.c
+ *
+ * \brief		Minimal LZF compressor and decompressor
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "tinyproto_lzf.h"
+
+#include <string.h>
+
+#define MAX_LIT (1 << 5)
+#define MAX_OFF (1 << 13)
+#define MAX_REF ((1 << 8) + (1 << 3))
+
+static inline unsigned hash(const uint8_t *p) {
+	uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+	return (v * 2654435761u) >> (32 - TINYPROTO_LZF_HLOG);
+}
+
+size_t tinyproto_lzf_compress(const uint8_t *in, size_t in_len, uint8_t *out,
+							  size_t out_len, tinyproto_lzf_htab htab) {
+	size_t ip = 0;
+	// Reserve the control byte of the first literal run
+	size_t op = 1;
+	size_t lit = 0;
+
+	if (in_len == 0 || out_len == 0 || in_len > UINT16_MAX) {
+		return 0;
+	}
+	// Positions are stored + 1, so that 0 means empty
+	memset(htab, 0, sizeof(tinyproto_lzf_htab));
+
+	while (ip < in_len) {
+		if (ip + 2 < in_len) {
+			unsigned h = hash(in + ip);
+			size_t ref = htab[h];
+			htab[h] = ip + 1;
+			if (ref != 0 && ip - ref < MAX_OFF &&
+				memcmp(in + ref - 1, in + ip, 3) == 0) {
+				size_t off = ip - ref;
+				size_t max_len = in_len - ip;
+				size_t len = 3;
+
+				--ref;
+				if (max_len > MAX_REF) {
+					max_len = MAX_REF;
+				}
+				while (len < max_len && in[ref + len] == in[ip + len]) {
+					++len;
+				}
+
+				// Close the literal run, or drop its unused control byte
+				if (lit != 0) {
+					out[op - lit - 1] = lit - 1;
+				} else {
+					--op;
+				}
+				len -= 2;
+				if (op + (len < 7 ? 2 : 3) > out_len) {
+					return 0;
+				}
+				if (len < 7) {
+					out[op++] = (off >> 8) + (len << 5);
+				} else {
+					out[op++] = (off >> 8) + (7 << 5);
+					out[op++] = len - 7;
+				}
+				out[op++] = off;
+				// Control byte of the next literal run
+				++op;
+				lit = 0;
+				ip += len + 2;
+				continue;
+			}
+		}
+
+		if (op >= out_len) {
+			return 0;
+		}
+		out[op++] = in[ip++];
+		if (++lit == MAX_LIT) {
+			out[op - lit - 1] = MAX_LIT - 1;
+			lit = 0;
+			++op;
+		}
+	}
+
+	if (lit != 0) {
+		out[op - lit - 1] = lit - 1;
+	} else {
+		--op;
+	}
+	return op;
+}
+
+size_t tinyproto_lzf_decompress(const uint8_t *in, size_t in_len,
+								uint8_t *out, size_t out_len) {
+	size_t ip = 0;
+	size_t op = 0;
+
+	while (ip < in_len) {
+		unsigned ctrl = in[ip++];
+
+		if (ctrl < MAX_LIT) {
+			size_t len = ctrl + 1;
+			if (op + len > out_len || ip + len > in_len) {
+				return 0;
+			}
+			memcpy(out + op, in + ip, len);
+			op += len;
+			ip += len;
+		} else {
+			size_t len = ctrl >> 5;
+			size_t off = (ctrl & 0x1F) << 8;
+			if (len == 7) {
+				if (ip >= in_len) {
+					return 0;
+				}
+				len += in[ip++];
+			}
+			if (ip >= in_len) {
+				return 0;
+			}
+			off += in[ip++];
+			len += 2;
+			if (op + len > out_len || off + 1 > op) {
+				return 0;
+			}
+			// The reference may overlap the output: copy byte by byte
+			for (size_t i = 0; i < len; ++i, ++op) {
+				out[op] = out[op - off - 1];
+			}
+		}
+	}
+	return op;
+}
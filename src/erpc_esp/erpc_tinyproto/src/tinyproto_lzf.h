@@ -0,0 +1,72 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		tinyproto_lzf.h
+ *
+ * \brief		Minimal LZF compressor and decompressor
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_TINYPROTO_LZF_H_
+#define ERPC_TINYPROTO_LZF_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The compressed data is a sequence of:
+ *
+ *   000LLLLL                     L+1 literal bytes follow
+ *   LLLooooo oooooooo            back reference of L+2 bytes, L in [1, 6]
+ *   111ooooo LLLLLLLL oooooooo   back reference of L+9 bytes
+ *
+ * where o is the distance - 1 from the current position.
+ * This is the format of liblzf. Must be kept in sync with the Python
+ * counterpart.
+ */
+
+/**
+ * Bits of the hash table used by the compressor
+ */
+#define TINYPROTO_LZF_HLOG 10
+
+/**
+ * Working memory of tinyproto_lzf_compress
+ */
+typedef uint16_t tinyproto_lzf_htab[1 << TINYPROTO_LZF_HLOG];
+
+/**
+ * Compress \p in_len bytes of \p in in \p out.
+ *
+ * @param [in] htab working memory
+ *
+ * @return size of the compressed data, 0 if it does not fit in \p out_len
+ * bytes
+ */
+size_t tinyproto_lzf_compress(const uint8_t *in, size_t in_len, uint8_t *out,
+							  size_t out_len, tinyproto_lzf_htab htab);
+
+/**
+ * Decompress \p in_len bytes of \p in in \p out.
+ *
+ * @return size of the decompressed data, 0 if the data is corrupted or does
+ * not fit in \p out_len bytes
+ */
+size_t tinyproto_lzf_decompress(const uint8_t *in, size_t in_len,
+								uint8_t *out, size_t out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_TINYPROTO_LZF_H_ */
@@ -0,0 +1,362 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		tinyproto_stream.cpp
+ *
+ * \brief		Byte stream over the Tinyproto link - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "tinyproto_stream.hpp"
+
+#include "tinyproto_events.h"
+#include "tinyproto_link.h"
+#include "tinyproto_transport.hpp"
+
+#define TAG "erpc_esp_tinyproto"
+#include "esp_log.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace erpc::esp;
+
+enum stream_event {
+	/**
+	 * Set when data or the closure of the peer is received, and when the
+	 * stream is reset.
+	 * Cleared by read before checking for data.
+	 */
+	STREAM_EVENT_RX = 1,
+	/**
+	 * Set when credit is received, a frame is taken from the TX queue, or
+	 * the stream is reset.
+	 * Cleared by write before checking for credit and room in the TX queue.
+	 */
+	STREAM_EVENT_TX = 1 << 1,
+};
+
+static uint32_t read_u32(const uint8_t *data) {
+	return data[0] | (data[1] << 8) | (data[2] << 16) |
+		   ((uint32_t)data[3] << 24);
+}
+
+static void write_u32(uint8_t *data, uint32_t value) {
+	data[0] = value;
+	data[1] = value >> 8;
+	data[2] = value >> 16;
+	data[3] = value >> 24;
+}
+
+TinyprotoStream::TinyprotoStream(void)
+	: link_(NULL), id_(0), priority_(0), rx_window_(0), max_chunk_(0), rx_(),
+	  tx_queue_(), events_(), local_open_(false), peer_closed_(false),
+	  tx_credit_(0), pending_credit_(0) {
+}
+
+void TinyprotoStream::init(TinyprotoTransport *link, uint8_t id,
+						   uint8_t priority, uint8_t *rx_buffer,
+						   size_t rx_buffer_size, uint8_t *tx_buffer,
+						   size_t tx_buffer_size) {
+	this->link_ = link;
+	this->id_ = id;
+	this->priority_ = priority;
+	// FreeRTOS needs one more byte than the capacity
+	this->rx_window_ = rx_buffer_size - 1;
+	this->rx_.handle = xStreamBufferCreateStatic(this->rx_window_, 1,
+												 rx_buffer, &this->rx_.buf);
+	assert(this->rx_.handle);
+	this->tx_queue_.init(tx_buffer, tx_buffer_size);
+	this->max_chunk_ = std::min(this->tx_queue_.maxFrameSize(),
+								sizeof(link->tx_frame_.data)) -
+					   LINK_HEADER_SIZE - LINK_STREAM_OP_SIZE;
+	this->events_.handle = xEventGroupCreateStatic(&this->events_.buf);
+	assert(this->events_.handle);
+}
+
+bool TinyprotoStream::isInitialized(void) const {
+	return this->link_ != NULL;
+}
+
+erpc_status_t TinyprotoStream::open(void) {
+	if (!this->linkConnected()) {
+		return kErpcStatus_ConnectionClosed;
+	}
+	erpc_esp_freertos_critical_enter(&this->lock_);
+	if (this->local_open_) {
+		erpc_esp_freertos_critical_exit(&this->lock_);
+		return kErpcStatus_Fail;
+	}
+	xStreamBufferReset(this->rx_.handle);
+	this->pending_credit_ = 0;
+	this->peer_closed_ = false;
+	this->local_open_ = true;
+	erpc_esp_freertos_critical_exit(&this->lock_);
+
+	// Our whole receive window is the initial credit of the peer
+	uint8_t window[LINK_STREAM_CREDIT_SIZE];
+	write_u32(window, this->rx_window_);
+	erpc_status_t status = this->push(LINK_STREAM_OPEN, window, sizeof(window));
+	if (status != kErpcStatus_Success) {
+		erpc_esp_freertos_critical_enter(&this->lock_);
+		this->local_open_ = false;
+		erpc_esp_freertos_critical_exit(&this->lock_);
+	}
+	return status;
+}
+
+erpc_status_t TinyprotoStream::write(const uint8_t *data, size_t size,
+									 size_t *written, TickType_t timeout) {
+	const uint8_t op = LINK_STREAM_DATA;
+	const TickType_t start = xTaskGetTickCount();
+
+	*written = 0;
+	while (*written < size) {
+		/*
+		 * Clear before checking, so that credit received or a frame taken
+		 * meanwhile is not missed.
+		 */
+		xEventGroupClearBits(this->events_.handle, STREAM_EVENT_TX);
+
+		erpc_esp_freertos_critical_enter(&this->lock_);
+		bool writable = this->local_open_ && !this->peer_closed_;
+		size_t credit = this->tx_credit_;
+		erpc_esp_freertos_critical_exit(&this->lock_);
+		if (!writable || !this->linkConnected()) {
+			return kErpcStatus_ConnectionClosed;
+		}
+
+		size_t chunk = std::min(std::min(size - *written, credit),
+								this->max_chunk_);
+		if (chunk > 0 &&
+			this->tx_queue_.push(LINK_HEADER(LINK_FRAME_KIND_STREAM, this->id_),
+								 &op, sizeof(op), data + *written, chunk)) {
+			erpc_esp_freertos_critical_enter(&this->lock_);
+			// The credit may have been reset meanwhile
+			this->tx_credit_ -= std::min<uint32_t>(chunk, this->tx_credit_);
+			erpc_esp_freertos_critical_exit(&this->lock_);
+			*written += chunk;
+			xEventGroupSetBits(this->link_->events_.handle,
+							   EVENT_STATUS_POTENTIAL_NEW_TX);
+			continue;
+		}
+
+		// No credit or TX queue full
+		TickType_t wait = portMAX_DELAY;
+		if (timeout != portMAX_DELAY) {
+			TickType_t elapsed = xTaskGetTickCount() - start;
+			if (elapsed >= timeout) {
+				return kErpcStatus_Timeout;
+			}
+			wait = timeout - elapsed;
+		}
+		xEventGroupWaitBits(this->events_.handle, STREAM_EVENT_TX, pdFALSE,
+							pdFALSE, wait);
+	}
+	return kErpcStatus_Success;
+}
+
+erpc_status_t TinyprotoStream::read(uint8_t *data, size_t size, size_t *read,
+									TickType_t timeout) {
+	const TickType_t start = xTaskGetTickCount();
+
+	*read = 0;
+	while (1) {
+		// Clear before checking, so that data received meanwhile is not missed
+		xEventGroupClearBits(this->events_.handle, STREAM_EVENT_RX);
+
+		size_t received = 0;
+		erpc_esp_freertos_critical_enter(&this->lock_);
+		bool open = this->local_open_;
+		bool eof = this->peer_closed_;
+		if (open) {
+			received = xStreamBufferReceive(this->rx_.handle, data, size, 0);
+		}
+		this->pending_credit_ += received;
+		bool credit_due = this->pending_credit_ >= this->rx_window_ / 4;
+		erpc_esp_freertos_critical_exit(&this->lock_);
+
+		if (!open) {
+			return kErpcStatus_ConnectionClosed;
+		}
+		if (received > 0) {
+			if (credit_due) {
+				// Let the TX task return the credit to the peer
+				xEventGroupSetBits(this->link_->events_.handle,
+								   EVENT_STATUS_POTENTIAL_NEW_TX);
+			}
+			*read = received;
+			return kErpcStatus_Success;
+		}
+		if (eof) {
+			// Closed by the peer and fully read
+			return kErpcStatus_Success;
+		}
+
+		TickType_t wait = portMAX_DELAY;
+		if (timeout != portMAX_DELAY) {
+			TickType_t elapsed = xTaskGetTickCount() - start;
+			if (elapsed >= timeout) {
+				return kErpcStatus_Timeout;
+			}
+			wait = timeout - elapsed;
+		}
+		xEventGroupWaitBits(this->events_.handle, STREAM_EVENT_RX, pdFALSE,
+							pdFALSE, wait);
+	}
+}
+
+erpc_status_t TinyprotoStream::close(void) {
+	erpc_esp_freertos_critical_enter(&this->lock_);
+	bool open = this->local_open_;
+	erpc_esp_freertos_critical_exit(&this->lock_);
+	if (!open) {
+		return kErpcStatus_Success;
+	}
+
+	// Queued after the data, so the peer gets all the data first
+	erpc_status_t status = this->push(LINK_STREAM_CLOSE, NULL, 0);
+
+	erpc_esp_freertos_critical_enter(&this->lock_);
+	this->local_open_ = false;
+	this->peer_closed_ = false;
+	this->tx_credit_ = 0;
+	this->pending_credit_ = 0;
+	xStreamBufferReset(this->rx_.handle);
+	erpc_esp_freertos_critical_exit(&this->lock_);
+	xEventGroupSetBits(this->events_.handle,
+					   STREAM_EVENT_RX | STREAM_EVENT_TX);
+	return status;
+}
+
+void TinyprotoStream::onFrame(const uint8_t *data, size_t size) {
+	if (size < LINK_STREAM_OP_SIZE) {
+		return;
+	}
+	const uint8_t *payload = data + LINK_STREAM_OP_SIZE;
+	size_t payload_len = size - LINK_STREAM_OP_SIZE;
+
+	switch (data[0]) {
+	case LINK_STREAM_OPEN:
+		if (payload_len < LINK_STREAM_CREDIT_SIZE) {
+			break;
+		}
+		/*
+		 * Accepted even if we are not open yet: we keep the credit until we
+		 * open.
+		 */
+		erpc_esp_freertos_critical_enter(&this->lock_);
+		this->tx_credit_ = read_u32(payload);
+		this->peer_closed_ = false;
+		erpc_esp_freertos_critical_exit(&this->lock_);
+		xEventGroupSetBits(this->events_.handle, STREAM_EVENT_TX);
+		break;
+	case LINK_STREAM_DATA: {
+		size_t stored = payload_len;
+		erpc_esp_freertos_critical_enter(&this->lock_);
+		if (this->local_open_) {
+			stored = xStreamBufferSend(this->rx_.handle, payload, payload_len,
+									   0);
+		}
+		erpc_esp_freertos_critical_exit(&this->lock_);
+		if (stored != payload_len) {
+			// Can't happen unless the peer ignores the credit
+			ESP_LOGW(TAG, "Stream %u: dropped %u bytes beyond the window",
+					 this->id_, (unsigned)(payload_len - stored));
+		}
+		xEventGroupSetBits(this->events_.handle, STREAM_EVENT_RX);
+		break;
+	}
+	case LINK_STREAM_CREDIT:
+		if (payload_len < LINK_STREAM_CREDIT_SIZE) {
+			break;
+		}
+		erpc_esp_freertos_critical_enter(&this->lock_);
+		this->tx_credit_ += read_u32(payload);
+		erpc_esp_freertos_critical_exit(&this->lock_);
+		xEventGroupSetBits(this->events_.handle, STREAM_EVENT_TX);
+		break;
+	case LINK_STREAM_CLOSE:
+		erpc_esp_freertos_critical_enter(&this->lock_);
+		// When we are not open, it is the closure of an old session
+		if (this->local_open_) {
+			this->peer_closed_ = true;
+			this->tx_credit_ = 0;
+		}
+		erpc_esp_freertos_critical_exit(&this->lock_);
+		xEventGroupSetBits(this->events_.handle,
+						   STREAM_EVENT_RX | STREAM_EVENT_TX);
+		break;
+	default:
+		ESP_LOGW(TAG, "Stream %u: unknown op %u", this->id_, data[0]);
+		break;
+	}
+}
+
+void TinyprotoStream::onLinkReset(void) {
+	erpc_esp_freertos_critical_enter(&this->lock_);
+	this->local_open_ = false;
+	this->peer_closed_ = false;
+	this->tx_credit_ = 0;
+	this->pending_credit_ = 0;
+	erpc_esp_freertos_critical_exit(&this->lock_);
+	xEventGroupSetBits(this->events_.handle,
+					   STREAM_EVENT_RX | STREAM_EVENT_TX);
+}
+
+void TinyprotoStream::onTxRead(void) {
+	xEventGroupSetBits(this->events_.handle, STREAM_EVENT_TX);
+}
+
+uint32_t TinyprotoStream::takeCredit(void) {
+	uint32_t credit = 0;
+	erpc_esp_freertos_critical_enter(&this->lock_);
+	/*
+	 * Return the credit in large enough pieces. The peer always keeps at
+	 * least 3/4 of the window of credit, so it is not slowed down.
+	 */
+	if (this->local_open_ && this->pending_credit_ > 0 &&
+		this->pending_credit_ >= this->rx_window_ / 4) {
+		credit = this->pending_credit_;
+		this->pending_credit_ = 0;
+	}
+	erpc_esp_freertos_critical_exit(&this->lock_);
+	return credit;
+}
+
+erpc_status_t TinyprotoStream::push(uint8_t op, const uint8_t *data,
+									size_t size) {
+	const TickType_t timeout = this->link_->config_.send_timeout;
+	const TickType_t start = xTaskGetTickCount();
+
+	while (1) {
+		xEventGroupClearBits(this->events_.handle, STREAM_EVENT_TX);
+		if (!this->linkConnected()) {
+			return kErpcStatus_ConnectionClosed;
+		}
+		if (this->tx_queue_.push(LINK_HEADER(LINK_FRAME_KIND_STREAM, this->id_),
+								 &op, sizeof(op), data, size)) {
+			xEventGroupSetBits(this->link_->events_.handle,
+							   EVENT_STATUS_POTENTIAL_NEW_TX);
+			return kErpcStatus_Success;
+		}
+		TickType_t elapsed = xTaskGetTickCount() - start;
+		if (elapsed >= timeout) {
+			return kErpcStatus_Timeout;
+		}
+		xEventGroupWaitBits(this->events_.handle, STREAM_EVENT_TX, pdFALSE,
+							pdFALSE, timeout - elapsed);
+	}
+}
+
+bool TinyprotoStream::linkConnected(void) {
+	EventBits_t bits = xEventGroupGetBits(this->link_->events_.handle);
+	return (bits & EVENT_STATUS_CONNECTED) && !(bits & EVENT_STATUS_CLOSED);
+}
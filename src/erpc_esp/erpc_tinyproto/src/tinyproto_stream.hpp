@@ -0,0 +1,143 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		tinyproto_stream.hpp
+ *
+ * \brief		Byte stream over the Tinyproto link - interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_TINYPROTO_STREAM_HPP_
+#define ERPC_TINYPROTO_STREAM_HPP_
+
+#include "erpc_esp_tinyproto_stream.h"
+
+#include "tinyproto_frame_queue.hpp"
+
+#include "erpc_esp/utils.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/stream_buffer.h"
+
+namespace erpc {
+namespace esp {
+
+class TinyprotoTransport;
+
+/*!
+ * @brief Bidirectional byte stream with credit based flow control.
+ *
+ * The peer grants credit, i.e. the free room in its receive window, and we
+ * never send more data than the credit. So received data always fits in the
+ * receive window and the stream never blocks the link RX task.
+ *
+ * One task may write and one task may read at the same time.
+ */
+class TinyprotoStream {
+  public:
+	TinyprotoStream(void);
+
+	/*!
+	 * @brief Bind the stream to the link.
+	 */
+	void init(TinyprotoTransport *link, uint8_t id, uint8_t priority,
+			  uint8_t *rx_buffer, size_t rx_buffer_size, uint8_t *tx_buffer,
+			  size_t tx_buffer_size);
+
+	bool isInitialized(void) const;
+
+	erpc_status_t open(void);
+	erpc_status_t write(const uint8_t *data, size_t size, size_t *written,
+						TickType_t timeout);
+	erpc_status_t read(uint8_t *data, size_t size, size_t *read,
+					   TickType_t timeout);
+	erpc_status_t close(void);
+
+  private:
+	friend class TinyprotoTransport;
+
+	/*!
+	 * @brief Handle a stream frame. Called by the link RX task.
+	 */
+	void onFrame(const uint8_t *data, size_t size);
+
+	/*!
+	 * @brief Called on disconnection and closure of the link.
+	 */
+	void onLinkReset(void);
+
+	/*!
+	 * @brief Called by the link TX task when it takes a frame from the TX
+	 * queue.
+	 */
+	void onTxRead(void);
+
+	/*!
+	 * @brief Take the credit to be returned to the peer, if worth a frame.
+	 * Called by the link TX task.
+	 *
+	 * @return credit, 0 if none
+	 */
+	uint32_t takeCredit(void);
+
+	/*!
+	 * @brief Queue a frame with \p op and \p data, waiting up to the send
+	 * timeout of the link if the TX queue is full.
+	 */
+	erpc_status_t push(uint8_t op, const uint8_t *data, size_t size);
+
+	/*!
+	 * @brief Whether the link is connected
+	 */
+	bool linkConnected(void);
+
+	TinyprotoTransport *link_;
+	uint8_t id_;
+	uint8_t priority_;
+	/**
+	 * Size of the receive window
+	 */
+	size_t rx_window_;
+	/**
+	 * Largest data chunk that fits in a frame
+	 */
+	size_t max_chunk_;
+	struct {
+		StaticStreamBuffer_t buf;
+		StreamBufferHandle_t handle;
+	} rx_;
+	/**
+	 * Frames waiting to be passed to Tinyproto by the link TX task
+	 */
+	TinyprotoFrameQueue tx_queue_;
+	struct {
+		StaticEventGroup_t buf;
+		EventGroupHandle_t handle;
+	} events_;
+	/**
+	 * Protects the fields below and rx_
+	 */
+	erpc_esp_freertos_critical_section_lock lock_ =
+		ERPC_ESP_FREERTOS_CRITICAL_SECTION_LOCK_INIT;
+	bool local_open_;
+	bool peer_closed_;
+	/**
+	 * Bytes we can still send
+	 */
+	uint32_t tx_credit_;
+	/**
+	 * Bytes read and not yet returned to the peer as credit
+	 */
+	uint32_t pending_credit_;
+};
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_TINYPROTO_STREAM_HPP_ */
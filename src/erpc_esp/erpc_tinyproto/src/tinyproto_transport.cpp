@@ -16,80 +16,37 @@
 
 #include "tinyproto_transport.hpp"
 
-#include "erpc_esp/utils.h"
+#include "tinyproto_events.h"
+#include "tinyproto_link.h"
 
-#include <cassert>
+#define TAG "erpc_esp_tinyproto"
+#include "esp_log.h"
 
-enum event_status {
-	/**
-	 * Set on TinyprotoTransport::open.
-	 * Cleared in TinyprotoTransport::close.
-	 * When cleared, TinyprotoTransport::rx_task and TinyprotoTransport::tx_task
-	 * will terminate themselves.
-	 */
-	EVENT_STATUS_OPENED = 1,
-	/**
-	 * Set on open => closed transition.
-	 * Cleared in TinyprotoTransport::open.
-	 * Mainly used to give blocking functions a way to unblock themselves
-	 * immediately on closure.
-	 */
-	EVENT_STATUS_CLOSED = 1 << 1,
-	/**
-	 * Set when the connection is established and cleared when the connection is
-	 * dropped.
-	 */
-	EVENT_STATUS_CONNECTED = 1 << 2,
-	/**
-	 * Set on connected => disconnected transition.
-	 * Cleared when a new connection is established.
-	 * Mainly used to give blocking functions a way to unblock themselves
-	 * immediately on disconnection.
-	 */
-	EVENT_STATUS_DISCONNECTED = 1 << 3,
-	/**
-	 * Event bit for TinyprotoTransport::receive, which may run in any user
-	 * thread.
-	 * Set when a new frame has been received and enqueued in the
-	 * TinyprotoTransport::rx_fifo
-	 * Cleared by TinyprotoTransport::receive when the new frame is read from
-	 * the message buffer.
-	 */
-	EVENT_STATUS_NEW_FRAME_PENDING = 1 << 4,
-	/**
-	 * Cleared on TinyprotoTransport::open
-	 * Set by TX thread just before its termination.
-	 */
-	EVENT_STATUS_TX_THREAD_CLOSED = 1 << 5,
-	/**
-	 * Cleared on TinyprotoTransport::open
-	 * Set by RX thread just before its termination.
-	 */
-	EVENT_STATUS_RX_THREAD_CLOSED = 1 << 6,
-	/**
-	 * Set whenever something could leads to potentially new data to be
-	 * transmitted.
-	 * TX thread waits on this flags and clears it.
-	 */
-	EVENT_STATUS_POTENTIAL_NEW_TX = 1 << 7,
-	/**
-	 * Set whenever some data is read from the RX queue.
-	 * If RX queue is full, RX thread waits on this flags and clears it.
-	 */
-	EVENT_STATUS_RX_QUEUE_READ = 1 << 8,
-};
+#include <cassert>
 
 using namespace erpc::esp;
 
+/**
+ * Number of queues served by schedule_tx: the channels, then the streams
+ */
+#define TX_SOURCE_COUNT                                                        \
+	(ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS +                               \
+	 ERPC_ESP_TRANSPORT_TINYPROTO_MAX_STREAMS)
+
 TinyprotoTransport::TinyprotoTransport(
 	void *buffer, size_t buffer_size, write_block_cb_t write_func,
 	read_block_cb_t read_func,
 	const erpc_esp_transport_tinyproto_config &config)
 	: tinyproto_(buffer, buffer_size), write_func_(write_func),
-	  read_func_(read_func), config_(config) {
-	this->rx_fifo_.handle =
-		xMessageBufferCreateStatic(sizeof(this->rx_fifo_.buffer) - 1,
-								   this->rx_fifo_.buffer, &this->rx_fifo_.buf);
+	  read_func_(read_func), config_(config), tx_frame_(),
+	  tx_last_source_(0), hello_pending_(false), peer_features_(0),
+	  stats_() {
+	this->channels_[0].init(this, 0, this->config_.priority,
+							this->channel0_buffers_.rx,
+							sizeof(this->channel0_buffers_.rx),
+							this->channel0_buffers_.tx,
+							sizeof(this->channel0_buffers_.tx),
+							this->config_.batch);
 
 	this->tinyproto_.setConnectEventCallback(TinyprotoTransport::connect_cb);
 	this->tinyproto_.setReceiveCallback(TinyprotoTransport::receive_cb);
@@ -137,6 +94,7 @@ void TinyprotoTransport::close() {
 
 	xEventGroupClearBits(this->events_.handle, EVENT_STATUS_OPENED);
 	xEventGroupSetBits(this->events_.handle, EVENT_STATUS_CLOSED);
+	this->reset_streams();
 	// wait until both tx and rx thread have gracefully terminated
 	xEventGroupWaitBits(this->events_.handle,
 						EVENT_STATUS_RX_THREAD_CLOSED |
@@ -164,6 +122,79 @@ erpc_status_t TinyprotoTransport::wait_connected(TickType_t timeout) {
 	return status;
 }
 
+TinyprotoChannel *TinyprotoTransport::init_channel(
+	uint8_t id, const erpc_esp_transport_tinyproto_channel_config &config) {
+	assert(!(xEventGroupGetBits(this->events_.handle) & EVENT_STATUS_OPENED));
+
+	if (id == 0 || id >= ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS ||
+		this->channels_[id].isInitialized()) {
+		return NULL;
+	}
+	if (config.rx_buffer == NULL || config.tx_buffer == NULL) {
+		return NULL;
+	}
+	this->channels_[id].init(this, id, config.priority,
+							 static_cast<uint8_t *>(config.rx_buffer),
+							 config.rx_buffer_size,
+							 static_cast<uint8_t *>(config.tx_buffer),
+							 config.tx_buffer_size, config.batch);
+	return &this->channels_[id];
+}
+
+TinyprotoChannel *TinyprotoTransport::channel(uint8_t id) {
+	if (id >= ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS ||
+		!this->channels_[id].isInitialized()) {
+		return NULL;
+	}
+	return &this->channels_[id];
+}
+
+TinyprotoStream *TinyprotoTransport::init_stream(
+	uint8_t id, const erpc_esp_transport_tinyproto_stream_config &config) {
+	assert(!(xEventGroupGetBits(this->events_.handle) & EVENT_STATUS_OPENED));
+
+	if (id >= ERPC_ESP_TRANSPORT_TINYPROTO_MAX_STREAMS ||
+		this->streams_[id].isInitialized()) {
+		return NULL;
+	}
+	if (config.rx_buffer == NULL || config.tx_buffer == NULL) {
+		return NULL;
+	}
+	this->streams_[id].init(this, id, config.priority,
+							static_cast<uint8_t *>(config.rx_buffer),
+							config.rx_buffer_size,
+							static_cast<uint8_t *>(config.tx_buffer),
+							config.tx_buffer_size);
+	return &this->streams_[id];
+}
+
+TinyprotoStream *TinyprotoTransport::stream(uint8_t id) {
+	if (id >= ERPC_ESP_TRANSPORT_TINYPROTO_MAX_STREAMS ||
+		!this->streams_[id].isInitialized()) {
+		return NULL;
+	}
+	return &this->streams_[id];
+}
+
+void TinyprotoTransport::reset_streams(void) {
+	for (uint8_t i = 0; i < ERPC_ESP_TRANSPORT_TINYPROTO_MAX_STREAMS; ++i) {
+		if (this->streams_[i].isInitialized()) {
+			this->streams_[i].onLinkReset();
+		}
+	}
+}
+
+void TinyprotoTransport::get_stats(
+	erpc_esp_transport_tinyproto_stats *stats) const {
+	*stats = this->stats_;
+#if CONFIG_ERPC_ESP_TINYPROTO_COMPRESSION
+	stats->compression = (this->peer_features_ & LINK_FEATURE_LZF) &&
+						 this->config_.compression_threshold != 0;
+#else
+	stats->compression = false;
+#endif
+}
+
 void TinyprotoTransport::rx_task(void *user_data) {
 	TinyprotoTransport *pthis = static_cast<TinyprotoTransport *>(user_data);
 	tiny_fd_handle_t handle = pthis->tinyproto_.getHandle();
@@ -174,7 +205,8 @@ void TinyprotoTransport::rx_task(void *user_data) {
 		 * user provided read_func_ to "block for a while" and thus we won't
 		 * starve other tasks
 		 */
-		int len = pthis->read_func_(NULL, buf, sizeof(buf));
+		int len = pthis->read_func_(pthis->config_.io_user_data, buf,
+									 sizeof(buf));
 		if (len > 0) {
 			tiny_fd_on_rx_data(handle, buf, len);
 			// Something was received. Potentially there is need to send ACK.
@@ -193,6 +225,7 @@ void TinyprotoTransport::tx_task(void *user_data) {
 	uint8_t buf[512];
 	int to_be_sent = 0;
 	while (xEventGroupGetBits(pthis->events_.handle) & EVENT_STATUS_OPENED) {
+		pthis->schedule_tx();
 		to_be_sent = tiny_fd_get_tx_data(handle, buf, sizeof(buf));
 		assert(to_be_sent >= 0);
 		if (to_be_sent == 0) {
@@ -212,7 +245,8 @@ void TinyprotoTransport::tx_task(void *user_data) {
 		} else {
 			uint8_t *ptr = buf;
 			while (to_be_sent) {
-				int result = pthis->write_func_(NULL, ptr, to_be_sent);
+				int result = pthis->write_func_(pthis->config_.io_user_data,
+												 ptr, to_be_sent);
 				assert(result >= 0);
 				to_be_sent -= result;
 				ptr += result;
@@ -224,187 +258,326 @@ void TinyprotoTransport::tx_task(void *user_data) {
 	vTaskDelete(NULL);
 }
 
-static erpc_esp_freertos_critical_section_lock lock =
-	ERPC_ESP_FREERTOS_CRITICAL_SECTION_LOCK_INIT;
+void TinyprotoTransport::schedule_tx(void) {
+	tiny_fd_handle_t handle = this->tinyproto_.getHandle();
+
+	bool connected =
+		xEventGroupGetBits(this->events_.handle) & EVENT_STATUS_CONNECTED;
+	for (uint8_t i = 0; i < ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS; ++i) {
+		if (this->channels_[i].isInitialized()) {
+			this->channels_[i].pollBatch(connected);
+		}
+	}
+
+	if (!connected) {
+		/*
+		 * Frames queued before the disconnection are stale. Drop them and
+		 * wake up the senders, which will notice the disconnection.
+		 */
+		this->tx_frame_.len = 0;
+		for (size_t i = 0; i < TX_SOURCE_COUNT; ++i) {
+			uint8_t priority;
+			TinyprotoFrameQueue *queue = this->tx_source(i, &priority);
+			if (queue != NULL && !queue->isEmpty()) {
+				queue->reset();
+				this->on_tx_source_read(i);
+			}
+		}
+		return;
+	}
 
-void TinyprotoTransport::receive_cb(void *user_data, uint8_t addr,
-									tinyproto::IPacket &pkt) {
-	TinyprotoTransport *pthis = static_cast<TinyprotoTransport *>(user_data);
 	while (1) {
-		erpc_esp_freertos_critical_enter(&lock);
-		size_t sent = xMessageBufferSend(pthis->rx_fifo_.handle, pkt.data(),
-										 pkt.size(), 0);
-		erpc_esp_freertos_critical_exit(&lock);
-		if (sent == pkt.size()) {
-			xEventGroupSetBits(pthis->events_.handle,
-							   EVENT_STATUS_NEW_FRAME_PENDING);
-			break;
+		if (this->tx_frame_.len == 0 && this->hello_pending_) {
+			this->hello_pending_ = false;
+			this->stage_hello();
+		}
+		if (this->tx_frame_.len == 0) {
+			// Credit first: the peer may be waiting for it
+			this->stage_credit();
+		}
+		if (this->tx_frame_.len == 0) {
+			TinyprotoFrameQueue *next = NULL;
+			uint8_t next_priority = 0;
+			size_t next_index = 0;
+			for (size_t i = 1; i <= TX_SOURCE_COUNT; ++i) {
+				// Start after the last served source: round-robin on ties
+				size_t index = (this->tx_last_source_ + i) % TX_SOURCE_COUNT;
+				uint8_t priority;
+				TinyprotoFrameQueue *queue = this->tx_source(index, &priority);
+				if (queue != NULL && !queue->isEmpty() &&
+					(next == NULL || priority > next_priority)) {
+					next = queue;
+					next_priority = priority;
+					next_index = index;
+				}
+			}
+			if (next == NULL) {
+				return;
+			}
+			this->tx_frame_.len =
+				next->pop(this->tx_frame_.data, sizeof(this->tx_frame_.data));
+			this->tx_frame_.ptr = this->tx_frame_.data;
+			this->tx_frame_.payload_len =
+				this->tx_frame_.len - LINK_HEADER_SIZE;
+			this->tx_last_source_ = next_index;
+			this->on_tx_source_read(next_index);
+			this->compress_tx_frame();
+		}
+
+		/*
+		 * Don't block: a frame of higher priority may be queued while
+		 * Tinyproto waits for ACKs, and we have to keep pumping TX data.
+		 */
+		int ret = tiny_fd_send_packet(handle, this->tx_frame_.ptr,
+									  this->tx_frame_.len, 0);
+		if (ret == TINY_ERR_TIMEOUT) {
+			// TX window full. Retry later.
+			return;
+		}
+		if (ret < 0) {
+			ESP_LOGW(TAG, "Dropped frame of %u bytes: error %d",
+					 (unsigned)this->tx_frame_.len, ret);
 		} else {
-			xEventGroupWaitBits(pthis->events_.handle,
-								EVENT_STATUS_RX_QUEUE_READ, pdTRUE, pdFALSE,
-								portMAX_DELAY);
+			++this->stats_.tx_frames;
+			if (this->tx_frame_.ptr != this->tx_frame_.data) {
+				++this->stats_.tx_compressed_frames;
+			}
+			this->stats_.tx_payload_bytes += this->tx_frame_.payload_len;
+			this->stats_.tx_wire_bytes +=
+				this->tx_frame_.len - LINK_HEADER_SIZE;
 		}
+		this->tx_frame_.len = 0;
 	}
 }
 
-void TinyprotoTransport::connect_cb(void *user_data, uint8_t addr,
-									bool connected) {
-	TinyprotoTransport *pthis = static_cast<TinyprotoTransport *>(user_data);
-	if (connected) {
-		xEventGroupSetBits(pthis->events_.handle, EVENT_STATUS_CONNECTED);
-		xEventGroupClearBits(pthis->events_.handle, EVENT_STATUS_DISCONNECTED);
-	} else {
-		xEventGroupSetBits(pthis->events_.handle, EVENT_STATUS_DISCONNECTED);
-		xEventGroupClearBits(pthis->events_.handle, EVENT_STATUS_CONNECTED);
+TinyprotoFrameQueue *TinyprotoTransport::tx_source(size_t index,
+													 uint8_t *priority) {
+	if (index < ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS) {
+		TinyprotoChannel &channel = this->channels_[index];
+		*priority = channel.priority_;
+		return channel.isInitialized() ? &channel.tx_queue_ : NULL;
 	}
+	TinyprotoStream &stream =
+		this->streams_[index - ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS];
+	*priority = stream.priority_;
+	return stream.isInitialized() ? &stream.tx_queue_ : NULL;
+}
 
-	if (pthis->config_.on_connect_status_change_cb) {
-		pthis->config_.on_connect_status_change_cb(connected);
+void TinyprotoTransport::on_tx_source_read(size_t index) {
+	if (index < ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS) {
+		xEventGroupSetBits(this->events_.handle,
+						   EVENT_STATUS_CHANNEL_TX_READ(index));
+	} else {
+		this->streams_[index - ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS]
+			.onTxRead();
 	}
 }
 
-erpc_status_t TinyprotoTransport::send(MessageBuffer *message) {
-	int ret = this->tinyproto_.write((const char *)message->get(),
-									 message->getUsed());
-	if (ret < 0) {
-		return kErpcStatus_SendFailed;
+void TinyprotoTransport::stage_credit(void) {
+	for (uint8_t i = 0; i < ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS; ++i) {
+		TinyprotoChannel &channel = this->channels_[i];
+		uint32_t credit = channel.isInitialized() ? channel.takeCredit() : 0;
+		if (credit == 0) {
+			continue;
+		}
+		this->tx_frame_.len =
+			link_encode_credit(this->tx_frame_.data, i, credit);
+		this->tx_frame_.payload_len = this->tx_frame_.len - LINK_HEADER_SIZE;
+		this->tx_frame_.ptr = this->tx_frame_.data;
+		return;
 	}
+	for (uint8_t i = 0; i < ERPC_ESP_TRANSPORT_TINYPROTO_MAX_STREAMS; ++i) {
+		TinyprotoStream &stream = this->streams_[i];
+		uint32_t credit = stream.isInitialized() ? stream.takeCredit() : 0;
+		if (credit == 0) {
+			continue;
+		}
+		this->tx_frame_.len =
+			link_encode_stream_credit(this->tx_frame_.data, i, credit);
+		this->tx_frame_.payload_len = this->tx_frame_.len - LINK_HEADER_SIZE;
+		this->tx_frame_.ptr = this->tx_frame_.data;
+		return;
+	}
+}
 
-	/*
-	 * Successfully queued some data to be sent. Unblock the TX thread
-	 * immediately, if it is waiting for new TX data.
-	 */
-	xEventGroupSetBits(this->events_.handle, EVENT_STATUS_POTENTIAL_NEW_TX);
-	return kErpcStatus_Success;
+void TinyprotoTransport::stage_hello(void) {
+	// We can always split batches and use credit flow control
+	uint8_t features = LINK_FEATURE_BATCH | LINK_FEATURE_CREDIT;
+#if CONFIG_ERPC_ESP_TINYPROTO_COMPRESSION
+	// We can always decompress, even if we don't compress
+	features |= LINK_FEATURE_LZF;
+#endif
+	this->tx_frame_.len = link_encode_hello(this->tx_frame_.data, features);
+	this->tx_frame_.ptr = this->tx_frame_.data;
+	this->tx_frame_.payload_len = LINK_HELLO_SIZE;
 }
-erpc_status_t TinyprotoTransport::receive(MessageBuffer *message) {
-	assert(xEventGroupGetBits(this->events_.handle) & EVENT_STATUS_OPENED);
 
-	if (!(xEventGroupGetBits(this->events_.handle) &
-		  (EVENT_STATUS_CONNECTED))) {
-		xMessageBufferReset(this->rx_fifo_.handle);
-		// not connected yet
-		return kErpcStatus_ConnectionClosed;
-	}
-
-	/*
-	 * NOTE: for some reason access to the message buffer must be protected
-	 * in critical section.
-	 * Otherwise sometimes even thought xMessageBufferIsEmpty returns false
-	 * the subsequent call to xMessageBufferReceive returns 0 (i.e. zero bytes
-	 * read from the message queue).
-	 * I was able to hit the problem using the esp_log example in this
-	 * repository, which performs a massive number of eRPC communication.
-	 * So the idea is that we can hit the problem we a lot of data is passing
-	 * through the MessageBuffer.
-	 *
-	 * Since xMessageBuffer is by contract single producer single
-	 * consumer, if this `receive` function were called concurrently in multiple
-	 * tasks, then the necessity of using critical sections would make sense,
-	 * as suggested in the [MessageBuffer
-	 * documentation](https://www.freertos.org/RTOS-message-buffer-example.html).
-	 * But I have checked and this "receive" function doesn't seem to be called
-	 * concurrently...
-	 *
-	 * Maybe it's this bug? https://github.com/aws/amazon-freertos/issues/1837
-	 * I tried to apply the proposed workaround, but it doesn't seem to work.
-	 */
-	erpc_esp_freertos_critical_enter(&lock);
-	if (!xMessageBufferIsEmpty(this->rx_fifo_.handle)) {
-		/*
-		 * EVENT_STATUS_NEW_FRAME_PENDING could be set multiple times.
-		 * There could be multiple frames pending.
-		 * So, as long the message buffer is not empty, we simply read it
-		 * and don't wait for the EVENT_STATUS_NEW_FRAME_PENDING event.
-		 */
-		size_t received = xMessageBufferReceive(
-			this->rx_fifo_.handle, message->get(), message->getLength(), 0);
-		erpc_esp_freertos_critical_exit(&lock);
-		assert(received != 0);
-		xEventGroupSetBits(this->events_.handle, EVENT_STATUS_RX_QUEUE_READ);
-
-		message->setUsed(received);
-		xEventGroupClearBits(this->events_.handle,
-							 EVENT_STATUS_NEW_FRAME_PENDING);
-		return kErpcStatus_Success;
-	} else {
-		erpc_esp_freertos_critical_exit(&lock);
+void TinyprotoTransport::compress_tx_frame(void) {
+#if CONFIG_ERPC_ESP_TINYPROTO_COMPRESSION
+	if (!(this->peer_features_ & LINK_FEATURE_LZF) ||
+		this->config_.compression_threshold == 0 ||
+		this->tx_frame_.payload_len < this->config_.compression_threshold) {
+		return;
 	}
+	size_t len = link_compress_frame(this->tx_frame_.data, this->tx_frame_.len,
+									 this->lzf_.tx, this->lzf_.htab);
+	if (len != 0) {
+		this->tx_frame_.ptr = this->lzf_.tx;
+		this->tx_frame_.len = len;
+	}
+#endif
+}
 
-	{
-		erpc_status_t status = kErpcStatus_Success;
-		/*
-		 * No frame yet. Wait to receive.
-		 */
-		EventBits_t event = xEventGroupWaitBits(
-			this->events_.handle,
-			EVENT_STATUS_NEW_FRAME_PENDING | EVENT_STATUS_DISCONNECTED |
-				EVENT_STATUS_CLOSED,
-			pdFALSE, pdFALSE, this->config_.receive_timeout);
-
-		bool event_received = false;
-		if (event & EVENT_STATUS_NEW_FRAME_PENDING) {
-			/*
-			 * Is it possible to lose events due to clearing this bit at
-			 * this stage, instead of passing pdTRUE to the xClearOnExit
-			 * parameter of xEventGroupWaitBits? Yes. But, as commented above,
-			 * if multiple frames are received quickly,
-			 * EVENT_STATUS_NEW_FRAME_PENDING may be set multiple times, in
-			 * which case we also lose events.
-			 * That's why we also initially check whether the message buffer
-			 * is empty or not and if not read what's left in there.
-			 * We don't rely on EVENT_STATUS_NEW_FRAME_PENDING as the *only*
-			 * "trigger" to read from the message buffer, so we don't risk
-			 * leaving unread data in the message buffer.
-			 * OTOH not using xClearOnExit makes things easier. In fact
-			 * FreeRTOS doesn't allow to clear *only some of the bits we are
-			 * waiting for* on exit, which means that we can't wait for other
-			 * "shared" event bits (e.g. EVENT_STATUS_CLOSED) while we're
-			 * waiting for EVENT_STATUS_NEW_FRAME_PENDING if we wanted to clear
-			 * it with xClearOnExit, because also these would be cleared if set
-			 * while we're waiting, which is not what we want.
-			 */
-			xEventGroupClearBits(this->events_.handle,
-								 EVENT_STATUS_NEW_FRAME_PENDING);
-			erpc_esp_freertos_critical_enter(&lock);
-			if (!xMessageBufferIsEmpty(this->rx_fifo_.handle)) {
-				size_t received =
-					xMessageBufferReceive(this->rx_fifo_.handle, message->get(),
-										  message->getLength(), 0);
-				erpc_esp_freertos_critical_exit(&lock);
-				assert(received != 0);
-				xEventGroupSetBits(this->events_.handle,
-								   EVENT_STATUS_RX_QUEUE_READ);
-
-				message->setUsed(received);
-			} else {
-				erpc_esp_freertos_critical_exit(&lock);
-			}
-
-			event_received = true;
+void TinyprotoTransport::receive_cb(void *user_data, uint8_t addr,
+									tinyproto::IPacket &pkt) {
+	TinyprotoTransport *pthis = static_cast<TinyprotoTransport *>(user_data);
+	link_frame frame;
+#if CONFIG_ERPC_ESP_TINYPROTO_COMPRESSION
+	uint8_t *rx = pthis->lzf_.rx;
+	size_t rx_size = sizeof(pthis->lzf_.rx);
+#else
+	// We don't advertise LZF, so the peer is not supposed to compress
+	uint8_t *rx = NULL;
+	size_t rx_size = 0;
+#endif
+	if (!link_decode_frame(reinterpret_cast<const uint8_t *>(pkt.data()),
+						   pkt.size(), rx, rx_size, &frame)) {
+		ESP_LOGW(TAG, "Dropped invalid frame of %u bytes",
+				 (unsigned)pkt.size());
+		++pthis->stats_.rx_errors;
+		return;
+	}
+	uint8_t header = frame.header;
+	const uint8_t *payload = frame.payload;
+	size_t payload_len = frame.payload_len;
+	if (LINK_HEADER_IS_COMPRESSED(header)) {
+		++pthis->stats_.rx_compressed_frames;
+	}
+	++pthis->stats_.rx_frames;
+	pthis->stats_.rx_payload_bytes += payload_len;
+	pthis->stats_.rx_wire_bytes += frame.wire_len;
+
+	switch (LINK_HEADER_GET_KIND(header)) {
+	case LINK_FRAME_KIND_RPC:
+	case LINK_FRAME_KIND_BATCH: {
+		TinyprotoChannel *channel =
+			pthis->channel(LINK_HEADER_GET_CHANNEL(header));
+		if (channel == NULL) {
+			ESP_LOGW(TAG, "Frame for unknown channel %u",
+					 LINK_HEADER_GET_CHANNEL(header));
+			++pthis->stats_.rx_errors;
+			break;
 		}
-		if (event & (EVENT_STATUS_CLOSED | EVENT_STATUS_DISCONNECTED)) {
-			xMessageBufferReset(this->rx_fifo_.handle);
-			/*
-			 * Disconnected or closed. Why do we return kErpcStatus_Timeout
-			 * instead of kErpcStatus_ConnectionClosed? Well, eRPC unblocks
-			 * clients only when the error is timeout... See
-			 * https://github.com/EmbeddedRPC/erpc/blob/cd8ffc8c7f08cb6fb123b86422ecbb738a26a69c/erpc_c/infra/erpc_transport_arbitrator.cpp#L79-L90
-			 */
-			status = kErpcStatus_Timeout;
-
-			event_received = true;
+		if (LINK_HEADER_GET_KIND(header) == LINK_FRAME_KIND_RPC) {
+			channel->onReceive(payload, payload_len);
+		} else {
+			pthis->on_batch(*channel, payload, payload_len);
 		}
+		break;
+	}
+	case LINK_FRAME_KIND_CONTROL:
+		pthis->on_control(payload, payload_len);
+		break;
+	case LINK_FRAME_KIND_STREAM: {
+		TinyprotoStream *stream =
+			pthis->stream(LINK_HEADER_GET_CHANNEL(header));
+		if (stream == NULL) {
+			ESP_LOGW(TAG, "Frame for unknown stream %u",
+					 LINK_HEADER_GET_CHANNEL(header));
+			++pthis->stats_.rx_errors;
+			break;
+		}
+		stream->onFrame(payload, payload_len);
+		break;
+	}
+	default:
+		ESP_LOGW(TAG, "Unknown frame kind %u", LINK_HEADER_GET_KIND(header));
+		++pthis->stats_.rx_errors;
+		break;
+	}
+}
 
-		if (!event_received) {
-			// None of the events we waited for is set. xEventGroupWaitBits
-			// timed out
-			status = kErpcStatus_Timeout;
+void TinyprotoTransport::on_batch(TinyprotoChannel &channel,
+								  const uint8_t *data, size_t size) {
+	const uint8_t *message;
+	size_t message_size;
+	while (link_batch_next(&data, &size, &message, &message_size)) {
+		channel.onReceive(message, message_size);
+	}
+	if (size != 0) {
+		// The messages before are valid, they have been kept
+		ESP_LOGW(TAG, "Truncated batch on channel %u", channel.id_);
+		++this->stats_.rx_errors;
+	}
+}
+
+void TinyprotoTransport::on_control(const uint8_t *data, size_t size) {
+	link_control control;
+	if (!link_decode_control(data, size, &control)) {
+		ESP_LOGW(TAG, "Invalid control message of %u bytes", (unsigned)size);
+		++this->stats_.rx_errors;
+		return;
+	}
+	switch (control.op) {
+	case LINK_CONTROL_HELLO:
+		// Newer versions only add features, so the version is informative
+		ESP_LOGI(TAG, "Peer link version %u, features 0x%02x",
+				 control.version, control.features);
+		this->peer_features_ = control.features;
+		if (this->peer_features_ & LINK_FEATURE_CREDIT) {
+			for (uint8_t i = 0; i < ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS;
+				 ++i) {
+				if (this->channels_[i].isInitialized()) {
+					this->channels_[i].onPeerHello();
+				}
+			}
+			// Let the TX task grant the RX windows
+			xEventGroupSetBits(this->events_.handle,
+							   EVENT_STATUS_POTENTIAL_NEW_TX);
 		}
-		return status;
+		break;
+	case LINK_CONTROL_CREDIT: {
+		// The peer doesn't know which channels we have
+		TinyprotoChannel *channel = this->channel(control.channel);
+		if (channel != NULL) {
+			channel->onCredit(control.credit);
+		}
+		break;
+	}
 	}
 }
 
-bool TinyprotoTransport::hasMessage(void) {
-	return !xMessageBufferIsEmpty(this->rx_fifo_.handle);
+void TinyprotoTransport::connect_cb(void *user_data, uint8_t addr,
+									bool connected) {
+	TinyprotoTransport *pthis = static_cast<TinyprotoTransport *>(user_data);
+	// Until the HELLO of the peer, assume it supports nothing
+	pthis->peer_features_ = 0;
+	if (connected) {
+		for (uint8_t i = 0; i < ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS;
+			 ++i) {
+			if (pthis->channels_[i].isInitialized()) {
+				pthis->channels_[i].onConnect();
+			}
+		}
+		pthis->hello_pending_ = true;
+		xEventGroupSetBits(pthis->events_.handle, EVENT_STATUS_CONNECTED);
+		xEventGroupClearBits(pthis->events_.handle, EVENT_STATUS_DISCONNECTED);
+		xEventGroupSetBits(pthis->events_.handle,
+						   EVENT_STATUS_POTENTIAL_NEW_TX);
+		if (pthis->config_.on_connect_status_change_cb) {
+			pthis->config_.on_connect_status_change_cb(true);
+		}
+	} else {
+		/*
+		 * Notify before waking up the receivers, so that e.g. the arbitrated
+		 * client (see erpc_esp_arbitrated_client.h) fails the pending calls
+		 * due to the connection loss, rather than due to the receive error.
+		 */
+		if (pthis->config_.on_connect_status_change_cb) {
+			pthis->config_.on_connect_status_change_cb(false);
+		}
+		xEventGroupSetBits(pthis->events_.handle, EVENT_STATUS_DISCONNECTED);
+		xEventGroupClearBits(pthis->events_.handle, EVENT_STATUS_CONNECTED);
+		pthis->reset_streams();
+	}
 }
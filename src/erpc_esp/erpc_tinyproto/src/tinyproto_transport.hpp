@@ -18,7 +18,8 @@
 
 #include "erpc_esp_tinyproto_transport_setup.h"
 
-#include "erpc_framed_transport.hpp"
+#include "tinyproto_channel.hpp"
+#include "tinyproto_stream.hpp"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
@@ -28,6 +29,14 @@
 
 #include "TinyProtocolFd.h"
 
+#include "erpc_esp/utils.h"
+
+#include "sdkconfig.h"
+
+#if CONFIG_ERPC_ESP_TINYPROTO_COMPRESSION
+#include "tinyproto_lzf.h"
+#endif
+
 #include <string>
 
 namespace erpc {
@@ -37,9 +46,12 @@ namespace esp {
  * @brief Tinyproto transport layer
  *
  * Tinyproto (which is based on HDLC) is already a framed protocol, so we
- * inherit from Transport instead of FramedTransport
+ * don't use FramedTransport.
+ * The link is shared by up to #ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS
+ * channels, each one being an eRPC transport. Every frame starts with a
+ * link header (see tinyproto_link.h) that tells to which channel it belongs.
  */
-class TinyprotoTransport : public Transport {
+class TinyprotoTransport {
   public:
 	/*!
 	 * @brief Constructor.
@@ -76,27 +88,48 @@ class TinyprotoTransport : public Transport {
 	 */
 	erpc_status_t wait_connected(TickType_t timeout);
 
-  private:
 	/*!
-	 * @brief Write data to the Tinyproto connection.
+	 * @brief Initialize an additional channel. Must be called before open.
+	 *
+	 * @retval NULL invalid channel number or configuration
+	 */
+	TinyprotoChannel *
+	init_channel(uint8_t id,
+				 const erpc_esp_transport_tinyproto_channel_config &config);
+
+	/*!
+	 * @brief Get a channel
 	 *
-	 * @param[in] message Message to send.
+	 * @retval NULL channel not initialized
+	 */
+	TinyprotoChannel *channel(uint8_t id);
+
+	/*!
+	 * @brief Initialize a stream. Must be called before open.
 	 *
-	 * @retval kErpcStatus_ReceiveFailed Serial failed to receive data.
-	 * @retval kErpcStatus_Success Successfully received all data.
+	 * @retval NULL invalid stream id or configuration
 	 */
-	virtual erpc_status_t send(MessageBuffer *message) override;
+	TinyprotoStream *
+	init_stream(uint8_t id,
+				const erpc_esp_transport_tinyproto_stream_config &config);
 
 	/*!
-	 * @brief Read data from the Tinyproto connection.
+	 * @brief Get a stream
 	 *
-	 * @param[in] message Message to receive.
+	 * @retval NULL stream not initialized
+	 */
+	TinyprotoStream *stream(uint8_t id);
+
+	/*!
+	 * @brief Get the transport statistics.
 	 *
-	 * @retval kErpcStatus_ReceiveFailed Serial failed to receive data.
-	 * @retval kErpcStatus_Success Successfully received all data.
+	 * @param[out] stats statistics
 	 */
-	virtual erpc_status_t receive(MessageBuffer *message) override;
-	virtual bool hasMessage(void) override;
+	void get_stats(erpc_esp_transport_tinyproto_stats *stats) const;
+
+  private:
+	friend class TinyprotoChannel;
+	friend class TinyprotoStream;
 
 	static void rx_task(void *user_data);
 	static void tx_task(void *user_data);
@@ -110,6 +143,50 @@ class TinyprotoTransport : public Transport {
 	 */
 	static void connect_cb(void *user_data, uint8_t addr, bool connected);
 
+	/**
+	 * Pass the frames queued by the channels to Tinyproto, highest priority
+	 * first, until Tinyproto can't accept more. Also queues the batches whose
+	 * timeout has expired. Called by tx_task.
+	 */
+	void schedule_tx(void);
+	/**
+	 * Stage the HELLO control message, which advertises our features.
+	 */
+	void stage_hello(void);
+	/**
+	 * Stage a frame that returns credit to the peer of a channel or of a
+	 * stream, if any.
+	 */
+	void stage_credit(void);
+	/**
+	 * Get the TX queue and priority of a channel (index below
+	 * #ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS) or of a stream.
+	 *
+	 * @retval NULL channel or stream not initialized
+	 */
+	TinyprotoFrameQueue *tx_source(size_t index, uint8_t *priority);
+	/**
+	 * Wake up the writers of a TX source, after a frame has been taken.
+	 */
+	void on_tx_source_read(size_t index);
+	/**
+	 * Close all the streams, on disconnection or closure.
+	 */
+	void reset_streams(void);
+	/**
+	 * Compress the staged frame, if worth it and the peer supports it.
+	 */
+	void compress_tx_frame(void);
+	/**
+	 * Pass the messages of a received batch to the channel
+	 */
+	void on_batch(TinyprotoChannel &channel, const uint8_t *data,
+				  size_t size);
+	/**
+	 * Handle a received control message
+	 */
+	void on_control(const uint8_t *data, size_t size);
+
 	/**
 	 * Full-duplex Tinyproto instance
 	 */
@@ -149,28 +226,71 @@ class TinyprotoTransport : public Transport {
 	 * Configuration
 	 */
 	erpc_esp_transport_tinyproto_config config_;
+	TinyprotoChannel channels_[ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS];
+	TinyprotoStream streams_[ERPC_ESP_TRANSPORT_TINYPROTO_MAX_STREAMS];
 	/**
-	 * FIFO that contains data that received via receive_cb (called by
-	 * Tinyproto) and that receive waits.
+	 * Storage of the FIFOs of channel 0.
+	 *
+	 * This value bottlenecks the max eRPC message size.
+	 *
+	 * For now just hard-code a reasonably big value, which suffices my
+	 * needs.
 	 */
 	struct {
-		StaticMessageBuffer_t buf;
-		MessageBufferHandle_t handle;
+		uint8_t rx[2048 + 256];
+		uint8_t tx[2048 + 256];
+	} channel0_buffers_;
+	/**
+	 * Frame taken from a TX queue and not yet accepted by Tinyproto
+	 */
+	struct {
+		uint8_t data[sizeof(channel0_buffers_.tx)];
+		size_t len;
+		/**
+		 * Frame to pass to Tinyproto: either data or its compressed version
+		 */
+		const uint8_t *ptr;
 		/**
-		 * This value bottlenecks the max eRPC message size.
-		 *
-		 * TODO: We should implement TinyprotoTransport as FramedTransport and
-		 * use a StreamBuffer instead.
-		 *
-		 * For now just hard-code a reasonably big value, which suffices my
-		 * needs.
+		 * Size of the payload before compression
 		 */
-		uint8_t buffer[2048 + 256];
-	} rx_fifo_;
+		size_t payload_len;
+	} tx_frame_;
+	/**
+	 * TX source last served by schedule_tx, for round-robin among sources
+	 * with the same priority. See tx_source.
+	 */
+	uint8_t tx_last_source_;
 	struct {
 		StaticEventGroup_t buf;
 		EventGroupHandle_t handle;
 	} events_;
+	/**
+	 * Protects the RX FIFOs and the credit of the channels
+	 */
+	erpc_esp_freertos_critical_section_lock rx_lock_ =
+		ERPC_ESP_FREERTOS_CRITICAL_SECTION_LOCK_INIT;
+	/**
+	 * Set on connection, cleared by the TX task when it stages the HELLO
+	 */
+	volatile bool hello_pending_;
+	/**
+	 * Features advertised by the peer in its HELLO, see link_feature
+	 */
+	volatile uint8_t peer_features_;
+	erpc_esp_transport_tinyproto_stats stats_;
+#if CONFIG_ERPC_ESP_TINYPROTO_COMPRESSION
+	struct {
+		tinyproto_lzf_htab htab;
+		/**
+		 * Compressed version of tx_frame_, used by the TX task
+		 */
+		uint8_t tx[sizeof(tx_frame_.data)];
+		/**
+		 * Decompressed received frame, used by the RX task
+		 */
+		uint8_t rx[sizeof(tx_frame_.data)];
+	} lzf_;
+#endif
 };
 } // namespace esp
 } // namespace erpc
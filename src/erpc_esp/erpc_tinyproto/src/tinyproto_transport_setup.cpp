@@ -14,6 +14,7 @@
  * \copyright	Copyright 2021 Kerr s.r.l. - All Rights Reserved.
  */
 
+#include "erpc_esp_tinyproto_stream.h"
 #include "erpc_esp_tinyproto_transport_setup.h"
 
 #include "tinyproto_transport.hpp"
@@ -31,7 +32,14 @@ erpc_transport_t erpc_esp_transport_tinyproto_init(
 	const struct erpc_esp_transport_tinyproto_config *config) {
 
 	s_transport.construct(buffer, buffer_size, write_func, read_func, *config);
-	return reinterpret_cast<erpc_transport_t>(s_transport.get());
+	return reinterpret_cast<erpc_transport_t>(s_transport->channel(0));
+}
+
+erpc_transport_t erpc_esp_transport_tinyproto_channel_init(
+	uint8_t channel,
+	const struct erpc_esp_transport_tinyproto_channel_config *config) {
+	return reinterpret_cast<erpc_transport_t>(
+		s_transport->init_channel(channel, *config));
 }
 
 void erpc_esp_transport_tinyproto_open(void) {
@@ -44,3 +52,39 @@ void erpc_esp_transport_tinyproto_close(void) {
 bool erpc_esp_transport_tinyproto_wait_connected(TickType_t timeout) {
 	return s_transport->wait_connected(timeout) == kErpcStatus_Success;
 }
+
+void erpc_esp_transport_tinyproto_get_stats(
+	struct erpc_esp_transport_tinyproto_stats *stats) {
+	s_transport->get_stats(stats);
+}
+
+erpc_esp_tinyproto_stream_t erpc_esp_transport_tinyproto_stream_init(
+	uint8_t id,
+	const struct erpc_esp_transport_tinyproto_stream_config *config) {
+	return reinterpret_cast<erpc_esp_tinyproto_stream_t>(
+		s_transport->init_stream(id, *config));
+}
+
+erpc_status_t
+erpc_esp_transport_tinyproto_stream_open(erpc_esp_tinyproto_stream_t stream) {
+	return reinterpret_cast<TinyprotoStream *>(stream)->open();
+}
+
+erpc_status_t erpc_esp_transport_tinyproto_stream_write(
+	erpc_esp_tinyproto_stream_t stream, const void *data, size_t size,
+	size_t *written, TickType_t timeout) {
+	return reinterpret_cast<TinyprotoStream *>(stream)->write(
+		static_cast<const uint8_t *>(data), size, written, timeout);
+}
+
+erpc_status_t erpc_esp_transport_tinyproto_stream_read(
+	erpc_esp_tinyproto_stream_t stream, void *data, size_t size, size_t *read,
+	TickType_t timeout) {
+	return reinterpret_cast<TinyprotoStream *>(stream)->read(
+		static_cast<uint8_t *>(data), size, read, timeout);
+}
+
+erpc_status_t
+erpc_esp_transport_tinyproto_stream_close(erpc_esp_tinyproto_stream_t stream) {
+	return reinterpret_cast<TinyprotoStream *>(stream)->close();
+}
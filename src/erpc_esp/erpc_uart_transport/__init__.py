@@ -0,0 +1,164 @@
+import struct
+import threading
+import time
+
+import erpc
+from erpc.crc16 import Crc16
+
+
+class SyncFramedTransportTimeoutError(Exception):
+    def __init__(self, msg="Receive timed out", *args, **kwargs):
+        super().__init__(msg, *args, **kwargs)
+
+
+class SyncFramedTransport(erpc.transport.Transport):
+    """
+    Python counterpart of the ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC framing of
+    the ESP-IDF UART transport.
+
+    Each frame is made of a 2 bytes sync preamble, the payload size, the
+    payload CRC, the CRC of size and payload CRC and finally the payload. All
+    the fields are little endian.
+    Corrupted frames are silently dropped and the receiver resumes on the next
+    valid frame.
+    """
+
+    PREAMBLE = b"\xa5\x5a"
+    HEADER_FORMAT = "<2sHHH"
+    HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+
+    def __init__(
+        self,
+        read_func,
+        write_func,
+        max_message_size: int = 0xFFFF,
+        inter_byte_timeout: float = 0.02,
+        receive_timeout: float = None,
+    ):
+        """
+        SyncFramedTransport constructor
+
+        :param read_func function that takes the maximum number of bytes to read
+        and returns the read bytes. It may return less bytes than requested, or
+        no bytes at all, but it should not block indefinitely.
+        :param write_func function that writes all the given bytes
+        :param max_message_size maximum accepted payload size.
+        :param inter_byte_timeout maximum time to wait for the next byte once a
+        frame has started, in seconds.
+        :param receive_timeout receive timeout in seconds. None means no timeout.
+        """
+        super(SyncFramedTransport, self).__init__()
+        self._read_func = read_func
+        self._write_func = write_func
+        self._max_message_size = max_message_size
+        self._inter_byte_timeout = inter_byte_timeout
+        self._receive_timeout = receive_timeout
+        self._crc = Crc16()
+        self._send_lock = threading.Lock()
+        self._receive_lock = threading.Lock()
+        self._pending = bytearray()
+        self.stats = {
+            "rx_frames": 0,
+            "rx_discarded_bytes": 0,
+            "rx_header_errors": 0,
+            "rx_crc_errors": 0,
+            "rx_timeouts": 0,
+        }
+
+    def send(self, message):
+        message = bytes(message)
+        size = len(message)
+        crc = self._crc.computeCRC16(message)
+        header_crc = self._crc.computeCRC16(struct.pack("<HH", size, crc))
+        header = struct.pack(self.HEADER_FORMAT, self.PREAMBLE, size, crc, header_crc)
+        with self._send_lock:
+            self._write_func(header + message)
+
+    def _fill(self, size: int, deadline: float = None, gap: float = None) -> bool:
+        """
+        Make sure at least ``size`` bytes are pending.
+
+        :param deadline absolute time.monotonic() deadline. None means forever.
+        :param gap maximum time between two reads that return some data.
+        None means forever.
+        :rtype bool: False on timeout.
+        """
+        last_rx = time.monotonic()
+        while len(self._pending) < size:
+            now = time.monotonic()
+            if deadline is not None and now >= deadline:
+                return False
+            if gap is not None and now - last_rx >= gap:
+                return False
+            read_bytes = self._read_func(size - len(self._pending))
+            if len(read_bytes) > 0:
+                self._pending += read_bytes
+                last_rx = time.monotonic()
+        return True
+
+    def receive(self):
+        with self._receive_lock:
+            overall_deadline = None
+            if self._receive_timeout is not None:
+                overall_deadline = time.monotonic() + self._receive_timeout
+
+            while True:
+                if not self._fill(1, overall_deadline):
+                    raise SyncFramedTransportTimeoutError()
+
+                # Hunt for the preamble
+                index = self._pending.find(self.PREAMBLE)
+                if index < 0:
+                    # Keep a possible first preamble byte at the end
+                    keep = 1 if self._pending[-1:] == self.PREAMBLE[:1] else 0
+                    discarded = len(self._pending) - keep
+                    self.stats["rx_discarded_bytes"] += discarded
+                    del self._pending[:discarded]
+                    if keep and not self._fill(2, gap=self._inter_byte_timeout):
+                        self.stats["rx_discarded_bytes"] += len(self._pending)
+                        self._pending.clear()
+                    continue
+                self.stats["rx_discarded_bytes"] += index
+                del self._pending[:index]
+
+                # From here on, when the frame is dropped, the bytes following
+                # its preamble are scanned again: if bytes have been lost, they
+                # may hold the next frame.
+                if not self._fill(self.HEADER_SIZE, gap=self._inter_byte_timeout):
+                    self.stats["rx_timeouts"] += 1
+                    self.stats["rx_discarded_bytes"] += len(self.PREAMBLE)
+                    del self._pending[: len(self.PREAMBLE)]
+                    continue
+
+                _, size, crc, header_crc = struct.unpack_from(
+                    self.HEADER_FORMAT, self._pending
+                )
+                if (
+                    self._crc.computeCRC16(bytes(self._pending[2:6])) != header_crc
+                    or size == 0
+                    or size > self._max_message_size
+                ):
+                    # Not a real preamble
+                    self.stats["rx_header_errors"] += 1
+                    self.stats["rx_discarded_bytes"] += len(self.PREAMBLE)
+                    del self._pending[: len(self.PREAMBLE)]
+                    continue
+
+                if not self._fill(
+                    self.HEADER_SIZE + size, gap=self._inter_byte_timeout
+                ):
+                    self.stats["rx_timeouts"] += 1
+                    self.stats["rx_discarded_bytes"] += len(self.PREAMBLE)
+                    del self._pending[: len(self.PREAMBLE)]
+                    continue
+
+                payload = bytes(self._pending[self.HEADER_SIZE : self.HEADER_SIZE + size])
+                if self._crc.computeCRC16(payload) != crc:
+                    self.stats["rx_crc_errors"] += 1
+                    self.stats["rx_discarded_bytes"] += len(self.PREAMBLE)
+                    del self._pending[: len(self.PREAMBLE)]
+                    continue
+                del self._pending[: self.HEADER_SIZE + size]
+
+                self.stats["rx_frames"] += 1
+                return payload
@@ -18,6 +18,7 @@
 #define ERPC_ESP_UART_TRANSPORT_SETUP_H_
 
 #include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -31,16 +32,171 @@ extern "C" {
  */
 typedef struct ErpcTransport *erpc_transport_t;
 
+/**
+ * How the UART transport waits for incoming bytes.
+ */
+enum erpc_esp_transport_uart_receive_mode {
+	/**
+	 * Block in `uart_read_bytes` until the exact number of requested bytes
+	 * has been received.
+	 */
+	ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_BLOCKING,
+	/**
+	 * Wait on the UART driver event queue and drain the RX ring buffer as
+	 * soon as the driver reports new data (RX FIFO full or RX idle timeout).
+	 * Overflow events flush the RX ring buffer and fail the current receive.
+	 */
+	ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_EVENT,
+};
+
+/**
+ * How eRPC messages are delimited on the wire.
+ */
+enum erpc_esp_transport_uart_framing {
+	/**
+	 * Plain eRPC FramedTransport framing: 16 bit size + 16 bit CRC, followed
+	 * by the payload. Compatible with the other eRPC serial transports, but a
+	 * single corrupted size field stalls the link.
+	 */
+	ERPC_ESP_TRANSPORT_UART_FRAMING_BASIC,
+	/**
+	 * Each frame starts with a 2 bytes sync preamble and carries a CRC of its
+	 * header. The receiver hunts for the preamble, drops frames with an
+	 * invalid header, an oversized payload, a payload CRC mismatch or an
+	 * inter-byte gap longer than
+	 * erpc_esp_transport_uart_config::receive_timeout, and resumes on the next
+	 * valid frame. The bytes of a dropped frame are scanned again, so a frame
+	 * starting among them is not lost. This needs a buffer as large as the
+	 * largest frame, allocated at initialization.
+	 */
+	ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC,
+};
+
+/**
+ * UART transport configuration.
+ */
+struct erpc_esp_transport_uart_config {
+	/**
+	 * Size of the UART driver RX ring buffer. Must be greater than the size
+	 * of the hardware FIFO (UART_FIFO_LEN).
+	 */
+	int rx_buffer_size;
+	/**
+	 * Size of the UART driver TX ring buffer. 0 means that
+	 * `uart_write_bytes` blocks until all the data has been pushed into the
+	 * hardware FIFO.
+	 */
+	int tx_buffer_size;
+	/**
+	 * Depth of the UART driver event queue. The queue is only created with
+	 * #ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_EVENT, where 0 selects
+	 * #ERPC_ESP_TRANSPORT_UART_EVENT_QUEUE_SIZE_DEFAULT.
+	 */
+	int event_queue_size;
+	/**
+	 * Number of bytes in the RX hardware FIFO that triggers the RX FIFO full
+	 * interrupt. Lower values reduce latency, higher values reduce the
+	 * interrupt load at high baud rates.
+	 */
+	int rx_full_threshold;
+	/**
+	 * RX idle timeout, in UART symbols (time to transmit one byte). When the
+	 * line is idle for this long, the data in the hardware FIFO is delivered
+	 * even if #rx_full_threshold has not been reached.
+	 */
+	uint8_t rx_timeout;
+	/**
+	 * Receive mode
+	 */
+	enum erpc_esp_transport_uart_receive_mode receive_mode;
+	/**
+	 * Framing
+	 */
+	enum erpc_esp_transport_uart_framing framing;
+	/**
+	 * Only for #ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC.
+	 * Maximum payload size accepted by the receiver. 0 means that only the
+	 * size of the message buffer is used as limit.
+	 */
+	uint32_t max_message_size;
+	/**
+	 * Only for #ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC.
+	 * Maximum time to wait for the next byte once a frame has started.
+	 * Should be a few byte times at the configured baud rate.
+	 */
+	TickType_t receive_timeout;
+};
+
+/**
+ * Depth of the UART driver event queue used when
+ * erpc_esp_transport_uart_config::event_queue_size is 0
+ */
+#define ERPC_ESP_TRANSPORT_UART_EVENT_QUEUE_SIZE_DEFAULT 20
+
+#define ERPC_ESP_TRANSPORT_UART_CONFIG_DEFAULT()                               \
+	{                                                                          \
+		.rx_buffer_size = 1000, .tx_buffer_size = 1000,                        \
+		.event_queue_size = 0, .rx_full_threshold = 120, .rx_timeout = 10,     \
+		.receive_mode = ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_BLOCKING,         \
+		.framing = ERPC_ESP_TRANSPORT_UART_FRAMING_BASIC,                      \
+		.max_message_size = 0, .receive_timeout = pdMS_TO_TICKS(20),           \
+	}
+
+/**
+ * UART transport statistics.
+ * Only updated when #ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC is used.
+ */
+struct erpc_esp_transport_uart_stats {
+	/**
+	 * Frames successfully received
+	 */
+	uint32_t rx_frames;
+	/**
+	 * Bytes discarded while hunting for the sync preamble
+	 */
+	uint32_t rx_discarded_bytes;
+	/**
+	 * Frames dropped due to an invalid header (header CRC or size)
+	 */
+	uint32_t rx_header_errors;
+	/**
+	 * Frames dropped due to payload CRC mismatch
+	 */
+	uint32_t rx_crc_errors;
+	/**
+	 * Frames dropped because the line went idle in the middle of the frame
+	 */
+	uint32_t rx_timeouts;
+};
+
 /*!
- * @brief Create an ESP-IDF UART transport.
+ * @brief Create an ESP-IDF UART transport with the default configuration.
  *
  * @param [in] port UART port
- * @param [in] baud_rate baud rate
  *
  * @return Return NULL or erpc_transport_t instance pointer.
  */
 erpc_transport_t erpc_esp_transport_uart_init(uart_port_t port);
 
+/*!
+ * @brief Create an ESP-IDF UART transport.
+ *
+ * @param [in] port UART port
+ * @param [in] config UART transport configuration
+ *
+ * @return Return NULL or erpc_transport_t instance pointer.
+ */
+erpc_transport_t erpc_esp_transport_uart_init_with_config(
+	uart_port_t port, const struct erpc_esp_transport_uart_config *config);
+
+/*!
+ * @brief Get the statistics of the UART transport.
+ *
+ * @param [out] stats statistics
+ */
+void erpc_esp_transport_uart_get_stats(
+	struct erpc_esp_transport_uart_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
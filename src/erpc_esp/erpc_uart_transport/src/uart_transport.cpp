@@ -16,25 +16,252 @@
 
 #include "uart_transport.hpp"
 
+#include "erpc_esp_mbf_size_class.hpp"
+#include "erpc_port.h"
+
 #define TAG "erpc_esp_uart"
 #include "esp_log.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
 using namespace erpc::esp;
 
-UARTTransport::UARTTransport(uart_port_t port) : m_port(port) {
+/**
+ * Sync preamble of #ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC frames.
+ * Must be kept in sync with the Python counterpart.
+ */
+static const uint8_t kSyncPreamble[2] = {0xA5, 0x5A};
+
+UARTTransport::UARTTransport(uart_port_t port,
+							 const erpc_esp_transport_uart_config &config)
+	: m_port(port), m_config(config), m_eventQueue(NULL), m_pushback(),
+	  m_stats() {
 }
 
 UARTTransport::~UARTTransport(void) {
 	ESP_ERROR_CHECK(uart_driver_delete(this->m_port));
+	if (this->m_pushback.data != NULL) {
+		erpc_free(this->m_pushback.data);
+	}
 }
 
 erpc_status_t UARTTransport::init(void) {
 	erpc_status_t status = kErpcStatus_Success;
+	int event_queue_size = 0;
+	QueueHandle_t *event_queue = NULL;
+
+	// The blocking mode never reads the events, so don't waste RAM on them
+	if (this->m_config.receive_mode ==
+		ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_EVENT) {
+		event_queue_size = this->m_config.event_queue_size;
+		if (event_queue_size <= 0) {
+			event_queue_size = ERPC_ESP_TRANSPORT_UART_EVENT_QUEUE_SIZE_DEFAULT;
+		}
+		event_queue = &this->m_eventQueue;
+	}
+
+	if (this->m_config.framing == ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC) {
+		// A broken frame is scanned again, header tail and payload included
+		uint32_t max_payload = this->m_config.max_message_size != 0
+								   ? this->m_config.max_message_size
+								   : ERPC_ESP_MAX_MESSAGE_BUFFER_SIZE;
+		this->m_pushback.capacity = sizeof(SyncHeader) + max_payload;
+		this->m_pushback.data = reinterpret_cast<uint8_t *>(
+			erpc_malloc(this->m_pushback.capacity));
+		if (this->m_pushback.data == NULL) {
+			ESP_LOGE(TAG, "Cannot allocate the resynchronization buffer");
+			return kErpcStatus_InitFailed;
+		}
+	}
+
+	ESP_ERROR_CHECK(uart_driver_install(
+		this->m_port, this->m_config.rx_buffer_size,
+		this->m_config.tx_buffer_size, event_queue_size, event_queue, 0));
+	ESP_ERROR_CHECK(uart_set_rx_full_threshold(
+		this->m_port, this->m_config.rx_full_threshold));
 	ESP_ERROR_CHECK(
-		uart_driver_install(this->m_port, 1000, 1000, 100, NULL, 0));
+		uart_set_rx_timeout(this->m_port, this->m_config.rx_timeout));
+	return status;
+}
+
+erpc_status_t UARTTransport::send(MessageBuffer *message) {
+	if (this->m_config.framing != ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC) {
+		return FramedTransport::send(message);
+	}
+
+	erpc_assert(this->m_crcImpl != NULL);
+
+	uint32_t message_size = message->getUsed();
+	SyncHeader h;
+	memcpy(h.m_preamble, kSyncPreamble, sizeof(h.m_preamble));
+	h.m_messageSize = message_size;
+	h.m_crc = this->m_crcImpl->computeCRC16(message->get(), message_size);
+	h.m_headerCrc = this->m_crcImpl->computeCRC16(
+		reinterpret_cast<const uint8_t *>(&h.m_messageSize),
+		sizeof(h.m_messageSize) + sizeof(h.m_crc));
+
+#if !ERPC_THREADS_IS(NONE)
+	Mutex::Guard lock(this->m_sendLock);
+#endif
+	erpc_status_t status =
+		this->underlyingSend(reinterpret_cast<const uint8_t *>(&h), sizeof(h));
+	if (status == kErpcStatus_Success) {
+		status = this->underlyingSend(message->get(), message_size);
+	}
+	// The data is in the UART driver. Release the large buffer, if any.
+	fitMessageBuffer(message, 0);
+	return status;
+}
+
+erpc_status_t UARTTransport::receive(MessageBuffer *message) {
+	if (this->m_config.framing != ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC) {
+		return FramedTransport::receive(message);
+	}
+
+	erpc_assert(this->m_crcImpl != NULL);
+
+#if !ERPC_THREADS_IS(NONE)
+	Mutex::Guard lock(this->m_receiveLock);
+#endif
+	return this->receiveSyncFrame(message);
+}
+
+void UARTTransport::getStats(erpc_esp_transport_uart_stats *stats) const {
+	*stats = this->m_stats;
+}
+
+erpc_status_t UARTTransport::receiveSyncFrame(MessageBuffer *message) {
+	const TickType_t timeout = this->m_config.receive_timeout;
+	SyncHeader h;
+	uint8_t *raw_header = reinterpret_cast<uint8_t *>(&h);
+	uint8_t *raw_header_tail = raw_header + sizeof(h.m_preamble);
+	const uint32_t header_tail_size = sizeof(h) - sizeof(h.m_preamble);
+	uint32_t received;
+
+	// Don't hold a large buffer while waiting for a frame
+	fitMessageBuffer(message, 0);
+
+	while (1) {
+		/*
+		 * Hunt for the preamble. An idle line is not an error, so wait
+		 * forever for the first byte of the preamble.
+		 */
+		uint32_t matched = 0;
+		while (matched < sizeof(kSyncPreamble)) {
+			uint8_t byte;
+			erpc_status_t status = this->receiveSyncBytes(
+				&byte, 1, matched == 0 ? portMAX_DELAY : timeout, &received);
+			if (status != kErpcStatus_Success) {
+				this->m_stats.rx_discarded_bytes += matched;
+				matched = 0;
+				continue;
+			}
+			uint32_t new_matched = 0;
+			if (byte == kSyncPreamble[matched]) {
+				new_matched = matched + 1;
+			} else if (byte == kSyncPreamble[0]) {
+				new_matched = 1;
+			}
+			this->m_stats.rx_discarded_bytes += matched + 1 - new_matched;
+			matched = new_matched;
+		}
+
+		/*
+		 * From here on, whenever the frame is dropped, the bytes following
+		 * its preamble are scanned again: if bytes have been lost, they may
+		 * hold the next frame.
+		 */
+		if (this->receiveSyncBytes(raw_header_tail, header_tail_size, timeout,
+								   &received) != kErpcStatus_Success) {
+			++this->m_stats.rx_timeouts;
+			this->m_stats.rx_discarded_bytes += sizeof(h.m_preamble);
+			this->unreceive(raw_header_tail, received);
+			continue;
+		}
+
+		uint16_t header_crc = this->m_crcImpl->computeCRC16(
+			reinterpret_cast<const uint8_t *>(&h.m_messageSize),
+			sizeof(h.m_messageSize) + sizeof(h.m_crc));
+		bool header_valid = header_crc == h.m_headerCrc && h.m_messageSize != 0;
+		if (this->m_config.max_message_size != 0 &&
+			h.m_messageSize > this->m_config.max_message_size) {
+			header_valid = false;
+		}
+		if (header_valid && !fitMessageBuffer(message, h.m_messageSize)) {
+			header_valid = false;
+		}
+		if (!header_valid) {
+			// What we took for a preamble was probably part of a corrupted
+			// frame
+			++this->m_stats.rx_header_errors;
+			this->m_stats.rx_discarded_bytes += sizeof(h.m_preamble);
+			this->unreceive(raw_header_tail, header_tail_size);
+			continue;
+		}
+
+		erpc_status_t status = this->receiveSyncBytes(
+			message->get(), h.m_messageSize, timeout, &received);
+		if (status == kErpcStatus_Success &&
+			this->m_crcImpl->computeCRC16(message->get(), h.m_messageSize) ==
+				h.m_crc) {
+			message->setUsed(h.m_messageSize);
+			++this->m_stats.rx_frames;
+			return kErpcStatus_Success;
+		}
+
+		if (status != kErpcStatus_Success) {
+			++this->m_stats.rx_timeouts;
+		} else {
+			++this->m_stats.rx_crc_errors;
+		}
+		this->m_stats.rx_discarded_bytes += sizeof(h.m_preamble);
+		this->unreceive(message->get(), received);
+		this->unreceive(raw_header_tail, header_tail_size);
+	}
+}
+
+erpc_status_t UARTTransport::receiveSyncBytes(uint8_t *data, uint32_t size,
+											  TickType_t timeout,
+											  uint32_t *received) {
+	uint32_t from_pushback = std::min(size, this->m_pushback.len);
+	if (from_pushback > 0) {
+		memcpy(data, this->m_pushback.data + this->m_pushback.pos,
+			   from_pushback);
+		this->m_pushback.pos += from_pushback;
+		this->m_pushback.len -= from_pushback;
+	}
+	if (from_pushback == size) {
+		*received = size;
+		return kErpcStatus_Success;
+	}
+	erpc_status_t status = this->receiveBytes(
+		data + from_pushback, size - from_pushback, timeout, received);
+	*received += from_pushback;
 	return status;
 }
 
+void UARTTransport::unreceive(const uint8_t *data, uint32_t size) {
+	// The oldest bytes are the first to go
+	uint32_t room = this->m_pushback.capacity - this->m_pushback.len;
+	if (size > room) {
+		this->m_stats.rx_discarded_bytes += size - room;
+		data += size - room;
+		size = room;
+	}
+
+	if (this->m_pushback.pos < size) {
+		memmove(this->m_pushback.data + size,
+				this->m_pushback.data + this->m_pushback.pos,
+				this->m_pushback.len);
+		this->m_pushback.pos = size;
+	}
+	this->m_pushback.pos -= size;
+	memcpy(this->m_pushback.data + this->m_pushback.pos, data, size);
+	this->m_pushback.len += size;
+}
+
 erpc_status_t UARTTransport::underlyingSend(const uint8_t *data,
 											uint32_t size) {
 	int bytes_written = uart_write_bytes(this->m_port, data, size);
@@ -43,8 +270,115 @@ erpc_status_t UARTTransport::underlyingSend(const uint8_t *data,
 								   : kErpcStatus_Success;
 }
 erpc_status_t UARTTransport::underlyingReceive(uint8_t *data, uint32_t size) {
-	int bytes_read = uart_read_bytes(this->m_port, data, size, portMAX_DELAY);
+	uint32_t received;
+	erpc_status_t status =
+		this->receiveBytes(data, size, portMAX_DELAY, &received);
+
+	return (status != kErpcStatus_Success) ? kErpcStatus_ReceiveFailed
+										   : kErpcStatus_Success;
+}
+
+erpc_status_t UARTTransport::receiveBytes(uint8_t *data, uint32_t size,
+										  TickType_t timeout,
+										  uint32_t *received) {
+	*received = 0;
+	if (this->m_config.receive_mode ==
+		ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_EVENT) {
+		return this->receiveFromEvents(data, size, timeout, received);
+	}
+
+	while (*received < size) {
+		/*
+		 * Take whatever is already buffered, otherwise wait for the next
+		 * byte: the timeout restarts with every chunk of data.
+		 */
+		size_t buffered_len = 0;
+		if (timeout != portMAX_DELAY) {
+			ESP_ERROR_CHECK(
+				uart_get_buffered_data_len(this->m_port, &buffered_len));
+		}
+		uint32_t to_read = size - *received;
+		TickType_t wait = 0;
+		if (buffered_len > 0) {
+			to_read = std::min<uint32_t>(to_read, buffered_len);
+		} else if (timeout != portMAX_DELAY) {
+			to_read = 1;
+			wait = timeout;
+		} else {
+			wait = portMAX_DELAY;
+		}
+
+		int bytes_read =
+			uart_read_bytes(this->m_port, data + *received, to_read, wait);
+		if (bytes_read < 0) {
+			return kErpcStatus_ReceiveFailed;
+		}
+		if (bytes_read == 0) {
+			return kErpcStatus_Timeout;
+		}
+		*received += bytes_read;
+	}
+	return kErpcStatus_Success;
+}
+
+erpc_status_t UARTTransport::receiveFromEvents(uint8_t *data, uint32_t size,
+											   TickType_t timeout,
+											   uint32_t *received) {
+	TickType_t start = xTaskGetTickCount();
+
+	*received = 0;
+	while (*received < size) {
+		/*
+		 * Drain whatever is already in the RX ring buffer first. Events that
+		 * refer to data we have already drained are harmless: they simply
+		 * make us re-check an empty RX buffer.
+		 */
+		size_t buffered_len = 0;
+		ESP_ERROR_CHECK(
+			uart_get_buffered_data_len(this->m_port, &buffered_len));
+		if (buffered_len > 0) {
+			uint32_t to_read =
+				std::min<uint32_t>(size - *received, buffered_len);
+			int bytes_read =
+				uart_read_bytes(this->m_port, data + *received, to_read, 0);
+			if (bytes_read < 0) {
+				return kErpcStatus_ReceiveFailed;
+			}
+			*received += bytes_read;
+			// The timeout is the gap between chunks
+			start = xTaskGetTickCount();
+			continue;
+		}
+
+		TickType_t wait = portMAX_DELAY;
+		if (timeout != portMAX_DELAY) {
+			TickType_t elapsed = xTaskGetTickCount() - start;
+			if (elapsed >= timeout) {
+				return kErpcStatus_Timeout;
+			}
+			wait = timeout - elapsed;
+		}
+
+		uart_event_t event;
+		if (xQueueReceive(this->m_eventQueue, &event, wait) != pdTRUE) {
+			continue;
+		}
+		switch (event.type) {
+		case UART_FIFO_OVF:
+		case UART_BUFFER_FULL:
+			/*
+			 * Bytes have been lost, so the frame we were receiving is
+			 * corrupted anyway. Start over from a clean state.
+			 */
+			ESP_LOGW(TAG, "RX overflow (event %d). Flushing RX buffer",
+					 event.type);
+			uart_flush_input(this->m_port);
+			xQueueReset(this->m_eventQueue);
+			return kErpcStatus_ReceiveFailed;
+		default:
+			break;
+		}
+	}
 
-	return (size != bytes_read) ? kErpcStatus_ReceiveFailed
-								: kErpcStatus_Success;
+	return kErpcStatus_Success;
 }
@@ -16,9 +16,14 @@
 #ifndef ERPC_ESP_UART_TRANSPORT_HPP_H_
 #define ERPC_ESP_UART_TRANSPORT_HPP_H_
 
+#include "erpc_esp_uart_transport_setup.h"
+
 #include "erpc_framed_transport.hpp"
 
 #include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
 
 #include <string>
 
@@ -32,8 +37,12 @@ class UARTTransport : public FramedTransport {
   public:
 	/*!
 	 * @brief Constructor.
+	 *
+	 * @param [in] port UART port
+	 * @param [in] config UART transport configuration
 	 */
-	UARTTransport(uart_port_t port);
+	UARTTransport(uart_port_t port,
+				  const erpc_esp_transport_uart_config &config);
 
 	/*!
 	 * @brief Destructor.
@@ -47,6 +56,38 @@ class UARTTransport : public FramedTransport {
 	 */
 	erpc_status_t init(void);
 
+	/*!
+	 * @brief Receive a message.
+	 *
+	 * With #ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC corrupted frames are
+	 * dropped and the receiver resumes on the next valid frame.
+	 *
+	 * @param[in] message Message buffer, to which will be stored incoming
+	 * message.
+	 *
+	 * @retval kErpcStatus_Success When receiving was successful.
+	 * @retval other Subclass may return other errors from the underlying
+	 * receive.
+	 */
+	virtual erpc_status_t receive(MessageBuffer *message) override;
+
+	/*!
+	 * @brief Send a message.
+	 *
+	 * @param[in] message Message buffer to send.
+	 *
+	 * @retval kErpcStatus_Success When sending was successful.
+	 * @retval other Subclass may return other errors from the underlying send.
+	 */
+	virtual erpc_status_t send(MessageBuffer *message) override;
+
+	/*!
+	 * @brief Get the receive statistics.
+	 *
+	 * @param[out] stats statistics
+	 */
+	void getStats(erpc_esp_transport_uart_stats *stats) const;
+
   private:
 	/*!
 	 * @brief Write data to Serial peripheral.
@@ -70,8 +111,95 @@ class UARTTransport : public FramedTransport {
 	 */
 	virtual erpc_status_t underlyingReceive(uint8_t *data, uint32_t size);
 
+	/*!
+	 * @brief Receive data by waiting on the UART driver event queue.
+	 *
+	 * @param[inout] data Preallocated buffer for receiving data.
+	 * @param[in] size Size of data to read.
+	 * @param[in] timeout Maximum time to wait for the next bytes.
+	 * @param[out] received Number of bytes received, also on failure.
+	 *
+	 * @retval kErpcStatus_ReceiveFailed RX overflow. The RX buffer has been
+	 * flushed.
+	 * @retval kErpcStatus_Timeout Timeout expired.
+	 * @retval kErpcStatus_Success Successfully received all data.
+	 */
+	erpc_status_t receiveFromEvents(uint8_t *data, uint32_t size,
+								   TickType_t timeout, uint32_t *received);
+
+	/*!
+	 * @brief Receive exactly \p size bytes.
+	 *
+	 * \p timeout restarts whenever some bytes are received, i.e. it is the
+	 * longest accepted gap in the data, not a deadline for all of it.
+	 *
+	 * @param[out] received Number of bytes received, also on failure.
+	 *
+	 * @retval kErpcStatus_Timeout Nothing was received for \p timeout.
+	 * @retval kErpcStatus_Success Successfully received all data.
+	 */
+	erpc_status_t receiveBytes(uint8_t *data, uint32_t size,
+							   TickType_t timeout, uint32_t *received);
+
+	/*!
+	 * @brief Like receiveBytes, but consumes the bytes given back by
+	 * unreceive first.
+	 */
+	erpc_status_t receiveSyncBytes(uint8_t *data, uint32_t size,
+								   TickType_t timeout, uint32_t *received);
+
+	/*!
+	 * @brief Give back bytes that have been received but must be scanned
+	 * again for the sync preamble. They are received again before the bytes
+	 * given back earlier.
+	 *
+	 * If they do not fit, the oldest ones are discarded.
+	 */
+	void unreceive(const uint8_t *data, uint32_t size);
+
+	/*!
+	 * @brief Receive one frame using #ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC.
+	 */
+	erpc_status_t receiveSyncFrame(MessageBuffer *message);
+
+	/*!
+	 * @brief Header used by #ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC
+	 */
+	struct SyncHeader {
+		uint8_t m_preamble[2];
+		uint16_t m_messageSize;
+		uint16_t m_crc;
+		/**
+		 * CRC of m_messageSize and m_crc
+		 */
+		uint16_t m_headerCrc;
+	} __attribute__((packed));
+
   private:
 	uart_port_t m_port;
+	/**
+	 * Configuration
+	 */
+	erpc_esp_transport_uart_config m_config;
+	/**
+	 * UART driver event queue. Only created in event receive mode.
+	 */
+	QueueHandle_t m_eventQueue;
+	/**
+	 * Bytes given back by unreceive, m_pushback.data[pos, pos + len).
+	 * Allocated by init with #ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC, large
+	 * enough for the header and the payload of the largest frame.
+	 */
+	struct {
+		uint8_t *data;
+		uint32_t capacity;
+		uint32_t pos;
+		uint32_t len;
+	} m_pushback;
+	/**
+	 * Receive statistics
+	 */
+	erpc_esp_transport_uart_stats m_stats;
 };
 } // namespace esp
 } // namespace erpc
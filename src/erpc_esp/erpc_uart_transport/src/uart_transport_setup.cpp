@@ -26,9 +26,16 @@ using namespace erpc::esp;
 static ManuallyConstructed<UARTTransport> s_transport;
 
 erpc_transport_t erpc_esp_transport_uart_init(uart_port_t port) {
+	const struct erpc_esp_transport_uart_config config =
+		ERPC_ESP_TRANSPORT_UART_CONFIG_DEFAULT();
+	return erpc_esp_transport_uart_init_with_config(port, &config);
+}
+
+erpc_transport_t erpc_esp_transport_uart_init_with_config(
+	uart_port_t port, const struct erpc_esp_transport_uart_config *config) {
 	erpc_transport_t transport;
 
-	s_transport.construct(port);
+	s_transport.construct(port, *config);
 	if (s_transport->init() == kErpcStatus_Success) {
 		transport = reinterpret_cast<erpc_transport_t>(s_transport.get());
 	} else {
@@ -37,3 +44,8 @@ erpc_transport_t erpc_esp_transport_uart_init(uart_port_t port) {
 
 	return transport;
 }
+
+void erpc_esp_transport_uart_get_stats(
+	struct erpc_esp_transport_uart_stats *stats) {
+	s_transport->getStats(stats);
+}
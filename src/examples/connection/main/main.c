@@ -1,4 +1,5 @@
 #include "erpc_arbitrated_client_setup.h"
+#include "erpc_esp_arbitrated_client.h"
 #include "erpc_mbf_setup.h"
 #include "erpc_port.h"
 #include "erpc_server_setup.h"
@@ -64,6 +65,7 @@ char *say_hello_to_target(const char *name, uint32_t ith) {
 #endif
 
 static EventGroupHandle_t g_event_flag;
+static erpc_client_t g_client;
 
 void server_task(void *params) {
 	ESP_LOGI(TAG, "Starting server");
@@ -104,6 +106,10 @@ static void client_error(erpc_status_t err, uint32_t functionID) {
 }
 
 static void on_tinyproto_connect_status_change(bool connected) {
+	if (g_client) {
+		// Fail the pending calls now, rather than after the receive timeout
+		erpc_esp_arbitrated_client_set_connected(g_client, connected);
+	}
 	if (connected) {
 		ESP_LOGI(TAG, "Tinyproto connected");
 		xEventGroupSetBits(g_event_flag, CONNECTED_BIT);
@@ -154,13 +160,13 @@ void app_main() {
 
 	erpc_mbf_t message_buffer_factory = erpc_mbf_static_init();
 	erpc_transport_t arbitrator;
-	erpc_client_t client = erpc_arbitrated_client_init(
+	g_client = erpc_esp_arbitrated_client_init(
 		transport, message_buffer_factory, &arbitrator);
-	erpc_arbitrated_client_set_error_handler(client, client_error);
+	erpc_arbitrated_client_set_error_handler(g_client, client_error);
 #if HOST
-	inithello_world_target_client(client);
+	inithello_world_target_client(g_client);
 #else
-	inithello_world_host_client(client);
+	inithello_world_host_client(g_client);
 #endif
 
 	ESP_LOGD(TAG, "Initializing server");
@@ -119,6 +119,7 @@ static struct erpc_esp_transport_tinyproto_config tinyproto_config =
 	ERPC_ESP_TRANSPORT_TINYPROTO_CONFIG_DEFAULT();
 
 static uint8_t g_tinyproto_rx_buffer[1024];
+static uint8_t g_tinyproto_batch_buffer[512];
 
 void app_main() {
 	ESP_LOGI(TAG, "Target started");
@@ -137,6 +138,9 @@ void app_main() {
 	tinyproto_config.receive_timeout = pdMS_TO_TICKS(5000);
 	tinyproto_config.on_connect_status_change_cb =
 		on_tinyproto_connect_status_change;
+	// say_hello_to_host is oneway: send the calls in batches
+	tinyproto_config.batch.buffer = g_tinyproto_batch_buffer;
+	tinyproto_config.batch.buffer_size = sizeof(g_tinyproto_batch_buffer);
 	erpc_transport_t transport = erpc_esp_transport_tinyproto_init(
 		g_tinyproto_rx_buffer, sizeof(g_tinyproto_rx_buffer),
 		tinyproto_write_fn, tinyproto_read_fn, &tinyproto_config);
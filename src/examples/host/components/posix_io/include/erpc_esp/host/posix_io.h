@@ -19,36 +19,99 @@ extern "C" {
  *
  * Use as opaque type
  */
-typedef struct {
+typedef struct erpc_esp_host_posix_io {
 	int fd;
 	union {
 		struct {
-			struct {
-				StaticMessageBuffer_t buf;
-				StreamBufferHandle_t handle;
-				uint8_t data_buffer[256];
-			} fifo;
+			/**
+			 * FIFO drained by the writer thread
+			 */
+			StreamBufferHandle_t fifo;
+			/**
+			 * Buffer of the writer thread. Everything that is in the FIFO, up
+			 * to chunk_size bytes, is written with a single write().
+			 */
+			uint8_t *chunk;
+			size_t chunk_size;
 		} tx;
 		struct {
-			struct {
-				/**
-				 * NULL if no no pending read to be performed by reader thread
-				 */
-				uint8_t *buffer;
-				size_t buffer_max_size;
-				size_t actually_read_size;
-			} pending;
-			struct {
-				StaticSemaphore_t buf;
-				SemaphoreHandle_t handle;
-			} sem;
+			/**
+			 * Read-ahead FIFO, continuously filled by the reactor thread
+			 */
+			StreamBufferHandle_t fifo;
+			/**
+			 * The FIFO is full and the fd is not armed
+			 */
+			bool paused;
+			/**
+			 * End of file (or unrecoverable error) reached
+			 */
+			bool eof;
+			/**
+			 * The fd is registered in the epoll instance of the reactor.
+			 * False for the fds that epoll cannot watch, e.g. regular files,
+			 * which are always readable.
+			 */
+			bool polled;
 		} rx;
 	} io;
+	/**
+	 * Given from the FreeRTOS world when `waiting` is set and the FIFO is
+	 * no longer empty (readers) or full (writers)
+	 */
+	struct {
+		StaticSemaphore_t buf;
+		SemaphoreHandle_t handle;
+	} sem;
+	/**
+	 * A FreeRTOS task is waiting on `sem`
+	 */
+	bool waiting;
+	/**
+	 * Link in the list of handles whose `sem` must be given from the FreeRTOS
+	 * world
+	 */
+	struct erpc_esp_host_posix_io *notify_next;
+	/**
+	 * Link in the list of armed readers that are not polled
+	 */
+	struct erpc_esp_host_posix_io *ready_next;
 	pthread_mutex_t mutex;
 	pthread_cond_t cond;
 } erpc_esp_host_posix_io;
 
 /**
+ * erpc_esp_host_posix_io configuration
+ */
+struct erpc_esp_host_posix_io_config {
+	/**
+	 * Only for writers.
+	 * Size of the FIFO between erpc_esp_host_posix_write and the writer
+	 * thread.
+	 */
+	size_t tx_fifo_size;
+	/**
+	 * Only for writers.
+	 * Maximum number of bytes written by a single write() call.
+	 */
+	size_t write_chunk_size;
+	/**
+	 * Only for readers.
+	 * Size of the read-ahead FIFO. The fd is drained as long as there is space
+	 * in the FIFO, independently of pending read requests.
+	 */
+	size_t rx_fifo_size;
+};
+
+#define ERPC_ESP_HOST_POSIX_IO_CONFIG_DEFAULT()                                \
+	{                                                                          \
+		.tx_fifo_size = 4096, .write_chunk_size = 4096, .rx_fifo_size = 4096,  \
+	}
+
+/**
+ * Same as erpc_esp_host_posix_io_init_with_config, with the default
+ * configuration.
+ *
  * \param [in] handle:
  * \param [in] fd open file descriptor
  * \param [in] read_or_write false for read, true for write
@@ -56,9 +119,29 @@ typedef struct {
 void erpc_esp_host_posix_io_init(erpc_esp_host_posix_io *handle, int fd,
 								 bool read_or_write);
 
+/**
+ * \param [in] handle:
+ * \param [in] fd open file descriptor
+ * \param [in] read_or_write false for read, true for write
+ * \param [in] config configuration
+ */
+void erpc_esp_host_posix_io_init_with_config(
+	erpc_esp_host_posix_io *handle, int fd, bool read_or_write,
+	const struct erpc_esp_host_posix_io_config *config);
+
+/**
+ * Read at most \p size bytes. Blocks until at least one byte is available.
+ *
+ * \return number of bytes read. 0 on end of file.
+ */
 int erpc_esp_host_posix_read(erpc_esp_host_posix_io *handle, void *data,
 							 size_t size);
 
+/**
+ * Write all the \p size bytes. Blocks while the TX FIFO is full.
+ *
+ * \return \p size
+ */
 int erpc_esp_host_posix_write(erpc_esp_host_posix_io *handle, const void *data,
 							  size_t size);
 
@@ -8,10 +8,13 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <math.h>
-#include <semaphore.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
@@ -22,23 +25,61 @@
 #define SIG_RX_READY SIGUSR2
 
 /**
- * Structure shared between signal handler and all the posix reader threads.
- * Access synchronization happens via the `sem` semaphore .
+ * Maximum number of epoll events handled per epoll_wait
+ */
+#define REACTOR_MAX_EVENTS 16
+
+/**
+ * Maximum number of bytes moved from a reader fd to its FIFO per event
+ */
+#define REACTOR_READ_CHUNK 4096
+
+/**
+ * Reactor shared by all the readers. Its lock-free `notify` list is used also
+ * by the writer threads.
  *
- * Who it works:
+ * How it works:
  *
- * * The semaphore is initially 1.
- * * A reader thread waits for the semaphore then modifies g_rx
- * * The same reader then raises a signal
- * * Until the signal handler posts the signal, all the readers are blocked and
- * can't access g_rx.
+ * * Every reader fd is registered in a single epoll instance with
+ * EPOLLONESHOT, so it is disarmed after each event.
+ * * The fds that epoll cannot watch (e.g. regular files) are always readable:
+ * arming them pushes them on the lock-free `ready` list and wakes the reactor
+ * through `wake_fd`.
+ * * The reactor thread drains each readable fd into the read-ahead FIFO of its
+ * handle and re-arms the fd as long as there is space left in the FIFO.
+ * erpc_esp_host_posix_read re-arms the fd once it has made space in a full
+ * FIFO.
+ * * Only if a FreeRTOS task is waiting for data, the reactor pushes the
+ * handle on the lock-free `notify` list.
+ * * Only the first handle pushed after the signal handler has run raises a
+ * signal. The signal handler gives the semaphore of all the handles in the
+ * list at once.
  */
 static struct {
 	pthread_once_t setup_once;
-	sem_t sem;
-	erpc_esp_host_posix_io *pending_rx;
-} g_rx = {
+	int epoll_fd;
+	/**
+	 * eventfd registered in `epoll_fd`, written when `ready` is pushed to
+	 */
+	int wake_fd;
+	/**
+	 * Lock-free stack of the armed readers that are not registered in
+	 * `epoll_fd`
+	 */
+	_Atomic(erpc_esp_host_posix_io *) ready;
+	/**
+	 * Lock-free stack of handles to be notified
+	 */
+	_Atomic(erpc_esp_host_posix_io *) notify;
+	/**
+	 * True when a signal has been raised and its handler has not yet started
+	 * draining `notify`
+	 */
+	atomic_bool signal_pending;
+} g_reactor = {
 	.setup_once = PTHREAD_ONCE_INIT,
+	.epoll_fd = -1,
+	.wake_fd = -1,
 };
 
 /**
@@ -49,16 +90,24 @@ static struct {
  */
 static void rx_ready_signal_handler(int sig) {
 	assert(sig == SIG_RX_READY);
-	assert(g_rx.pending_rx != NULL);
 
-	BaseType_t high_priority_task_woken;
-	xSemaphoreGiveFromISR(g_rx.pending_rx->io.rx.sem.handle,
-						  &high_priority_task_woken);
+	/*
+	 * Clear the flag before taking the list: handles pushed from now on raise
+	 * a new signal.
+	 */
+	atomic_store(&g_reactor.signal_pending, false);
+	erpc_esp_host_posix_io *handle = atomic_exchange(&g_reactor.notify, NULL);
 
-	g_rx.pending_rx = NULL;
-	// Finished accessing g_rx, unlock it.
-	int ret = sem_post(&g_rx.sem);
-	assert(ret == 0);
+	while (handle != NULL) {
+		/*
+		 * Read the link before giving the semaphore: from then on the handle
+		 * may be pushed again.
+		 */
+		erpc_esp_host_posix_io *next = handle->notify_next;
+		BaseType_t high_priority_task_woken;
+		xSemaphoreGiveFromISR(handle->sem.handle, &high_priority_task_woken);
+		handle = next;
+	}
 }
 
 static void raise_process_signal(int signo) {
@@ -70,95 +119,227 @@ static void raise_process_signal(int signo) {
 	kill(getpid(), signo);
 }
 
-static void setup_rx_signal_handler() {
-	{
-		// initialized an unamed semaphore that is not shared among processes
-		int ret = sem_init(&g_rx.sem, 0, 1);
-		assert(ret == 0);
+/**
+ * Give the semaphore of \p handle from the FreeRTOS world.
+ * Can be called from any pthread.
+ */
+static void notify_task(erpc_esp_host_posix_io *handle) {
+	erpc_esp_host_posix_io *head = atomic_load(&g_reactor.notify);
+	do {
+		handle->notify_next = head;
+	} while (!atomic_compare_exchange_weak(&g_reactor.notify, &head, handle));
+
+	if (!atomic_exchange(&g_reactor.signal_pending, true)) {
+		raise_process_signal(SIG_RX_READY);
+	}
+}
+
+static void arm_reader(erpc_esp_host_posix_io *handle) {
+	if (!handle->io.rx.polled) {
+		erpc_esp_host_posix_io *head = atomic_load(&g_reactor.ready);
+		do {
+			handle->ready_next = head;
+		} while (
+			!atomic_compare_exchange_weak(&g_reactor.ready, &head, handle));
+
+		uint64_t one = 1;
+		int ret = write(g_reactor.wake_fd, &one, sizeof(one));
+		// EAGAIN only if the counter is about to overflow: already woken
+		assert(ret == sizeof(one) || errno == EAGAIN);
+		return;
 	}
 
+	struct epoll_event event = {
+		.events = EPOLLIN | EPOLLONESHOT,
+		.data.ptr = handle,
+	};
+	int ret = epoll_ctl(g_reactor.epoll_fd, EPOLL_CTL_MOD, handle->fd, &event);
+	assert(ret == 0);
+}
+
+static void reactor_read(erpc_esp_host_posix_io *handle) {
+	uint8_t buffer[REACTOR_READ_CHUNK];
+
+	pthread_mutex_lock(&handle->mutex);
+	size_t space = xStreamBufferSpacesAvailable(handle->io.rx.fifo);
+	assert(space > 0);
+	if (space > sizeof(buffer)) {
+		space = sizeof(buffer);
+	}
+	int ret = read(handle->fd, buffer, space);
+	if (ret < 0 && (errno == EAGAIN || errno == EINTR)) {
+		// Spurious wake up
+		pthread_mutex_unlock(&handle->mutex);
+		arm_reader(handle);
+		return;
+	}
+
+	bool rearm = false;
+	if (ret > 0) {
+		/*
+		 * No FreeRTOS task ever blocks on the FIFO, so the FromISR variant is
+		 * safe to be used outside of the FreeRTOS world.
+		 */
+		BaseType_t woken;
+		size_t sent =
+			xStreamBufferSendFromISR(handle->io.rx.fifo, buffer, ret, &woken);
+		assert(sent == ret);
+		if (xStreamBufferSpacesAvailable(handle->io.rx.fifo) > 0) {
+			rearm = true;
+		} else {
+			handle->io.rx.paused = true;
+		}
+	} else {
+		if (ret < 0) {
+			printf("Error [%d]: %s", ret, strerror(errno));
+		}
+		handle->io.rx.eof = true;
+	}
+	bool wake = handle->waiting;
+	handle->waiting = false;
+	pthread_mutex_unlock(&handle->mutex);
+
+	if (rearm) {
+		arm_reader(handle);
+	}
+	if (wake) {
+		notify_task(handle);
+	}
+}
+
+static void *reactor(void *arg) {
+	(void)arg;
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+
+	while (1) {
+		int n = epoll_wait(g_reactor.epoll_fd, events, REACTOR_MAX_EVENTS, -1);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			printf("Error [%d]: %s", n, strerror(errno));
+			assert(0);
+		}
+
+		for (int i = 0; i < n; ++i) {
+			if (events[i].data.ptr != NULL) {
+				reactor_read(events[i].data.ptr);
+				continue;
+			}
+
+			uint64_t count;
+			(void)read(g_reactor.wake_fd, &count, sizeof(count));
+			erpc_esp_host_posix_io *handle =
+				atomic_exchange(&g_reactor.ready, NULL);
+			while (handle != NULL) {
+				// reactor_read may push the handle again
+				erpc_esp_host_posix_io *next = handle->ready_next;
+				reactor_read(handle);
+				handle = next;
+			}
+		}
+	}
+	return NULL;
+}
+
+static void setup_reactor() {
+	g_reactor.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	assert(g_reactor.epoll_fd >= 0);
+	g_reactor.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	assert(g_reactor.wake_fd >= 0);
+	atomic_init(&g_reactor.ready, NULL);
+	atomic_init(&g_reactor.notify, NULL);
+	atomic_init(&g_reactor.signal_pending, false);
+
 	struct sigaction sigtick;
 	sigtick.sa_flags = 0;
 	sigtick.sa_handler = rx_ready_signal_handler;
 	sigfillset(&sigtick.sa_mask);
 	int ret = sigaction(SIG_RX_READY, &sigtick, NULL);
 	assert(ret == 0);
+
+	// Level triggered: the reactor reads it back when it wakes up
+	struct epoll_event wake = {
+		.events = EPOLLIN,
+		.data.ptr = NULL,
+	};
+	ret = epoll_ctl(g_reactor.epoll_fd, EPOLL_CTL_ADD, g_reactor.wake_fd,
+					&wake);
+	assert(ret == 0);
+
+	pthread_t tid;
+	/*
+	 * Create the reactor with all the signals masked, so that FreeRTOS does
+	 * not interfere with it.
+	 */
+	sigset_t set;
+	sigfillset(&set);
+	sigset_t old;
+	pthread_sigmask(SIG_SETMASK, &set, &old);
+	ret = pthread_create(&tid, NULL, reactor, NULL);
+	assert(ret == 0);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
 }
 
 static void *writer(void *arg) {
 	erpc_esp_host_posix_io *handle = arg;
-	uint8_t buffer[256];
 
 	while (1) {
-		// TODO can we use portYIELD_FROM_ISR? I don't think so.
 		BaseType_t woken;
 
 		pthread_mutex_lock(&handle->mutex);
-		size_t n_read = xStreamBufferReceiveFromISR(
-			handle->io.tx.fifo.handle, buffer, sizeof(buffer), &woken);
+		/*
+		 * No FreeRTOS task ever blocks on the FIFO, so the FromISR variant is
+		 * safe to be used outside of the FreeRTOS world.
+		 */
+		size_t n_read =
+			xStreamBufferReceiveFromISR(handle->io.tx.fifo, handle->io.tx.chunk,
+										handle->io.tx.chunk_size, &woken);
 		while (n_read == 0) {
 			pthread_cond_wait(&handle->cond, &handle->mutex);
-			n_read = xStreamBufferReceiveFromISR(
-				handle->io.tx.fifo.handle, buffer, sizeof(buffer), &woken);
+			n_read = xStreamBufferReceiveFromISR(handle->io.tx.fifo,
+												 handle->io.tx.chunk,
+												 handle->io.tx.chunk_size,
+												 &woken);
 		}
+		bool wake = handle->waiting;
+		handle->waiting = false;
 		pthread_mutex_unlock(&handle->mutex);
 
-		assert(n_read > 0);
-		int ret = write(handle->fd, buffer, n_read);
-		if (ret != n_read) {
-			printf("Error [%d]: %s", ret, strerror(errno));
-		}
-	}
-	return NULL;
-}
-static void *reader(void *arg) {
-	erpc_esp_host_posix_io *handle = arg;
-
-	while (1) {
-		pthread_mutex_lock(&handle->mutex);
-		while (handle->io.rx.pending.buffer == NULL) {
-			pthread_cond_wait(&handle->cond, &handle->mutex);
+		if (wake) {
+			// There is space again in the FIFO
+			notify_task(handle);
 		}
 
-		fd_set read_set;
-		FD_ZERO(&read_set);
-		FD_SET(handle->fd, &read_set);
-		int ret = select(handle->fd + 1, &read_set, NULL, NULL, NULL);
-		if (ret < 0) {
-			printf("Error [%d]: %s", ret, strerror(errno));
-			assert(0);
+		size_t written = 0;
+		while (written < n_read) {
+			int ret = write(handle->fd, handle->io.tx.chunk + written,
+							n_read - written);
+			if (ret < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				printf("Error [%d]: %s", ret, strerror(errno));
+				break;
+			}
+			written += ret;
 		}
-		ret = read(handle->fd, handle->io.rx.pending.buffer,
-				   handle->io.rx.pending.buffer_max_size);
-		assert(ret >= 0);
-
-		handle->io.rx.pending.actually_read_size = ret;
-		// clear pending status
-		handle->io.rx.pending.buffer = NULL;
-		handle->io.rx.pending.buffer_max_size = 0;
-		pthread_mutex_unlock(&handle->mutex);
-
-		// lock g_rx
-		ret = sem_wait(&g_rx.sem);
-		assert(ret == 0);
-
-		g_rx.pending_rx = handle;
-		/*
-		 * Raise signal. What happens next is that the signal handler
-		 * will access g_rx and call sem_post to unlock it.
-		 * We don't need to wait until signal handler finishes.
-		 * We can just wait for the next read request, which will be made
-		 * only if the signal handler has finished.
-		 */
-		raise_process_signal(SIG_RX_READY);
 	}
 	return NULL;
 }
 
 void erpc_esp_host_posix_io_init(erpc_esp_host_posix_io *handle, int fd,
 								 bool read_or_write) {
+	const struct erpc_esp_host_posix_io_config config =
+		ERPC_ESP_HOST_POSIX_IO_CONFIG_DEFAULT();
+	erpc_esp_host_posix_io_init_with_config(handle, fd, read_or_write, &config);
+}
+
+void erpc_esp_host_posix_io_init_with_config(
+	erpc_esp_host_posix_io *handle, int fd, bool read_or_write,
+	const struct erpc_esp_host_posix_io_config *config) {
 	{
-		int ret = pthread_once(&g_rx.setup_once, setup_rx_signal_handler);
+		int ret = pthread_once(&g_reactor.setup_once, setup_reactor);
 		assert(ret == 0);
 	}
 
@@ -177,17 +358,46 @@ void erpc_esp_host_posix_io_init(erpc_esp_host_posix_io *handle, int fd,
 	 * object; 3. create pthread.
 	 * At step 3 we may have signals unmasked, which is not what we want.
 	 */
+	handle->sem.handle = xSemaphoreCreateBinaryStatic(&handle->sem.buf);
+	assert(handle->sem.handle);
+	handle->waiting = false;
+	handle->notify_next = NULL;
+
 	if (read_or_write) {
-		handle->io.tx.fifo.handle = xStreamBufferCreateStatic(
-			sizeof(handle->io.tx.fifo.data_buffer), 1,
-			handle->io.tx.fifo.data_buffer, &handle->io.tx.fifo.buf);
-		assert(handle->io.tx.fifo.handle);
+		assert(config->tx_fifo_size > 0);
+		assert(config->write_chunk_size > 0);
+		handle->io.tx.fifo = xStreamBufferCreate(config->tx_fifo_size, 1);
+		assert(handle->io.tx.fifo);
+		handle->io.tx.chunk = malloc(config->write_chunk_size);
+		assert(handle->io.tx.chunk);
+		handle->io.tx.chunk_size = config->write_chunk_size;
 	} else {
 		// set as non-blocking
-		fcntl(handle->fd, F_SETFL, fcntl(0, F_GETFL) | O_NONBLOCK);
-		handle->io.rx.sem.handle =
-			xSemaphoreCreateBinaryStatic(&handle->io.rx.sem.buf);
-		assert(handle->io.rx.sem.handle);
+		fcntl(handle->fd, F_SETFL, fcntl(handle->fd, F_GETFL) | O_NONBLOCK);
+		assert(config->rx_fifo_size > 0);
+		handle->io.rx.fifo = xStreamBufferCreate(config->rx_fifo_size, 1);
+		assert(handle->io.rx.fifo);
+		handle->io.rx.paused = false;
+		handle->io.rx.eof = false;
+		handle->io.rx.polled = true;
+
+		/*
+		 * Register the fd armed: read-ahead starts right away.
+		 */
+		struct epoll_event event = {
+			.events = EPOLLIN | EPOLLONESHOT,
+			.data.ptr = handle,
+		};
+		ret = epoll_ctl(g_reactor.epoll_fd, EPOLL_CTL_ADD, handle->fd, &event);
+		if (ret < 0 && errno == EPERM) {
+			// Regular file or the like: it never blocks
+			handle->io.rx.polled = false;
+			arm_reader(handle);
+		} else {
+			assert(ret == 0);
+		}
+		// Readers are served by the reactor thread
+		return;
 	}
 
 	pthread_t tid;
@@ -199,11 +409,7 @@ void erpc_esp_host_posix_io_init(erpc_esp_host_posix_io *handle, int fd,
 	sigfillset(&set);
 	sigset_t old;
 	pthread_sigmask(SIG_SETMASK, &set, &old);
-	if (read_or_write) {
-		pthread_create(&tid, NULL, writer, handle);
-	} else {
-		pthread_create(&tid, NULL, reader, handle);
-	}
+	pthread_create(&tid, NULL, writer, handle);
 	/*
 	 * Restore signal mask of this thread
 	 */
@@ -212,39 +418,57 @@ void erpc_esp_host_posix_io_init(erpc_esp_host_posix_io *handle, int fd,
 
 int erpc_esp_host_posix_read(erpc_esp_host_posix_io *handle, void *data,
 							 size_t size) {
-	pthread_mutex_lock(&handle->mutex);
-	handle->io.rx.pending.buffer_max_size = size;
-	handle->io.rx.pending.buffer = data;
-	pthread_mutex_unlock(&handle->mutex);
+	while (1) {
+		pthread_mutex_lock(&handle->mutex);
+		size_t read_size =
+			xStreamBufferReceive(handle->io.rx.fifo, data, size, 0);
+		bool resume = read_size > 0 && handle->io.rx.paused;
+		if (resume) {
+			handle->io.rx.paused = false;
+		}
+		bool eof = handle->io.rx.eof;
+		if (read_size == 0 && !eof) {
+			handle->waiting = true;
+		}
+		pthread_mutex_unlock(&handle->mutex);
 
-	// awake reader thread
-	pthread_cond_signal(&handle->cond);
-	BaseType_t res = xSemaphoreTake(handle->io.rx.sem.handle, portMAX_DELAY);
-	assert(res == pdTRUE);
+		if (resume) {
+			// There is space again in the FIFO
+			arm_reader(handle);
+		}
+		if (read_size > 0 || eof) {
+			return read_size;
+		}
 
-	pthread_mutex_lock(&handle->mutex);
-	assert(handle->io.rx.pending.buffer == NULL);
-	assert(handle->io.rx.pending.buffer_max_size == 0);
-	size_t read_size = handle->io.rx.pending.actually_read_size;
-	pthread_mutex_unlock(&handle->mutex);
-	return read_size;
+		BaseType_t res = xSemaphoreTake(handle->sem.handle, portMAX_DELAY);
+		assert(res == pdTRUE);
+	}
 }
 
 int erpc_esp_host_posix_write(erpc_esp_host_posix_io *handle, const void *data,
 							  size_t size) {
-	int written = 0;
-	int remaining = size;
+	size_t written = 0;
 
-	assert(remaining > 0);
-	while (remaining) {
+	assert(size > 0);
+	while (1) {
 		pthread_mutex_lock(&handle->mutex);
-		size_t sent = xStreamBufferSend(handle->io.tx.fifo.handle,
-										data + written, remaining, 0);
-		pthread_mutex_unlock(&handle->mutex);
-		pthread_cond_signal(&handle->cond);
-		assert(remaining >= sent);
-		remaining -= sent;
+		size_t sent = xStreamBufferSend(handle->io.tx.fifo, data + written,
+										size - written, 0);
 		written += sent;
+		if (written < size) {
+			handle->waiting = true;
+		}
+		pthread_mutex_unlock(&handle->mutex);
+		if (sent > 0) {
+			pthread_cond_signal(&handle->cond);
+		}
+		if (written == size) {
+			break;
+		}
+
+		// FIFO full. Wait for the writer thread to make space.
+		BaseType_t res = xSemaphoreTake(handle->sem.handle, portMAX_DELAY);
+		assert(res == pdTRUE);
 	}
 
 	return size;
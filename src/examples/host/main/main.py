@@ -136,7 +136,7 @@ def _assert_not_none(obj: Optional[T]) -> T:
     return obj
 
 
-def main(program: str, repl: bool):
+def main(program: str, repl: bool, native: bool):
     esp_app = Popen(
         program,
         # Unbuffered pipe
@@ -160,9 +160,18 @@ def main(program: str, repl: bool):
         return data
 
     # Create shared transport
-    tinyproto_transport = erpc_tinyproto.TinyprotoTransport(
-        read_func, write_func, send_timeout=5
-    )
+    if native:
+        from erpc_esp.erpc_tinyproto.native import NativeTinyprotoTransport
+
+        tinyproto_transport = NativeTinyprotoTransport(
+            _assert_not_none(esp_app.stdout),
+            _assert_not_none(esp_app.stdin),
+            send_timeout=5,
+        )
+    else:
+        tinyproto_transport = erpc_tinyproto.TinyprotoTransport(
+            read_func, write_func, send_timeout=5
+        )
 
     tinyproto_transport.open()
 
@@ -192,7 +201,8 @@ def main(program: str, repl: bool):
     except (KeyboardInterrupt, SystemExit):
         pass
     finally:
-        tinyproto_transport.disconnect()
+        if not native:
+            tinyproto_transport.disconnect()
         tinyproto_transport.close()
         server_thread.stop()
         client_thread.stop()
@@ -211,5 +221,11 @@ if __name__ == "__main__":
         action="store_true",
         help="Interact with the program via REPL, instead of sending burst eRPC calls",
     )
+    arg_parser.add_argument(
+        "--native",
+        default=False,
+        action="store_true",
+        help="Use the native Tinyproto transport (see erpc_esp.erpc_tinyproto.native)",
+    )
     args = arg_parser.parse_args()
-    main(args.program, args.repl)
+    main(args.program, args.repl, args.native)
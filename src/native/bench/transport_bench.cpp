@@ -0,0 +1,376 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		transport_bench.cpp
+ *
+ * \brief		Microbenchmarks of the hot paths of the transports
+ *
+ * Each benchmark repeats one operation until it has run for at least the
+ * minimum time, then reports the time per operation and the throughput.
+ * Run with a benchmark name (or part of it) to run only the matching ones.
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "erpc_crc16.hpp"
+#include "erpc_framed_transport.hpp"
+#include "erpc_message_buffer.hpp"
+
+#include "erpc_esp/utils.h"
+#include "erpc_esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/message_buffer.h"
+
+#include "esp_log.h"
+
+#include "TinyProtocolFd.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace erpc;
+
+namespace {
+
+uint64_t s_min_ns = 200 * 1000000ULL;
+const char *s_filter = NULL;
+/**
+ * Results are accumulated here, so that the compiler can't drop the work
+ */
+volatile uint32_t s_sink;
+
+uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+bool selected(const std::string &name) {
+	return s_filter == NULL || name.find(s_filter) != std::string::npos;
+}
+
+void report(const std::string &name, uint64_t ops, uint64_t ns,
+			size_t bytes_per_op) {
+	double ns_per_op = static_cast<double>(ns) / ops;
+	printf("%-50s %12.1f %12.1f\n", name.c_str(), ns_per_op,
+		   bytes_per_op * 1e3 / ns_per_op);
+}
+
+/**
+ * Run \p op in batches of growing size, until a batch lasts s_min_ns
+ */
+template <typename Op>
+void bench(const std::string &name, size_t bytes_per_op, Op op) {
+	if (!selected(name)) {
+		return;
+	}
+	uint64_t ops = 1;
+	while (1) {
+		uint64_t start = now_ns();
+		for (uint64_t i = 0; i < ops; ++i) {
+			op();
+		}
+		uint64_t ns = now_ns() - start;
+		if (ns >= s_min_ns) {
+			report(name, ops, ns, bytes_per_op);
+			return;
+		}
+		// Aim slightly above the minimum time, at most 10x at once
+		uint64_t next = ns == 0 ? ops * 10 : ops * s_min_ns * 12 / 10 / ns;
+		ops = next > ops * 10 ? ops * 10 : (next > ops ? next : ops + 1);
+	}
+}
+
+std::vector<uint8_t> payload(size_t size) {
+	std::vector<uint8_t> data(size);
+	for (size_t i = 0; i < size; ++i) {
+		data[i] = static_cast<uint8_t>(i * 7 + (i >> 3));
+	}
+	return data;
+}
+
+/*
+ * erpc_esp_log_transport_send
+ */
+
+char s_log_line[4096];
+
+/**
+ * Formats the log line like the console would, without the I/O
+ */
+int format_only(const char *format, va_list args) {
+	return vsnprintf(s_log_line, sizeof(s_log_line), format, args);
+}
+
+void bench_log_transport(size_t size) {
+	std::vector<uint8_t> data = payload(size);
+	std::vector<char> buffer(ERPC_ESP_LOG_REQUIRED_BUFFER_SIZE(size));
+	vprintf_like_t previous = esp_log_set_vprintf(format_only);
+	erpc_esp_log_transport_init();
+	bench("erpc_esp_log_transport_send " + std::to_string(size) + " B", size,
+		  [&] {
+			  erpc_esp_log_transport_send(data.data(), data.size(),
+										  buffer.data());
+		  });
+	esp_log_set_vprintf(previous);
+}
+
+/*
+ * CRC16
+ */
+
+void bench_crc16(size_t size) {
+	std::vector<uint8_t> data = payload(size);
+	Crc16 crc;
+	bench("Crc16::computeCRC16 " + std::to_string(size) + " B", size,
+		  [&] { s_sink += crc.computeCRC16(data.data(), data.size()); });
+}
+
+/*
+ * Message buffer, as the RX FIFO of TinyprotoChannel
+ */
+
+void bench_message_buffer(size_t size) {
+	static uint8_t storage[2048 + 256];
+	static StaticMessageBuffer_t buffer;
+	static erpc_esp_freertos_critical_section_lock lock =
+		ERPC_ESP_FREERTOS_CRITICAL_SECTION_LOCK_INIT;
+	MessageBufferHandle_t handle =
+		xMessageBufferCreateStatic(sizeof(storage), storage, &buffer);
+	std::vector<uint8_t> data = payload(size);
+	std::vector<uint8_t> out(size);
+
+	bench("xMessageBufferSend+Receive " + std::to_string(size) + " B", size,
+		  [&] {
+			  erpc_esp_freertos_critical_enter(&lock);
+			  size_t sent =
+				  xMessageBufferSend(handle, data.data(), data.size(), 0);
+			  erpc_esp_freertos_critical_exit(&lock);
+			  erpc_esp_freertos_critical_enter(&lock);
+			  size_t received =
+				  xMessageBufferReceive(handle, out.data(), out.size(), 0);
+			  erpc_esp_freertos_critical_exit(&lock);
+			  s_sink += sent + received;
+		  });
+}
+
+/*
+ * Tinyproto framing, between two in-memory peers
+ */
+
+struct TinyprotoPeer {
+	TinyprotoPeer(void)
+		: fd(buffer, sizeof(buffer)), connected(false), received(0) {
+		fd.setConnectEventCallback(connect_cb);
+		fd.setReceiveCallback(receive_cb);
+		fd.setUserData(this);
+		fd.setWindowSize(7);
+		fd.enableCrc16();
+	}
+
+	static void connect_cb(void *user_data, uint8_t addr, bool connected) {
+		static_cast<TinyprotoPeer *>(user_data)->connected = connected;
+	}
+	static void receive_cb(void *user_data, uint8_t addr,
+						   tinyproto::IPacket &pkt) {
+		++static_cast<TinyprotoPeer *>(user_data)->received;
+	}
+
+	uint8_t buffer[16384];
+	tinyproto::IFd fd;
+	bool connected;
+	uint32_t received;
+};
+
+/**
+ * Move everything \p from has to send to \p to
+ *
+ * @return number of bytes moved
+ */
+size_t transfer(TinyprotoPeer &from, TinyprotoPeer &to) {
+	uint8_t wire[4096];
+	size_t total = 0;
+	int len;
+	while ((len = tiny_fd_get_tx_data(from.fd.getHandle(), wire,
+									  sizeof(wire))) > 0) {
+		tiny_fd_on_rx_data(to.fd.getHandle(), wire, len);
+		total += len;
+	}
+	return total;
+}
+
+void bench_tinyproto(size_t size) {
+	std::string tx_name =
+		"tiny_fd_get_tx_data " + std::to_string(size) + " B frame";
+	std::string rx_name =
+		"tiny_fd_on_rx_data " + std::to_string(size) + " B frame";
+	if (!selected(tx_name) && !selected(rx_name)) {
+		return;
+	}
+
+	TinyprotoPeer a;
+	TinyprotoPeer b;
+	a.fd.begin();
+	b.fd.begin();
+	for (int i = 0; i < 1000 && !(a.connected && b.connected); ++i) {
+		transfer(a, b);
+		transfer(b, a);
+		usleep(1000);
+	}
+	if (!a.connected || !b.connected) {
+		printf("%-50s not connected\n", tx_name.c_str());
+		return;
+	}
+
+	std::vector<uint8_t> data = payload(size);
+	std::vector<uint8_t> wire(2 * size + 64);
+	uint64_t ops = 0;
+	uint64_t wire_bytes = 0;
+	uint64_t tx_ns = 0;
+	uint64_t rx_ns = 0;
+	uint64_t start = now_ns();
+	while (tx_ns + rx_ns < s_min_ns && now_ns() - start < 10 * s_min_ns) {
+		int ret = tiny_fd_send_packet(a.fd.getHandle(), data.data(),
+									  data.size(), 0);
+		if (ret == TINY_ERR_TIMEOUT) {
+			// Window full: let the acknowledgements through
+			transfer(b, a);
+			continue;
+		}
+		if (ret < 0) {
+			printf("%-50s send error %d\n", tx_name.c_str(), ret);
+			break;
+		}
+		uint64_t t0 = now_ns();
+		int len = tiny_fd_get_tx_data(a.fd.getHandle(), wire.data(),
+									  wire.size());
+		uint64_t t1 = now_ns();
+		if (len > 0) {
+			tiny_fd_on_rx_data(b.fd.getHandle(), wire.data(), len);
+		}
+		uint64_t t2 = now_ns();
+		tx_ns += t1 - t0;
+		rx_ns += t2 - t1;
+		wire_bytes += len > 0 ? len : 0;
+		++ops;
+		// Acknowledgements and anything left, not measured
+		transfer(a, b);
+		transfer(b, a);
+	}
+	a.fd.end();
+	b.fd.end();
+	if (ops == 0 || b.received != ops) {
+		printf("%-50s %u of %u frames received\n", rx_name.c_str(),
+			   (unsigned)b.received, (unsigned)ops);
+		return;
+	}
+	if (selected(tx_name)) {
+		report(tx_name, ops, tx_ns, size);
+	}
+	if (selected(rx_name)) {
+		report(rx_name, ops, rx_ns, size);
+	}
+}
+
+/*
+ * FramedTransport, over an in-memory FIFO
+ */
+
+class MemoryTransport : public FramedTransport {
+  public:
+	MemoryTransport(void) : read_offset_(0) {}
+
+  private:
+	virtual erpc_status_t underlyingSend(const uint8_t *data,
+										 uint32_t size) override {
+		this->fifo_.insert(this->fifo_.end(), data, data + size);
+		return kErpcStatus_Success;
+	}
+
+	virtual erpc_status_t underlyingReceive(uint8_t *data,
+											uint32_t size) override {
+		if (this->fifo_.size() - this->read_offset_ < size) {
+			return kErpcStatus_ReceiveFailed;
+		}
+		memcpy(data, this->fifo_.data() + this->read_offset_, size);
+		this->read_offset_ += size;
+		if (this->read_offset_ == this->fifo_.size()) {
+			this->fifo_.clear();
+			this->read_offset_ = 0;
+		}
+		return kErpcStatus_Success;
+	}
+
+	std::vector<uint8_t> fifo_;
+	size_t read_offset_;
+};
+
+void bench_framed_transport(size_t size) {
+	Crc16 crc;
+	MemoryTransport transport;
+	transport.setCrc16(&crc);
+	std::vector<uint8_t> data = payload(size);
+	std::vector<uint8_t> out(size);
+	MessageBuffer tx(data.data(), data.size());
+	tx.setUsed(data.size());
+	MessageBuffer rx(out.data(), out.size());
+
+	bench("FramedTransport send+receive " + std::to_string(size) + " B",
+		  size, [&] {
+			  s_sink += transport.send(&tx);
+			  s_sink += transport.receive(&rx);
+		  });
+}
+
+void usage(const char *program) {
+	fprintf(stderr,
+			"Usage: %s [-t MIN_MS] [FILTER]\n"
+			"\n"
+			"Run the benchmarks whose name contains FILTER, each for at least\n"
+			"MIN_MS milliseconds (default: 200).\n",
+			program);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	int opt;
+	while ((opt = getopt(argc, argv, "t:h")) != -1) {
+		switch (opt) {
+		case 't':
+			s_min_ns = strtoull(optarg, NULL, 10) * 1000000ULL;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+	if (optind < argc) {
+		s_filter = argv[optind];
+	}
+
+	printf("%-50s %12s %12s\n", "benchmark", "ns/op", "MB/s");
+	bench_log_transport(64);
+	bench_log_transport(512);
+	bench_crc16(1024);
+	bench_message_buffer(64);
+	bench_message_buffer(512);
+	bench_tinyproto(64);
+	bench_tinyproto(512);
+	bench_framed_transport(16);
+	bench_framed_transport(512);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,303 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		client_port.cpp
+ *
+ * \brief		Unix domain socket exposing a channel of a device link -
+ *				implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "client_port.hpp"
+
+#include "device_link.hpp"
+
+#include "tinyproto_link.h"
+
+#define TAG "gateway"
+#include "esp_log.h"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+/**
+ * Size of the FramedTransport header: u16 size and u16 CRC16
+ */
+#define FRAME_HEADER_SIZE 4
+
+/**
+ * Largest message accepted from a client: it must fit in a link frame
+ */
+#define MAX_MESSAGE_SIZE (GATEWAY_FRAME_SIZE - LINK_HEADER_SIZE)
+
+/**
+ * Messages of the device are dropped when more than this is waiting to be
+ * written to the client. Devices using credit flow control never send more.
+ */
+#define CLIENT_TX_LIMIT GATEWAY_CHANNEL_RX_WINDOW
+
+/*
+ * A message uses as much credit as it takes in tx_, so the bytes written to
+ * the client, or dropped with it, are the credit to return to the device
+ */
+static_assert(FRAME_HEADER_SIZE == LINK_CREDIT_MESSAGE_COST,
+			  "credit of the messages written to the client");
+
+/**
+ * Maximum data read from a client per event, so that a busy client can't
+ * starve the others
+ */
+#define CLIENT_RX_CHUNK (16 * 1024)
+
+using namespace erpc::esp::gateway;
+
+ClientPort::ClientPort(void)
+	: loop_(nullptr), link_(nullptr), channel_(0), listen_fd_(-1),
+	  client_fd_(-1), paused_(false), want_write_(false), tx_offset_(0) {}
+
+ClientPort::~ClientPort(void) {
+	this->deinit();
+}
+
+bool ClientPort::init(EventLoop *loop, DeviceLink *link, uint8_t channel,
+					  const std::string &path) {
+	struct sockaddr_un addr = {};
+	if (path.size() >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	addr.sun_family = AF_UNIX;
+	memcpy(addr.sun_path, path.c_str(), path.size());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return false;
+	}
+	unlink(path.c_str());
+	if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) !=
+			0 ||
+		listen(fd, 4) != 0 || !loop->add(fd, EPOLLIN, this)) {
+		int error = errno;
+		close(fd);
+		errno = error;
+		return false;
+	}
+	this->loop_ = loop;
+	this->link_ = link;
+	this->channel_ = channel;
+	this->path_ = path;
+	this->listen_fd_ = fd;
+	return true;
+}
+
+void ClientPort::deinit(void) {
+	this->disconnect_client();
+	if (this->listen_fd_ >= 0) {
+		this->loop_->remove(this->listen_fd_);
+		close(this->listen_fd_);
+		unlink(this->path_.c_str());
+		this->listen_fd_ = -1;
+	}
+}
+
+bool ClientPort::deliver(const uint8_t *data, size_t size) {
+	if (this->client_fd_ < 0 ||
+		this->tx_.size() - this->tx_offset_ > CLIENT_TX_LIMIT) {
+		return false;
+	}
+	uint16_t crc = this->crc_.computeCRC16(data, size);
+	uint8_t header[FRAME_HEADER_SIZE] = {
+		static_cast<uint8_t>(size), static_cast<uint8_t>(size >> 8),
+		static_cast<uint8_t>(crc), static_cast<uint8_t>(crc >> 8)};
+	this->tx_.insert(this->tx_.end(), header, header + sizeof(header));
+	this->tx_.insert(this->tx_.end(), data, data + size);
+	if (!this->want_write_) {
+		this->flush();
+	}
+	return true;
+}
+
+void ClientPort::disconnect_client(void) {
+	if (this->client_fd_ < 0) {
+		return;
+	}
+	ESP_LOGI(TAG, "%s: client disconnected", this->path_.c_str());
+	this->loop_->remove(this->client_fd_);
+	close(this->client_fd_);
+	this->client_fd_ = -1;
+	size_t unwritten = this->tx_.size() - this->tx_offset_;
+	this->paused_ = false;
+	this->want_write_ = false;
+	this->rx_.clear();
+	this->tx_.clear();
+	this->tx_offset_ = 0;
+	this->link_->return_credit(this->channel_, unwritten);
+}
+
+void ClientPort::resume(void) {
+	if (!this->paused_) {
+		return;
+	}
+	this->paused_ = false;
+	this->forward();
+	this->update_events();
+}
+
+bool ClientPort::has_client(void) const {
+	return this->client_fd_ >= 0;
+}
+
+const std::string &ClientPort::path(void) const {
+	return this->path_;
+}
+
+void ClientPort::on_event(int fd, uint32_t events) {
+	BusyScope busy(this->link_->mutable_stats());
+	if (fd == this->listen_fd_) {
+		this->accept_client();
+		return;
+	}
+	if (fd != this->client_fd_) {
+		return;
+	}
+	if (events & EPOLLOUT) {
+		this->flush();
+	}
+	if (this->client_fd_ >= 0 &&
+		(events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+		this->read_client();
+	}
+}
+
+void ClientPort::accept_client(void) {
+	while (1) {
+		int fd = accept4(this->listen_fd_, nullptr, nullptr,
+						 SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			// EAGAIN, or the client gave up in the meantime
+			return;
+		}
+		if (this->client_fd_ >= 0 || !this->link_->connected() ||
+			!this->loop_->add(fd, EPOLLIN, this)) {
+			++this->link_->mutable_stats().rejected_clients;
+			close(fd);
+			continue;
+		}
+		ESP_LOGI(TAG, "%s: client connected", this->path_.c_str());
+		this->client_fd_ = fd;
+	}
+}
+
+void ClientPort::read_client(void) {
+	uint8_t buf[4096];
+	size_t total = 0;
+	while (total < CLIENT_RX_CHUNK) {
+		ssize_t len = read(this->client_fd_, buf, sizeof(buf));
+		if (len > 0) {
+			this->rx_.insert(this->rx_.end(), buf, buf + len);
+			total += len;
+		} else if (len < 0 && errno == EINTR) {
+			continue;
+		} else if (len < 0 && errno == EAGAIN) {
+			break;
+		} else {
+			this->disconnect_client();
+			return;
+		}
+	}
+	this->forward();
+	this->update_events();
+}
+
+void ClientPort::forward(void) {
+	size_t offset = 0;
+	while (!this->paused_ && this->rx_.size() - offset >= FRAME_HEADER_SIZE) {
+		const uint8_t *frame = this->rx_.data() + offset;
+		size_t size = frame[0] | (frame[1] << 8);
+		uint16_t crc = frame[2] | (frame[3] << 8);
+		if (size > MAX_MESSAGE_SIZE) {
+			ESP_LOGW(TAG, "%s: message of %u bytes too large",
+					 this->path_.c_str(), (unsigned)size);
+			this->disconnect_client();
+			return;
+		}
+		if (this->rx_.size() - offset < FRAME_HEADER_SIZE + size) {
+			break;
+		}
+		const uint8_t *message = frame + FRAME_HEADER_SIZE;
+		if (this->crc_.computeCRC16(message, size) != crc) {
+			ESP_LOGW(TAG, "%s: CRC error", this->path_.c_str());
+			this->disconnect_client();
+			return;
+		}
+		if (!this->link_->send(this->channel_, message, size)) {
+			this->paused_ = true;
+			break;
+		}
+		// Sending may detect the disconnection of the device
+		if (this->client_fd_ < 0) {
+			return;
+		}
+		offset += FRAME_HEADER_SIZE + size;
+	}
+	this->rx_.erase(this->rx_.begin(), this->rx_.begin() + offset);
+}
+
+void ClientPort::flush(void) {
+	while (this->tx_offset_ < this->tx_.size()) {
+		ssize_t len =
+			write(this->client_fd_, this->tx_.data() + this->tx_offset_,
+				  this->tx_.size() - this->tx_offset_);
+		if (len > 0) {
+			this->tx_offset_ += len;
+			this->link_->return_credit(this->channel_, len);
+			// Returning the credit may detect the disconnection of the device
+			if (this->client_fd_ < 0) {
+				return;
+			}
+		} else if (len < 0 && errno == EINTR) {
+			continue;
+		} else if (len < 0 && errno == EAGAIN) {
+			if (!this->want_write_) {
+				this->want_write_ = true;
+				this->update_events();
+			}
+			return;
+		} else {
+			this->disconnect_client();
+			return;
+		}
+	}
+	this->tx_.clear();
+	this->tx_offset_ = 0;
+	if (this->want_write_) {
+		this->want_write_ = false;
+		this->update_events();
+	}
+}
+
+void ClientPort::update_events(void) {
+	if (this->client_fd_ < 0) {
+		return;
+	}
+	uint32_t events = 0;
+	if (!this->paused_) {
+		events |= EPOLLIN;
+	}
+	if (this->want_write_) {
+		events |= EPOLLOUT;
+	}
+	this->loop_->modify(this->client_fd_, events, this);
+}
@@ -0,0 +1,124 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		client_port.hpp
+ *
+ * \brief		Unix domain socket exposing a channel of a device link -
+ *				interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_GATEWAY_CLIENT_PORT_HPP_
+#define ERPC_ESP_GATEWAY_CLIENT_PORT_HPP_
+
+#include "event_loop.hpp"
+
+#include "erpc_crc16.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace erpc {
+namespace esp {
+namespace gateway {
+
+class DeviceLink;
+
+/*!
+ * @brief Listening Unix domain socket of a channel of a device link.
+ *
+ * The eRPC messages are exchanged with the local client with the framing of
+ * eRPC's FramedTransport: u16 size, u16 CRC16 of the message (little endian)
+ * and the message. Any eRPC client or server built on FramedTransport can
+ * therefore use the channel, e.g.
+ * erpc_esp.erpc_gateway.GatewayTransport.
+ *
+ * A single local client is served at a time, and only while the device is
+ * connected: other connections are closed at once. When the device
+ * disconnects, the client is disconnected too, so that its pending calls
+ * fail.
+ */
+class ClientPort : public EventHandler {
+  public:
+	ClientPort(void);
+	~ClientPort(void);
+
+	/*!
+	 * @brief Listen on \p path, replacing the socket left there by a
+	 * previous instance.
+	 *
+	 * @retval true success
+	 * @retval false failure, errno is set
+	 */
+	bool init(EventLoop *loop, DeviceLink *link, uint8_t channel,
+			  const std::string &path);
+	/*!
+	 * @brief Close the sockets and remove the socket file
+	 */
+	void deinit(void);
+
+	/*!
+	 * @brief Forward a message received from the device to the client.
+	 *
+	 * @retval true queued for the client
+	 * @retval false dropped: no client, or the client does not keep up
+	 */
+	bool deliver(const uint8_t *data, size_t size);
+
+	/*!
+	 * @brief Disconnect the client, if any
+	 */
+	void disconnect_client(void);
+
+	/*!
+	 * @brief Resume forwarding the messages of the client, after the link
+	 * made room in the TX queue of the channel.
+	 */
+	void resume(void);
+
+	bool has_client(void) const;
+	const std::string &path(void) const;
+
+	void on_event(int fd, uint32_t events) override;
+
+  private:
+	void accept_client(void);
+	void read_client(void);
+	/*!
+	 * @brief Send the complete frames received from the client to the link
+	 */
+	void forward(void);
+	void flush(void);
+	void update_events(void);
+
+	EventLoop *loop_;
+	DeviceLink *link_;
+	uint8_t channel_;
+	std::string path_;
+	int listen_fd_;
+	int client_fd_;
+	/**
+	 * The TX queue of the channel is full: the client is not read until
+	 * resume()
+	 */
+	bool paused_;
+	bool want_write_;
+	std::vector<uint8_t> rx_;
+	std::vector<uint8_t> tx_;
+	size_t tx_offset_;
+	Crc16 crc_;
+};
+
+} // namespace gateway
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_ESP_GATEWAY_CLIENT_PORT_HPP_ */
@@ -0,0 +1,241 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		device_io.cpp
+ *
+ * \brief		File descriptors of the device links of the gateway -
+ *				implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "device_io.hpp"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+using namespace erpc::esp::gateway;
+
+namespace {
+
+bool starts_with(const std::string &str, const char *prefix) {
+	return str.compare(0, strlen(prefix), prefix) == 0;
+}
+
+bool set_nonblocking(int fd) {
+	int flags = fcntl(fd, F_GETFL);
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool open_exec(const std::string &command, DeviceIo *io) {
+	int to_child[2];
+	int from_child[2];
+	if (pipe2(to_child, O_CLOEXEC) != 0) {
+		return false;
+	}
+	if (pipe2(from_child, O_CLOEXEC) != 0) {
+		close(to_child[0]);
+		close(to_child[1]);
+		return false;
+	}
+	pid_t pid = fork();
+	if (pid == 0) {
+		// Don't outlive the gateway
+		prctl(PR_SET_PDEATHSIG, SIGTERM);
+		dup2(to_child[0], STDIN_FILENO);
+		dup2(from_child[1], STDOUT_FILENO);
+		std::string script = "exec " + command;
+		execl("/bin/sh", "sh", "-c", script.c_str(), (char *)NULL);
+		_exit(127);
+	}
+	close(to_child[0]);
+	close(from_child[1]);
+	if (pid < 0 || !set_nonblocking(to_child[1]) ||
+		!set_nonblocking(from_child[0])) {
+		int error = errno;
+		close(to_child[1]);
+		close(from_child[0]);
+		errno = error;
+		return false;
+	}
+	io->read_fd = from_child[0];
+	io->write_fd = to_child[1];
+	io->pid = pid;
+	return true;
+}
+
+bool open_tcp(const std::string &address, DeviceIo *io) {
+	size_t colon = address.rfind(':');
+	if (colon == std::string::npos) {
+		errno = EINVAL;
+		return false;
+	}
+	std::string host = address.substr(0, colon);
+	std::string port = address.substr(colon + 1);
+	struct addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	struct addrinfo *result = NULL;
+	if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) {
+		errno = EHOSTUNREACH;
+		return false;
+	}
+	int fd = socket(result->ai_family,
+					SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd >= 0 && connect(fd, result->ai_addr, result->ai_addrlen) != 0 &&
+		errno != EINPROGRESS) {
+		int error = errno;
+		close(fd);
+		fd = -1;
+		errno = error;
+	}
+	freeaddrinfo(result);
+	if (fd < 0) {
+		return false;
+	}
+	io->read_fd = io->write_fd = fd;
+	return true;
+}
+
+bool open_unix(const std::string &path, DeviceIo *io) {
+	struct sockaddr_un addr = {};
+	if (path.size() >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	addr.sun_family = AF_UNIX;
+	memcpy(addr.sun_path, path.c_str(), path.size());
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return false;
+	}
+	if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+				sizeof(addr)) != 0 &&
+		errno != EINPROGRESS) {
+		int error = errno;
+		close(fd);
+		errno = error;
+		return false;
+	}
+	io->read_fd = io->write_fd = fd;
+	return true;
+}
+
+speed_t baud_to_speed(unsigned long baud) {
+	switch (baud) {
+	case 9600:
+		return B9600;
+	case 19200:
+		return B19200;
+	case 38400:
+		return B38400;
+	case 57600:
+		return B57600;
+	case 115200:
+		return B115200;
+	case 230400:
+		return B230400;
+	case 460800:
+		return B460800;
+	case 921600:
+		return B921600;
+	case 1500000:
+		return B1500000;
+	case 2000000:
+		return B2000000;
+	default:
+		return B0;
+	}
+}
+
+bool open_device(const std::string &spec, DeviceIo *io) {
+	std::string path = spec;
+	unsigned long baud = 115200;
+	size_t at = spec.rfind('@');
+	if (at != std::string::npos) {
+		path = spec.substr(0, at);
+		baud = strtoul(spec.c_str() + at + 1, NULL, 10);
+	}
+	speed_t speed = baud_to_speed(baud);
+	if (speed == B0) {
+		errno = EINVAL;
+		return false;
+	}
+	int fd = open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	if (isatty(fd)) {
+		struct termios tio;
+		if (tcgetattr(fd, &tio) != 0) {
+			close(fd);
+			return false;
+		}
+		cfmakeraw(&tio);
+		cfsetspeed(&tio, speed);
+		tio.c_cflag |= CLOCAL | CREAD;
+		if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+			int error = errno;
+			close(fd);
+			errno = error;
+			return false;
+		}
+		tcflush(fd, TCIOFLUSH);
+	}
+	io->read_fd = io->write_fd = fd;
+	return true;
+}
+
+} // namespace
+
+bool erpc::esp::gateway::device_io_open(const std::string &spec,
+										DeviceIo *io) {
+	io->read_fd = io->write_fd = -1;
+	io->pid = 0;
+	if (starts_with(spec, "exec:")) {
+		return open_exec(spec.substr(5), io);
+	}
+	if (starts_with(spec, "tcp:")) {
+		return open_tcp(spec.substr(4), io);
+	}
+	if (starts_with(spec, "unix:")) {
+		return open_unix(spec.substr(5), io);
+	}
+	return open_device(spec, io);
+}
+
+void erpc::esp::gateway::device_io_close(DeviceIo *io) {
+	if (io->write_fd >= 0 && io->write_fd != io->read_fd) {
+		close(io->write_fd);
+	}
+	if (io->read_fd >= 0) {
+		close(io->read_fd);
+	}
+	if (io->pid > 0) {
+		kill(io->pid, SIGTERM);
+	}
+	io->read_fd = io->write_fd = -1;
+	io->pid = 0;
+}
+
+void erpc::esp::gateway::device_io_reap_children(void) {
+	while (waitpid(-1, NULL, WNOHANG) > 0) {
+	}
+}
@@ -0,0 +1,74 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		device_io.hpp
+ *
+ * \brief		File descriptors of the device links of the gateway -
+ *				interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_GATEWAY_DEVICE_IO_HPP_
+#define ERPC_ESP_GATEWAY_DEVICE_IO_HPP_
+
+#include <sys/types.h>
+
+#include <string>
+
+namespace erpc {
+namespace esp {
+namespace gateway {
+
+/**
+ * Non-blocking file descriptors of a device. read_fd and write_fd are the
+ * same, except for child processes.
+ */
+struct DeviceIo {
+	int read_fd;
+	int write_fd;
+	/**
+	 * Child process, 0 if none
+	 */
+	pid_t pid;
+};
+
+/**
+ * Open the device described by \p spec:
+ *
+ *   exec:COMMAND     run COMMAND with /bin/sh and talk to its stdin and
+ *                    stdout, e.g. an ESP-IDF application built for Linux
+ *   tcp:HOST:PORT    connect to a TCP server, e.g. a serial to TCP bridge
+ *   unix:PATH        connect to a Unix domain stream socket
+ *   PATH[@BAUD]      open a character device. Serial ports are set to raw
+ *                    mode at BAUD (115200 by default).
+ *
+ * Connections to sockets complete in background: a failure shows up as an
+ * error of the file descriptor.
+ *
+ * @retval true success
+ * @retval false failure, errno is set
+ */
+bool device_io_open(const std::string &spec, DeviceIo *io);
+
+/**
+ * Close the file descriptors and terminate the child process, if any. The
+ * child is reaped by device_io_reap_children.
+ */
+void device_io_close(DeviceIo *io);
+
+/**
+ * Reap the terminated child processes
+ */
+void device_io_reap_children(void);
+
+} // namespace gateway
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_ESP_GATEWAY_DEVICE_IO_HPP_ */
@@ -0,0 +1,643 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		device_link.cpp
+ *
+ * \brief		Tinyproto link with a device, driven by the gateway event
+ *				loop - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "device_link.hpp"
+
+#include "erpc_esp_message_header.h"
+#include "tinyproto_link.h"
+
+#define TAG "gateway"
+#include "esp_log.h"
+
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+/**
+ * Messages of a client queued per channel. When the queue is full the client
+ * is not read anymore.
+ */
+#define CHANNEL_QUEUE_LENGTH 16
+
+/**
+ * Delay before reopening a device after a failure
+ */
+#define REOPEN_DELAY_MS 1000
+
+using namespace erpc::esp::gateway;
+
+namespace {
+
+uint64_t monotonic_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+bool is_oneway(const std::vector<uint8_t> &message) {
+	erpc_esp_message_header header;
+	return erpc_esp_message_header_decode(message.data(), message.size(),
+										  &header) &&
+		   header.type == ERPC_ESP_MESSAGE_TYPE_ONEWAY;
+}
+
+} // namespace
+
+BusyScope::BusyScope(DeviceLinkStats &stats)
+	: stats_(stats), start_us_(monotonic_us()) {}
+
+BusyScope::~BusyScope(void) {
+	this->stats_.busy_us += monotonic_us() - this->start_us_;
+}
+
+DeviceLink::DeviceLink(EventLoop *loop, const std::string &name,
+					   const std::string &spec, uint8_t channels,
+					   size_t compression_threshold)
+	: loop_(loop), name_(name), spec_(spec), channels_(channels),
+	  compression_threshold_(compression_threshold), io_(), opened_(false),
+	  connected_(false), want_write_(false), pumping_(false),
+	  reopen_at_ms_(0),
+	  tinyproto_(tinyproto_buffer_, sizeof(tinyproto_buffer_)), out_(),
+	  tx_frame_(), tx_last_channel_(0), hello_pending_(false),
+	  peer_features_(0), receiving_(false), credit_(), stats_() {
+	this->io_.read_fd = this->io_.write_fd = -1;
+
+	this->tinyproto_.setConnectEventCallback(DeviceLink::connect_cb);
+	this->tinyproto_.setReceiveCallback(DeviceLink::receive_cb);
+	this->tinyproto_.setUserData(this);
+	// Never wait: the event loop retries when there is room
+	this->tinyproto_.setSendTimeout(0);
+	this->tinyproto_.setWindowSize(7);
+	this->tinyproto_.enableCrc16();
+}
+
+DeviceLink::~DeviceLink(void) {
+	this->stop();
+}
+
+bool DeviceLink::start(const std::string &socket_dir) {
+	for (uint8_t i = 0; i < this->channels_; ++i) {
+		// Channel 0 is the default one: no suffix
+		std::string path = socket_dir + "/" + this->name_;
+		if (i > 0) {
+			path += "." + std::to_string(i);
+		}
+		path += ".sock";
+		if (!this->ports_[i].init(this->loop_, this, i, path)) {
+			ESP_LOGE(TAG, "%s: cannot listen on %s: %s", this->name_.c_str(),
+					 path.c_str(), strerror(errno));
+			return false;
+		}
+	}
+	this->open();
+	return true;
+}
+
+void DeviceLink::stop(void) {
+	this->close();
+	for (uint8_t i = 0; i < this->channels_; ++i) {
+		this->ports_[i].deinit();
+	}
+}
+
+void DeviceLink::tick(void) {
+	BusyScope busy(this->stats_);
+	if (this->opened_) {
+		this->pump();
+	} else if (monotonic_us() / 1000 >= this->reopen_at_ms_) {
+		++this->stats_.reopens;
+		this->open();
+	}
+}
+
+bool DeviceLink::send(uint8_t channel, const uint8_t *data, size_t size) {
+	if (!this->connected_) {
+		// Pending calls fail anyway: the client is about to be disconnected
+		return true;
+	}
+	std::deque<std::vector<uint8_t>> &queue = this->tx_queues_[channel];
+	if (queue.size() >= CHANNEL_QUEUE_LENGTH) {
+		return false;
+	}
+	queue.emplace_back(data, data + size);
+	this->pump();
+	return true;
+}
+
+void DeviceLink::return_credit(uint8_t channel, size_t credit) {
+	if (!this->connected_ || !(this->peer_features_ & LINK_FEATURE_CREDIT)) {
+		return;
+	}
+	this->credit_[channel].pending += credit;
+	// While receiving, on_event pumps once Tinyproto is done
+	if (!this->receiving_ &&
+		this->credit_[channel].pending >= GATEWAY_CHANNEL_RX_WINDOW / 4) {
+		this->pump();
+	}
+}
+
+bool DeviceLink::connected(void) const {
+	return this->connected_;
+}
+
+const char *DeviceLink::state(void) const {
+	if (!this->opened_) {
+		return "closed";
+	}
+	return this->connected_ ? "connected" : "connecting";
+}
+
+const std::string &DeviceLink::name(void) const {
+	return this->name_;
+}
+
+const std::string &DeviceLink::spec(void) const {
+	return this->spec_;
+}
+
+const DeviceLinkStats &DeviceLink::stats(void) const {
+	return this->stats_;
+}
+
+DeviceLinkStats &DeviceLink::mutable_stats(void) {
+	return this->stats_;
+}
+
+bool DeviceLink::compression(void) const {
+	return (this->peer_features_ & LINK_FEATURE_LZF) &&
+		   this->compression_threshold_ != 0;
+}
+
+void DeviceLink::on_event(int fd, uint32_t events) {
+	BusyScope busy(this->stats_);
+	if (!this->opened_ ||
+		(fd != this->io_.read_fd && fd != this->io_.write_fd)) {
+		return;
+	}
+	if (fd == this->io_.read_fd &&
+		(events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+		this->read_device();
+	} else if (fd != this->io_.read_fd && (events & (EPOLLHUP | EPOLLERR))) {
+		// Write end of a child process
+		this->fail("device closed its input");
+	}
+	if (this->opened_) {
+		// Received data may need to be acknowledged
+		this->pump();
+	}
+}
+
+bool DeviceLink::open(void) {
+	if (!device_io_open(this->spec_, &this->io_)) {
+		ESP_LOGW(TAG, "%s: cannot open %s: %s", this->name_.c_str(),
+				 this->spec_.c_str(), strerror(errno));
+		this->reopen_at_ms_ = monotonic_us() / 1000 + REOPEN_DELAY_MS;
+		return false;
+	}
+	bool added = this->loop_->add(this->io_.read_fd, EPOLLIN, this);
+	if (added && this->io_.write_fd != this->io_.read_fd) {
+		added = this->loop_->add(this->io_.write_fd, 0, this);
+		if (!added) {
+			this->loop_->remove(this->io_.read_fd);
+		}
+	}
+	if (!added) {
+		ESP_LOGW(TAG, "%s: cannot poll %s: %s", this->name_.c_str(),
+				 this->spec_.c_str(), strerror(errno));
+		device_io_close(&this->io_);
+		this->reopen_at_ms_ = monotonic_us() / 1000 + REOPEN_DELAY_MS;
+		return false;
+	}
+	ESP_LOGI(TAG, "%s: opened %s", this->name_.c_str(), this->spec_.c_str());
+	this->opened_ = true;
+	this->want_write_ = false;
+	this->out_.len = this->out_.offset = 0;
+	this->tinyproto_.begin();
+	this->pump();
+	return true;
+}
+
+void DeviceLink::close(void) {
+	if (!this->opened_) {
+		return;
+	}
+	this->loop_->remove(this->io_.read_fd);
+	if (this->io_.write_fd != this->io_.read_fd) {
+		this->loop_->remove(this->io_.write_fd);
+	}
+	device_io_close(&this->io_);
+	this->opened_ = false;
+	this->tinyproto_.end();
+	if (this->connected_) {
+		DeviceLink::connect_cb(this, 0, false);
+	}
+}
+
+void DeviceLink::fail(const char *what) {
+	ESP_LOGW(TAG, "%s: %s, reopening in %u ms", this->name_.c_str(), what,
+			 REOPEN_DELAY_MS);
+	this->close();
+	this->reopen_at_ms_ = monotonic_us() / 1000 + REOPEN_DELAY_MS;
+}
+
+void DeviceLink::read_device(void) {
+	tiny_fd_handle_t handle = this->tinyproto_.getHandle();
+	uint8_t buf[4096];
+	while (1) {
+		ssize_t len = read(this->io_.read_fd, buf, sizeof(buf));
+		if (len > 0) {
+			this->stats_.rx_bytes += len;
+			this->receiving_ = true;
+			tiny_fd_on_rx_data(handle, buf, len);
+			this->receiving_ = false;
+			// Callbacks may have closed the link
+			if (!this->opened_) {
+				return;
+			}
+		} else if (len == 0) {
+			this->fail("end of file");
+			return;
+		} else if (errno == EINTR) {
+			continue;
+		} else if (errno == EAGAIN) {
+			return;
+		} else {
+			this->fail(strerror(errno));
+			return;
+		}
+	}
+}
+
+void DeviceLink::pump(void) {
+	/*
+	 * schedule_tx resumes the clients, which queue more messages: the loop of
+	 * the outer call sends them
+	 */
+	if (this->pumping_) {
+		return;
+	}
+	this->pumping_ = true;
+	this->write_tx();
+	this->pumping_ = false;
+}
+
+void DeviceLink::write_tx(void) {
+	tiny_fd_handle_t handle = this->tinyproto_.getHandle();
+	while (this->opened_) {
+		if (this->out_.offset == this->out_.len) {
+			this->schedule_tx();
+			int len =
+				tiny_fd_get_tx_data(handle, this->out_.data,
+									sizeof(this->out_.data));
+			if (len <= 0) {
+				break;
+			}
+			this->out_.len = len;
+			this->out_.offset = 0;
+		}
+		ssize_t len = write(this->io_.write_fd,
+							this->out_.data + this->out_.offset,
+							this->out_.len - this->out_.offset);
+		if (len > 0) {
+			this->out_.offset += len;
+			this->stats_.tx_bytes += len;
+		} else if (len < 0 && errno == EINTR) {
+			continue;
+		} else if (len < 0 && errno == EAGAIN) {
+			if (!this->want_write_) {
+				this->want_write_ = true;
+				this->update_events();
+			}
+			return;
+		} else {
+			this->fail(len < 0 ? strerror(errno) : "write failure");
+			return;
+		}
+	}
+	if (this->opened_ && this->want_write_) {
+		this->want_write_ = false;
+		this->update_events();
+	}
+}
+
+void DeviceLink::update_events(void) {
+	uint32_t write_events = 0;
+	if (this->want_write_) {
+		write_events |= EPOLLOUT;
+	}
+	if (this->io_.write_fd == this->io_.read_fd) {
+		this->loop_->modify(this->io_.read_fd, EPOLLIN | write_events, this);
+	} else {
+		this->loop_->modify(this->io_.write_fd, write_events, this);
+	}
+}
+
+void DeviceLink::schedule_tx(void) {
+	if (!this->connected_) {
+		return;
+	}
+	tiny_fd_handle_t handle = this->tinyproto_.getHandle();
+	while (1) {
+		if (this->tx_frame_.len == 0 && this->hello_pending_) {
+			this->hello_pending_ = false;
+			this->stage_hello();
+		}
+		if (this->tx_frame_.len == 0) {
+			// Credit first: the device may be waiting for it
+			this->stage_credit();
+		}
+		if (this->tx_frame_.len == 0) {
+			// Round-robin: the channels have all the same priority
+			uint8_t count = ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS;
+			uint8_t i = 1;
+			for (; i <= count; ++i) {
+				uint8_t channel = (this->tx_last_channel_ + i) % count;
+				if (!this->tx_queues_[channel].empty() &&
+					this->has_credit(channel)) {
+					this->tx_last_channel_ = channel;
+					this->stage_messages(channel);
+					break;
+				}
+			}
+			if (i > count) {
+				return;
+			}
+		}
+
+		int ret = tiny_fd_send_packet(handle, this->tx_frame_.ptr,
+									  this->tx_frame_.len, 0);
+		if (ret == TINY_ERR_TIMEOUT) {
+			// TX window full. Retry later.
+			return;
+		}
+		if (ret < 0) {
+			ESP_LOGW(TAG, "%s: dropped frame of %u bytes: error %d",
+					 this->name_.c_str(), (unsigned)this->tx_frame_.len, ret);
+		} else {
+			++this->stats_.tx_frames;
+			this->stats_.tx_messages += this->tx_frame_.messages;
+		}
+		this->tx_frame_.len = 0;
+	}
+}
+
+void DeviceLink::stage_hello(void) {
+	const uint8_t features =
+		LINK_FEATURE_BATCH | LINK_FEATURE_LZF | LINK_FEATURE_CREDIT;
+	this->tx_frame_.len = link_encode_hello(this->tx_frame_.data, features);
+	this->tx_frame_.ptr = this->tx_frame_.data;
+	this->tx_frame_.payload_len = LINK_HELLO_SIZE;
+	this->tx_frame_.messages = 0;
+}
+
+void DeviceLink::stage_messages(uint8_t channel) {
+	std::deque<std::vector<uint8_t>> &queue = this->tx_queues_[channel];
+	bool was_full = queue.size() >= CHANNEL_QUEUE_LENGTH;
+	uint8_t *frame = this->tx_frame_.data;
+	size_t len = LINK_HEADER_SIZE;
+	uint16_t messages = 0;
+	// has_credit checked the first message
+	int64_t credit = (this->peer_features_ & LINK_FEATURE_CREDIT)
+						 ? this->credit_[channel].tx
+						 : INT64_MAX;
+
+	// Worth a batch only if at least the first two messages fit in it
+	bool batch = (this->peer_features_ & LINK_FEATURE_BATCH) &&
+				 queue.size() >= 2 && is_oneway(queue[0]) &&
+				 is_oneway(queue[1]) &&
+				 LINK_HEADER_SIZE + 2 * LINK_BATCH_LEN_SIZE + queue[0].size() +
+						 queue[1].size() <=
+					 GATEWAY_FRAME_SIZE &&
+				 static_cast<int64_t>(queue[0].size() + queue[1].size() +
+									  2 * LINK_CREDIT_MESSAGE_COST) <= credit;
+	if (batch) {
+		frame[0] = LINK_HEADER(LINK_FRAME_KIND_BATCH, channel);
+		while (!queue.empty() && is_oneway(queue.front()) &&
+			   len + LINK_BATCH_LEN_SIZE + queue.front().size() <=
+				   GATEWAY_FRAME_SIZE &&
+			   static_cast<int64_t>(queue.front().size() +
+									LINK_CREDIT_MESSAGE_COST) <= credit) {
+			const std::vector<uint8_t> &message = queue.front();
+			len += link_batch_append(frame + len, message.data(),
+									 message.size());
+			credit -= message.size() + LINK_CREDIT_MESSAGE_COST;
+			++messages;
+			queue.pop_front();
+		}
+	} else {
+		const std::vector<uint8_t> &message = queue.front();
+		frame[0] = LINK_HEADER(LINK_FRAME_KIND_RPC, channel);
+		memcpy(frame + LINK_HEADER_SIZE, message.data(), message.size());
+		len += message.size();
+		messages = 1;
+		queue.pop_front();
+	}
+	if (this->peer_features_ & LINK_FEATURE_CREDIT) {
+		this->credit_[channel].tx -=
+			link_credit_cost(frame[0], frame + LINK_HEADER_SIZE,
+							 len - LINK_HEADER_SIZE);
+	}
+	this->tx_frame_.ptr = frame;
+	this->tx_frame_.len = len;
+	this->tx_frame_.payload_len = len - LINK_HEADER_SIZE;
+	this->tx_frame_.messages = messages;
+	this->compress_tx_frame();
+
+	if (was_full) {
+		this->ports_[channel].resume();
+	}
+}
+
+void DeviceLink::stage_credit(void) {
+	if (!(this->peer_features_ & LINK_FEATURE_CREDIT)) {
+		return;
+	}
+	for (uint8_t i = 0; i < this->channels_; ++i) {
+		uint32_t credit = this->credit_[i].pending;
+		// Like the ESP32 side, return it in pieces of a quarter of the window
+		if (credit < GATEWAY_CHANNEL_RX_WINDOW / 4) {
+			continue;
+		}
+		this->credit_[i].pending = 0;
+		this->tx_frame_.len =
+			link_encode_credit(this->tx_frame_.data, i, credit);
+		this->tx_frame_.ptr = this->tx_frame_.data;
+		this->tx_frame_.payload_len = this->tx_frame_.len - LINK_HEADER_SIZE;
+		this->tx_frame_.messages = 0;
+		return;
+	}
+}
+
+bool DeviceLink::has_credit(uint8_t channel) {
+	if (!(this->peer_features_ & LINK_FEATURE_CREDIT)) {
+		return true;
+	}
+	std::deque<std::vector<uint8_t>> &queue = this->tx_queues_[channel];
+	while (!queue.empty()) {
+		int64_t cost = queue.front().size() + LINK_CREDIT_MESSAGE_COST;
+		if (cost <= this->credit_[channel].tx) {
+			return true;
+		}
+		// Unknown until the device grants its window
+		if (this->credit_[channel].window == 0 ||
+			cost <= this->credit_[channel].window) {
+			return false;
+		}
+		ESP_LOGW(TAG, "%s: dropped message of %u bytes on channel %u: "
+					  "larger than the device RX FIFO",
+				 this->name_.c_str(), (unsigned)queue.front().size(),
+				 channel);
+		++this->stats_.tx_dropped;
+		bool was_full = queue.size() >= CHANNEL_QUEUE_LENGTH;
+		queue.pop_front();
+		if (was_full) {
+			this->ports_[channel].resume();
+		}
+	}
+	return false;
+}
+
+void DeviceLink::compress_tx_frame(void) {
+	if (!this->compression() ||
+		this->tx_frame_.payload_len < this->compression_threshold_) {
+		return;
+	}
+	size_t len = link_compress_frame(this->tx_frame_.data, this->tx_frame_.len,
+									 this->lzf_.tx, this->lzf_.htab);
+	if (len != 0) {
+		this->tx_frame_.ptr = this->lzf_.tx;
+		this->tx_frame_.len = len;
+	}
+}
+
+void DeviceLink::connect_cb(void *user_data, uint8_t addr, bool connected) {
+	DeviceLink *pthis = static_cast<DeviceLink *>(user_data);
+	// Until the HELLO of the peer, assume it supports nothing
+	pthis->peer_features_ = 0;
+	pthis->connected_ = connected;
+	for (uint8_t i = 0; i < ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS; ++i) {
+		pthis->credit_[i].tx = 0;
+		pthis->credit_[i].window = 0;
+		pthis->credit_[i].pending = 0;
+	}
+	if (connected) {
+		ESP_LOGI(TAG, "%s: connected", pthis->name_.c_str());
+		++pthis->stats_.connections;
+		pthis->hello_pending_ = true;
+		return;
+	}
+	ESP_LOGW(TAG, "%s: disconnected", pthis->name_.c_str());
+	// Queued messages are stale, and the pending calls can't complete
+	pthis->hello_pending_ = false;
+	pthis->tx_frame_.len = 0;
+	for (uint8_t i = 0; i < ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS; ++i) {
+		pthis->tx_queues_[i].clear();
+		pthis->ports_[i].disconnect_client();
+	}
+}
+
+void DeviceLink::receive_cb(void *user_data, uint8_t addr,
+							tinyproto::IPacket &pkt) {
+	DeviceLink *pthis = static_cast<DeviceLink *>(user_data);
+	link_frame frame;
+	if (!link_decode_frame(reinterpret_cast<const uint8_t *>(pkt.data()),
+						   pkt.size(), pthis->lzf_.rx, sizeof(pthis->lzf_.rx),
+						   &frame)) {
+		++pthis->stats_.rx_errors;
+		return;
+	}
+	++pthis->stats_.rx_frames;
+
+	const uint8_t *payload = frame.payload;
+	size_t payload_len = frame.payload_len;
+	uint8_t channel = LINK_HEADER_GET_CHANNEL(frame.header);
+	switch (LINK_HEADER_GET_KIND(frame.header)) {
+	case LINK_FRAME_KIND_RPC:
+		pthis->on_message(channel, payload, payload_len);
+		break;
+	case LINK_FRAME_KIND_BATCH: {
+		const uint8_t *message;
+		size_t message_size;
+		while (link_batch_next(&payload, &payload_len, &message,
+							   &message_size)) {
+			pthis->on_message(channel, message, message_size);
+		}
+		if (payload_len != 0) {
+			ESP_LOGW(TAG, "%s: truncated batch on channel %u",
+					 pthis->name_.c_str(), channel);
+			++pthis->stats_.rx_errors;
+		}
+		break;
+	}
+	case LINK_FRAME_KIND_CONTROL:
+		pthis->on_control(payload, payload_len);
+		break;
+	default:
+		// Including streams: the gateway forwards only eRPC messages
+		++pthis->stats_.rx_errors;
+		break;
+	}
+}
+
+void DeviceLink::on_control(const uint8_t *data, size_t size) {
+	link_control control;
+	if (!link_decode_control(data, size, &control)) {
+		++this->stats_.rx_errors;
+		return;
+	}
+	switch (control.op) {
+	case LINK_CONTROL_HELLO:
+		ESP_LOGI(TAG, "%s: peer link version %u, features 0x%02x",
+				 this->name_.c_str(), control.version, control.features);
+		this->peer_features_ = control.features;
+		if (this->peer_features_ & LINK_FEATURE_CREDIT) {
+			// Granted by stage_credit
+			for (uint8_t i = 0; i < this->channels_; ++i) {
+				this->credit_[i].pending += GATEWAY_CHANNEL_RX_WINDOW;
+			}
+		}
+		break;
+	case LINK_CONTROL_CREDIT:
+		// The device doesn't know which channels we expose
+		if (control.channel < this->channels_) {
+			int64_t &tx = this->credit_[control.channel].tx;
+			int64_t &window = this->credit_[control.channel].window;
+			tx += control.credit;
+			if (tx > window) {
+				window = tx;
+			}
+		}
+		break;
+	}
+}
+
+void DeviceLink::on_message(uint8_t channel, const uint8_t *data,
+							size_t size) {
+	if (channel >= this->channels_) {
+		++this->stats_.rx_errors;
+		return;
+	}
+	++this->stats_.rx_messages;
+	if (!this->ports_[channel].deliver(data, size)) {
+		++this->stats_.dropped_messages;
+		// As if it had been written to the client
+		this->return_credit(channel, size + LINK_CREDIT_MESSAGE_COST);
+	}
+}
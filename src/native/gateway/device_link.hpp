@@ -0,0 +1,306 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		device_link.hpp
+ *
+ * \brief		Tinyproto link with a device, driven by the gateway event
+ *				loop - interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_GATEWAY_DEVICE_LINK_HPP_
+#define ERPC_ESP_GATEWAY_DEVICE_LINK_HPP_
+
+#include "client_port.hpp"
+#include "device_io.hpp"
+#include "event_loop.hpp"
+
+#include "erpc_esp_tinyproto_transport_setup.h"
+#include "tinyproto_lzf.h"
+
+#include "TinyProtocolFd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace erpc {
+namespace esp {
+namespace gateway {
+
+/**
+ * Largest link frame, header included. The same as the ESP32 side.
+ */
+#define GATEWAY_FRAME_SIZE (2048 + 256)
+
+/**
+ * Credit granted to a device that supports credit flow control for each
+ * channel, i.e. how much of its messages can wait to be written to the client
+ * of the channel. See LINK_FEATURE_CREDIT.
+ */
+#define GATEWAY_CHANNEL_RX_WINDOW (64 * 1024)
+
+/**
+ * Statistics of a device link. Counters are never reset.
+ */
+struct DeviceLinkStats {
+	/**
+	 * Bytes read from and written to the device
+	 */
+	uint64_t rx_bytes;
+	uint64_t tx_bytes;
+	/**
+	 * Link frames exchanged with the device
+	 */
+	uint64_t rx_frames;
+	uint64_t tx_frames;
+	/**
+	 * eRPC messages received from the device and forwarded to it
+	 */
+	uint64_t rx_messages;
+	uint64_t tx_messages;
+	/**
+	 * Messages of the device dropped because no client was connected to the
+	 * channel or the client did not keep up
+	 */
+	uint64_t dropped_messages;
+	/**
+	 * Messages of the clients dropped because larger than the credit the
+	 * device grants for their channel, so that they could never be sent
+	 */
+	uint64_t tx_dropped;
+	/**
+	 * Malformed or unsupported frames
+	 */
+	uint64_t rx_errors;
+	/**
+	 * Connections refused because the device was disconnected or the
+	 * channel had already a client
+	 */
+	uint64_t rejected_clients;
+	uint32_t connections;
+	uint32_t reopens;
+	/**
+	 * Time spent by the event loop on the link and its clients
+	 */
+	uint64_t busy_us;
+};
+
+/*!
+ * @brief Tinyproto link with a device, the peer of the ESP32 side
+ * TinyprotoTransport.
+ *
+ * Unlike TinyprotoTransport, it has no tasks: it is driven by the events of
+ * the device file descriptors and by tick(), all in the event loop. The
+ * eRPC messages are not decoded: the messages of each channel are forwarded
+ * as they are between the device and the local client of the channel (see
+ * ClientPort).
+ *
+ * If the device I/O fails, e.g. the child process exits, the device is
+ * reopened periodically.
+ */
+class DeviceLink : public EventHandler {
+  public:
+	/*!
+	 * @param [in] name name of the link, used for the socket names
+	 * @param [in] spec device, see device_io_open
+	 * @param [in] channels number of channels exposed to local clients
+	 * @param [in] compression_threshold frames of at least this size are
+	 * compressed, if the device supports it. 0 disables compression.
+	 */
+	DeviceLink(EventLoop *loop, const std::string &name,
+			   const std::string &spec, uint8_t channels,
+			   size_t compression_threshold);
+	~DeviceLink(void);
+
+	/*!
+	 * @brief Create the sockets of the channels in \p socket_dir and open
+	 * the device.
+	 *
+	 * @retval true success. Failures to open the device are not fatal.
+	 * @retval false a socket could not be created
+	 */
+	bool start(const std::string &socket_dir);
+	/*!
+	 * @brief Close the device and the sockets
+	 */
+	void stop(void);
+
+	/*!
+	 * @brief Pump Tinyproto (keep alive, retransmissions) and reopen the
+	 * device if needed. To be called every few milliseconds.
+	 */
+	void tick(void);
+
+	/*!
+	 * @brief Queue a message of a local client for the device
+	 *
+	 * @retval true queued, or dropped because the device is disconnected
+	 * @retval false the queue of the channel is full. ClientPort::resume() is
+	 * called once there is room.
+	 */
+	bool send(uint8_t channel, const uint8_t *data, size_t size);
+
+	/*!
+	 * @brief Return to the device the credit of messages of \p channel
+	 * written to the client or dropped, if the device uses credit flow
+	 * control. Messages use credit as in LINK_CREDIT_MESSAGE_COST.
+	 */
+	void return_credit(uint8_t channel, size_t credit);
+
+	bool connected(void) const;
+	const char *state(void) const;
+	const std::string &name(void) const;
+	const std::string &spec(void) const;
+	const DeviceLinkStats &stats(void) const;
+	/*!
+	 * @brief Whether messages are compressed
+	 */
+	bool compression(void) const;
+	DeviceLinkStats &mutable_stats(void);
+
+	void on_event(int fd, uint32_t events) override;
+
+  private:
+	bool open(void);
+	void close(void);
+	/*!
+	 * @brief Close the device after an I/O error, and reopen it later
+	 */
+	void fail(const char *what);
+	void read_device(void);
+	/*!
+	 * @brief Call write_tx, unless already in progress
+	 */
+	void pump(void);
+	/*!
+	 * @brief Write the pending TX data, then get more from Tinyproto, until
+	 * the device does not accept more
+	 */
+	void write_tx(void);
+	void update_events(void);
+
+	void schedule_tx(void);
+	void stage_hello(void);
+	/*!
+	 * @brief Stage a LINK_CONTROL_CREDIT frame for the first channel whose
+	 * credit is due, if any
+	 */
+	void stage_credit(void);
+	/*!
+	 * @brief Whether the device granted enough credit for the oldest message
+	 * of \p channel. The messages that would never get enough are dropped.
+	 */
+	bool has_credit(uint8_t channel);
+	/*!
+	 * @brief Stage the oldest message of \p channel, with the following
+	 * oneway messages in a batch frame if the device supports it
+	 */
+	void stage_messages(uint8_t channel);
+	void compress_tx_frame(void);
+
+	static void connect_cb(void *user_data, uint8_t addr, bool connected);
+	static void receive_cb(void *user_data, uint8_t addr,
+						   tinyproto::IPacket &pkt);
+	void on_control(const uint8_t *data, size_t size);
+	void on_message(uint8_t channel, const uint8_t *data, size_t size);
+
+	EventLoop *loop_;
+	std::string name_;
+	std::string spec_;
+	uint8_t channels_;
+	size_t compression_threshold_;
+	DeviceIo io_;
+	bool opened_;
+	bool connected_;
+	bool want_write_;
+	bool pumping_;
+	uint64_t reopen_at_ms_;
+
+	uint8_t tinyproto_buffer_[4096];
+	tinyproto::IFd tinyproto_;
+
+	/**
+	 * Data got from Tinyproto, not yet written to the device
+	 */
+	struct {
+		uint8_t data[512];
+		size_t len;
+		size_t offset;
+	} out_;
+
+	/**
+	 * Frame that Tinyproto did not accept yet
+	 */
+	struct {
+		uint8_t data[GATEWAY_FRAME_SIZE];
+		const uint8_t *ptr;
+		size_t len;
+		size_t payload_len;
+		uint16_t messages;
+	} tx_frame_;
+	std::deque<std::vector<uint8_t>>
+		tx_queues_[ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS];
+	uint8_t tx_last_channel_;
+	bool hello_pending_;
+	uint8_t peer_features_;
+	/**
+	 * Set while Tinyproto processes received data: it is pumped afterwards
+	 */
+	bool receiving_;
+
+	/**
+	 * Credit flow control of each channel, see LINK_FEATURE_CREDIT
+	 */
+	struct {
+		/**
+		 * Credit granted by the device and not used yet
+		 */
+		int64_t tx;
+		/**
+		 * Largest credit held, i.e. the RX FIFO of the channel on the
+		 * device. Larger messages never get enough credit.
+		 */
+		int64_t window;
+		/**
+		 * Credit to return to the device
+		 */
+		uint32_t pending;
+	} credit_[ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS];
+
+	struct {
+		uint8_t tx[GATEWAY_FRAME_SIZE];
+		uint8_t rx[GATEWAY_FRAME_SIZE];
+		tinyproto_lzf_htab htab;
+	} lzf_;
+
+	ClientPort ports_[ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS];
+	DeviceLinkStats stats_;
+};
+
+/*!
+ * @brief Adds the time spent in its scope to DeviceLinkStats::busy_us
+ */
+class BusyScope {
+  public:
+	explicit BusyScope(DeviceLinkStats &stats);
+	~BusyScope(void);
+
+  private:
+	DeviceLinkStats &stats_;
+	uint64_t start_us_;
+};
+
+} // namespace gateway
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_ESP_GATEWAY_DEVICE_LINK_HPP_ */
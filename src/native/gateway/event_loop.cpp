@@ -0,0 +1,99 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		event_loop.cpp
+ *
+ * \brief		Single threaded epoll event loop of the gateway -
+ *				implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "event_loop.hpp"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+/**
+ * Maximum number of events handled per epoll_wait
+ */
+#define MAX_EVENTS 64
+
+using namespace erpc::esp::gateway;
+
+EventLoop::EventLoop(void) : epoll_fd_(-1), running_(false) {}
+
+EventLoop::~EventLoop(void) {
+	if (this->epoll_fd_ >= 0) {
+		close(this->epoll_fd_);
+	}
+}
+
+bool EventLoop::init(void) {
+	this->epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+	return this->epoll_fd_ >= 0;
+}
+
+bool EventLoop::add(int fd, uint32_t events, EventHandler *handler) {
+	struct epoll_event event = {};
+	event.events = events;
+	event.data.fd = fd;
+	if (epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+		return false;
+	}
+	if (static_cast<size_t>(fd) >= this->handlers_.size()) {
+		this->handlers_.resize(fd + 1, nullptr);
+	}
+	this->handlers_[fd] = handler;
+	return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events, EventHandler *handler) {
+	struct epoll_event event = {};
+	event.events = events;
+	event.data.fd = fd;
+	if (epoll_ctl(this->epoll_fd_, EPOLL_CTL_MOD, fd, &event) != 0) {
+		return false;
+	}
+	this->handlers_[fd] = handler;
+	return true;
+}
+
+void EventLoop::remove(int fd) {
+	epoll_ctl(this->epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+	if (static_cast<size_t>(fd) < this->handlers_.size()) {
+		this->handlers_[fd] = nullptr;
+	}
+}
+
+void EventLoop::run(void) {
+	struct epoll_event events[MAX_EVENTS];
+	this->running_ = true;
+	while (this->running_) {
+		int n = epoll_wait(this->epoll_fd_, events, MAX_EVENTS, -1);
+		if (n < 0 && errno != EINTR) {
+			break;
+		}
+		for (int i = 0; i < n; ++i) {
+			int fd = events[i].data.fd;
+			// Removed by a handler called before in this batch
+			if (static_cast<size_t>(fd) >= this->handlers_.size() ||
+				this->handlers_[fd] == nullptr) {
+				continue;
+			}
+			this->handlers_[fd]->on_event(fd, events[i].events);
+		}
+	}
+}
+
+void EventLoop::stop(void) {
+	this->running_ = false;
+}
@@ -0,0 +1,97 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		event_loop.hpp
+ *
+ * \brief		Single threaded epoll event loop of the gateway - interface
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_GATEWAY_EVENT_LOOP_HPP_
+#define ERPC_ESP_GATEWAY_EVENT_LOOP_HPP_
+
+#include <cstdint>
+#include <vector>
+
+namespace erpc {
+namespace esp {
+namespace gateway {
+
+/*!
+ * @brief Receiver of the events of one or more file descriptors
+ */
+class EventHandler {
+  public:
+	virtual ~EventHandler(void) {}
+
+	/*!
+	 * @brief Called by the event loop with the ready events (EPOLLIN, ...)
+	 * of one of the file descriptors of the handler.
+	 */
+	virtual void on_event(int fd, uint32_t events) = 0;
+};
+
+/*!
+ * @brief epoll event loop. Handlers are never called concurrently, so they
+ * need no locking.
+ *
+ * A handler must stay alive until its file descriptors are removed. Pending
+ * events of a removed file descriptor are discarded, but if the number is
+ * reused by a new registration within the same epoll_wait batch, the new
+ * handler may get them: handlers must tolerate spurious events (e.g. EAGAIN
+ * on read).
+ */
+class EventLoop {
+  public:
+	EventLoop(void);
+	~EventLoop(void);
+
+	/*!
+	 * @retval true success
+	 * @retval false the epoll instance could not be created
+	 */
+	bool init(void);
+
+	/*!
+	 * @brief Start monitoring \p events of \p fd.
+	 *
+	 * @retval true success
+	 * @retval false epoll_ctl failure, errno is set
+	 */
+	bool add(int fd, uint32_t events, EventHandler *handler);
+	/*!
+	 * @brief Change the monitored events of \p fd
+	 */
+	bool modify(int fd, uint32_t events, EventHandler *handler);
+	/*!
+	 * @brief Stop monitoring \p fd. Must be called before closing it, if it
+	 * is shared with another process.
+	 */
+	void remove(int fd);
+
+	/*!
+	 * @brief Dispatch the events until stop() is called
+	 */
+	void run(void);
+	void stop(void);
+
+  private:
+	int epoll_fd_;
+	bool running_;
+	/**
+	 * Indexed by file descriptor
+	 */
+	std::vector<EventHandler *> handlers_;
+};
+
+} // namespace gateway
+} // namespace esp
+} // namespace erpc
+
+#endif /* ifndef ERPC_ESP_GATEWAY_EVENT_LOOP_HPP_ */
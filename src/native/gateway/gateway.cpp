@@ -0,0 +1,376 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		gateway.cpp
+ *
+ * \brief		Gateway daemon terminating the Tinyproto links of many
+ *				devices in one event loop
+ *
+ * Each device gets one Unix domain socket per channel, through which local
+ * eRPC clients and servers talk to it. See README.md.
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "device_io.hpp"
+#include "device_link.hpp"
+#include "event_loop.hpp"
+
+#define TAG "gateway"
+#include "esp_log.h"
+
+#include <getopt.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Period of DeviceLink::tick. Tinyproto timeouts are much longer.
+ */
+#define TICK_MS 10
+
+using namespace erpc::esp::gateway;
+
+namespace {
+
+uint64_t monotonic_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+std::string json_string(const std::string &str) {
+	std::string out = "\"";
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			out += escaped;
+		} else {
+			out += c;
+		}
+	}
+	return out + "\"";
+}
+
+/**
+ * Periodic tick of the links
+ */
+class Ticker : public EventHandler {
+  public:
+	explicit Ticker(std::vector<std::unique_ptr<DeviceLink>> &links)
+		: links_(links), fd_(-1) {}
+	~Ticker(void) {
+		if (this->fd_ >= 0) {
+			close(this->fd_);
+		}
+	}
+
+	bool init(EventLoop *loop) {
+		this->fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		struct itimerspec period = {};
+		period.it_interval.tv_nsec = TICK_MS * 1000000;
+		period.it_value = period.it_interval;
+		return this->fd_ >= 0 &&
+			   timerfd_settime(this->fd_, 0, &period, NULL) == 0 &&
+			   loop->add(this->fd_, EPOLLIN, this);
+	}
+
+	void on_event(int fd, uint32_t events) override {
+		uint64_t expirations;
+		if (read(this->fd_, &expirations, sizeof(expirations)) < 0) {
+			return;
+		}
+		for (std::unique_ptr<DeviceLink> &link : this->links_) {
+			link->tick();
+		}
+		device_io_reap_children();
+	}
+
+  private:
+	std::vector<std::unique_ptr<DeviceLink>> &links_;
+	int fd_;
+};
+
+/**
+ * Stops the event loop on SIGINT and SIGTERM
+ */
+class SignalHandler : public EventHandler {
+  public:
+	SignalHandler(void) : loop_(nullptr), fd_(-1) {}
+	~SignalHandler(void) {
+		if (this->fd_ >= 0) {
+			close(this->fd_);
+		}
+	}
+
+	bool init(EventLoop *loop) {
+		sigset_t mask;
+		sigemptyset(&mask);
+		sigaddset(&mask, SIGINT);
+		sigaddset(&mask, SIGTERM);
+		if (sigprocmask(SIG_BLOCK, &mask, NULL) != 0) {
+			return false;
+		}
+		this->loop_ = loop;
+		this->fd_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+		return this->fd_ >= 0 && loop->add(this->fd_, EPOLLIN, this);
+	}
+
+	void on_event(int fd, uint32_t events) override {
+		struct signalfd_siginfo info;
+		if (read(this->fd_, &info, sizeof(info)) == sizeof(info)) {
+			ESP_LOGI(TAG, "Signal %u, exiting", info.ssi_signo);
+			this->loop_->stop();
+		}
+	}
+
+  private:
+	EventLoop *loop_;
+	int fd_;
+};
+
+/**
+ * Unix domain socket that writes the statistics of the links as JSON to
+ * whoever connects, then closes the connection
+ */
+class StatsPort : public EventHandler {
+  public:
+	explicit StatsPort(const std::vector<std::unique_ptr<DeviceLink>> &links)
+		: links_(links), loop_(nullptr), fd_(-1),
+		  start_ms_(monotonic_ms()) {}
+	~StatsPort(void) {
+		if (this->fd_ >= 0) {
+			this->loop_->remove(this->fd_);
+			close(this->fd_);
+			unlink(this->path_.c_str());
+		}
+	}
+
+	bool init(EventLoop *loop, const std::string &path) {
+		struct sockaddr_un addr = {};
+		if (path.size() >= sizeof(addr.sun_path)) {
+			errno = ENAMETOOLONG;
+			return false;
+		}
+		addr.sun_family = AF_UNIX;
+		memcpy(addr.sun_path, path.c_str(), path.size());
+		this->fd_ =
+			socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (this->fd_ < 0) {
+			return false;
+		}
+		unlink(path.c_str());
+		this->loop_ = loop;
+		this->path_ = path;
+		return bind(this->fd_, reinterpret_cast<struct sockaddr *>(&addr),
+					sizeof(addr)) == 0 &&
+			   listen(this->fd_, 4) == 0 &&
+			   loop->add(this->fd_, EPOLLIN, this);
+	}
+
+	void on_event(int fd, uint32_t events) override {
+		int client;
+		while ((client = accept4(this->fd_, nullptr, nullptr,
+								 SOCK_CLOEXEC)) >= 0) {
+			std::string json = this->to_json();
+			// Best effort: the document fits in the socket buffer
+			ssize_t ret = send(client, json.data(), json.size(),
+							   MSG_DONTWAIT | MSG_NOSIGNAL);
+			(void)ret;
+			close(client);
+		}
+	}
+
+  private:
+	std::string to_json(void) const {
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		uint64_t cpu_us =
+			(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL +
+			usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+
+		std::string json = "{\"uptime_ms\": " +
+						   std::to_string(monotonic_ms() - this->start_ms_) +
+						   ", \"cpu_us\": " + std::to_string(cpu_us) +
+						   ", \"links\": [";
+		for (size_t i = 0; i < this->links_.size(); ++i) {
+			const DeviceLink &link = *this->links_[i];
+			const DeviceLinkStats &stats = link.stats();
+			json += i == 0 ? "\n" : ",\n";
+			json += "  {\"name\": " + json_string(link.name()) +
+					", \"spec\": " + json_string(link.spec()) +
+					", \"state\": \"" + link.state() + "\"" +
+					", \"compression\": " +
+					(link.compression() ? "true" : "false");
+#define STATS_FIELD(field)                                                     \
+	json += ", \"" #field "\": " + std::to_string(stats.field)
+			STATS_FIELD(rx_bytes);
+			STATS_FIELD(tx_bytes);
+			STATS_FIELD(rx_frames);
+			STATS_FIELD(tx_frames);
+			STATS_FIELD(rx_messages);
+			STATS_FIELD(tx_messages);
+			STATS_FIELD(dropped_messages);
+			STATS_FIELD(tx_dropped);
+			STATS_FIELD(rx_errors);
+			STATS_FIELD(rejected_clients);
+			STATS_FIELD(connections);
+			STATS_FIELD(reopens);
+			STATS_FIELD(busy_us);
+#undef STATS_FIELD
+			json += "}";
+		}
+		return json + "\n]}\n";
+	}
+
+	const std::vector<std::unique_ptr<DeviceLink>> &links_;
+	EventLoop *loop_;
+	int fd_;
+	std::string path_;
+	uint64_t start_ms_;
+};
+
+void usage(const char *program) {
+	fprintf(stderr,
+			"Usage: %s [-d DIR] [-c CHANNELS] [-z THRESHOLD] [-v] "
+			"NAME=DEVICE...\n"
+			"\n"
+			"Terminate the Tinyproto links of the given devices and expose\n"
+			"each channel of device NAME as the Unix domain socket\n"
+			"DIR/NAME.sock (channel 0) or DIR/NAME.<channel>.sock.\n"
+			"DIR/stats returns the statistics of the links as JSON.\n"
+			"\n"
+			"DEVICE is one of:\n"
+			"  exec:COMMAND    stdin and stdout of COMMAND\n"
+			"  tcp:HOST:PORT   TCP connection\n"
+			"  unix:PATH       Unix domain stream socket\n"
+			"  PATH[@BAUD]     serial port (115200 baud by default)\n"
+			"\n"
+			"  -d DIR        socket directory (default: current directory)\n"
+			"  -c CHANNELS   channels exposed per device, 1 to %u (default: "
+			"1)\n"
+			"  -z THRESHOLD  compress frames of at least THRESHOLD bytes, 0 "
+			"to\n"
+			"                disable compression (default: 64)\n"
+			"  -v            verbose, repeat for more\n",
+			program, ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	std::string socket_dir = ".";
+	unsigned long channels = 1;
+	unsigned long compression_threshold = 64;
+	int verbosity = ESP_LOG_INFO;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "d:c:z:vh")) != -1) {
+		switch (opt) {
+		case 'd':
+			socket_dir = optarg;
+			break;
+		case 'c':
+			channels = strtoul(optarg, NULL, 10);
+			break;
+		case 'z':
+			compression_threshold = strtoul(optarg, NULL, 10);
+			break;
+		case 'v':
+			++verbosity;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+	if (optind == argc || channels == 0 ||
+		channels > ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	esp_log_level_set("*", static_cast<esp_log_level_t>(
+							   verbosity > ESP_LOG_VERBOSE ? ESP_LOG_VERBOSE
+														   : verbosity));
+	// Write errors are handled where they happen
+	signal(SIGPIPE, SIG_IGN);
+
+	EventLoop loop;
+	if (!loop.init()) {
+		ESP_LOGE(TAG, "epoll_create1: %s", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (mkdir(socket_dir.c_str(), 0700) != 0 && errno != EEXIST) {
+		ESP_LOGE(TAG, "Cannot create %s: %s", socket_dir.c_str(),
+				 strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	std::vector<std::unique_ptr<DeviceLink>> links;
+	for (int i = optind; i < argc; ++i) {
+		std::string arg = argv[i];
+		size_t equal = arg.find('=');
+		std::string name = arg.substr(0, equal);
+		// The name is part of socket names
+		if (equal == std::string::npos || name.empty() ||
+			name.find_first_of("/.") != std::string::npos ||
+			name == "stats") {
+			ESP_LOGE(TAG, "Invalid device: %s", argv[i]);
+			return EXIT_FAILURE;
+		}
+		links.emplace_back(new DeviceLink(&loop, name, arg.substr(equal + 1),
+										  channels, compression_threshold));
+	}
+
+	SignalHandler signals;
+	Ticker ticker(links);
+	StatsPort stats(links);
+	if (!signals.init(&loop) || !ticker.init(&loop)) {
+		ESP_LOGE(TAG, "Initialization failed: %s", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (!stats.init(&loop, socket_dir + "/stats")) {
+		ESP_LOGE(TAG, "Cannot listen on %s/stats: %s", socket_dir.c_str(),
+				 strerror(errno));
+		return EXIT_FAILURE;
+	}
+	for (std::unique_ptr<DeviceLink> &link : links) {
+		if (!link->start(socket_dir)) {
+			return EXIT_FAILURE;
+		}
+	}
+	ESP_LOGI(TAG, "Serving %u devices in %s", (unsigned)links.size(),
+			 socket_dir.c_str());
+
+	loop.run();
+
+	for (std::unique_ptr<DeviceLink> &link : links) {
+		link->stop();
+	}
+	return EXIT_SUCCESS;
+}
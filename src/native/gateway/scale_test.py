@@ -0,0 +1,206 @@
+"""
+Scale test of the gateway.
+
+Spawns the gateway with N instances of the host example application
+(host.elf) as devices, connects a client to each of them and measures the
+aggregate message rate and the CPU time of the gateway per link.
+
+The host example calls say_hello_to_host in a loop, so the device to client
+direction is always loaded. With --send, the clients also call
+say_hello_to_target as fast as the gateway accepts.
+
+    python scale_test.py --gateway build/gateway/erpc_esp_gateway \\
+        --links 64 path/to/host/build/host.elf
+"""
+
+import argparse
+import os
+import selectors
+import signal
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", ".."))
+
+from erpc_esp.erpc_gateway import read_stats, socket_path  # noqa: E402
+
+
+def say_hello_to_target_frames(count: int) -> bytes:
+    """
+    Framed oneway say_hello_to_target calls. 1 and 1 are the IDs assigned by
+    erpcgen to hello_world_target and say_hello_to_target.
+    """
+    import erpc
+    from erpc.crc16 import Crc16
+
+    crc = Crc16()
+    frames = bytearray()
+    for i in range(count):
+        codec = erpc.basic_codec.BasicCodec()
+        codec.start_write_message(
+            erpc.codec.MessageInfo(
+                type=erpc.codec.MessageType.kOnewayMessage,
+                service=1,
+                request=1,
+                sequence=i,
+            )
+        )
+        codec.write_string("scale test")
+        codec.write_uint32(i)
+        message = bytes(codec.buffer)
+        frames += struct.pack("<HH", len(message), crc.computeCRC16(message))
+        frames += message
+    return bytes(frames)
+
+
+class Clients(threading.Thread):
+    """
+    One client per link, all served by one selector: they drain what the
+    gateway sends and optionally send a stream of calls
+    """
+
+    def __init__(self, paths, frames: bytes = b""):
+        super(Clients, self).__init__(daemon=True)
+        self._frames = frames
+        self._selector = selectors.DefaultSelector()
+        self._stop_event = threading.Event()
+        self.rx_bytes = 0
+        self.tx_bytes = 0
+        for path in paths:
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            sock.connect(path)
+            sock.setblocking(False)
+            events = selectors.EVENT_READ
+            if frames:
+                events |= selectors.EVENT_WRITE
+            # Data: offset in self._frames of the next byte to send
+            self._selector.register(sock, events, [0])
+
+    def run(self):
+        while not self._stop_event.is_set():
+            for key, mask in self._selector.select(timeout=0.1):
+                if mask & selectors.EVENT_READ:
+                    data = key.fileobj.recv(65536)
+                    if not data:
+                        raise ConnectionError("Connection closed by the gateway")
+                    self.rx_bytes += len(data)
+                if mask & selectors.EVENT_WRITE:
+                    offset = key.data[0]
+                    sent = key.fileobj.send(self._frames[offset:])
+                    key.data[0] = (offset + sent) % len(self._frames)
+                    self.tx_bytes += sent
+
+    def stop(self):
+        self._stop_event.set()
+        self.join()
+        for key in list(self._selector.get_map().values()):
+            key.fileobj.close()
+
+
+def wait_connected(socket_dir: str, links: int, timeout: float):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        try:
+            stats = read_stats(socket_dir)
+            states = [link["state"] for link in stats["links"]]
+            if states.count("connected") == links:
+                return
+        except (OSError, ValueError):
+            pass
+        time.sleep(0.2)
+    raise TimeoutError("Not all the devices connected")
+
+
+def delta(before: dict, after: dict, field: str) -> list:
+    return [b[field] - a[field] for a, b in zip(before["links"], after["links"])]
+
+
+def report(before: dict, after: dict):
+    seconds = (after["uptime_ms"] - before["uptime_ms"]) / 1000
+    cpu_us = after["cpu_us"] - before["cpu_us"]
+    links = len(after["links"])
+    rx_messages = sum(delta(before, after, "rx_messages"))
+    tx_messages = sum(delta(before, after, "tx_messages"))
+    dropped = sum(delta(before, after, "dropped_messages"))
+    wire_bytes = sum(delta(before, after, "rx_bytes")) + sum(
+        delta(before, after, "tx_bytes")
+    )
+    busy = [us / seconds / 1e4 for us in delta(before, after, "busy_us")]
+    messages = rx_messages + tx_messages
+
+    print(f"Links:                     {links}")
+    print(f"Duration:                  {seconds:.1f} s")
+    print(f"Messages from devices:     {rx_messages / seconds:.0f} msg/s")
+    print(f"Messages to devices:       {tx_messages / seconds:.0f} msg/s")
+    print(f"Dropped messages:          {dropped}")
+    print(f"Device I/O:                {wire_bytes / seconds / 1024:.0f} KiB/s")
+    print(f"Gateway CPU:               {cpu_us / seconds / 1e4:.1f} %")
+    print(f"Gateway CPU per link:      {cpu_us / seconds / 1e4 / links:.2f} %")
+    print(
+        f"Busy time per link:        {min(busy):.2f} % min, "
+        f"{sum(busy) / links:.2f} % mean, {max(busy):.2f} % max"
+    )
+    if messages:
+        print(f"CPU per message:           {cpu_us / messages:.1f} us")
+
+
+def main(args):
+    socket_dir = tempfile.mkdtemp(prefix="erpc_esp_gateway_")
+    devices = [f"dev{i}=exec:{args.program} 2>/dev/null" for i in range(args.links)]
+    log = open(os.path.join(socket_dir, "gateway.log"), "w")
+    gateway = subprocess.Popen([args.gateway, "-d", socket_dir] + devices, stderr=log)
+    clients = None
+    try:
+        wait_connected(socket_dir, args.links, args.connect_timeout)
+        frames = say_hello_to_target_frames(64) if args.send else b""
+        clients = Clients(
+            [socket_path(socket_dir, f"dev{i}") for i in range(args.links)],
+            frames,
+        )
+        clients.start()
+
+        time.sleep(args.warmup)
+        before = read_stats(socket_dir)
+        time.sleep(args.duration)
+        after = read_stats(socket_dir)
+        report(before, after)
+    finally:
+        if clients is not None:
+            clients.stop()
+        gateway.send_signal(signal.SIGINT)
+        gateway.wait()
+        log.close()
+        print(f"Gateway log: {log.name}")
+
+
+if __name__ == "__main__":
+    arg_parser = argparse.ArgumentParser(description="Gateway scale test")
+    arg_parser.add_argument("program", help="The host example application")
+    arg_parser.add_argument(
+        "--gateway", default="erpc_esp_gateway", help="The gateway executable"
+    )
+    arg_parser.add_argument("--links", type=int, default=16, help="Devices")
+    arg_parser.add_argument(
+        "--duration", type=float, default=10, help="Measurement time in seconds"
+    )
+    arg_parser.add_argument(
+        "--warmup", type=float, default=2, help="Time before measuring, in seconds"
+    )
+    arg_parser.add_argument(
+        "--connect-timeout",
+        type=float,
+        default=30,
+        help="Maximum time for all the devices to connect, in seconds",
+    )
+    arg_parser.add_argument(
+        "--send",
+        default=False,
+        action="store_true",
+        help="Also call say_hello_to_target as fast as possible",
+    )
+    main(arg_parser.parse_args())
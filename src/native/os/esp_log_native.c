@@ -0,0 +1,56 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		esp_log_native.c
+ *
+ * \brief		ESP-IDF logging, printing to stderr - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+static int stderr_vprintf(const char *format, va_list args) {
+	// stderr is unbuffered and the stdio functions are thread safe
+	return vfprintf(stderr, format, args);
+}
+
+static volatile esp_log_level_t s_level = ESP_LOG_INFO;
+static vprintf_like_t s_vprintf = stderr_vprintf;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+	s_level = level;
+}
+
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func) {
+	vprintf_like_t previous = s_vprintf;
+	s_vprintf = func;
+	return previous;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format,
+				   ...) {
+	if (level > s_level) {
+		return;
+	}
+	va_list args;
+	va_start(args, format);
+	s_vprintf(format, args);
+	va_end(args);
+}
+
+uint32_t esp_log_timestamp(void) {
+	return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
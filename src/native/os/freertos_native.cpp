@@ -0,0 +1,353 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		freertos_native.cpp
+ *
+ * \brief		Subset of the FreeRTOS API on native threads - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "freertos/task.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+using Lock = std::unique_lock<std::mutex>;
+
+/**
+ * Wait on \p cond until \p pred is true or \p ticks have elapsed
+ *
+ * \return the last value of \p pred
+ */
+template <typename Predicate>
+static bool wait_ticks(std::condition_variable &cond, Lock &lock,
+					   TickType_t ticks, Predicate pred) {
+	if (ticks == portMAX_DELAY) {
+		cond.wait(lock, pred);
+		return true;
+	}
+	return cond.wait_for(lock, std::chrono::milliseconds(ticks), pred);
+}
+
+/**
+ * Construct \p T in the storage of the Static*_t type \p S
+ */
+template <typename T, typename S> static T *construct_in(S *storage) {
+	static_assert(sizeof(T) <= sizeof(S), "Static type too small");
+	static_assert(alignof(T) <= alignof(S), "Static type misaligned");
+	return new (storage) T();
+}
+
+/*
+ * Critical section
+ */
+
+static std::recursive_mutex s_critical;
+
+void vPortEnterCritical(void) {
+	s_critical.lock();
+}
+
+void vPortExitCritical(void) {
+	s_critical.unlock();
+}
+
+/*
+ * Tasks
+ */
+
+struct tskTaskControlBlock {
+	char name[16];
+};
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode, const char *pcName,
+							   uint32_t ulStackDepth, void *pvParameters,
+							   UBaseType_t uxPriority,
+							   StackType_t *puxStackBuffer,
+							   StaticTask_t *pxTaskBuffer) {
+	tskTaskControlBlock *task =
+		construct_in<tskTaskControlBlock>(pxTaskBuffer);
+	strncpy(task->name, pcName, sizeof(task->name) - 1);
+	std::thread(pxTaskCode, pvParameters).detach();
+	return task;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+	assert(xTaskToDelete == NULL);
+}
+
+void vTaskDelay(TickType_t xTicksToDelay) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(xTicksToDelay));
+}
+
+TickType_t xTaskGetTickCount(void) {
+	static const Clock::time_point start = Clock::now();
+	return static_cast<TickType_t>(
+		std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+															  start)
+			.count());
+}
+
+/*
+ * Event groups
+ */
+
+struct EventGroupDef_t {
+	std::mutex mutex;
+	std::condition_variable cond;
+	EventBits_t bits = 0;
+};
+
+EventGroupHandle_t
+xEventGroupCreateStatic(StaticEventGroup_t *pxEventGroupBuffer) {
+	return construct_in<EventGroupDef_t>(pxEventGroupBuffer);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup,
+							   const EventBits_t uxBitsToSet) {
+	Lock lock(xEventGroup->mutex);
+	xEventGroup->bits |= uxBitsToSet;
+	xEventGroup->cond.notify_all();
+	return xEventGroup->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup,
+								 const EventBits_t uxBitsToClear) {
+	Lock lock(xEventGroup->mutex);
+	EventBits_t bits = xEventGroup->bits;
+	xEventGroup->bits &= ~uxBitsToClear;
+	return bits;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup) {
+	Lock lock(xEventGroup->mutex);
+	return xEventGroup->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup,
+								const EventBits_t uxBitsToWaitFor,
+								const BaseType_t xClearOnExit,
+								const BaseType_t xWaitForAllBits,
+								TickType_t xTicksToWait) {
+	Lock lock(xEventGroup->mutex);
+	auto satisfied = [&] {
+		EventBits_t set = xEventGroup->bits & uxBitsToWaitFor;
+		return xWaitForAllBits ? set == uxBitsToWaitFor : set != 0;
+	};
+	bool ok = wait_ticks(xEventGroup->cond, lock, xTicksToWait, satisfied);
+	EventBits_t bits = xEventGroup->bits;
+	if (ok && xClearOnExit) {
+		xEventGroup->bits &= ~uxBitsToWaitFor;
+	}
+	return bits;
+}
+
+/*
+ * Semaphores
+ */
+
+struct QueueDefinition {
+	std::mutex mutex;
+	std::condition_variable cond;
+	UBaseType_t count = 0;
+	UBaseType_t max = 0;
+};
+
+SemaphoreHandle_t
+xSemaphoreCreateCountingStatic(UBaseType_t uxMaxCount,
+							   UBaseType_t uxInitialCount,
+							   StaticSemaphore_t *pxSemaphoreBuffer) {
+	QueueDefinition *sem = construct_in<QueueDefinition>(pxSemaphoreBuffer);
+	sem->count = uxInitialCount;
+	sem->max = uxMaxCount;
+	return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore,
+						  TickType_t xBlockTime) {
+	Lock lock(xSemaphore->mutex);
+	if (!wait_ticks(xSemaphore->cond, lock, xBlockTime,
+					[&] { return xSemaphore->count > 0; })) {
+		return pdFALSE;
+	}
+	--xSemaphore->count;
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore) {
+	Lock lock(xSemaphore->mutex);
+	if (xSemaphore->count >= xSemaphore->max) {
+		return pdFALSE;
+	}
+	++xSemaphore->count;
+	xSemaphore->cond.notify_one();
+	return pdTRUE;
+}
+
+/*
+ * Stream and message buffers
+ */
+
+struct StreamBufferDef_t {
+	std::mutex mutex;
+	std::condition_variable cond;
+	uint8_t *storage = nullptr;
+	/**
+	 * Size of storage, one more than the capacity
+	 */
+	size_t length = 0;
+	size_t head = 0;
+	size_t tail = 0;
+	bool is_message_buffer = false;
+
+	size_t used(void) const {
+		return (this->head + this->length - this->tail) % this->length;
+	}
+	size_t space(void) const {
+		return this->length - 1 - this->used();
+	}
+	void write(const void *data, size_t size) {
+		const uint8_t *src = static_cast<const uint8_t *>(data);
+		size_t first = std::min(size, this->length - this->head);
+		memcpy(this->storage + this->head, src, first);
+		memcpy(this->storage, src + first, size - first);
+		this->head = (this->head + size) % this->length;
+	}
+	void peek(void *data, size_t size) const {
+		uint8_t *dst = static_cast<uint8_t *>(data);
+		size_t first = std::min(size, this->length - this->tail);
+		memcpy(dst, this->storage + this->tail, first);
+		memcpy(dst + first, this->storage, size - first);
+	}
+	void read(void *data, size_t size) {
+		this->peek(data, size);
+		this->tail = (this->tail + size) % this->length;
+	}
+	/**
+	 * Length of the next message, 0 if none
+	 */
+	size_t nextMessage(void) const {
+		size_t len = 0;
+		if (this->used() >= sizeof(len)) {
+			this->peek(&len, sizeof(len));
+		}
+		return len;
+	}
+};
+
+StreamBufferHandle_t xStreamBufferGenericCreateStatic(
+	size_t xBufferSizeBytes, size_t xTriggerLevelBytes,
+	BaseType_t xIsMessageBuffer, uint8_t *pucStreamBufferStorageArea,
+	StaticStreamBuffer_t *pxStaticStreamBuffer) {
+	StreamBufferDef_t *buffer =
+		construct_in<StreamBufferDef_t>(pxStaticStreamBuffer);
+	buffer->storage = pucStreamBufferStorageArea;
+	buffer->length = xBufferSizeBytes + 1;
+	buffer->is_message_buffer = xIsMessageBuffer;
+	return buffer;
+}
+
+StreamBufferHandle_t
+xStreamBufferCreateStatic(size_t xBufferSizeBytes, size_t xTriggerLevelBytes,
+						  uint8_t *pucStreamBufferStorageArea,
+						  StaticStreamBuffer_t *pxStaticStreamBuffer) {
+	return xStreamBufferGenericCreateStatic(
+		xBufferSizeBytes, xTriggerLevelBytes, pdFALSE,
+		pucStreamBufferStorageArea, pxStaticStreamBuffer);
+}
+
+size_t xStreamBufferSend(StreamBufferHandle_t xStreamBuffer,
+						 const void *pvTxData, size_t xDataLengthBytes,
+						 TickType_t xTicksToWait) {
+	StreamBufferDef_t *b = xStreamBuffer;
+	Lock lock(b->mutex);
+	size_t needed = b->is_message_buffer
+						? sizeof(xDataLengthBytes) + xDataLengthBytes
+						: 1;
+	if (needed > b->length - 1) {
+		return 0;
+	}
+	if (!wait_ticks(b->cond, lock, xTicksToWait,
+					[&] { return b->space() >= needed; })) {
+		return 0;
+	}
+	size_t size = xDataLengthBytes;
+	if (b->is_message_buffer) {
+		b->write(&xDataLengthBytes, sizeof(xDataLengthBytes));
+	} else {
+		size = std::min(size, b->space());
+	}
+	b->write(pvTxData, size);
+	b->cond.notify_all();
+	return size;
+}
+
+size_t xStreamBufferReceive(StreamBufferHandle_t xStreamBuffer,
+							void *pvRxData, size_t xBufferLengthBytes,
+							TickType_t xTicksToWait) {
+	StreamBufferDef_t *b = xStreamBuffer;
+	Lock lock(b->mutex);
+	if (!wait_ticks(b->cond, lock, xTicksToWait,
+					[&] { return b->used() > 0; })) {
+		return 0;
+	}
+	size_t size;
+	if (b->is_message_buffer) {
+		size = b->nextMessage();
+		if (size > xBufferLengthBytes) {
+			return 0;
+		}
+		b->tail = (b->tail + sizeof(size)) % b->length;
+	} else {
+		size = std::min(xBufferLengthBytes, b->used());
+	}
+	b->read(pvRxData, size);
+	b->cond.notify_all();
+	return size;
+}
+
+size_t xStreamBufferNextMessageLengthBytes(StreamBufferHandle_t xStreamBuffer) {
+	Lock lock(xStreamBuffer->mutex);
+	return xStreamBuffer->nextMessage();
+}
+
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t xStreamBuffer) {
+	Lock lock(xStreamBuffer->mutex);
+	return xStreamBuffer->used();
+}
+
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t xStreamBuffer) {
+	Lock lock(xStreamBuffer->mutex);
+	return xStreamBuffer->space();
+}
+
+BaseType_t xStreamBufferIsEmpty(StreamBufferHandle_t xStreamBuffer) {
+	Lock lock(xStreamBuffer->mutex);
+	return xStreamBuffer->used() == 0;
+}
+
+BaseType_t xStreamBufferReset(StreamBufferHandle_t xStreamBuffer) {
+	Lock lock(xStreamBuffer->mutex);
+	xStreamBuffer->head = 0;
+	xStreamBuffer->tail = 0;
+	xStreamBuffer->cond.notify_all();
+	return pdPASS;
+}
@@ -0,0 +1,74 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		esp_log.h
+ *
+ * \brief		ESP-IDF logging macros, printing to stderr
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_ESP_LOG_H_
+#define ERPC_ESP_NATIVE_ESP_LOG_H_
+
+#include <stdarg.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	ESP_LOG_NONE,
+	ESP_LOG_ERROR,
+	ESP_LOG_WARN,
+	ESP_LOG_INFO,
+	ESP_LOG_DEBUG,
+	ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+/**
+ * Set the log level. Unlike ESP-IDF, there is a single level for all the
+ * tags, so \p tag is ignored. ESP_LOG_INFO by default.
+ */
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+
+typedef int (*vprintf_like_t)(const char *, va_list);
+
+/**
+ * Replace the function that prints the logs, vfprintf to stderr by default.
+ *
+ * @return the previous function
+ */
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func);
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format,
+				   ...) __attribute__((format(printf, 3, 4)));
+
+uint32_t esp_log_timestamp(void);
+
+#define ESP_LOG_LEVEL(level, letter, tag, format, ...)                         \
+	esp_log_write(level, tag, #letter " (%u) %s: " format "\n",                \
+				  (unsigned)esp_log_timestamp(), tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...)                                             \
+	ESP_LOG_LEVEL(ESP_LOG_ERROR, E, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)                                             \
+	ESP_LOG_LEVEL(ESP_LOG_WARN, W, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)                                             \
+	ESP_LOG_LEVEL(ESP_LOG_INFO, I, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)                                             \
+	ESP_LOG_LEVEL(ESP_LOG_DEBUG, D, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)                                             \
+	ESP_LOG_LEVEL(ESP_LOG_VERBOSE, V, tag, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_NATIVE_ESP_LOG_H_ */
@@ -0,0 +1,34 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		esp_timer.h
+ *
+ * \brief		ESP-IDF high resolution time, on the monotonic clock
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_ESP_TIMER_H_
+#define ERPC_ESP_NATIVE_ESP_TIMER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Get the time in us since an unspecified point, from CLOCK_MONOTONIC
+ */
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_NATIVE_ESP_TIMER_H_ */
@@ -0,0 +1,73 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		FreeRTOS.h
+ *
+ * \brief		Subset of the FreeRTOS API used by the transports, on native
+ * 				threads
+ *
+ * The transports of this repository are written against FreeRTOS. When built
+ * natively (see src/native/README.md) they use these headers, which implement
+ * the few FreeRTOS objects they need with std::thread, std::mutex and
+ * std::condition_variable, instead of the FreeRTOS POSIX simulator.
+ *
+ * Objects are created only with the static API. The Static*_t types are
+ * storage large enough for the native objects, which are constructed in
+ * place and never destroyed.
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_FREERTOS_H_
+#define ERPC_ESP_NATIVE_FREERTOS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint8_t StackType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS (pdTRUE)
+#define pdFAIL (pdFALSE)
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs)                                               \
+	((TickType_t)(((uint64_t)(xTimeInMs) * configTICK_RATE_HZ) / 1000U))
+
+/**
+ * Storage of the native objects, see the Static*_t types
+ */
+#define ERPC_ESP_NATIVE_STATIC_STORAGE(words)                                  \
+	struct {                                                                   \
+		uint64_t storage[words];                                               \
+	}
+
+/**
+ * Enter the critical section. It is a single process wide recursive mutex, so
+ * unlike on a single core MCU it does not prevent the other threads from
+ * running, but only from entering the critical section too.
+ */
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_NATIVE_FREERTOS_H_ */
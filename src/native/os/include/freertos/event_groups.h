@@ -0,0 +1,56 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		event_groups.h
+ *
+ * \brief		FreeRTOS event groups on a mutex and a condition variable
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_FREERTOS_EVENT_GROUPS_H_
+#define ERPC_ESP_NATIVE_FREERTOS_EVENT_GROUPS_H_
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t EventBits_t;
+typedef struct EventGroupDef_t *EventGroupHandle_t;
+typedef ERPC_ESP_NATIVE_STATIC_STORAGE(16) StaticEventGroup_t;
+
+EventGroupHandle_t
+xEventGroupCreateStatic(StaticEventGroup_t *pxEventGroupBuffer);
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup,
+							   const EventBits_t uxBitsToSet);
+
+/**
+ * \return the bits before clearing them
+ */
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup,
+								 const EventBits_t uxBitsToClear);
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup);
+
+/**
+ * \return the bits when the wait ended, before clearing them
+ */
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup,
+								const EventBits_t uxBitsToWaitFor,
+								const BaseType_t xClearOnExit,
+								const BaseType_t xWaitForAllBits,
+								TickType_t xTicksToWait);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_NATIVE_FREERTOS_EVENT_GROUPS_H_ */
@@ -0,0 +1,51 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		message_buffer.h
+ *
+ * \brief		FreeRTOS message buffers, on the native stream buffers
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_FREERTOS_MESSAGE_BUFFER_H_
+#define ERPC_ESP_NATIVE_FREERTOS_MESSAGE_BUFFER_H_
+
+#include "stream_buffer.h"
+
+typedef StreamBufferHandle_t MessageBufferHandle_t;
+typedef StaticStreamBuffer_t StaticMessageBuffer_t;
+
+#define xMessageBufferCreateStatic(xBufferSizeBytes,                          \
+								   pucMessageBufferStorageArea,               \
+								   pxStaticMessageBuffer)                     \
+	xStreamBufferGenericCreateStatic((xBufferSizeBytes), 0, pdTRUE,            \
+									 (pucMessageBufferStorageArea),           \
+									 (pxStaticMessageBuffer))
+/**
+ * Send a whole message, or nothing
+ */
+#define xMessageBufferSend(xMessageBuffer, pvTxData, xDataLengthBytes,        \
+						   xTicksToWait)                                      \
+	xStreamBufferSend((xMessageBuffer), (pvTxData), (xDataLengthBytes),        \
+					  (xTicksToWait))
+/**
+ * Receive a whole message. If it does not fit, it is left in the buffer and 0
+ * is returned.
+ */
+#define xMessageBufferReceive(xMessageBuffer, pvRxData, xBufferLengthBytes,   \
+							  xTicksToWait)                                   \
+	xStreamBufferReceive((xMessageBuffer), (pvRxData), (xBufferLengthBytes),   \
+						 (xTicksToWait))
+#define xMessageBufferNextLengthBytes(xMessageBuffer)                          \
+	xStreamBufferNextMessageLengthBytes(xMessageBuffer)
+#define xMessageBufferIsEmpty(xMessageBuffer)                                  \
+	xStreamBufferIsEmpty(xMessageBuffer)
+#define xMessageBufferReset(xMessageBuffer) xStreamBufferReset(xMessageBuffer)
+
+#endif /* ifndef ERPC_ESP_NATIVE_FREERTOS_MESSAGE_BUFFER_H_ */
@@ -0,0 +1,52 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		semphr.h
+ *
+ * \brief		FreeRTOS semaphores and mutexes on a mutex and a condition
+ * 				variable
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_FREERTOS_SEMPHR_H_
+#define ERPC_ESP_NATIVE_FREERTOS_SEMPHR_H_
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct QueueDefinition *SemaphoreHandle_t;
+typedef ERPC_ESP_NATIVE_STATIC_STORAGE(16) StaticSemaphore_t;
+
+/**
+ * Counting semaphore with \p uxInitialCount of \p uxMaxCount tokens. The
+ * mutexes and binary semaphores are counting semaphores with one token,
+ * without priority inheritance.
+ */
+SemaphoreHandle_t
+xSemaphoreCreateCountingStatic(UBaseType_t uxMaxCount,
+							   UBaseType_t uxInitialCount,
+							   StaticSemaphore_t *pxSemaphoreBuffer);
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore,
+						  TickType_t xBlockTime);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore);
+
+#define xSemaphoreCreateMutexStatic(pxMutexBuffer)                             \
+	xSemaphoreCreateCountingStatic(1, 1, (pxMutexBuffer))
+#define xSemaphoreCreateBinaryStatic(pxSemaphoreBuffer)                        \
+	xSemaphoreCreateCountingStatic(1, 0, (pxSemaphoreBuffer))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_NATIVE_FREERTOS_SEMPHR_H_ */
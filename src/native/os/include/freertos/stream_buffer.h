@@ -0,0 +1,67 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		stream_buffer.h
+ *
+ * \brief		FreeRTOS stream buffers on a mutex and a condition variable
+ *
+ * As on FreeRTOS, the storage area holds one byte more than the capacity, and
+ * message buffers (see message_buffer.h) are stream buffers where each
+ * message is preceded by its size_t length.
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_FREERTOS_STREAM_BUFFER_H_
+#define ERPC_ESP_NATIVE_FREERTOS_STREAM_BUFFER_H_
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct StreamBufferDef_t *StreamBufferHandle_t;
+typedef ERPC_ESP_NATIVE_STATIC_STORAGE(24) StaticStreamBuffer_t;
+
+/**
+ * \param [in] xBufferSizeBytes capacity
+ * \param [in] xTriggerLevelBytes ignored: receivers are woken up by any data
+ * \param [in] pucStreamBufferStorageArea xBufferSizeBytes + 1 bytes
+ * \param [in] pxStaticStreamBuffer
+ */
+StreamBufferHandle_t
+xStreamBufferCreateStatic(size_t xBufferSizeBytes, size_t xTriggerLevelBytes,
+						  uint8_t *pucStreamBufferStorageArea,
+						  StaticStreamBuffer_t *pxStaticStreamBuffer);
+
+size_t xStreamBufferSend(StreamBufferHandle_t xStreamBuffer,
+						 const void *pvTxData, size_t xDataLengthBytes,
+						 TickType_t xTicksToWait);
+size_t xStreamBufferReceive(StreamBufferHandle_t xStreamBuffer,
+							void *pvRxData, size_t xBufferLengthBytes,
+							TickType_t xTicksToWait);
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t xStreamBuffer);
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t xStreamBuffer);
+BaseType_t xStreamBufferIsEmpty(StreamBufferHandle_t xStreamBuffer);
+BaseType_t xStreamBufferReset(StreamBufferHandle_t xStreamBuffer);
+
+/*
+ * Message buffer primitives, see message_buffer.h
+ */
+StreamBufferHandle_t xStreamBufferGenericCreateStatic(
+	size_t xBufferSizeBytes, size_t xTriggerLevelBytes,
+	BaseType_t xIsMessageBuffer, uint8_t *pucStreamBufferStorageArea,
+	StaticStreamBuffer_t *pxStaticStreamBuffer);
+size_t xStreamBufferNextMessageLengthBytes(StreamBufferHandle_t xStreamBuffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_NATIVE_FREERTOS_STREAM_BUFFER_H_ */
@@ -0,0 +1,60 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		task.h
+ *
+ * \brief		FreeRTOS tasks on native threads
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_FREERTOS_TASK_H_
+#define ERPC_ESP_NATIVE_FREERTOS_TASK_H_
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef ERPC_ESP_NATIVE_STATIC_STORAGE(8) StaticTask_t;
+typedef void (*TaskFunction_t)(void *);
+
+/**
+ * Start a detached thread running \p pxTaskCode. The stack, the stack depth
+ * and the priority are ignored: the thread has its own stack and is scheduled
+ * by the OS.
+ */
+TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode, const char *pcName,
+							   uint32_t ulStackDepth, void *pvParameters,
+							   UBaseType_t uxPriority,
+							   StackType_t *puxStackBuffer,
+							   StaticTask_t *pxTaskBuffer);
+
+/**
+ * Only NULL (the calling task) is supported. It does nothing: the thread ends
+ * when the task function returns, which it must do right after.
+ */
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+
+void vTaskDelay(TickType_t xTicksToDelay);
+
+/**
+ * Milliseconds elapsed on a monotonic clock, wrapping like on FreeRTOS
+ */
+TickType_t xTaskGetTickCount(void);
+
+#define taskENTER_CRITICAL() vPortEnterCritical()
+#define taskEXIT_CRITICAL() vPortExitCritical()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_NATIVE_FREERTOS_TASK_H_ */
@@ -0,0 +1,38 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		sdkconfig.h
+ *
+ * \brief		Kconfig options of the native build
+ *
+ * There is no menuconfig outside ESP-IDF: each option can be overridden with
+ * a compiler definition.
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_SDKCONFIG_H_
+#define ERPC_ESP_NATIVE_SDKCONFIG_H_
+
+/*
+ * Selects the single critical section of the native FreeRTOS API in
+ * erpc_esp_utils
+ */
+#ifndef CONFIG_IDF_TARGET_LINUX
+#define CONFIG_IDF_TARGET_LINUX 1
+#endif
+
+#ifndef CONFIG_ERPC_ESP_TINYPROTO_COMPRESSION
+#define CONFIG_ERPC_ESP_TINYPROTO_COMPRESSION 1
+#endif
+
+#ifndef CONFIG_ERPC_ESP_CRITICAL_TRACE
+#define CONFIG_ERPC_ESP_CRITICAL_TRACE 0
+#endif
+
+#endif /* ifndef ERPC_ESP_NATIVE_SDKCONFIG_H_ */
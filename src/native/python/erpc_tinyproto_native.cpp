@@ -0,0 +1,377 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		erpc_tinyproto_native.cpp
+ *
+ * \brief		erpc_esp.erpc_tinyproto._native Python extension module
+ *
+ * Wraps the C++ TinyprotoTransport, whose RX and TX tasks run on native
+ * threads, without the GIL. Use it through
+ * erpc_esp.erpc_tinyproto.native.NativeTinyprotoTransport, which maps the
+ * failures to the exceptions of erpc_esp.erpc_tinyproto.
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "tinyproto_transport.hpp"
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <vector>
+
+using namespace erpc;
+using namespace erpc::esp;
+
+/**
+ * Poll period of the file descriptors, so that the RX task notices the
+ * closure of the transport
+ */
+#define IO_POLL_MS 100
+
+/**
+ * Storage of the FIFOs of each channel, the same as channel 0
+ */
+#define CHANNEL_BUFFER_SIZE (2048 + 256)
+
+namespace {
+
+/**
+ * Transport and everything it needs, on file descriptors
+ */
+struct Link {
+	Link(int read_fd, int write_fd,
+		 const erpc_esp_transport_tinyproto_config &config)
+		: read_fd(read_fd), write_fd(write_fd), opened(false),
+		  closing(false), write_errors(0),
+		  transport(tinyproto_buffer, sizeof(tinyproto_buffer), fd_write,
+					fd_read, with_user_data(config, this)) {
+		for (uint8_t i = 1; i < ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS;
+			 ++i) {
+			erpc_esp_transport_tinyproto_channel_config channel_config =
+				ERPC_ESP_TRANSPORT_TINYPROTO_CHANNEL_CONFIG_DEFAULT();
+			channel_config.rx_buffer = this->channel_buffers[i - 1].rx;
+			channel_config.rx_buffer_size =
+				sizeof(this->channel_buffers[i - 1].rx);
+			channel_config.tx_buffer = this->channel_buffers[i - 1].tx;
+			channel_config.tx_buffer_size =
+				sizeof(this->channel_buffers[i - 1].tx);
+			this->transport.init_channel(i, channel_config);
+		}
+	}
+
+	static erpc_esp_transport_tinyproto_config
+	with_user_data(erpc_esp_transport_tinyproto_config config, Link *link) {
+		config.io_user_data = link;
+		return config;
+	}
+
+	/**
+	 * Read what is available, waiting at most IO_POLL_MS
+	 */
+	static int fd_read(void *user_data, void *buffer, int size) {
+		Link *link = static_cast<Link *>(user_data);
+		struct pollfd fds = {link->read_fd, POLLIN, 0};
+		if (poll(&fds, 1, IO_POLL_MS) <= 0) {
+			return 0;
+		}
+		ssize_t ret = read(link->read_fd, buffer, size);
+		if (ret <= 0) {
+			// End of file or error: don't spin on poll
+			usleep(IO_POLL_MS * 1000);
+			return 0;
+		}
+		return ret;
+	}
+
+	/**
+	 * Write at least one byte, waiting for room. The TX task retries until
+	 * everything is written, so on error or closure the data is dropped:
+	 * Tinyproto retransmits it or detects the disconnection.
+	 */
+	static int fd_write(void *user_data, const void *buffer, int size) {
+		Link *link = static_cast<Link *>(user_data);
+		while (!link->closing) {
+			struct pollfd fds = {link->write_fd, POLLOUT, 0};
+			if (poll(&fds, 1, IO_POLL_MS) <= 0) {
+				continue;
+			}
+			ssize_t ret = write(link->write_fd, buffer, size);
+			if (ret > 0) {
+				return ret;
+			}
+			if (ret < 0 && errno != EAGAIN && errno != EINTR) {
+				++link->write_errors;
+				break;
+			}
+		}
+		return size;
+	}
+
+	int read_fd;
+	int write_fd;
+	bool opened;
+	volatile bool closing;
+	uint32_t write_errors;
+	uint8_t tinyproto_buffer[4096];
+	struct {
+		uint8_t rx[CHANNEL_BUFFER_SIZE];
+		uint8_t tx[CHANNEL_BUFFER_SIZE];
+	} channel_buffers[ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS - 1];
+	TinyprotoTransport transport;
+};
+
+struct LinkObject {
+	PyObject_HEAD
+	Link *link;
+};
+
+TickType_t ticks_from_ms(long ms) {
+	return ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(ms);
+}
+
+TinyprotoChannel *get_channel(LinkObject *self, int id) {
+	TinyprotoChannel *channel =
+		id >= 0 ? self->link->transport.channel(id) : NULL;
+	if (channel == NULL) {
+		PyErr_Format(PyExc_ValueError, "Invalid channel %d", id);
+	}
+	return channel;
+}
+
+bool check_opened(LinkObject *self) {
+	if (!self->link->opened) {
+		PyErr_SetString(PyExc_RuntimeError, "Link not opened");
+	}
+	return self->link->opened;
+}
+
+int Link_init(LinkObject *self, PyObject *args, PyObject *kwds) {
+	static const char *kwlist[] = {"read_fd",
+								   "write_fd",
+								   "send_timeout_ms",
+								   "receive_timeout_ms",
+								   "compression_threshold",
+								   NULL};
+	int read_fd;
+	int write_fd;
+	long send_timeout_ms = 500;
+	long receive_timeout_ms = -1;
+	unsigned int compression_threshold = 64;
+
+	if (!PyArg_ParseTupleAndKeywords(
+			args, kwds, "ii|llI", const_cast<char **>(kwlist), &read_fd,
+			&write_fd, &send_timeout_ms, &receive_timeout_ms,
+			&compression_threshold)) {
+		return -1;
+	}
+	if (self->link != NULL) {
+		PyErr_SetString(PyExc_RuntimeError, "Link already initialized");
+		return -1;
+	}
+
+	erpc_esp_transport_tinyproto_config config =
+		ERPC_ESP_TRANSPORT_TINYPROTO_CONFIG_DEFAULT();
+	config.send_timeout = ticks_from_ms(send_timeout_ms);
+	config.receive_timeout = ticks_from_ms(receive_timeout_ms);
+	config.compression_threshold = compression_threshold;
+	self->link = new Link(read_fd, write_fd, config);
+	return 0;
+}
+
+PyObject *Link_close(LinkObject *self, PyObject *unused);
+
+void Link_dealloc(LinkObject *self) {
+	if (self->link != NULL) {
+		if (self->link->opened) {
+			Py_XDECREF(Link_close(self, NULL));
+		}
+		delete self->link;
+	}
+	PyTypeObject *type = Py_TYPE(self);
+	type->tp_free(self);
+	Py_DECREF(type);
+}
+
+PyObject *Link_open(LinkObject *self, PyObject *unused) {
+	if (self->link->opened) {
+		PyErr_SetString(PyExc_RuntimeError, "Link already opened");
+		return NULL;
+	}
+	self->link->closing = false;
+	self->link->transport.open();
+	self->link->opened = true;
+	Py_RETURN_NONE;
+}
+
+PyObject *Link_close(LinkObject *self, PyObject *unused) {
+	if (!check_opened(self)) {
+		return NULL;
+	}
+	self->link->opened = false;
+	self->link->closing = true;
+	Py_BEGIN_ALLOW_THREADS;
+	self->link->transport.close();
+	Py_END_ALLOW_THREADS;
+	Py_RETURN_NONE;
+}
+
+PyObject *Link_wait_connected(LinkObject *self, PyObject *args) {
+	long timeout_ms = -1;
+	if (!PyArg_ParseTuple(args, "|l", &timeout_ms) || !check_opened(self)) {
+		return NULL;
+	}
+	erpc_status_t status;
+	Py_BEGIN_ALLOW_THREADS;
+	status = self->link->transport.wait_connected(ticks_from_ms(timeout_ms));
+	Py_END_ALLOW_THREADS;
+	return PyBool_FromLong(status == kErpcStatus_Success);
+}
+
+PyObject *Link_connected(LinkObject *self, PyObject *unused) {
+	return PyBool_FromLong(self->link->opened &&
+						   self->link->transport.wait_connected(0) ==
+							   kErpcStatus_Success);
+}
+
+PyObject *Link_opened(LinkObject *self, PyObject *unused) {
+	return PyBool_FromLong(self->link->opened);
+}
+
+PyObject *Link_send(LinkObject *self, PyObject *args) {
+	int id;
+	Py_buffer data;
+	if (!PyArg_ParseTuple(args, "iy*", &id, &data)) {
+		return NULL;
+	}
+	TinyprotoChannel *channel = get_channel(self, id);
+	if (channel == NULL || !check_opened(self)) {
+		PyBuffer_Release(&data);
+		return NULL;
+	}
+	if (data.len > UINT16_MAX) {
+		PyBuffer_Release(&data);
+		Py_RETURN_FALSE;
+	}
+	// The channel copies the message and doesn't modify it
+	MessageBuffer message(static_cast<uint8_t *>(data.buf),
+						  static_cast<uint16_t>(data.len));
+	message.setUsed(static_cast<uint16_t>(data.len));
+	erpc_status_t status;
+	Py_BEGIN_ALLOW_THREADS;
+	status = channel->send(&message);
+	Py_END_ALLOW_THREADS;
+	PyBuffer_Release(&data);
+	return PyBool_FromLong(status == kErpcStatus_Success);
+}
+
+PyObject *Link_receive(LinkObject *self, PyObject *args) {
+	int id;
+	if (!PyArg_ParseTuple(args, "i", &id)) {
+		return NULL;
+	}
+	TinyprotoChannel *channel = get_channel(self, id);
+	if (channel == NULL || !check_opened(self)) {
+		return NULL;
+	}
+	std::vector<uint8_t> buffer(CHANNEL_BUFFER_SIZE);
+	MessageBuffer message(buffer.data(), buffer.size());
+	erpc_status_t status;
+	Py_BEGIN_ALLOW_THREADS;
+	status = channel->receive(&message);
+	Py_END_ALLOW_THREADS;
+	if (status != kErpcStatus_Success) {
+		Py_RETURN_NONE;
+	}
+	return PyBytes_FromStringAndSize(
+		reinterpret_cast<const char *>(message.get()), message.getUsed());
+}
+
+PyObject *Link_stats(LinkObject *self, PyObject *unused) {
+	erpc_esp_transport_tinyproto_stats stats;
+	self->link->transport.get_stats(&stats);
+	return Py_BuildValue(
+		"{s:O,s:I,s:I,s:I,s:I,s:I,s:I,s:I,s:I,s:I,s:I,s:I}", "compression",
+		stats.compression ? Py_True : Py_False, "tx_frames", stats.tx_frames,
+		"tx_compressed_frames", stats.tx_compressed_frames, "tx_payload_bytes",
+		stats.tx_payload_bytes, "tx_wire_bytes", stats.tx_wire_bytes,
+		"rx_frames", stats.rx_frames, "rx_compressed_frames",
+		stats.rx_compressed_frames, "rx_payload_bytes", stats.rx_payload_bytes,
+		"rx_wire_bytes", stats.rx_wire_bytes, "rx_errors", stats.rx_errors,
+		"rx_stalls", stats.rx_stalls, "write_errors", self->link->write_errors);
+}
+
+PyMethodDef Link_methods[] = {
+	{"open", (PyCFunction)Link_open, METH_NOARGS, "Open the link"},
+	{"close", (PyCFunction)Link_close, METH_NOARGS,
+	 "Close the link, waiting for the RX and TX threads"},
+	{"wait_connected", (PyCFunction)Link_wait_connected, METH_VARARGS,
+	 "wait_connected(timeout_ms=-1) -> bool"},
+	{"connected", (PyCFunction)Link_connected, METH_NOARGS,
+	 "connected() -> bool"},
+	{"opened", (PyCFunction)Link_opened, METH_NOARGS, "opened() -> bool"},
+	{"send", (PyCFunction)Link_send, METH_VARARGS,
+	 "send(channel, data) -> bool. False if the message could not be queued."},
+	{"receive", (PyCFunction)Link_receive, METH_VARARGS,
+	 "receive(channel) -> bytes, or None on failure"},
+	{"stats", (PyCFunction)Link_stats, METH_NOARGS, "stats() -> dict"},
+	{NULL, NULL, 0, NULL},
+};
+
+PyType_Slot Link_slots[] = {
+	{Py_tp_init, (void *)Link_init},
+	{Py_tp_dealloc, (void *)Link_dealloc},
+	{Py_tp_methods, (void *)Link_methods},
+	{Py_tp_doc,
+	 (void *)"Link(read_fd, write_fd, send_timeout_ms=500, "
+			 "receive_timeout_ms=-1, compression_threshold=64)\n\n"
+			 "Tinyproto link over two file descriptors. Negative timeouts "
+			 "wait forever."},
+	{0, NULL},
+};
+
+PyType_Spec Link_spec = {
+	"erpc_esp.erpc_tinyproto._native.Link",
+	sizeof(LinkObject),
+	0,
+	Py_TPFLAGS_DEFAULT,
+	Link_slots,
+};
+
+struct PyModuleDef native_module = {
+	PyModuleDef_HEAD_INIT,
+	"_native",
+	"Native Tinyproto transport",
+	-1,
+	NULL,
+};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit__native(void) {
+	PyObject *module = PyModule_Create(&native_module);
+	if (module == NULL) {
+		return NULL;
+	}
+	PyObject *link_type = PyType_FromSpec(&Link_spec);
+	if (link_type == NULL ||
+		PyModule_AddObject(module, "Link", link_type) < 0 ||
+		PyModule_AddIntConstant(module, "MAX_CHANNELS",
+								ERPC_ESP_TRANSPORT_TINYPROTO_MAX_CHANNELS) <
+			0) {
+		Py_XDECREF(link_type);
+		Py_DECREF(module);
+		return NULL;
+	}
+	return module;
+}
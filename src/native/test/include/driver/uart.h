@@ -0,0 +1,80 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		uart.h
+ *
+ * \brief		Subset of the ESP-IDF UART driver API used by the UART
+ * 				transport, implemented by uart_driver_stub.cpp
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_TEST_DRIVER_UART_H_
+#define ERPC_ESP_NATIVE_TEST_DRIVER_UART_H_
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	UART_NUM_0,
+	UART_NUM_1,
+	UART_NUM_2,
+	UART_NUM_MAX,
+} uart_port_t;
+
+typedef enum {
+	UART_DATA,
+	UART_BREAK,
+	UART_BUFFER_FULL,
+	UART_FIFO_OVF,
+	UART_FRAME_ERR,
+	UART_PARITY_ERR,
+	UART_DATA_BREAK,
+	UART_PATTERN_DET,
+	UART_EVENT_MAX,
+} uart_event_type_t;
+
+typedef struct {
+	uart_event_type_t type;
+	size_t size;
+	bool timeout_flag;
+} uart_event_t;
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size,
+							  int tx_buffer_size, int queue_size,
+							  QueueHandle_t *uart_queue, int intr_alloc_flags);
+
+esp_err_t uart_driver_delete(uart_port_t uart_num);
+
+esp_err_t uart_set_rx_full_threshold(uart_port_t uart_num, int threshold);
+
+esp_err_t uart_set_rx_timeout(uart_port_t uart_num, const uint8_t tout_thresh);
+
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size);
+
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length,
+					TickType_t ticks_to_wait);
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t *size);
+
+esp_err_t uart_flush_input(uart_port_t uart_num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_NATIVE_TEST_DRIVER_UART_H_ */
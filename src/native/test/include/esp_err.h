@@ -0,0 +1,45 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		esp_err.h
+ *
+ * \brief		Subset of the ESP-IDF error codes used by the driver stubs
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_TEST_ESP_ERR_H_
+#define ERPC_ESP_NATIVE_TEST_ESP_ERR_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+#define ESP_ERROR_CHECK(x)                                                     \
+	do {                                                                       \
+		esp_err_t err_rc_ = (x);                                               \
+		if (err_rc_ != ESP_OK) {                                               \
+			fprintf(stderr, "%s:%d: %s failed (%d)\n", __FILE__, __LINE__,   \
+					#x, err_rc_);                                              \
+			abort();                                                           \
+		}                                                                      \
+	} while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_NATIVE_TEST_ESP_ERR_H_ */
@@ -0,0 +1,39 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		queue.h
+ *
+ * \brief		FreeRTOS queues, only those created by the UART driver stub
+ *
+ * The OS abstraction has no queues: the only one the transports use is the
+ * event queue of the UART driver, which the stub implements itself.
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_TEST_FREERTOS_QUEUE_H_
+#define ERPC_ESP_NATIVE_TEST_FREERTOS_QUEUE_H_
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer,
+						 TickType_t xTicksToWait);
+
+BaseType_t xQueueReset(QueueHandle_t xQueue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef ERPC_ESP_NATIVE_TEST_FREERTOS_QUEUE_H_ */
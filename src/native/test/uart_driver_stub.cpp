@@ -0,0 +1,252 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		uart_driver_stub.cpp
+ *
+ * \brief		ESP-IDF UART driver on a scripted line - implementation
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "uart_driver_stub.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Arrival {
+	Clock::time_point at;
+	uint8_t byte;
+};
+
+struct Event {
+	Clock::time_point at;
+	uart_event_t event;
+};
+
+Clock::time_point s_origin;
+/**
+ * Bytes not read yet, in order of arrival
+ */
+std::deque<Arrival> s_line;
+/**
+ * Events not received yet, in order
+ */
+std::deque<Event> s_events;
+std::vector<uint8_t> s_written;
+uart_stub::Calls s_calls;
+/**
+ * Its address is the handle of the event queue
+ */
+int s_event_queue;
+
+Clock::time_point from_origin(uint32_t ms) {
+	return s_origin + std::chrono::milliseconds(ms);
+}
+
+Clock::time_point deadline_after(TickType_t ticks) {
+	if (ticks == portMAX_DELAY) {
+		return Clock::time_point::max();
+	}
+	return Clock::now() + std::chrono::milliseconds(ticks * portTICK_PERIOD_MS);
+}
+
+/**
+ * Wait until \p at, unless it is after \p deadline: then wait until the
+ * deadline.
+ *
+ * \retval true \p at has come
+ */
+bool wait_until(Clock::time_point at, Clock::time_point deadline) {
+	if (at > deadline) {
+		std::this_thread::sleep_until(deadline);
+		return false;
+	}
+	std::this_thread::sleep_until(at);
+	return true;
+}
+
+/**
+ * Nothing more is scheduled: wait until \p deadline, but abort rather than
+ * waiting forever
+ */
+void wait_nothing(const char *function, Clock::time_point deadline) {
+	if (deadline == Clock::time_point::max()) {
+		fprintf(stderr, "%s would wait forever: nothing more is scheduled\n",
+				function);
+		abort();
+	}
+	std::this_thread::sleep_until(deadline);
+}
+
+void post(const uart_event_t &event, Clock::time_point at) {
+	Event e = {at, event};
+	auto it = std::upper_bound(
+		s_events.begin(), s_events.end(), e,
+		[](const Event &a, const Event &b) { return a.at < b.at; });
+	s_events.insert(it, e);
+}
+
+} // namespace
+
+namespace uart_stub {
+
+void reset(void) {
+	s_origin = Clock::now();
+	s_line.clear();
+	s_events.clear();
+	s_written.clear();
+	s_calls = Calls();
+}
+
+void receive(const uint8_t *data, size_t size, uint32_t at_ms,
+			 uint32_t gap_ms) {
+	for (size_t i = 0; i < size; ++i) {
+		Clock::time_point at = from_origin(at_ms + i * gap_ms);
+		assert(s_line.empty() || s_line.back().at <= at);
+		s_line.push_back({at, data[i]});
+		post({UART_DATA, 1, false}, at);
+	}
+}
+
+void post_event(uart_event_type_t type, uint32_t at_ms) {
+	post({type, 0, false}, from_origin(at_ms));
+}
+
+std::vector<uint8_t> take_written(void) {
+	std::vector<uint8_t> written;
+	written.swap(s_written);
+	return written;
+}
+
+const Calls &calls(void) {
+	return s_calls;
+}
+
+} // namespace uart_stub
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size,
+							  int tx_buffer_size, int queue_size,
+							  QueueHandle_t *uart_queue, int intr_alloc_flags) {
+	(void)uart_num;
+	(void)rx_buffer_size;
+	(void)tx_buffer_size;
+	(void)intr_alloc_flags;
+	s_calls.event_queue_size = queue_size;
+	s_calls.event_queue = uart_queue != NULL;
+	if (uart_queue != NULL) {
+		*uart_queue = reinterpret_cast<QueueHandle_t>(&s_event_queue);
+	}
+	return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t uart_num) {
+	(void)uart_num;
+	return ESP_OK;
+}
+
+esp_err_t uart_set_rx_full_threshold(uart_port_t uart_num, int threshold) {
+	(void)uart_num;
+	(void)threshold;
+	return ESP_OK;
+}
+
+esp_err_t uart_set_rx_timeout(uart_port_t uart_num, const uint8_t tout_thresh) {
+	(void)uart_num;
+	(void)tout_thresh;
+	return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size) {
+	(void)uart_num;
+	const uint8_t *data = static_cast<const uint8_t *>(src);
+	s_written.insert(s_written.end(), data, data + size);
+	return size;
+}
+
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length,
+					TickType_t ticks_to_wait) {
+	(void)uart_num;
+	Clock::time_point deadline = deadline_after(ticks_to_wait);
+	uint8_t *data = static_cast<uint8_t *>(buf);
+	uint32_t read = 0;
+
+	while (read < length) {
+		if (s_line.empty()) {
+			wait_nothing(__func__, deadline);
+			break;
+		}
+		if (!wait_until(s_line.front().at, deadline)) {
+			break;
+		}
+		data[read++] = s_line.front().byte;
+		s_line.pop_front();
+	}
+	return read;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t *size) {
+	(void)uart_num;
+	Clock::time_point now = Clock::now();
+	*size = 0;
+	for (const Arrival &arrival : s_line) {
+		if (arrival.at > now) {
+			break;
+		}
+		++*size;
+	}
+	return ESP_OK;
+}
+
+esp_err_t uart_flush_input(uart_port_t uart_num) {
+	(void)uart_num;
+	Clock::time_point now = Clock::now();
+	++s_calls.flushes;
+	while (!s_line.empty() && s_line.front().at <= now) {
+		s_line.pop_front();
+		++s_calls.flushed_bytes;
+	}
+	return ESP_OK;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer,
+						 TickType_t xTicksToWait) {
+	assert(xQueue == reinterpret_cast<QueueHandle_t>(&s_event_queue));
+	Clock::time_point deadline = deadline_after(xTicksToWait);
+
+	if (s_events.empty()) {
+		wait_nothing(__func__, deadline);
+		return pdFALSE;
+	}
+	if (!wait_until(s_events.front().at, deadline)) {
+		return pdFALSE;
+	}
+	memcpy(pvBuffer, &s_events.front().event, sizeof(uart_event_t));
+	s_events.pop_front();
+	return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue) {
+	assert(xQueue == reinterpret_cast<QueueHandle_t>(&s_event_queue));
+	Clock::time_point now = Clock::now();
+	++s_calls.queue_resets;
+	while (!s_events.empty() && s_events.front().at <= now) {
+		s_events.pop_front();
+	}
+	return pdPASS;
+}
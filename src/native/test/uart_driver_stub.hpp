@@ -0,0 +1,83 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		uart_driver_stub.hpp
+ *
+ * \brief		ESP-IDF UART driver on a scripted line
+ *
+ * The test schedules the bytes arriving on the line and the driver events,
+ * in milliseconds from uart_stub::reset. The driver functions (see
+ * driver/uart.h) wait for them for real, on the same monotonic clock as
+ * xTaskGetTickCount, so that the timeouts of the transport are exercised
+ * as on the device. A single port is simulated.
+ *
+ * Waiting forever while nothing more is scheduled aborts the test, instead
+ * of hanging it.
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+#ifndef ERPC_ESP_NATIVE_TEST_UART_DRIVER_STUB_HPP_
+#define ERPC_ESP_NATIVE_TEST_UART_DRIVER_STUB_HPP_
+
+#include "driver/uart.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace uart_stub {
+
+/**
+ * Calls to the driver since the last reset
+ */
+struct Calls {
+	/**
+	 * Arguments of uart_driver_install
+	 */
+	int event_queue_size;
+	bool event_queue;
+	/**
+	 * uart_flush_input calls, and the bytes they discarded
+	 */
+	unsigned flushes;
+	size_t flushed_bytes;
+	/**
+	 * xQueueReset calls
+	 */
+	unsigned queue_resets;
+};
+
+/**
+ * Forget the line, the events and the calls, and restart the clock
+ */
+void reset(void);
+
+/**
+ * Schedule \p size bytes arriving on the line, the first one \p at_ms after
+ * the reset and the others every \p gap_ms. Each byte posts an #UART_DATA
+ * event. Bytes must be scheduled in order of arrival.
+ */
+void receive(const uint8_t *data, size_t size, uint32_t at_ms,
+			 uint32_t gap_ms = 0);
+
+/**
+ * Schedule the event \p type, \p at_ms after the reset
+ */
+void post_event(uart_event_type_t type, uint32_t at_ms);
+
+/**
+ * Bytes written with uart_write_bytes since the last call
+ */
+std::vector<uint8_t> take_written(void);
+
+const Calls &calls(void);
+
+} // namespace uart_stub
+
+#endif /* ifndef ERPC_ESP_NATIVE_TEST_UART_DRIVER_STUB_HPP_ */
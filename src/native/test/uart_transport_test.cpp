@@ -0,0 +1,399 @@
+/**
+ * \verbatim
+ *                              _  __
+ *                             | |/ /
+ *                             | ' / ___ _ __ _ __
+ *                             |  < / _ \ '__| '__|
+ *                             | . \  __/ |  | |
+ *                             |_|\_\___|_|  |_|
+ * \endverbatim
+ * \file		uart_transport_test.cpp
+ *
+ * \brief		Host test of the receive paths of the UART transport
+ *
+ * The transport runs on the UART driver stub, whose line is scripted by each
+ * test case. The timings are real, with margins of tens of milliseconds.
+ *
+ * \copyright	Copyright 2022 Kerr s.r.l. - All Rights Reserved.
+ */
+
+#include "uart_driver_stub.hpp"
+#include "uart_transport.hpp"
+
+#include "erpc_crc16.hpp"
+#include "erpc_message_buffer.hpp"
+
+#include <cstdio>
+#include <vector>
+
+using namespace erpc;
+using namespace erpc::esp;
+
+namespace {
+
+unsigned s_failures;
+
+#define CHECK(cond) check((cond), #cond, __FILE__, __LINE__)
+
+void check(bool ok, const char *what, const char *file, int line) {
+	if (!ok) {
+		fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, what);
+		++s_failures;
+	}
+}
+
+erpc_esp_transport_uart_config
+make_config(erpc_esp_transport_uart_receive_mode receive_mode,
+			erpc_esp_transport_uart_framing framing) {
+	erpc_esp_transport_uart_config config =
+		ERPC_ESP_TRANSPORT_UART_CONFIG_DEFAULT();
+	config.receive_mode = receive_mode;
+	config.framing = framing;
+	config.receive_timeout = pdMS_TO_TICKS(50);
+	return config;
+}
+
+/**
+ * \p size bytes counting up from \p first: they never hold the sync preamble
+ */
+std::vector<uint8_t> make_payload(size_t size, uint8_t first) {
+	std::vector<uint8_t> payload(size);
+	for (size_t i = 0; i < size; ++i) {
+		payload[i] = first + i;
+	}
+	return payload;
+}
+
+/**
+ * The frame \p transport sends for \p payload
+ */
+std::vector<uint8_t> encode(UARTTransport &transport,
+							std::vector<uint8_t> payload) {
+	MessageBuffer message(payload.data(), payload.size());
+	message.setUsed(payload.size());
+	CHECK(transport.send(&message) == kErpcStatus_Success);
+	return uart_stub::take_written();
+}
+
+struct Received {
+	erpc_status_t status;
+	std::vector<uint8_t> payload;
+};
+
+Received receive(UARTTransport &transport) {
+	uint8_t buffer[256];
+	MessageBuffer message(buffer, sizeof(buffer));
+	Received received;
+	received.status = transport.receive(&message);
+	if (received.status == kErpcStatus_Success) {
+		received.payload.assign(buffer, buffer + message.getUsed());
+	}
+	return received;
+}
+
+/**
+ * A frame arriving in two chunks is received whole
+ */
+void check_chunked_frame(UARTTransport &transport) {
+	std::vector<uint8_t> payload = make_payload(64, 0);
+	std::vector<uint8_t> frame = encode(transport, payload);
+	uart_stub::receive(frame.data(), 10, 0);
+	uart_stub::receive(frame.data() + 10, frame.size() - 10, 20, 1);
+
+	Received received = receive(transport);
+	CHECK(received.status == kErpcStatus_Success);
+	CHECK(received.payload == payload);
+}
+
+void test_blocking_mode(void) {
+	uart_stub::reset();
+	UARTTransport transport(
+		UART_NUM_1, make_config(ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_BLOCKING,
+								ERPC_ESP_TRANSPORT_UART_FRAMING_BASIC));
+	Crc16 crc;
+	transport.setCrc16(&crc);
+	CHECK(transport.init() == kErpcStatus_Success);
+	// The blocking mode does not read the events
+	CHECK(!uart_stub::calls().event_queue);
+	CHECK(uart_stub::calls().event_queue_size == 0);
+
+	check_chunked_frame(transport);
+}
+
+void test_event_mode(void) {
+	uart_stub::reset();
+	UARTTransport transport(
+		UART_NUM_1, make_config(ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_EVENT,
+								ERPC_ESP_TRANSPORT_UART_FRAMING_BASIC));
+	Crc16 crc;
+	transport.setCrc16(&crc);
+	CHECK(transport.init() == kErpcStatus_Success);
+	CHECK(uart_stub::calls().event_queue);
+	CHECK(uart_stub::calls().event_queue_size ==
+		  ERPC_ESP_TRANSPORT_UART_EVENT_QUEUE_SIZE_DEFAULT);
+
+	check_chunked_frame(transport);
+}
+
+/**
+ * An overflow fails the frame being received and flushes the RX buffer and
+ * the events. The next frame is received.
+ */
+void test_event_mode_overflow(uart_event_type_t overflow) {
+	uart_stub::reset();
+	UARTTransport transport(
+		UART_NUM_1, make_config(ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_EVENT,
+								ERPC_ESP_TRANSPORT_UART_FRAMING_BASIC));
+	Crc16 crc;
+	transport.setCrc16(&crc);
+	CHECK(transport.init() == kErpcStatus_Success);
+
+	std::vector<uint8_t> lost = encode(transport, make_payload(64, 0));
+	std::vector<uint8_t> payload = make_payload(32, 0x80);
+	std::vector<uint8_t> frame = encode(transport, payload);
+	// The driver reports the overflow while 10 bytes are still buffered
+	uart_stub::receive(lost.data(), 20, 0);
+	uart_stub::post_event(overflow, 10);
+	uart_stub::receive(lost.data() + 30, 10, 10);
+	uart_stub::receive(frame.data(), frame.size(), 30);
+
+	Received received = receive(transport);
+	CHECK(received.status == kErpcStatus_ReceiveFailed);
+	CHECK(uart_stub::calls().flushes == 1);
+	CHECK(uart_stub::calls().flushed_bytes == 10);
+	CHECK(uart_stub::calls().queue_resets == 1);
+
+	received = receive(transport);
+	CHECK(received.status == kErpcStatus_Success);
+	CHECK(received.payload == payload);
+}
+
+void test_fifo_overflow(void) {
+	test_event_mode_overflow(UART_FIFO_OVF);
+}
+
+void test_buffer_full(void) {
+	test_event_mode_overflow(UART_BUFFER_FULL);
+}
+
+/**
+ * The receive timeout is the longest gap between bytes: a slow frame is
+ * received, a frame stalling in the middle is dropped.
+ */
+void test_byte_timeout(erpc_esp_transport_uart_receive_mode receive_mode) {
+	uart_stub::reset();
+	UARTTransport transport(
+		UART_NUM_1,
+		make_config(receive_mode, ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC));
+	Crc16 crc;
+	transport.setCrc16(&crc);
+	CHECK(transport.init() == kErpcStatus_Success);
+
+	std::vector<uint8_t> slow_payload = make_payload(30, 0);
+	std::vector<uint8_t> slow = encode(transport, slow_payload);
+	std::vector<uint8_t> stalled = encode(transport, make_payload(30, 0x40));
+	std::vector<uint8_t> payload = make_payload(30, 0x80);
+	std::vector<uint8_t> frame = encode(transport, payload);
+	// 5 ms between bytes, 190 ms for the whole frame
+	uart_stub::receive(slow.data(), slow.size(), 0, 5);
+	// 200 ms gap after 20 bytes
+	uart_stub::receive(stalled.data(), 20, 250);
+	uart_stub::receive(stalled.data() + 20, stalled.size() - 20, 450);
+	uart_stub::receive(frame.data(), frame.size(), 500);
+
+	Received received = receive(transport);
+	CHECK(received.status == kErpcStatus_Success);
+	CHECK(received.payload == slow_payload);
+
+	received = receive(transport);
+	CHECK(received.status == kErpcStatus_Success);
+	CHECK(received.payload == payload);
+
+	erpc_esp_transport_uart_stats stats;
+	transport.getStats(&stats);
+	CHECK(stats.rx_frames == 2);
+	CHECK(stats.rx_timeouts == 1);
+}
+
+void test_blocking_mode_byte_timeout(void) {
+	test_byte_timeout(ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_BLOCKING);
+}
+
+void test_event_mode_byte_timeout(void) {
+	test_byte_timeout(ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_EVENT);
+}
+
+/**
+ * A link with #ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC
+ */
+struct SyncLink {
+	Crc16 crc;
+	UARTTransport transport;
+
+	SyncLink(void)
+		: transport(UART_NUM_1,
+					make_config(ERPC_ESP_TRANSPORT_UART_RECEIVE_MODE_BLOCKING,
+								ERPC_ESP_TRANSPORT_UART_FRAMING_SYNC)) {
+		uart_stub::reset();
+		this->transport.setCrc16(&this->crc);
+		CHECK(this->transport.init() == kErpcStatus_Success);
+	}
+
+	erpc_esp_transport_uart_stats stats(void) {
+		erpc_esp_transport_uart_stats stats;
+		this->transport.getStats(&stats);
+		return stats;
+	}
+};
+
+/**
+ * Schedule \p damaged and \p frame right after it, at \p at_ms
+ */
+void receive_after(const std::vector<uint8_t> &damaged,
+				   const std::vector<uint8_t> &frame, uint32_t at_ms) {
+	std::vector<uint8_t> line = damaged;
+	line.insert(line.end(), frame.begin(), frame.end());
+	uart_stub::receive(line.data(), line.size(), at_ms);
+}
+
+/**
+ * Bytes lost in the payload: the frame fails the CRC check after taking the
+ * start of the next one, which is found again. Bytes lost in the header: the
+ * header check fails after taking the start of the next frame, which is
+ * found again.
+ */
+void test_sync_byte_loss(void) {
+	SyncLink link;
+	std::vector<uint8_t> damaged = encode(link.transport, make_payload(40, 0));
+	std::vector<uint8_t> payload = make_payload(30, 0x80);
+	std::vector<uint8_t> frame = encode(link.transport, payload);
+	std::vector<uint8_t> lost_payload = damaged;
+	lost_payload.erase(lost_payload.begin() + 20, lost_payload.begin() + 30);
+	receive_after(lost_payload, frame, 0);
+	std::vector<uint8_t> lost_header(damaged.begin(), damaged.begin() + 4);
+	receive_after(lost_header, frame, 10);
+
+	Received received = receive(link.transport);
+	CHECK(received.status == kErpcStatus_Success);
+	CHECK(received.payload == payload);
+	CHECK(link.stats().rx_crc_errors == 1);
+
+	received = receive(link.transport);
+	CHECK(received.status == kErpcStatus_Success);
+	CHECK(received.payload == payload);
+	CHECK(link.stats().rx_frames == 2);
+	CHECK(link.stats().rx_header_errors == 1);
+}
+
+void test_sync_header_crc(void) {
+	SyncLink link;
+	std::vector<uint8_t> damaged = encode(link.transport, make_payload(40, 0));
+	std::vector<uint8_t> payload = make_payload(30, 0x80);
+	std::vector<uint8_t> frame = encode(link.transport, payload);
+	// Header CRC, after preamble, size and payload CRC
+	damaged[6] ^= 0x01;
+	receive_after(damaged, frame, 0);
+
+	Received received = receive(link.transport);
+	CHECK(received.status == kErpcStatus_Success);
+	CHECK(received.payload == payload);
+	CHECK(link.stats().rx_frames == 1);
+	CHECK(link.stats().rx_header_errors == 1);
+}
+
+/**
+ * A payload holding a preamble and a valid header is received whole. If the
+ * real preamble is lost, the false header is taken, and the frame it
+ * describes fails the CRC check after taking the start of the next frame.
+ */
+void test_sync_false_preamble(void) {
+	SyncLink link;
+	std::vector<uint8_t> tricky_payload = make_payload(40, 0);
+	uint8_t *false_header = tricky_payload.data() + 10;
+	false_header[0] = 0xA5;
+	false_header[1] = 0x5A;
+	// 40 bytes payload with CRC 0x1234
+	false_header[2] = 40;
+	false_header[3] = 0;
+	false_header[4] = 0x34;
+	false_header[5] = 0x12;
+	uint16_t header_crc = link.crc.computeCRC16(false_header + 2, 4);
+	false_header[6] = header_crc;
+	false_header[7] = header_crc >> 8;
+	std::vector<uint8_t> tricky = encode(link.transport, tricky_payload);
+	std::vector<uint8_t> payload = make_payload(30, 0x80);
+	std::vector<uint8_t> frame = encode(link.transport, payload);
+	uart_stub::receive(tricky.data(), tricky.size(), 0);
+	receive_after(std::vector<uint8_t>(tricky.begin() + 1, tricky.end()),
+				  frame, 10);
+
+	Received received = receive(link.transport);
+	CHECK(received.status == kErpcStatus_Success);
+	CHECK(received.payload == tricky_payload);
+
+	received = receive(link.transport);
+	CHECK(received.status == kErpcStatus_Success);
+	CHECK(received.payload == payload);
+	CHECK(link.stats().rx_frames == 2);
+	CHECK(link.stats().rx_crc_errors == 1);
+}
+
+/**
+ * A truncated frame is dropped, whether the next frame follows right away or
+ * after the line has been idle.
+ */
+void test_sync_truncated(void) {
+	SyncLink link;
+	std::vector<uint8_t> truncated =
+		encode(link.transport, make_payload(40, 0));
+	std::vector<uint8_t> payload = make_payload(30, 0x80);
+	std::vector<uint8_t> frame = encode(link.transport, payload);
+	truncated.resize(20);
+	receive_after(truncated, frame, 0);
+	uart_stub::receive(truncated.data(), truncated.size(), 100);
+	uart_stub::receive(frame.data(), frame.size(), 250);
+
+	Received received = receive(link.transport);
+	CHECK(received.status == kErpcStatus_Success);
+	CHECK(received.payload == payload);
+	CHECK(link.stats().rx_crc_errors == 1);
+
+	received = receive(link.transport);
+	CHECK(received.status == kErpcStatus_Success);
+	CHECK(received.payload == payload);
+	CHECK(link.stats().rx_frames == 2);
+	CHECK(link.stats().rx_timeouts == 1);
+}
+
+const struct {
+	const char *name;
+	void (*run)(void);
+} s_tests[] = {
+	{"blocking_mode", test_blocking_mode},
+	{"event_mode", test_event_mode},
+	{"fifo_overflow", test_fifo_overflow},
+	{"buffer_full", test_buffer_full},
+	{"blocking_mode_byte_timeout", test_blocking_mode_byte_timeout},
+	{"event_mode_byte_timeout", test_event_mode_byte_timeout},
+	{"sync_byte_loss", test_sync_byte_loss},
+	{"sync_header_crc", test_sync_header_crc},
+	{"sync_false_preamble", test_sync_false_preamble},
+	{"sync_truncated", test_sync_truncated},
+};
+
+} // namespace
+
+int main(void) {
+	unsigned failed = 0;
+
+	for (const auto &test : s_tests) {
+		unsigned failures = s_failures;
+		test.run();
+		bool ok = s_failures == failures;
+		printf("%-32s %s\n", test.name, ok ? "OK" : "FAILED");
+		failed += !ok;
+	}
+	printf("%u of %zu tests failed\n", failed,
+		   sizeof(s_tests) / sizeof(s_tests[0]));
+	return failed == 0 ? 0 : 1;
+}